@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "common/circular_buffer.h"
+#include "common/sharded_circular_buffer.h"
 #include "test/baseline_circular_buffer.h"
 using namespace lightstep;
 
@@ -41,6 +42,15 @@ uint64_t ConsumeBufferNumbers(CircularBuffer<uint64_t>& buffer) noexcept {
   return result;
 }
 
+uint64_t ConsumeBufferNumbers(
+    ShardedCircularBuffer<uint64_t>& buffer) noexcept {
+  uint64_t result = 0;
+  for (size_t i = 0; i < buffer.num_shards(); ++i) {
+    result += ConsumeBufferNumbers(buffer.shard(i));
+  }
+  return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 // GenerateNumbersForThread
 //--------------------------------------------------------------------------------------------------
@@ -118,7 +128,13 @@ static void BM_BaselineBuffer(benchmark::State& state) {
   }
 }
 
-BENCHMARK(BM_BaselineBuffer)->Arg(1)->Arg(2)->Arg(4);
+BENCHMARK(BM_BaselineBuffer)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
 
 //--------------------------------------------------------------------------------------------------
 // BM_LockFreeBuffer
@@ -133,7 +149,34 @@ static void BM_LockFreeBuffer(benchmark::State& state) {
   }
 }
 
-BENCHMARK(BM_LockFreeBuffer)->Arg(1)->Arg(2)->Arg(4);
+BENCHMARK(BM_LockFreeBuffer)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
+
+//--------------------------------------------------------------------------------------------------
+// BM_ShardedBuffer
+//--------------------------------------------------------------------------------------------------
+static void BM_ShardedBuffer(benchmark::State& state) {
+  const size_t max_elements = 500;
+  auto num_threads = state.range(0);
+  const int n = N / num_threads;
+  ShardedCircularBuffer<uint64_t> buffer{max_elements};
+  for (auto _ : state) {
+    RunSimulation(buffer, num_threads, n);
+  }
+}
+
+BENCHMARK(BM_ShardedBuffer)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
 
 //--------------------------------------------------------------------------------------------------
 // BENCHMARK_MAIN
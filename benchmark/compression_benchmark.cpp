@@ -0,0 +1,115 @@
+#include "benchmark/benchmark.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/random.h"
+#include "lightstep-tracer-common/collector.pb.h"
+#include "recorder/serialization/report_request_header.h"
+#include "recorder/stream_recorder/connection_stream.h"
+#include "recorder/stream_recorder/stream_compressor.h"
+#include "test/utility.h"
+using namespace lightstep;
+
+// The number of spans streamed each iteration.
+const int NumSpans = 1000;
+
+//--------------------------------------------------------------------------------------------------
+// MakeSerializedSpans
+//--------------------------------------------------------------------------------------------------
+// Generate spans resembling those from an instrumented http server: repeated
+// operation names and tag keys with random ids and timestamps.
+static std::vector<std::string> MakeSerializedSpans() {
+  std::vector<std::string> result;
+  result.reserve(NumSpans);
+  for (int i = 0; i < NumSpans; ++i) {
+    collector::Span span;
+    span.mutable_span_context()->set_trace_id(GenerateId());
+    span.mutable_span_context()->set_span_id(GenerateId());
+    span.set_operation_name(i % 2 == 0 ? "HTTP GET /api/v1/users"
+                                       : "SELECT users");
+    auto timestamp = span.mutable_start_timestamp();
+    timestamp->set_seconds(1500000000 + i);
+    timestamp->set_nanos(static_cast<int32_t>(GenerateId() % 1000000000));
+    span.set_duration_micros(GenerateId() % 100000);
+    auto tag = span.add_tags();
+    tag->set_key("component");
+    tag->set_string_value("http");
+    tag = span.add_tags();
+    tag->set_key("http.status_code");
+    tag->set_int_value(200);
+    tag = span.add_tags();
+    tag->set_key("peer.address");
+    tag->set_string_value("10.0.0." + std::to_string(i % 256));
+    result.emplace_back(span.SerializeAsString());
+  }
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// BM_StreamSpans
+//--------------------------------------------------------------------------------------------------
+// Reports the bytes written to the wire per span and, through the
+// items-per-second rate, the time spent serializing each span for upload at
+// compression levels 0 (uncompressed) through 9.
+static void BM_StreamSpans(benchmark::State& state) {
+  Logger logger;
+  StreamRecorderOptions options;
+  options.compression_level = static_cast<int>(state.range(0));
+  CompressionBudget budget{0, options.compression_budget_period};
+
+  LightStepTracerOptions tracer_options;
+  auto header_common = WriteReportRequestHeader(tracer_options, 123);
+  MetricsObserver metrics_observer;
+  MetricsTracker metrics{metrics_observer};
+  ShardedCircularBuffer<ChainedStream> span_buffer{NumSpans, 1};
+  ByteBudget span_buffer_budget{0};
+  SpanStream span_stream{span_buffer, span_buffer_budget, metrics};
+  ConnectionStream connection_stream{
+      MakeFragment("Host:abc\r\n"),
+      Fragment{static_cast<void*>(&header_common[0]),
+               static_cast<int>(header_common.size())},
+      span_stream, MakeStreamCompressor(logger, options, budget)};
+
+  auto spans = MakeSerializedSpans();
+  int64_t num_wire_bytes = 0;
+  auto writer = [&num_wire_bytes](
+      std::initializer_list<FragmentInputStream*> fragment_streams) {
+    int num_bytes = 0;
+    for (auto fragment_stream : fragment_streams) {
+      fragment_stream->ForEachFragment([&num_bytes](void* /*data*/, int size) {
+        num_bytes += size;
+        return true;
+      });
+    }
+    num_wire_bytes += num_bytes;
+    return Consume(fragment_streams, num_bytes);
+  };
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (auto& span : spans) {
+      if (!AddSpanChunkFramedString(span_buffer, span)) {
+        std::cerr << "Failed to buffer span\n";
+        std::terminate();
+      }
+    }
+    state.ResumeTiming();
+    connection_stream.Flush(writer);
+    connection_stream.Shutdown();
+    connection_stream.Flush(writer);
+    connection_stream.Reset();
+  }
+  auto num_spans = static_cast<int64_t>(state.iterations()) * NumSpans;
+  state.SetItemsProcessed(num_spans);
+  state.counters["wire_bytes_per_span"] =
+      static_cast<double>(num_wire_bytes) / static_cast<double>(num_spans);
+}
+
+BENCHMARK(BM_StreamSpans)->Arg(0)->Arg(1)->Arg(6)->Arg(9);
+
+//--------------------------------------------------------------------------------------------------
+// BENCHMARK_MAIN
+//--------------------------------------------------------------------------------------------------
+BENCHMARK_MAIN();
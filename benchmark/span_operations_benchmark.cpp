@@ -1,4 +1,6 @@
 #include <cassert>
+#include <string>
+#include <vector>
 
 #include "lightstep/tracer.h"
 
@@ -12,12 +14,11 @@
 // NullTransport
 //--------------------------------------------------------------------------------------------------
 namespace {
-class NullTransporter final : public lightstep::SyncTransporter {
+class NullTransporter final : public lightstep::AsyncTransporter {
  public:
-  opentracing::expected<void> Send(
-      const google::protobuf::Message& /*request*/,
-      google::protobuf::Message& /*response*/) override {
-    return {};
+  void Send(std::unique_ptr<lightstep::BufferChain>&& message,
+            Callback& callback) noexcept override {
+    callback.OnSuccess(*message);
   }
 };
 }  // namespace
@@ -112,7 +113,7 @@ static std::shared_ptr<opentracing::Tracer> MakeStreamTracer() {
   std::unique_ptr<lightstep::Recorder> recorder{stream_recorder};
   lightstep::PropagationOptions propagation_options;
 
-  return std::make_shared<lightstep::TracerImpl>(
+  return lightstep::MakeTracerImpl(
       logger,
       lightstep::MakePropagationOptions(lightstep::LightStepTracerOptions{}),
       std::move(recorder));
@@ -247,6 +248,96 @@ static void BM_SpanSetTag2(benchmark::State& state, const char* tracer_type) {
 BENCHMARK_CAPTURE(BM_SpanSetTag2, rpc, "rpc");
 BENCHMARK_CAPTURE(BM_SpanSetTag2, stream, "stream");
 
+//--------------------------------------------------------------------------------------------------
+// BM_SpanSetTypedTag1
+//--------------------------------------------------------------------------------------------------
+static void BM_SpanSetTypedTag1(benchmark::State& state,
+                                const char* tracer_type) {
+  auto tracer = std::static_pointer_cast<lightstep::LightStepTracer>(
+      MakeTracer(tracer_type));
+  assert(tracer != nullptr);
+  auto operation_name =
+      lightstep::LightStepTracer::RegisterOperationName("abc123");
+  for (auto _ : state) {
+    auto span = tracer->StartSpan(operation_name);
+    span->SetTag("abc", "123");
+  }
+}
+BENCHMARK_CAPTURE(BM_SpanSetTypedTag1, rpc, "rpc");
+BENCHMARK_CAPTURE(BM_SpanSetTypedTag1, stream, "stream");
+
+//--------------------------------------------------------------------------------------------------
+// BM_SpanSetTypedTag2
+//--------------------------------------------------------------------------------------------------
+static void BM_SpanSetTypedTag2(benchmark::State& state,
+                                const char* tracer_type) {
+  auto tracer = std::static_pointer_cast<lightstep::LightStepTracer>(
+      MakeTracer(tracer_type));
+  assert(tracer != nullptr);
+  auto operation_name =
+      lightstep::LightStepTracer::RegisterOperationName("abc123");
+  for (auto _ : state) {
+    auto span = tracer->StartSpan(operation_name);
+    char key[5];
+    key[0] = 'a';
+    key[1] = 'b';
+    key[2] = 'c';
+    key[3] = '0';
+    key[4] = '\0';
+    for (int i = 0; i < 10; ++i) {
+      span->SetTag(opentracing::string_view{key, 4}, "123");
+      ++key[3];
+    }
+  }
+}
+BENCHMARK_CAPTURE(BM_SpanSetTypedTag2, rpc, "rpc");
+BENCHMARK_CAPTURE(BM_SpanSetTypedTag2, stream, "stream");
+
+//--------------------------------------------------------------------------------------------------
+// BM_SpanSetRegisteredTag1
+//--------------------------------------------------------------------------------------------------
+static void BM_SpanSetRegisteredTag1(benchmark::State& state,
+                                     const char* tracer_type) {
+  auto tracer = std::static_pointer_cast<lightstep::LightStepTracer>(
+      MakeTracer(tracer_type));
+  assert(tracer != nullptr);
+  auto operation_name =
+      lightstep::LightStepTracer::RegisterOperationName("abc123");
+  auto key = lightstep::LightStepTracer::RegisterTagKey("abc");
+  for (auto _ : state) {
+    auto span = tracer->StartSpan(operation_name);
+    span->SetTag(key, "123");
+  }
+}
+BENCHMARK_CAPTURE(BM_SpanSetRegisteredTag1, rpc, "rpc");
+BENCHMARK_CAPTURE(BM_SpanSetRegisteredTag1, stream, "stream");
+
+//--------------------------------------------------------------------------------------------------
+// BM_SpanSetRegisteredTag2
+//--------------------------------------------------------------------------------------------------
+static void BM_SpanSetRegisteredTag2(benchmark::State& state,
+                                     const char* tracer_type) {
+  auto tracer = std::static_pointer_cast<lightstep::LightStepTracer>(
+      MakeTracer(tracer_type));
+  assert(tracer != nullptr);
+  auto operation_name =
+      lightstep::LightStepTracer::RegisterOperationName("abc123");
+  std::vector<lightstep::TagKeyHandle> keys;
+  keys.reserve(10);
+  for (int i = 0; i < 10; ++i) {
+    keys.emplace_back(
+        lightstep::LightStepTracer::RegisterTagKey("abc" + std::to_string(i)));
+  }
+  for (auto _ : state) {
+    auto span = tracer->StartSpan(operation_name);
+    for (auto& key : keys) {
+      span->SetTag(key, "123");
+    }
+  }
+}
+BENCHMARK_CAPTURE(BM_SpanSetRegisteredTag2, rpc, "rpc");
+BENCHMARK_CAPTURE(BM_SpanSetRegisteredTag2, stream, "stream");
+
 //--------------------------------------------------------------------------------------------------
 // BM_SpanLog1
 //--------------------------------------------------------------------------------------------------
@@ -261,6 +352,44 @@ static void BM_SpanLog1(benchmark::State& state, const char* tracer_type) {
 BENCHMARK_CAPTURE(BM_SpanLog1, rpc, "rpc");
 BENCHMARK_CAPTURE(BM_SpanLog1, stream, "stream");
 
+//--------------------------------------------------------------------------------------------------
+// BM_SpanLogStructured
+//--------------------------------------------------------------------------------------------------
+static void BM_SpanLogStructured(benchmark::State& state,
+                                 const char* tracer_type) {
+  auto tracer = MakeTracer(tracer_type);
+  assert(tracer != nullptr);
+  opentracing::Value payload = opentracing::Dictionary{
+      {"user", "abc\n123"},
+      {"ids", opentracing::Values{1, 2, 3, 4, 5}},
+      {"request", opentracing::Dictionary{{"method", "GET"},
+                                          {"status", 200},
+                                          {"latency", 1.5}}}};
+  for (auto _ : state) {
+    auto span = tracer->StartSpan("abc123");
+    span->Log({{"event", payload}});
+  }
+}
+BENCHMARK_CAPTURE(BM_SpanLogStructured, rpc, "rpc");
+BENCHMARK_CAPTURE(BM_SpanLogStructured, stream, "stream");
+
+//--------------------------------------------------------------------------------------------------
+// BM_SpanTypedLog1
+//--------------------------------------------------------------------------------------------------
+static void BM_SpanTypedLog1(benchmark::State& state, const char* tracer_type) {
+  auto tracer = std::static_pointer_cast<lightstep::LightStepTracer>(
+      MakeTracer(tracer_type));
+  assert(tracer != nullptr);
+  auto operation_name =
+      lightstep::LightStepTracer::RegisterOperationName("abc123");
+  for (auto _ : state) {
+    auto span = tracer->StartSpan(operation_name);
+    span->Log("abc", 123);
+  }
+}
+BENCHMARK_CAPTURE(BM_SpanTypedLog1, rpc, "rpc");
+BENCHMARK_CAPTURE(BM_SpanTypedLog1, stream, "stream");
+
 //--------------------------------------------------------------------------------------------------
 // BM_SpanLog2
 //--------------------------------------------------------------------------------------------------
@@ -0,0 +1,85 @@
+#include "benchmark/benchmark.h"
+
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "common/fragment_array_input_stream.h"
+#include "network/socket.h"
+#include "network/vector_write.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+using namespace lightstep;
+
+// The number of fragments written each iteration; about what a flush of a
+// thousand small spans produces.
+const int NumFragments = 10000;
+
+//--------------------------------------------------------------------------------------------------
+// DrainSocket
+//--------------------------------------------------------------------------------------------------
+static void DrainSocket(FileDescriptor file_descriptor) noexcept {
+  std::array<char, 1 << 16> buffer;
+  while (::read(file_descriptor, static_cast<void*>(buffer.data()),
+                buffer.size()) > 0) {
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// RunWrites
+//--------------------------------------------------------------------------------------------------
+static void RunWrites(benchmark::State& state,
+                      FragmentCoalescer* coalescer) noexcept {
+  auto fragment_size = static_cast<int>(state.range(0));
+  int descriptors[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, descriptors) != 0) {
+    std::cerr << "socketpair failed\n";
+    std::terminate();
+  }
+  std::unique_ptr<Socket> writer_socket{new Socket{descriptors[0]}};
+  Socket reader_socket{descriptors[1]};
+  std::thread reader{DrainSocket, reader_socket.file_descriptor()};
+
+  std::string data(static_cast<size_t>(fragment_size), 'X');
+  for (auto _ : state) {
+    FragmentArrayInputStream fragments;
+    for (int i = 0; i < NumFragments; ++i) {
+      fragments.Add(Fragment{static_cast<void*>(&data[0]), fragment_size});
+    }
+    if (!Write(writer_socket->file_descriptor(), {&fragments}, coalescer)) {
+      std::cerr << "Write failed\n";
+      std::terminate();
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          NumFragments * fragment_size);
+
+  writer_socket.reset();
+  reader.join();
+}
+
+//--------------------------------------------------------------------------------------------------
+// BM_Write
+//--------------------------------------------------------------------------------------------------
+static void BM_Write(benchmark::State& state) { RunWrites(state, nullptr); }
+
+BENCHMARK(BM_Write)->Arg(16)->Arg(64)->Arg(256)->Arg(1024);
+
+//--------------------------------------------------------------------------------------------------
+// BM_CoalescedWrite
+//--------------------------------------------------------------------------------------------------
+static void BM_CoalescedWrite(benchmark::State& state) {
+  FragmentCoalescer coalescer{512, 512, 1024 * 1024};
+  RunWrites(state, &coalescer);
+}
+
+BENCHMARK(BM_CoalescedWrite)->Arg(16)->Arg(64)->Arg(256)->Arg(1024);
+
+//--------------------------------------------------------------------------------------------------
+// BENCHMARK_MAIN
+//--------------------------------------------------------------------------------------------------
+BENCHMARK_MAIN();
@@ -14,6 +14,7 @@ add_custom_command(
  ARGS "--proto_path=${PROTO_PATH}"
       "--cpp_out=${GENERATED_PROTOBUF_PATH}"
       ${TRACER_CONFIGURATION_PROTO}
+ DEPENDS ${TRACER_CONFIGURATION_PROTO}
 )
 
 include_directories(SYSTEM ${GENERATED_PROTOBUF_PATH})
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace lightstep {
 // MetricsObserver can be used to track LightStep tracer events.
 class MetricsObserver {
@@ -23,5 +25,8 @@ class MetricsObserver {
 
   // OnFlush records flush events by the recorder.
   virtual void OnFlush() noexcept {}
+
+  // OnBytesDropped records the serialized size of spans dropped.
+  virtual void OnBytesDropped(size_t /*num_bytes*/) noexcept {}
 };
 }  // namespace lightstep
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <opentracing/string_view.h>
+
+namespace lightstep {
+// Sampler decides whether a trace started by the tracer is sampled.
+//
+// Samplers are only consulted for root spans; a span with references inherits
+// the sampling decision of the spans it references. In both cases, an explicit
+// `sampling.priority` tag overrides the decision.
+//
+// Note: ShouldSample can be called concurrently from multiple threads.
+class Sampler {
+ public:
+  Sampler() noexcept = default;
+
+  Sampler(const Sampler&) = delete;
+  Sampler(Sampler&&) = delete;
+
+  virtual ~Sampler() = default;
+
+  Sampler& operator=(const Sampler&) = delete;
+  Sampler& operator=(Sampler&&) = delete;
+
+  // ShouldSample returns true if the trace with the given id and root
+  // operation should be sampled.
+  virtual bool ShouldSample(
+      uint64_t trace_id, opentracing::string_view operation_name) noexcept = 0;
+};
+
+// Returns a Sampler that samples the given fraction of traces, between 0 and
+// 1.
+//
+// The decision is derived from the trace id so that any tracer configured with
+// the same ratio makes the same decision for a given trace.
+std::unique_ptr<Sampler> MakeTraceIdRatioSampler(double ratio);
+
+// Returns a Sampler that samples at most `spans_per_second` traces for each
+// root operation name using a token bucket.
+std::unique_ptr<Sampler> MakeRateLimitingSampler(double spans_per_second);
+
+// Returns a Sampler that targets a budget of `spans_per_second` sampled traces
+// across all operations.
+//
+// The fraction of sampled traces is adjusted every second from the observed
+// rate of new traces, and a token bucket caps bursts in between.
+std::unique_ptr<Sampler> MakeAdaptiveSampler(double spans_per_second);
+}  // namespace lightstep
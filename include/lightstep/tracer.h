@@ -1,6 +1,7 @@
 #pragma once
 
 #include <lightstep/metrics_observer.h>
+#include <lightstep/sampler.h>
 #include <lightstep/transporter.h>
 #include <opentracing/tracer.h>
 #include <opentracing/value.h>
@@ -8,7 +9,10 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace lightstep {
@@ -85,6 +89,9 @@ struct LightStepTracerOptions {
 
   // A list of satellite endpoints to upload spans to.
   //
+  // A node-local satellite can be given as a unix domain socket with the host
+  // "unix:///path/to/socket", in which case the port is ignored.
+  //
   // Note: Only used when `use_stream_recorder` is true.
   std::vector<std::pair<std::string, uint16_t>> satellite_endpoints = {
       {"collector.lightstep.com", static_cast<uint16_t>(80)}};
@@ -118,6 +125,14 @@ struct LightStepTracerOptions {
   // before sending them to a collector.
   DynamicConfigurationValue<size_t> max_buffered_spans = 2000;
 
+  // `max_buffered_bytes` is the maximum number of bytes of serialized spans
+  // that will be buffered before sending them to a collector. Spans that would
+  // exceed it are dropped. If zero, only `max_buffered_spans` applies.
+  //
+  // Note: `max_buffered_bytes` isn't supported when `use_thread` is true and
+  // `transporter` is a SyncTransporter.
+  size_t max_buffered_bytes = 0;
+
   // If `use_thread` is true, then the tracer will internally manage a thread to
   // regularly send reports to the collector; otherwise, if false,
   // LightStepTracer::Flush must be manually invoked to send reports.
@@ -130,6 +145,15 @@ struct LightStepTracerOptions {
   // Enable streaming recorder for faster uploading of spans.
   bool use_stream_recorder = false;
 
+  // If `use_contiguous_span_buffer` is true, the streaming recorder copies
+  // finished spans into a single preallocated ring of `max_buffered_bytes`
+  // bytes (or 4 MiB, if `max_buffered_bytes` is zero) instead of buffering
+  // each span separately. Spans are then sent to satellites with fewer, larger
+  // writes and recording a span doesn't allocate memory.
+  //
+  // Note: `max_buffered_spans` doesn't apply when this is enabled.
+  bool use_contiguous_span_buffer = false;
+
   // `reporting_period` is the maximum duration of time between sending spans
   // to a collector.  If zero, the default will be used; and ignored if
   // `use_thread` is false.
@@ -141,22 +165,204 @@ struct LightStepTracerOptions {
   // collector. Ignored if a custom transport is used.
   std::chrono::system_clock::duration report_timeout = std::chrono::seconds{5};
 
+  // `max_concurrent_reports` is the maximum number of reports that can be
+  // waiting on a response from the collector at once. When reached, the
+  // tracer's thread waits for a report to complete before sending another.
+  // Ignored if a custom transporter is used or `use_thread` is false.
+  size_t max_concurrent_reports = 4;
+
+  // `max_report_spans` and `max_report_bytes` bound the number of spans and
+  // bytes of serialized spans sent in a single report. A flush of more spans
+  // is split into several reports that are handed to the transporter together.
+  // Zero, the default, disables the corresponding limit. A single span larger
+  // than `max_report_bytes` is still sent, in a report of its own.
+  //
+  // Note: Ignored unless the transporter is asynchronous. Once a flush can be
+  // split, the transporter must handle calls to AsyncTransporter::Send before
+  // earlier reports complete.
+  size_t max_report_spans = 0;
+  size_t max_report_bytes = 0;
+
   // `transporter` customizes how spans are sent when flushed. If null, then a
   // default transporter is used.
   //
   // If `use_thread` is false, `transporter` should be derived from
-  // LegacyAsyncTransporter; otherwise, it must be derived from SyncTransporter.
+  // AsyncTransporter or LegacyAsyncTransporter; otherwise, it must be derived
+  // from AsyncTransporter or SyncTransporter. With `use_thread`, an
+  // AsyncTransporter is sent reports from the tracer's thread and spans are
+  // serialized as they finish instead of being built up as protobuf messages.
   std::unique_ptr<Transporter> transporter;
 
   // `metrics_observer` can be optionally provided to track LightStep tracer
   // events. See MetricsObserver.
   std::unique_ptr<MetricsObserver> metrics_observer;
+
+  // `sampler` decides whether traces started by this tracer are sampled. If
+  // null, every trace is sampled. See lightstep/sampler.h.
+  std::unique_ptr<Sampler> sampler;
+};
+
+// A string whose protobuf serialization is computed once up front so that it
+// can be copied directly into spans.
+class PreEncodedString {
+ public:
+  PreEncodedString() noexcept = default;
+
+  // Returns the original string.
+  opentracing::string_view value() const noexcept {
+    return opentracing::string_view{serialization_.data() + value_offset_,
+                                    serialization_.size() - value_offset_};
+  }
+
+  // Returns the string's serialization, including its protobuf field key and
+  // length prefix.
+  opentracing::string_view serialization() const noexcept {
+    return serialization_;
+  }
+
+ protected:
+  PreEncodedString(std::string&& serialization, size_t value_size) noexcept
+      : serialization_{std::move(serialization)},
+        value_offset_{serialization_.size() - value_size} {}
+
+ private:
+  std::string serialization_;
+  size_t value_offset_{0};
+};
+
+// A handle to an operation name registered with
+// LightStepTracer::RegisterOperationName.
+class OperationNameHandle : public PreEncodedString {
+ public:
+  OperationNameHandle() noexcept = default;
+
+ private:
+  friend class LightStepTracer;
+
+  OperationNameHandle(std::string&& serialization, size_t value_size) noexcept
+      : PreEncodedString{std::move(serialization), value_size} {}
+};
+
+// A handle to a tag key registered with LightStepTracer::RegisterTagKey.
+class TagKeyHandle : public PreEncodedString {
+ public:
+  TagKeyHandle() noexcept = default;
+
+ private:
+  friend class LightStepTracer;
+
+  TagKeyHandle(std::string&& serialization, size_t value_size) noexcept
+      : PreEncodedString{std::move(serialization), value_size} {}
+};
+
+// The LightStepSpan interface extends opentracing::Span with methods that
+// accept pre-encoded tag keys and typed values.
+//
+// Tags and logs whose values are bools, numbers, or strings are serialized
+// directly instead of being converted to an opentracing::Value.
+class LightStepSpan : public opentracing::Span {
+  template <class T>
+  struct IsTypedValue
+      : std::integral_constant<
+            bool, std::is_arithmetic<T>::value ||
+                      (std::is_convertible<const T&,
+                                           opentracing::string_view>::value &&
+                       !std::is_same<T, std::nullptr_t>::value)> {};
+
+  template <class T>
+  using TypedValue = typename std::conditional<
+      std::is_same<T, bool>::value, bool,
+      typename std::conditional<
+          std::is_integral<T>::value, int64_t,
+          typename std::conditional<std::is_floating_point<T>::value, double,
+                                    opentracing::string_view>::type>::type>::
+      type;
+
+ public:
+  using opentracing::Span::Log;
+  using opentracing::Span::SetTag;
+
+  virtual void SetTag(const TagKeyHandle& key,
+                      const opentracing::Value& value) noexcept = 0;
+
+  template <class T>
+  typename std::enable_if<IsTypedValue<T>::value>::type SetTag(
+      opentracing::string_view key, const T& value) noexcept {
+    SetTypedTag(key, nullptr, static_cast<TypedValue<T>>(value));
+  }
+
+  template <class T>
+  typename std::enable_if<IsTypedValue<T>::value>::type SetTag(
+      const TagKeyHandle& key, const T& value) noexcept {
+    SetTypedTag(key.value(), &key, static_cast<TypedValue<T>>(value));
+  }
+
+  // Logs a record with a single field.
+  template <class T>
+  typename std::enable_if<IsTypedValue<T>::value>::type Log(
+      opentracing::string_view key, const T& value) noexcept {
+    LogTypedField(key, static_cast<TypedValue<T>>(value));
+  }
+
+ protected:
+  // key_handle is the pre-encoded key if the tag was set with one or nullptr.
+  virtual void SetTypedTag(opentracing::string_view key,
+                           const TagKeyHandle* key_handle,
+                           bool value) noexcept = 0;
+
+  virtual void SetTypedTag(opentracing::string_view key,
+                           const TagKeyHandle* key_handle,
+                           int64_t value) noexcept = 0;
+
+  virtual void SetTypedTag(opentracing::string_view key,
+                           const TagKeyHandle* key_handle,
+                           double value) noexcept = 0;
+
+  virtual void SetTypedTag(opentracing::string_view key,
+                           const TagKeyHandle* key_handle,
+                           opentracing::string_view value) noexcept = 0;
+
+  virtual void LogTypedField(opentracing::string_view key,
+                             bool value) noexcept = 0;
+
+  virtual void LogTypedField(opentracing::string_view key,
+                             int64_t value) noexcept = 0;
+
+  virtual void LogTypedField(opentracing::string_view key,
+                             double value) noexcept = 0;
+
+  virtual void LogTypedField(opentracing::string_view key,
+                             opentracing::string_view value) noexcept = 0;
 };
 
 // The LightStepTracer interface can be used by custom carriers that need more
 // direct access to a span context's data so as to propagate more efficiently.
 class LightStepTracer : public opentracing::Tracer {
  public:
+  using opentracing::Tracer::StartSpan;
+  using opentracing::Tracer::StartSpanWithOptions;
+
+  // Registers an operation name so that spans started with the returned
+  // handle copy its precomputed serialization instead of re-encoding it.
+  static OperationNameHandle RegisterOperationName(
+      opentracing::string_view operation_name);
+
+  // Registers a tag key so that tags set with the returned handle copy its
+  // precomputed serialization instead of re-encoding it.
+  static TagKeyHandle RegisterTagKey(opentracing::string_view key);
+
+  std::unique_ptr<LightStepSpan> StartSpan(
+      const OperationNameHandle& operation_name,
+      std::initializer_list<
+          opentracing::option_wrapper<opentracing::StartSpanOption>>
+          option_list = {}) const noexcept {
+    opentracing::StartSpanOptions options;
+    for (const auto& option : option_list) {
+      option.get().Apply(options);
+    }
+    return this->StartSpanWithOptions(operation_name, options);
+  }
+
   opentracing::expected<std::array<uint64_t, 3>> GetTraceSpanIdsSampled(
       const opentracing::SpanContext& span_context) const noexcept;
 
@@ -177,6 +383,17 @@ class LightStepTracer : public opentracing::Tracer {
   virtual bool FlushWithTimeout(
       std::chrono::system_clock::duration timeout) noexcept = 0;
 
+  // Starts a span whose operation name is a registered handle. LightStep's own
+  // tracers copy the handle's serialization; by default, the span is started
+  // from the handle's string value with the string overload.
+  //
+  // Note: This is declared after the other virtual functions so that it
+  // doesn't shift their vtable slots for tracers built against an older
+  // version of this header.
+  virtual std::unique_ptr<LightStepSpan> StartSpanWithOptions(
+      const OperationNameHandle& operation_name,
+      const opentracing::StartSpanOptions& options) const noexcept;
+
   template <class Rep, class Period>
   bool FlushWithTimeout(std::chrono::duration<Rep, Period> timeout) noexcept {
     return this->FlushWithTimeout(
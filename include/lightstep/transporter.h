@@ -113,6 +113,11 @@ class AsyncTransporter : public Transporter {
    * Send a ReportRequest
    * @param message a BufferChain representing the ReportRequest's serialization
    * @param callback a Callback to be called after message is transported
+   *
+   * Note: If LightStepTracerOptions::max_report_spans or max_report_bytes is
+   * set, a flush can be split into several ReportRequests that are sent one
+   * after another without waiting for their callbacks, so Send may be called
+   * while earlier messages are still being transported.
    */
   virtual void Send(std::unique_ptr<BufferChain>&& message,
                     Callback& callback) noexcept = 0;
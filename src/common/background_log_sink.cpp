@@ -0,0 +1,156 @@
+#include "common/background_log_sink.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+BackgroundLogSink::BackgroundLogSink(
+    std::function<void(LogLevel, opentracing::string_view)>&& sink,
+    size_t max_records)
+    : sink_{std::move(sink)}, records_(max_records) {
+  Start();
+}
+
+//--------------------------------------------------------------------------------------------------
+// destructor
+//--------------------------------------------------------------------------------------------------
+BackgroundLogSink::~BackgroundLogSink() noexcept { Stop(); }
+
+//--------------------------------------------------------------------------------------------------
+// operator()
+//--------------------------------------------------------------------------------------------------
+void BackgroundLogSink::operator()(LogLevel level,
+                                   opentracing::string_view message) noexcept {
+  {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    if (num_records_ == records_.size()) {
+      ++num_dropped_;
+      ++num_dropped_unreported_;
+      return;
+    }
+    auto& record = records_[(first_ + num_records_) % records_.size()];
+    record.level = level;
+    record.size = std::min(message.size(), MaxLogMessageSize);
+    std::memcpy(static_cast<void*>(record.message),
+                static_cast<const void*>(message.data()), record.size);
+    ++num_records_;
+  }
+  condition_variable_.notify_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Flush
+//--------------------------------------------------------------------------------------------------
+void BackgroundLogSink::Flush() noexcept {
+  std::unique_lock<std::mutex> lock{mutex_};
+  condition_variable_.wait(lock, [this] { return IsFlushed(); });
+}
+
+//--------------------------------------------------------------------------------------------------
+// FlushWithTimeout
+//--------------------------------------------------------------------------------------------------
+bool BackgroundLogSink::FlushWithTimeout(
+    std::chrono::system_clock::duration timeout) noexcept {
+  std::unique_lock<std::mutex> lock{mutex_};
+  return condition_variable_.wait_for(lock, timeout,
+                                      [this] { return IsFlushed(); });
+}
+
+//--------------------------------------------------------------------------------------------------
+// Stop
+//--------------------------------------------------------------------------------------------------
+void BackgroundLogSink::Stop() noexcept {
+  {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    if (!running_) {
+      return;
+    }
+    exit_ = true;
+  }
+  condition_variable_.notify_all();
+  thread_.join();
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  exit_ = false;
+  running_ = false;
+  condition_variable_.notify_all();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Start
+//--------------------------------------------------------------------------------------------------
+void BackgroundLogSink::Start() {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  if (running_) {
+    return;
+  }
+  thread_ = std::thread{&BackgroundLogSink::Run, this};
+  running_ = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// num_dropped
+//--------------------------------------------------------------------------------------------------
+int64_t BackgroundLogSink::num_dropped() const noexcept {
+  std::lock_guard<std::mutex> lock_guard{mutex_};
+  return num_dropped_;
+}
+
+//--------------------------------------------------------------------------------------------------
+// IsFlushed
+//--------------------------------------------------------------------------------------------------
+bool BackgroundLogSink::IsFlushed() const noexcept {
+  return !running_ ||
+         (num_records_ == 0 && num_dropped_unreported_ == 0 && !busy_);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Run
+//--------------------------------------------------------------------------------------------------
+void BackgroundLogSink::Run() noexcept {
+  Record record;
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true) {
+    condition_variable_.wait(lock, [this] {
+      return exit_ || num_records_ > 0 || num_dropped_unreported_ > 0;
+    });
+    if (num_records_ == 0 && num_dropped_unreported_ == 0) {
+      return;
+    }
+    auto num_dropped = num_dropped_unreported_;
+    num_dropped_unreported_ = 0;
+    auto has_record = num_records_ > 0;
+    if (has_record) {
+      auto& front = records_[first_];
+      record.level = front.level;
+      record.size = front.size;
+      std::memcpy(static_cast<void*>(record.message),
+                  static_cast<const void*>(front.message), front.size);
+      first_ = (first_ + 1) % records_.size();
+      --num_records_;
+    }
+    busy_ = true;
+    lock.unlock();
+    try {
+      if (num_dropped > 0) {
+        auto& buffer = LogMessageBuffer::GetThreadInstance();
+        Concatenate(buffer, "Dropped ", num_dropped,
+                    " log messages: the log queue was full");
+        sink_(LogLevel::warn, buffer.message());
+      }
+      if (has_record) {
+        sink_(record.level,
+              opentracing::string_view{record.message, record.size});
+      }
+    } catch (const std::exception& /*e*/) {
+      // Ignore exceptions.
+    }
+    lock.lock();
+    busy_ = false;
+    condition_variable_.notify_all();
+  }
+}
+}  // namespace lightstep
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/logger.h"
+#include "common/noncopyable.h"
+
+namespace lightstep {
+/**
+ * A log sink that queues records and passes them to another sink from a
+ * background thread so that logging threads never wait on the sink.
+ *
+ * Records are copied into a fixed number of preallocated slots. If the queue
+ * is full, records are dropped and a count of them is logged once there's
+ * space again.
+ */
+class BackgroundLogSink : private Noncopyable {
+ public:
+  /**
+   * @param sink the sink to forward records to
+   * @param max_records the maximum number of records to queue; must be
+   * positive
+   */
+  BackgroundLogSink(
+      std::function<void(LogLevel, opentracing::string_view)>&& sink,
+      size_t max_records);
+
+  ~BackgroundLogSink() noexcept;
+
+  /**
+   * Queues a record.
+   * @param level the level of the record
+   * @param message the message of the record
+   */
+  void operator()(LogLevel level, opentracing::string_view message) noexcept;
+
+  /**
+   * Waits until every queued record has been passed to the sink. Returns
+   * immediately if the background thread is stopped.
+   */
+  void Flush() noexcept;
+
+  /**
+   * Waits until every queued record has been passed to the sink or the timeout
+   * elapses. Returns immediately if the background thread is stopped.
+   * @param timeout the maximum amount of time to wait
+   * @return true if the queue was drained or the background thread is stopped
+   */
+  bool FlushWithTimeout(std::chrono::system_clock::duration timeout) noexcept;
+
+  /**
+   * Passes any queued records to the sink and stops the background thread.
+   *
+   * Records queued while stopped are held until the thread is started again.
+   */
+  void Stop() noexcept;
+
+  /**
+   * Starts the background thread if it isn't running.
+   *
+   * Note: Start and Stop must not be called concurrently with each other.
+   */
+  void Start();
+
+  /**
+   * @return the number of records dropped because the queue was full.
+   */
+  int64_t num_dropped() const noexcept;
+
+ private:
+  struct Record {
+    LogLevel level;
+    size_t size;
+    char message[MaxLogMessageSize];
+  };
+
+  std::function<void(LogLevel, opentracing::string_view)> sink_;
+  std::vector<Record> records_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  size_t first_{0};
+  size_t num_records_{0};
+  bool running_{false};
+  bool busy_{false};
+  bool exit_{false};
+  int64_t num_dropped_{0};
+  int64_t num_dropped_unreported_{0};
+  std::thread thread_;
+
+  bool IsFlushed() const noexcept;
+
+  void Run() noexcept;
+};
+}  // namespace lightstep
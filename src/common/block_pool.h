@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+#include "common/noncopyable.h"
+#include "common/platform/fork.h"
+#include "common/spin_lock_mutex.h"
+
+namespace lightstep {
+/**
+ * Counters describing how effectively a BlockPool recycles memory.
+ */
+struct BlockPoolStats {
+  // The number of allocations served from recycled blocks.
+  uint64_t num_hits;
+
+  // The number of allocations that had to fall back to the heap.
+  uint64_t num_misses;
+
+  // The number of freed blocks returned to the heap because the pool was full.
+  uint64_t num_overflows;
+};
+
+/**
+ * Recycles the memory for objects of type T.
+ *
+ * Each thread keeps a bounded cache of free blocks so that allocating and
+ * freeing are cheap and uncontended. Threads exchange blocks in batches through
+ * a bounded central free list so that memory freed on one thread (e.g. the
+ * recorder thread after uploading spans) can be reused by another (e.g. an
+ * application thread starting spans) without a round trip through the heap.
+ *
+ * Hits are counted per thread and only published when a thread interacts with
+ * the central free list, so stats() may lag slightly behind.
+ */
+template <class T>
+class BlockPool {
+ public:
+  // The maximum number of free blocks kept in a thread's cache.
+  static const size_t MaxThreadCacheSize = 128;
+
+  // The number of blocks moved between a thread's cache and the central free
+  // list at a time.
+  static const size_t TransferBatchSize = 32;
+
+  // The maximum number of free blocks kept in the central free list.
+  static const size_t MaxCentralSize = 4096;
+
+  static_assert(TransferBatchSize <= MaxThreadCacheSize,
+                "TransferBatchSize too large");
+
+  /**
+   * Allocate a block large enough to hold a T.
+   * @return a pointer to the block
+   */
+  static void* Allocate() {
+    auto cache = GetThreadCache();
+    if (cache == nullptr) {
+      return AllocateFromCentral();
+    }
+    if (cache->size == 0) {
+      cache->Refill();
+      if (cache->size == 0) {
+        return AllocateFromHeap();
+      }
+    }
+    ++cache->num_hits;
+    return cache->blocks[--cache->size];
+  }
+
+  /**
+   * Return a block to the pool.
+   * @param ptr a pointer to a block previously returned from Allocate
+   */
+  static void Free(void* ptr) noexcept {
+    if (ptr == nullptr) {
+      return;
+    }
+    auto cache = GetThreadCache();
+    if (cache == nullptr) {
+      return FreeToCentral(ptr);
+    }
+    if (cache->size == MaxThreadCacheSize) {
+      cache->Drain();
+    }
+    cache->blocks[cache->size++] = ptr;
+  }
+
+  /**
+   * @return a snapshot of the pool's counters.
+   */
+  static BlockPoolStats stats() noexcept {
+    auto& central = GetCentral();
+    return {central.num_hits.load(std::memory_order_relaxed),
+            central.num_misses.load(std::memory_order_relaxed),
+            central.num_overflows.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  struct Central : private Noncopyable {
+    Central() : blocks{new void*[MaxCentralSize]} {
+      AtFork(Lock, Unlock, Unlock);
+    }
+
+    SpinLockMutex mutex;
+    std::unique_ptr<void*[]> blocks;
+    size_t size{0};
+
+    std::atomic<uint64_t> num_hits{0};
+    std::atomic<uint64_t> num_misses{0};
+    std::atomic<uint64_t> num_overflows{0};
+
+    // Ensure that a forked child process doesn't inherit a locked free list.
+    static void Lock() noexcept { GetCentral().mutex.lock(); }
+
+    static void Unlock() noexcept { GetCentral().mutex.unlock(); }
+  };
+
+  struct ThreadCache : private Noncopyable {
+    ThreadCache() noexcept = default;
+
+    ~ThreadCache() noexcept {
+      while (size > 0) {
+        Drain();
+      }
+      Publish();
+      IsThreadCacheDestroyed() = true;
+    }
+
+    std::array<void*, MaxThreadCacheSize> blocks;
+    size_t size{0};
+
+    uint64_t num_hits{0};
+
+    void Refill() noexcept {
+      auto& central = GetCentral();
+      {
+        SpinLockGuard lock_guard{central.mutex};
+        auto n = std::min(TransferBatchSize, central.size);
+        central.size -= n;
+        std::copy(central.blocks.get() + central.size,
+                  central.blocks.get() + central.size + n, blocks.data());
+        size = n;
+      }
+      Publish();
+    }
+
+    void Drain() noexcept {
+      auto& central = GetCentral();
+      auto n = std::min(TransferBatchSize, size);
+      size_t num_transferred;
+      {
+        SpinLockGuard lock_guard{central.mutex};
+        num_transferred = std::min(n, MaxCentralSize - central.size);
+        std::copy(blocks.data() + size - num_transferred, blocks.data() + size,
+                  central.blocks.get() + central.size);
+        central.size += num_transferred;
+      }
+      size -= num_transferred;
+      for (auto i = num_transferred; i < n; ++i) {
+        FreeToHeap(blocks[--size]);
+      }
+      Publish();
+    }
+
+    void Publish() noexcept {
+      GetCentral().num_hits.fetch_add(num_hits, std::memory_order_relaxed);
+      num_hits = 0;
+    }
+  };
+
+  static Central& GetCentral() noexcept {
+    // Note: The central free list is intentionally leaked so that it remains
+    // valid while thread caches and static objects are destroyed.
+    static Central* central = new Central{};
+    return *central;
+  }
+
+  static bool& IsThreadCacheDestroyed() noexcept {
+    static thread_local bool is_destroyed{false};
+    return is_destroyed;
+  }
+
+  static ThreadCache* GetThreadCache() noexcept {
+    // Blocks can still be freed while a thread is exiting after its cache was
+    // destroyed, so fall back to the central free list in that case.
+    if (IsThreadCacheDestroyed()) {
+      return nullptr;
+    }
+    static thread_local ThreadCache cache;
+    return &cache;
+  }
+
+  static void* AllocateFromCentral() {
+    auto& central = GetCentral();
+    {
+      SpinLockGuard lock_guard{central.mutex};
+      if (central.size > 0) {
+        central.num_hits.fetch_add(1, std::memory_order_relaxed);
+        return central.blocks[--central.size];
+      }
+    }
+    return AllocateFromHeap();
+  }
+
+  static void FreeToCentral(void* ptr) noexcept {
+    auto& central = GetCentral();
+    {
+      SpinLockGuard lock_guard{central.mutex};
+      if (central.size < MaxCentralSize) {
+        central.blocks[central.size++] = ptr;
+        return;
+      }
+    }
+    FreeToHeap(ptr);
+  }
+
+  static void* AllocateFromHeap() {
+    GetCentral().num_misses.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(sizeof(T));
+  }
+
+  static void FreeToHeap(void* ptr) noexcept {
+    GetCentral().num_overflows.fetch_add(1, std::memory_order_relaxed);
+    ::operator delete(ptr);
+  }
+};
+
+template <class T>
+const size_t BlockPool<T>::MaxThreadCacheSize;
+
+template <class T>
+const size_t BlockPool<T>::TransferBatchSize;
+
+template <class T>
+const size_t BlockPool<T>::MaxCentralSize;
+}  // namespace lightstep
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "common/noncopyable.h"
+
+namespace lightstep {
+/**
+ * Tracks the number of bytes held by a buffer against a maximum.
+ *
+ * Producers reserve bytes before adding to the buffer and the consumer
+ * releases them once they're removed. A maximum of 0 disables the budget, in
+ * which case nothing is tracked so that producers don't contend on the
+ * counter.
+ */
+class ByteBudget : private Noncopyable {
+ public:
+  /**
+   * @param max_bytes the maximum number of bytes or 0 for no limit
+   */
+  explicit ByteBudget(size_t max_bytes) noexcept : max_bytes_{max_bytes} {}
+
+  /**
+   * Reserve bytes from the budget.
+   * @param num_bytes the number of bytes to reserve
+   * @return true if the bytes were reserved; false, if they would exceed the
+   * budget.
+   */
+  bool Reserve(size_t num_bytes) noexcept {
+    if (max_bytes_ == 0) {
+      return true;
+    }
+    auto num_bytes_used = num_bytes_used_.load(std::memory_order_relaxed);
+    do {
+      if (num_bytes > max_bytes_ - num_bytes_used) {
+        return false;
+      }
+    } while (!num_bytes_used_.compare_exchange_weak(
+        num_bytes_used, num_bytes_used + num_bytes, std::memory_order_relaxed,
+        std::memory_order_relaxed));
+    return true;
+  }
+
+  /**
+   * Return previously reserved bytes to the budget.
+   * @param num_bytes the number of bytes to release
+   */
+  void Release(size_t num_bytes) noexcept {
+    if (max_bytes_ == 0) {
+      return;
+    }
+    num_bytes_used_.fetch_sub(num_bytes, std::memory_order_relaxed);
+  }
+
+  /**
+   * @return true if the budget has a limit.
+   */
+  bool is_limited() const noexcept { return max_bytes_ != 0; }
+
+  /**
+   * @return the maximum number of bytes or 0 if there's no limit.
+   */
+  size_t max_bytes() const noexcept { return max_bytes_; }
+
+  /**
+   * @return the number of bytes currently reserved.
+   */
+  size_t num_bytes_used() const noexcept {
+    return num_bytes_used_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  size_t max_bytes_;
+  std::atomic<size_t> num_bytes_used_{0};
+};
+}  // namespace lightstep
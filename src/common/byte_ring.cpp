@@ -0,0 +1,167 @@
+#include "common/byte_ring.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+ByteRing::ByteRing(size_t capacity)
+    : capacity_{capacity}, data_{new char[capacity]} {
+  assert(capacity > 0);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Reserve
+//--------------------------------------------------------------------------------------------------
+bool ByteRing::Reserve(size_t num_bytes, uint64_t& position) noexcept {
+  position = reserve_position_.value.load(std::memory_order_relaxed);
+  do {
+    auto consumer_position =
+        consumer_position_.value.load(std::memory_order_acquire);
+    if (position + num_bytes - consumer_position > capacity_) {
+      return false;
+    }
+  } while (!reserve_position_.value.compare_exchange_weak(
+      position, position + num_bytes, std::memory_order_relaxed,
+      std::memory_order_relaxed));
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Write
+//--------------------------------------------------------------------------------------------------
+void ByteRing::Write(uint64_t position, const void* data,
+                     size_t size) noexcept {
+  auto index = static_cast<size_t>(position % capacity_);
+  auto first_size = std::min(size, capacity_ - index);
+  std::memcpy(data_.get() + index, data, first_size);
+  std::memcpy(data_.get(), static_cast<const char*>(data) + first_size,
+              size - first_size);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Commit
+//--------------------------------------------------------------------------------------------------
+void ByteRing::Commit(uint64_t position, size_t num_bytes) noexcept {
+  auto last = position + num_bytes;
+  while (commit_position_.value.load() != position) {
+    if (!ParkCommit(position, last)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // If the earlier reservations were all committed before they could see
+    // the parked range, publish it ourselves.
+    if (commit_position_.value.load() != position ||
+        !UnparkCommit(position, last)) {
+      return;
+    }
+    break;
+  }
+  Publish(last);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ForEachFragment
+//--------------------------------------------------------------------------------------------------
+bool ByteRing::ForEachFragment(uint64_t first, uint64_t last,
+                               Callback callback) const noexcept {
+  assert(first <= last && last - first <= capacity_);
+  auto size = static_cast<size_t>(last - first);
+  if (size == 0) {
+    return true;
+  }
+  auto index = static_cast<size_t>(first % capacity_);
+  auto first_size = std::min(size, capacity_ - index);
+  if (!callback(static_cast<void*>(data_.get() + index),
+                static_cast<int>(first_size))) {
+    return false;
+  }
+  if (first_size == size) {
+    return true;
+  }
+  return callback(static_cast<void*>(data_.get()),
+                  static_cast<int>(size - first_size));
+}
+
+//--------------------------------------------------------------------------------------------------
+// Consume
+//--------------------------------------------------------------------------------------------------
+void ByteRing::Consume(size_t num_bytes) noexcept {
+  assert(num_bytes <= size());
+  consumer_position_.value.store(consumer_position() + num_bytes,
+                                 std::memory_order_release);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Reset
+//--------------------------------------------------------------------------------------------------
+void ByteRing::Reset() noexcept {
+  reserve_position_.value = 0;
+  commit_position_.value = 0;
+  consumer_position_.value = 0;
+  for (auto& pending_commit : pending_commits_) {
+    pending_commit.first = EmptySlot;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// ParkCommit
+//--------------------------------------------------------------------------------------------------
+bool ByteRing::ParkCommit(uint64_t first, uint64_t last) noexcept {
+  for (auto& pending_commit : pending_commits_) {
+    auto expected = EmptySlot;
+    if (!pending_commit.first.compare_exchange_strong(
+            expected, ReservingSlot, std::memory_order_relaxed)) {
+      continue;
+    }
+    pending_commit.last.store(last, std::memory_order_relaxed);
+    pending_commit.first.store(first);
+    return true;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// UnparkCommit
+//--------------------------------------------------------------------------------------------------
+bool ByteRing::UnparkCommit(uint64_t first, uint64_t& last) noexcept {
+  for (auto& pending_commit : pending_commits_) {
+    if (pending_commit.first.load() != first) {
+      continue;
+    }
+    // Positions are never reused, so if the slot still holds first after
+    // reading last, then last belongs to the same commit.
+    auto pending_last = pending_commit.last.load(std::memory_order_relaxed);
+    auto expected = first;
+    if (pending_commit.first.compare_exchange_strong(expected, EmptySlot)) {
+      last = pending_last;
+      return true;
+    }
+    return false;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Publish
+//--------------------------------------------------------------------------------------------------
+void ByteRing::Publish(uint64_t last) noexcept {
+  // Only the thread that committed the range ending at last can get here, so
+  // no other thread advances commit_position_ until the store below.
+  do {
+    commit_position_.value.store(last);
+  } while (UnparkCommit(last, last));
+}
+
+//--------------------------------------------------------------------------------------------------
+// static members
+//--------------------------------------------------------------------------------------------------
+const uint64_t ByteRing::EmptySlot;
+const uint64_t ByteRing::ReservingSlot;
+const size_t ByteRing::NumPendingCommits;
+}  // namespace lightstep
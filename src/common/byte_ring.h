@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "common/function_ref.h"
+#include "common/noncopyable.h"
+
+namespace lightstep {
+/**
+ * A preallocated circular buffer of bytes with multiple producers and a single
+ * consumer.
+ *
+ * Producers reserve space, copy their data into it, and then commit it.
+ * Commits are published in the order space was reserved so that the consumer
+ * always sees a single contiguous run of committed bytes, which it can access
+ * as at most two fragments.
+ *
+ * A producer that commits ahead of an earlier reservation doesn't wait for it.
+ * Instead, it parks its range in a small table of pending commits and returns;
+ * whichever thread commits the earlier reservation then publishes the parked
+ * ranges that follow it. Producers only wait if the table is full.
+ *
+ * Positions are absolute byte offsets that only ever increase; they're mapped
+ * into the ring modulo its capacity.
+ */
+class ByteRing : private Noncopyable {
+ public:
+  using Callback = FunctionRef<bool(void* data, int size)>;
+
+  /**
+   * @param capacity the number of bytes the ring can hold.
+   */
+  explicit ByteRing(size_t capacity);
+
+  /**
+   * Reserve space in the ring.
+   * @param num_bytes the number of bytes to reserve
+   * @param position outputs the position of the reserved space
+   * @return true if the space was reserved; false, if the ring doesn't have
+   * room.
+   */
+  bool Reserve(size_t num_bytes, uint64_t& position) noexcept;
+
+  /**
+   * Copy data into previously reserved space.
+   * @param position the position to copy to
+   * @param data the data to copy
+   * @param size the number of bytes to copy
+   */
+  void Write(uint64_t position, const void* data, size_t size) noexcept;
+
+  /**
+   * Publish reserved space to the consumer.
+   * @param position the position of the reserved space
+   * @param num_bytes the number of bytes reserved
+   *
+   * Note: This only waits for earlier reservations to be committed if too
+   * many commits are already pending.
+   */
+  void Commit(uint64_t position, size_t num_bytes) noexcept;
+
+  /**
+   * @param position a position in the ring
+   * @return the byte at position
+   *
+   * Note: This method must only be called from the consumer thread.
+   */
+  char at(uint64_t position) const noexcept {
+    return data_[position % capacity_];
+  }
+
+  /**
+   * Iterate over the contiguous fragments of a range of the ring.
+   * @param first the start of the range
+   * @param last the end of the range
+   * @param callback the callback to call for each fragment
+   * @return false if the iteration was interrupted early.
+   *
+   * Note: This method must only be called from the consumer thread.
+   */
+  bool ForEachFragment(uint64_t first, uint64_t last, Callback callback) const
+      noexcept;
+
+  /**
+   * Consume bytes from the ring's tail.
+   * @param num_bytes the number of bytes to consume
+   *
+   * Note: This method must only be called from the consumer thread.
+   */
+  void Consume(size_t num_bytes) noexcept;
+
+  /**
+   * Consume all the committed bytes.
+   *
+   * Note: This method must only be called from the consumer thread.
+   */
+  void Clear() noexcept { Consume(size()); }
+
+  /**
+   * Discard all bytes including those reserved but not yet committed.
+   *
+   * Note: This method must only be called when no producer can be using the
+   * ring (e.g. in a forked child process).
+   */
+  void Reset() noexcept;
+
+  /**
+   * @return the number of bytes the ring can hold.
+   */
+  size_t capacity() const noexcept { return capacity_; }
+
+  /**
+   * @return the position of the ring's tail.
+   */
+  uint64_t consumer_position() const noexcept {
+    return consumer_position_.value.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return the position of the end of the committed bytes.
+   */
+  uint64_t committed_position() const noexcept {
+    return commit_position_.value.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @return the number of committed bytes not yet consumed.
+   */
+  size_t size() const noexcept {
+    return static_cast<size_t>(committed_position() - consumer_position());
+  }
+
+  /**
+   * @return true if there are no committed bytes to consume.
+   */
+  bool empty() const noexcept { return size() == 0; }
+
+ private:
+  // The padding keeps the positions updated by producers and the consumer on
+  // different cache lines.
+  struct Position {
+    std::atomic<uint64_t> value{0};
+    char padding[64];
+  };
+
+  // A commit waiting on earlier reservations. first is EmptySlot when the slot
+  // is free and ReservingSlot while a producer is filling in last.
+  struct PendingCommit {
+    std::atomic<uint64_t> first{EmptySlot};
+    std::atomic<uint64_t> last{0};
+  };
+
+  static const uint64_t EmptySlot = ~uint64_t{0};
+  static const uint64_t ReservingSlot = EmptySlot - 1;
+  static const size_t NumPendingCommits = 32;
+
+  size_t capacity_;
+  std::unique_ptr<char[]> data_;
+
+  Position reserve_position_;
+  Position commit_position_;
+  Position consumer_position_;
+
+  PendingCommit pending_commits_[NumPendingCommits];
+
+  bool ParkCommit(uint64_t first, uint64_t last) noexcept;
+
+  bool UnparkCommit(uint64_t first, uint64_t& last) noexcept;
+
+  void Publish(uint64_t last) noexcept;
+};
+}  // namespace lightstep
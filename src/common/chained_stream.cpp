@@ -8,6 +8,46 @@ namespace lightstep {
 //--------------------------------------------------------------------------------------------------
 ChainedStream::ChainedStream() noexcept : current_block_{&head_} {}
 
+//--------------------------------------------------------------------------------------------------
+// operator new
+//--------------------------------------------------------------------------------------------------
+void* ChainedStream::operator new(size_t size) {
+  assert(size == sizeof(ChainedStream));
+  (void)size;
+  return BlockPool<ChainedStream>::Allocate();
+}
+
+void* ChainedStream::Block::operator new(size_t size) {
+  assert(size == sizeof(Block));
+  (void)size;
+  return BlockPool<Block>::Allocate();
+}
+
+//--------------------------------------------------------------------------------------------------
+// operator delete
+//--------------------------------------------------------------------------------------------------
+void ChainedStream::operator delete(void* ptr) noexcept {
+  BlockPool<ChainedStream>::Free(ptr);
+}
+
+void ChainedStream::Block::operator delete(void* ptr) noexcept {
+  BlockPool<Block>::Free(ptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// stream_pool_stats
+//--------------------------------------------------------------------------------------------------
+BlockPoolStats ChainedStream::stream_pool_stats() noexcept {
+  return BlockPool<ChainedStream>::stats();
+}
+
+//--------------------------------------------------------------------------------------------------
+// block_pool_stats
+//--------------------------------------------------------------------------------------------------
+BlockPoolStats ChainedStream::block_pool_stats() noexcept {
+  return BlockPool<Block>::stats();
+}
+
 //--------------------------------------------------------------------------------------------------
 // CloseOutput
 //--------------------------------------------------------------------------------------------------
@@ -31,7 +71,9 @@ bool ChainedStream::Next(void** data, int* size) {
     current_block_->size = BlockSize;
     return true;
   }
-  current_block_->next.reset(new Block{});
+  // Note: Use default-initialization so that we don't pay to zero the block's
+  // data.
+  current_block_->next.reset(new Block);
   current_block_ = current_block_->next.get();
   current_block_->size = BlockSize;
   current_block_position_ = BlockSize;
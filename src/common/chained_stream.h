@@ -5,6 +5,7 @@
 #include <limits>
 #include <memory>
 
+#include "common/block_pool.h"
 #include "common/composable_fragment_input_stream.h"
 #include "common/function_ref.h"
 #include "common/noncopyable.h"
@@ -23,6 +24,23 @@ class ChainedStream final : public google::protobuf::io::ZeroCopyOutputStream,
 
   ChainedStream() noexcept;
 
+  // ChainedStreams are recycled through a BlockPool so that streams freed by
+  // the recorder can be reused for new spans without going through the heap.
+  static void* operator new(size_t size);
+
+  static void operator delete(void* ptr) noexcept;
+
+  /**
+   * @return counters for the pool that recycles ChainedStreams.
+   */
+  static BlockPoolStats stream_pool_stats() noexcept;
+
+  /**
+   * @return counters for the pool that recycles the overflow blocks of
+   * ChainedStreams.
+   */
+  static BlockPoolStats block_pool_stats() noexcept;
+
   /**
    * Close the stream for output. After calling this, we can no longer write to
    * the stream, but we can interact with it as a FragmentInputStream.
@@ -52,6 +70,10 @@ class ChainedStream final : public google::protobuf::io::ZeroCopyOutputStream,
     std::unique_ptr<Block> next;
     int size;
     std::array<char, BlockSize> data;
+
+    static void* operator new(size_t size);
+
+    static void operator delete(void* ptr) noexcept;
   };
 
   bool output_closed_{false};
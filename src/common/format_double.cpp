@@ -0,0 +1,49 @@
+#include "common/format_double.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// FormatDouble
+//--------------------------------------------------------------------------------------------------
+size_t FormatDouble(double x, char* buffer, size_t buffer_size) noexcept {
+  if (buffer_size == 0) {
+    return 0;
+  }
+  auto result = std::snprintf(buffer, buffer_size, "%g", x);
+  if (result <= 0) {
+    buffer[0] = '\0';
+    return 0;
+  }
+  auto size = std::min(static_cast<size_t>(result), buffer_size - 1);
+  size = DelocalizeRadix(buffer, size);
+  buffer[size] = '\0';
+  return size;
+}
+
+//--------------------------------------------------------------------------------------------------
+// DelocalizeRadix
+//--------------------------------------------------------------------------------------------------
+size_t DelocalizeRadix(char* buffer, size_t size) noexcept {
+  auto last = buffer + size;
+  auto iter = buffer;
+  if (iter != last && (*iter == '-' || *iter == '+')) {
+    ++iter;
+  }
+  auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+  auto digits_first = iter;
+  iter = std::find_if_not(iter, last, is_digit);
+  if (iter == digits_first || iter == last || *iter == '.' || *iter == 'e' ||
+      *iter == 'E') {
+    return size;
+  }
+  // The radix may take more than a single character.
+  auto radix_last = std::find_if(iter, last, is_digit);
+  *iter++ = '.';
+  std::memmove(static_cast<void*>(iter), static_cast<const void*>(radix_last),
+               static_cast<size_t>(last - radix_last));
+  return size - static_cast<size_t>(radix_last - iter);
+}
+}  // namespace lightstep
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lightstep {
+/**
+ * Formats a double like printf's %g, but always with '.' as the radix
+ * character.
+ *
+ * snprintf uses the radix character of the C locale, so locales such as de_DE
+ * would otherwise format 1.5 as "1,5".
+ * @param x the number to format
+ * @param buffer where to write the number
+ * @param buffer_size the size of buffer
+ * @return the number of characters written, which is 0 if formatting failed.
+ * A number that doesn't fit is truncated, and buffer is always left null
+ * terminated.
+ */
+size_t FormatDouble(double x, char* buffer, size_t buffer_size) noexcept;
+
+/**
+ * Replaces a locale's radix character in a formatted number with '.'.
+ * @param buffer the formatted number
+ * @param size the size of the formatted number
+ * @return the new size of the formatted number
+ */
+size_t DelocalizeRadix(char* buffer, size_t size) noexcept;
+}  // namespace lightstep
@@ -0,0 +1,310 @@
+#include "common/json_serialization.h"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "common/direct_coded_output_stream.h"
+#include "common/format_double.h"
+
+#include <google/protobuf/io/coded_stream.h>
+
+namespace lightstep {
+// Large enough to hold any 64-bit integer or any double formatted with %g.
+static const size_t MaxNumberSize = 32;
+
+//--------------------------------------------------------------------------------------------------
+// FormatNumber
+//--------------------------------------------------------------------------------------------------
+static opentracing::string_view FormatNumber(uint64_t x, bool is_negative,
+                                             char* buffer) noexcept {
+  auto last = buffer + MaxNumberSize;
+  auto first = last;
+  do {
+    *--first = static_cast<char>('0' + x % 10);
+    x /= 10;
+  } while (x != 0);
+  if (is_negative) {
+    *--first = '-';
+  }
+  return opentracing::string_view{first, static_cast<size_t>(last - first)};
+}
+
+static opentracing::string_view FormatNumber(int64_t x,
+                                             char* buffer) noexcept {
+  if (x < 0) {
+    // Negate as unsigned so that the minimum value doesn't overflow.
+    return FormatNumber(0 - static_cast<uint64_t>(x), true, buffer);
+  }
+  return FormatNumber(static_cast<uint64_t>(x), false, buffer);
+}
+
+// Returns the JSON for a double. NaN and infinities have no JSON
+// representation so they're written as strings.
+static opentracing::string_view FormatNumber(double x, char* buffer) noexcept {
+  if (std::isnan(x)) {
+    return R"("NaN")";
+  }
+  if (std::isinf(x)) {
+    return std::signbit(x) ? R"("-Inf")" : R"("+Inf")";
+  }
+  return opentracing::string_view{buffer,
+                                  FormatDouble(x, buffer, MaxNumberSize)};
+}
+
+//--------------------------------------------------------------------------------------------------
+// ComputeEscapedCharacterSize
+//--------------------------------------------------------------------------------------------------
+// The escaping rules are based off of this answer from StackOverflow:
+// https://stackoverflow.com/a/33799784
+//
+// Returns the number of bytes needed to encode a character in a JSON string.
+static size_t ComputeEscapedCharacterSize(char c_prime) noexcept {
+  auto c = static_cast<signed char>(c_prime);
+  switch (c) {
+    case '"':
+    case '\\':
+    case '\b':
+    case '\n':
+    case '\r':
+    case '\t':
+      return 2;
+    default:
+      if (static_cast<signed char>('\x00') <= c &&
+          c <= static_cast<signed char>('\x1f')) {
+        return 6;  // \u00XX
+      }
+      return 1;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// ComputeEscapedStringSize
+//--------------------------------------------------------------------------------------------------
+static size_t ComputeEscapedStringSize(opentracing::string_view s) noexcept {
+  size_t result = 2;  // quotes
+  for (auto c : s) {
+    result += ComputeEscapedCharacterSize(c);
+  }
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// WriteRaw
+//--------------------------------------------------------------------------------------------------
+template <class Stream>
+static void WriteRaw(Stream& stream, opentracing::string_view s) {
+  stream.WriteRaw(static_cast<const void*>(s.data()), s.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+// WriteEscapedString
+//--------------------------------------------------------------------------------------------------
+template <class Stream>
+static void WriteEscapedString(Stream& stream, opentracing::string_view s) {
+  static const char* const HexDigits = "0123456789abcdef";
+  WriteRaw(stream, "\"");
+  auto run_first = s.data();
+  auto last = s.data() + s.size();
+  for (auto iter = run_first; iter != last; ++iter) {
+    if (ComputeEscapedCharacterSize(*iter) == 1) {
+      continue;
+    }
+    WriteRaw(stream, opentracing::string_view{
+                         run_first, static_cast<size_t>(iter - run_first)});
+    run_first = iter + 1;
+    switch (*iter) {
+      case '"':
+        WriteRaw(stream, R"(\")");
+        break;
+      case '\\':
+        WriteRaw(stream, R"(\\)");
+        break;
+      case '\b':
+        WriteRaw(stream, R"(\b)");
+        break;
+      case '\n':
+        WriteRaw(stream, R"(\n)");
+        break;
+      case '\r':
+        WriteRaw(stream, R"(\r)");
+        break;
+      case '\t':
+        WriteRaw(stream, R"(\t)");
+        break;
+      default:
+        char escape[6] = {'\\',
+                          'u',
+                          '0',
+                          '0',
+                          HexDigits[(*iter >> 4) & 0xf],
+                          HexDigits[*iter & 0xf]};
+        WriteRaw(stream, opentracing::string_view{escape, sizeof(escape)});
+    }
+  }
+  WriteRaw(stream, opentracing::string_view{
+                       run_first, static_cast<size_t>(last - run_first)});
+  WriteRaw(stream, "\"");
+}
+
+//--------------------------------------------------------------------------------------------------
+// JsonSizeValueVisitor
+//--------------------------------------------------------------------------------------------------
+namespace {
+struct JsonSizeValueVisitor {
+  size_t& result;
+
+  void operator()(bool value) const noexcept {
+    result += value ? sizeof("true") - 1 : sizeof("false") - 1;
+  }
+
+  void operator()(double value) const noexcept {
+    char buffer[MaxNumberSize];
+    result += FormatNumber(value, buffer).size();
+  }
+
+  void operator()(int64_t value) const noexcept {
+    char buffer[MaxNumberSize];
+    result += FormatNumber(value, buffer).size();
+  }
+
+  void operator()(uint64_t value) const noexcept {
+    char buffer[MaxNumberSize];
+    result += FormatNumber(value, false, buffer).size();
+  }
+
+  void operator()(opentracing::string_view s) const noexcept {
+    result += ComputeEscapedStringSize(s);
+  }
+
+  void operator()(const std::string& s) const noexcept {
+    this->operator()(opentracing::string_view{s});
+  }
+
+  void operator()(std::nullptr_t) const noexcept {
+    result += sizeof("null") - 1;
+  }
+
+  void operator()(const char* s) const noexcept {
+    this->operator()(opentracing::string_view{s});
+  }
+
+  void operator()(const opentracing::Values& values) const noexcept {
+    result += 2;  // []
+    if (!values.empty()) {
+      result += values.size() - 1;  // commas
+    }
+    for (auto& value : values) {
+      apply_visitor(*this, value);
+    }
+  }
+
+  void operator()(const opentracing::Dictionary& dictionary) const noexcept {
+    result += 2;  // {}
+    if (!dictionary.empty()) {
+      result += dictionary.size() - 1;  // commas
+    }
+    for (auto& key_value : dictionary) {
+      result += ComputeEscapedStringSize(key_value.first) + 1;  // :
+      apply_visitor(*this, key_value.second);
+    }
+  }
+};
+}  // namespace
+
+//--------------------------------------------------------------------------------------------------
+// JsonValueVisitor
+//--------------------------------------------------------------------------------------------------
+namespace {
+template <class Stream>
+struct JsonValueVisitor {
+  Stream& stream;
+
+  void operator()(bool value) const {
+    WriteRaw(stream, value ? "true" : "false");
+  }
+
+  void operator()(double value) const {
+    char buffer[MaxNumberSize];
+    WriteRaw(stream, FormatNumber(value, buffer));
+  }
+
+  void operator()(int64_t value) const {
+    char buffer[MaxNumberSize];
+    WriteRaw(stream, FormatNumber(value, buffer));
+  }
+
+  void operator()(uint64_t value) const {
+    char buffer[MaxNumberSize];
+    WriteRaw(stream, FormatNumber(value, false, buffer));
+  }
+
+  void operator()(opentracing::string_view s) const {
+    WriteEscapedString(stream, s);
+  }
+
+  void operator()(const std::string& s) const {
+    this->operator()(opentracing::string_view{s});
+  }
+
+  void operator()(std::nullptr_t) const { WriteRaw(stream, "null"); }
+
+  void operator()(const char* s) const {
+    this->operator()(opentracing::string_view{s});
+  }
+
+  void operator()(const opentracing::Values& values) const {
+    WriteRaw(stream, "[");
+    bool first = true;
+    for (auto& value : values) {
+      if (!first) {
+        WriteRaw(stream, ",");
+      }
+      first = false;
+      apply_visitor(*this, value);
+    }
+    WriteRaw(stream, "]");
+  }
+
+  void operator()(const opentracing::Dictionary& dictionary) const {
+    WriteRaw(stream, "{");
+    bool first = true;
+    for (auto& key_value : dictionary) {
+      if (!first) {
+        WriteRaw(stream, ",");
+      }
+      first = false;
+      WriteEscapedString(stream, key_value.first);
+      WriteRaw(stream, ":");
+      apply_visitor(*this, key_value.second);
+    }
+    WriteRaw(stream, "}");
+  }
+};
+}  // namespace
+
+//--------------------------------------------------------------------------------------------------
+// ComputeJsonSerializationSize
+//--------------------------------------------------------------------------------------------------
+size_t ComputeJsonSerializationSize(const opentracing::Value& value) noexcept {
+  size_t result = 0;
+  JsonSizeValueVisitor value_visitor{result};
+  apply_visitor(value_visitor, value);
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// WriteJson
+//--------------------------------------------------------------------------------------------------
+template <class Stream>
+void WriteJson(Stream& stream, const opentracing::Value& value) {
+  JsonValueVisitor<Stream> value_visitor{stream};
+  apply_visitor(value_visitor, value);
+}
+
+template void WriteJson(google::protobuf::io::CodedOutputStream& stream,
+                        const opentracing::Value& value);
+
+template void WriteJson(DirectCodedOutputStream& stream,
+                        const opentracing::Value& value);
+}  // namespace lightstep
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+#include <opentracing/value.h>
+
+namespace lightstep {
+/**
+ * Computes the size of the JSON encoding of a value without building it.
+ * @param value the value to encode
+ * @return the number of bytes in the encoding
+ */
+size_t ComputeJsonSerializationSize(const opentracing::Value& value) noexcept;
+
+/**
+ * Writes the JSON encoding of a value directly into a stream.
+ *
+ * Note: Exactly ComputeJsonSerializationSize(value) bytes are written.
+ * @param stream the stream to write into; either a CodedOutputStream or a
+ * DirectCodedOutputStream
+ * @param value the value to encode
+ */
+template <class Stream>
+void WriteJson(Stream& stream, const opentracing::Value& value);
+}  // namespace lightstep
@@ -1,6 +1,10 @@
 #include "common/logger.h"
+
+#include <algorithm>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+
+#include "common/format_double.h"
 
 namespace lightstep {
 //------------------------------------------------------------------------------
@@ -8,30 +12,151 @@ namespace lightstep {
 //------------------------------------------------------------------------------
 static void LogDefault(LogLevel log_level,
                        opentracing::string_view message) noexcept try {
-  std::ostringstream oss;
+  // Format into a separate buffer since message may refer to the calling
+  // thread's buffer.
+  LogMessageBuffer record;
   switch (log_level) {
     case LogLevel::debug:
-      oss << "Debug: ";
+      record.Append("Debug: ");
       break;
     case LogLevel::info:
-      oss << "Info: ";
+      record.Append("Info: ");
       break;
     case LogLevel::warn:
-      oss << "Warn: ";
+      record.Append("Warn: ");
       break;
     case LogLevel::error:
-      oss << "Error: ";
+      record.Append("Error: ");
       break;
     case LogLevel::off:
       /* This should never be reached. */
       return;
   }
-  oss << message << '\n';
-  std::cerr << oss.str();
+  record.Append(message);
+  record.Append('\n');
+  std::cerr.write(record.message().data(),
+                  static_cast<std::streamsize>(record.message().size()));
 } catch (const std::exception& /*e*/) {
   // Ignore errors.
 }
 
+//------------------------------------------------------------------------------
+// GetThreadInstance
+//------------------------------------------------------------------------------
+LogMessageBuffer& LogMessageBuffer::GetThreadInstance() noexcept {
+  static thread_local LogMessageBuffer buffer;
+  buffer.Clear();
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+// Append
+//------------------------------------------------------------------------------
+void LogMessageBuffer::Append(const char* data, size_t size) noexcept {
+  size = std::min(size, MaxLogMessageSize - size_);
+  std::memcpy(static_cast<void*>(data_ + size_), static_cast<const void*>(data),
+              size);
+  size_ += size;
+}
+
+void LogMessageBuffer::Append(const char* s) noexcept {
+  if (s == nullptr) {
+    return Append(opentracing::string_view{"(null)"});
+  }
+  Append(s, std::strlen(s));
+}
+
+void LogMessageBuffer::Append(double x) noexcept {
+  char buffer[32];
+  Append(buffer, FormatDouble(x, buffer, sizeof(buffer)));
+}
+
+//------------------------------------------------------------------------------
+// AppendSigned
+//------------------------------------------------------------------------------
+void LogMessageBuffer::AppendSigned(long long x) noexcept {
+  if (x >= 0) {
+    return AppendUnsigned(static_cast<unsigned long long>(x));
+  }
+  Append('-');
+  // Negate in unsigned arithmetic so that the minimum value doesn't overflow.
+  AppendUnsigned(0ULL - static_cast<unsigned long long>(x));
+}
+
+//------------------------------------------------------------------------------
+// AppendUnsigned
+//------------------------------------------------------------------------------
+void LogMessageBuffer::AppendUnsigned(unsigned long long x) noexcept {
+  char buffer[20];
+  auto last = buffer + sizeof(buffer);
+  auto first = last;
+  do {
+    *--first = static_cast<char>('0' + x % 10);
+    x /= 10;
+  } while (x != 0);
+  Append(first, static_cast<size_t>(last - first));
+}
+
+//------------------------------------------------------------------------------
+// overflow
+//------------------------------------------------------------------------------
+LogMessageBuffer::StreamBuffer::int_type
+LogMessageBuffer::StreamBuffer::overflow(int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    buffer_.Append(traits_type::to_char_type(c));
+  }
+  return traits_type::not_eof(c);
+}
+
+//------------------------------------------------------------------------------
+// xsputn
+//------------------------------------------------------------------------------
+std::streamsize LogMessageBuffer::StreamBuffer::xsputn(const char* s,
+                                                       std::streamsize n) {
+  buffer_.Append(s, static_cast<size_t>(n));
+  return n;
+}
+
+//------------------------------------------------------------------------------
+// LogRateLimiter
+//------------------------------------------------------------------------------
+LogRateLimiter::LogRateLimiter(int max_messages,
+                               std::chrono::steady_clock::duration period)
+    : max_messages_{max_messages},
+      period_{std::chrono::duration_cast<std::chrono::nanoseconds>(period)
+                  .count()},
+      window_start_{std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count() -
+                    period_} {}
+
+//------------------------------------------------------------------------------
+// Acquire
+//------------------------------------------------------------------------------
+bool LogRateLimiter::Acquire(std::chrono::steady_clock::time_point now,
+                             int64_t& num_suppressed) noexcept {
+  auto now_count = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       now.time_since_epoch())
+                       .count();
+  auto window_start = window_start_.load(std::memory_order_relaxed);
+  if (now_count - window_start >= period_ &&
+      window_start_.compare_exchange_strong(window_start, now_count,
+                                            std::memory_order_relaxed)) {
+    // A message racing with the start of a new window may be counted against
+    // the old one, which is fine for logging.
+    num_messages_.store(0, std::memory_order_relaxed);
+  }
+  // Check before incrementing so that the count can't overflow when a call
+  // site is hammered.
+  if (num_messages_.load(std::memory_order_relaxed) >= max_messages_ ||
+      num_messages_.fetch_add(1, std::memory_order_relaxed) >= max_messages_) {
+    num_suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  num_suppressed = num_suppressed_.exchange(0, std::memory_order_relaxed);
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
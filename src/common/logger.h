@@ -1,19 +1,153 @@
 #pragma once
 
 #include <lightstep/tracer.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
-#include <sstream>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
 
 namespace lightstep {
-inline void Concatenate(std::ostringstream& /*oss*/) {}
+// The maximum size of a formatted log message. Longer messages are truncated.
+const size_t MaxLogMessageSize = 1024;
+
+/**
+ * A fixed-size buffer that log messages are formatted into so that logging
+ * doesn't allocate.
+ */
+class LogMessageBuffer {
+ public:
+  /**
+   * @return the buffer for the calling thread, cleared of any previous message.
+   */
+  static LogMessageBuffer& GetThreadInstance() noexcept;
+
+  /**
+   * Appends characters to the message, truncating if the buffer is full.
+   * @param data the characters to append
+   * @param size the number of characters to append
+   */
+  void Append(const char* data, size_t size) noexcept;
+
+  void Append(opentracing::string_view s) noexcept {
+    Append(s.data(), s.size());
+  }
+
+  void Append(const std::string& s) noexcept { Append(s.data(), s.size()); }
+
+  void Append(const char* s) noexcept;
+
+  void Append(char c) noexcept { Append(&c, 1); }
+
+  template <class T>
+  typename std::enable_if<std::is_integral<T>::value &&
+                          std::is_signed<T>::value>::type
+  Append(T x) noexcept {
+    AppendSigned(static_cast<long long>(x));
+  }
+
+  template <class T>
+  typename std::enable_if<std::is_integral<T>::value &&
+                          !std::is_signed<T>::value>::type
+  Append(T x) noexcept {
+    AppendUnsigned(static_cast<unsigned long long>(x));
+  }
+
+  void Append(double x) noexcept;
+
+  /**
+   * Formats any other type with its stream insertion operator.
+   */
+  template <class T>
+  typename std::enable_if<!std::is_arithmetic<T>::value>::type Append(
+      const T& t) noexcept try {
+    StreamBuffer stream_buffer{*this};
+    std::ostream out{&stream_buffer};
+    out << t;
+  } catch (const std::exception& /*e*/) {
+    // Ignore exceptions.
+  }
+
+  /**
+   * Resets the buffer to an empty message.
+   */
+  void Clear() noexcept { size_ = 0; }
+
+  /**
+   * @return the formatted message.
+   */
+  opentracing::string_view message() const noexcept {
+    return opentracing::string_view{data_, size_};
+  }
+
+ private:
+  class StreamBuffer final : public std::streambuf {
+   public:
+    explicit StreamBuffer(LogMessageBuffer& buffer) noexcept
+        : buffer_{buffer} {}
+
+   protected:
+    int_type overflow(int_type c) override;
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+   private:
+    LogMessageBuffer& buffer_;
+  };
+
+  char data_[MaxLogMessageSize];
+  size_t size_{0};
+
+  void AppendSigned(long long x) noexcept;
+
+  void AppendUnsigned(unsigned long long x) noexcept;
+};
+
+inline void Concatenate(LogMessageBuffer& /*buffer*/) noexcept {}
 
 template <class TFirst, class... TRest>
-void Concatenate(std::ostringstream& oss, const TFirst& tfirst,
-                 const TRest&... trest) {
-  oss << tfirst;
-  Concatenate(oss, trest...);
+void Concatenate(LogMessageBuffer& buffer, const TFirst& tfirst,
+                 const TRest&... trest) noexcept {
+  buffer.Append(tfirst);
+  Concatenate(buffer, trest...);
 }
 
+/**
+ * Limits how often a call site logs. It's meant to be used as a static local
+ * at the call site.
+ */
+class LogRateLimiter {
+ public:
+  /**
+   * @param max_messages the maximum number of messages to log per period
+   * @param period the length of the rate limiting window
+   */
+  explicit LogRateLimiter(
+      int max_messages = 1,
+      std::chrono::steady_clock::duration period = std::chrono::seconds{1});
+
+  /**
+   * Checks whether a message can be logged.
+   * @param now the current time
+   * @param num_suppressed set to the number of messages suppressed since the
+   * last one allowed
+   * @return true if the message can be logged
+   */
+  bool Acquire(std::chrono::steady_clock::time_point now,
+               int64_t& num_suppressed) noexcept;
+
+ private:
+  int max_messages_;
+  int64_t period_;
+  std::atomic<int64_t> window_start_;
+  std::atomic<int> num_messages_{0};
+  std::atomic<int64_t> num_suppressed_{0};
+};
+
 class Logger {
  public:
   Logger();
@@ -23,7 +157,7 @@ class Logger {
 
   inline void Log(LogLevel level,
                   opentracing::string_view message) noexcept try {
-    if (static_cast<int>(level) >= static_cast<int>(level_)) {
+    if (enabled(level)) {
       logger_sink_(level, message);
     }
   } catch (const std::exception& /*e*/) {
@@ -35,15 +169,35 @@ class Logger {
   }
 
   template <class... Tx>
-  inline void Log(LogLevel level, const Tx&... tx) noexcept try {
-    if (static_cast<int>(level) < static_cast<int>(level_)) {
+  inline void Log(LogLevel level, const Tx&... tx) noexcept {
+    if (!enabled(level)) {
       return;
     }
-    std::ostringstream oss;
-    Concatenate(oss, tx...);
-    Log(level, opentracing::string_view{oss.str()});
-  } catch (const std::exception& /*e*/) {
-    // Ignore exceptions.
+    auto& buffer = LogMessageBuffer::GetThreadInstance();
+    Concatenate(buffer, tx...);
+    Log(level, buffer.message());
+  }
+
+  /**
+   * Logs a message unless the call site's rate limit is exceeded. When a
+   * message is logged after others were suppressed, a count of the suppressed
+   * messages is appended.
+   */
+  template <class... Tx>
+  inline void Log(LogLevel level, LogRateLimiter& rate_limiter,
+                  const Tx&... tx) noexcept {
+    if (!enabled(level)) {
+      return;
+    }
+    int64_t num_suppressed;
+    if (!rate_limiter.Acquire(std::chrono::steady_clock::now(),
+                              num_suppressed)) {
+      return;
+    }
+    if (num_suppressed == 0) {
+      return Log(level, tx...);
+    }
+    Log(level, tx..., " (suppressed ", num_suppressed, " similar messages)");
   }
 
   template <class... Tx>
@@ -66,10 +220,38 @@ class Logger {
     Log(LogLevel::error, tx...);
   }
 
+  template <class... Tx>
+  inline void Debug(LogRateLimiter& rate_limiter, const Tx&... tx) noexcept {
+    Log(LogLevel::debug, rate_limiter, tx...);
+  }
+
+  template <class... Tx>
+  inline void Info(LogRateLimiter& rate_limiter, const Tx&... tx) noexcept {
+    Log(LogLevel::info, rate_limiter, tx...);
+  }
+
+  template <class... Tx>
+  inline void Warn(LogRateLimiter& rate_limiter, const Tx&... tx) noexcept {
+    Log(LogLevel::warn, rate_limiter, tx...);
+  }
+
+  template <class... Tx>
+  inline void Error(LogRateLimiter& rate_limiter, const Tx&... tx) noexcept {
+    Log(LogLevel::error, rate_limiter, tx...);
+  }
+
   inline void set_level(LogLevel level) noexcept { level_ = level; }
 
   inline LogLevel level() const noexcept { return level_; }
 
+  /**
+   * @param level a log level
+   * @return true if messages at the given level are logged.
+   */
+  inline bool enabled(LogLevel level) const noexcept {
+    return static_cast<int>(level) >= static_cast<int>(level_);
+  }
+
  private:
   std::function<void(LogLevel, opentracing::string_view)> logger_sink_;
   LogLevel level_ = LogLevel::error;
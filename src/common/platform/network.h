@@ -11,6 +11,7 @@
 #else
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #endif
 
 namespace lightstep {
@@ -61,6 +62,48 @@ int SetSocketNonblocking(FileDescriptor socket) noexcept;
  */
 int SetSocketReuseAddress(FileDescriptor socket) noexcept;
 
+/**
+ * Gets the number of bytes written to a socket that the peer hasn't
+ * acknowledged yet.
+ * @param socket the socket to query
+ * @return the number of bytes or 0 if it can't be determined
+ */
+int GetNumUnacknowledgedBytes(FileDescriptor socket) noexcept;
+
+/**
+ * Enables MSG_ZEROCOPY sends on a socket.
+ * @param socket the socket to set
+ * @return true if the platform and socket support zero-copy sends
+ */
+bool EnableZeroCopy(FileDescriptor socket) noexcept;
+
+/**
+ * Writes to a socket with MSG_ZEROCOPY. The kernel references the written
+ * memory instead of copying it, so it must be kept alive until the send is
+ * reported complete by ReadZeroCopyCompletion.
+ *
+ * If the socket can't pin any more memory for pending sends, the data is
+ * written with a regular copying write instead.
+ * @param zero_copy set to true if the data was sent with MSG_ZEROCOPY
+ *
+ * See WriteV
+ */
+int WriteVZeroCopy(FileDescriptor socket, const IoVec* iov, int iovcnt,
+                   bool& zero_copy) noexcept;
+
+/**
+ * Reads a notification of completed zero-copy sends from a socket's error
+ * queue. The kernel numbers zero-copy sends on a socket sequentially from 0,
+ * and each notification covers the range of sends [first, last].
+ * @param socket the socket to read from
+ * @param first set to the first completed send
+ * @param last set to the last completed send
+ * @param copied set to true if the kernel fell back to copying the data
+ * @return 1 if a notification was read, 0 if there were none, or -1 on error
+ */
+int ReadZeroCopyCompletion(FileDescriptor socket, uint32_t& first,
+                           uint32_t& last, bool& copied) noexcept;
+
 /**
  * Closes a socket
  * @param socket the socket to close
@@ -1,13 +1,25 @@
 #include "common/platform/network.h"
 
+#include <cerrno>
 #include <climits>
+#include <cstring>
 
 #include <fcntl.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
+#endif
+
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define LIGHTSTEP_HAS_ZERO_COPY
+#endif
+
 namespace lightstep {
 //--------------------------------------------------------------------------------------------------
 // IoVecMax
@@ -51,6 +63,109 @@ int SetSocketReuseAddress(FileDescriptor socket) noexcept {
                       static_cast<void*>(&optvalue), sizeof(int));
 }
 
+//--------------------------------------------------------------------------------------------------
+// GetNumUnacknowledgedBytes
+//--------------------------------------------------------------------------------------------------
+int GetNumUnacknowledgedBytes(FileDescriptor socket) noexcept {
+#ifdef SIOCOUTQ
+  int result;
+  if (::ioctl(socket, SIOCOUTQ, &result) == 0) {
+    return result;
+  }
+#elif defined(SO_NWRITE)
+  int result;
+  socklen_t result_size = sizeof(result);
+  if (::getsockopt(socket, SOL_SOCKET, SO_NWRITE, static_cast<void*>(&result),
+                   &result_size) == 0) {
+    return result;
+  }
+#else
+  (void)socket;
+#endif
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// EnableZeroCopy
+//--------------------------------------------------------------------------------------------------
+bool EnableZeroCopy(FileDescriptor socket) noexcept {
+#ifdef LIGHTSTEP_HAS_ZERO_COPY
+  int optvalue = 1;
+  return ::setsockopt(socket, SOL_SOCKET, SO_ZEROCOPY,
+                      static_cast<void*>(&optvalue), sizeof(int)) == 0;
+#else
+  (void)socket;
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+// WriteVZeroCopy
+//--------------------------------------------------------------------------------------------------
+int WriteVZeroCopy(FileDescriptor socket, const IoVec* iov, int iovcnt,
+                   bool& zero_copy) noexcept {
+  zero_copy = false;
+#ifdef LIGHTSTEP_HAS_ZERO_COPY
+  msghdr message;
+  std::memset(static_cast<void*>(&message), 0, sizeof(message));
+  message.msg_iov = const_cast<IoVec*>(iov);
+  message.msg_iovlen = static_cast<size_t>(iovcnt);
+  auto result = ::sendmsg(socket, &message, MSG_ZEROCOPY);
+  if (result >= 0) {
+    zero_copy = true;
+    return static_cast<int>(result);
+  }
+  // ENOBUFS means that the socket has exceeded its limit on memory pinned for
+  // pending zero-copy sends.
+  if (errno != ENOBUFS) {
+    return -1;
+  }
+#endif
+  return WriteV(socket, iov, iovcnt);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ReadZeroCopyCompletion
+//--------------------------------------------------------------------------------------------------
+int ReadZeroCopyCompletion(FileDescriptor socket, uint32_t& first,
+                           uint32_t& last, bool& copied) noexcept {
+#ifdef LIGHTSTEP_HAS_ZERO_COPY
+  char control[CMSG_SPACE(sizeof(sock_extended_err)) + 64];
+  msghdr message;
+  std::memset(static_cast<void*>(&message), 0, sizeof(message));
+  message.msg_control = static_cast<void*>(control);
+  message.msg_controllen = sizeof(control);
+  if (::recvmsg(socket, &message, MSG_ERRQUEUE) < 0) {
+    return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+  }
+  for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&message, cmsg)) {
+    if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+          (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) {
+      continue;
+    }
+    sock_extended_err error;
+    std::memcpy(static_cast<void*>(&error),
+                static_cast<const void*>(CMSG_DATA(cmsg)), sizeof(error));
+    if (error.ee_origin != SO_EE_ORIGIN_ZEROCOPY || error.ee_errno != 0) {
+      continue;
+    }
+    first = error.ee_info;
+    last = error.ee_data;
+    copied = (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+    return 1;
+  }
+  // Something other than a zero-copy notification was on the error queue.
+  return -1;
+#else
+  (void)socket;
+  (void)first;
+  (void)last;
+  (void)copied;
+  return 0;
+#endif
+}
+
 //--------------------------------------------------------------------------------------------------
 // CloseSocket
 //--------------------------------------------------------------------------------------------------
@@ -50,6 +50,35 @@ int SetSocketReuseAddress(FileDescriptor socket) noexcept {
                       reinterpret_cast<char*>(&optvalue), sizeof(optvalue));
 }
 
+//--------------------------------------------------------------------------------------------------
+// GetNumUnacknowledgedBytes
+//--------------------------------------------------------------------------------------------------
+int GetNumUnacknowledgedBytes(FileDescriptor /*socket*/) noexcept {
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// EnableZeroCopy
+//--------------------------------------------------------------------------------------------------
+bool EnableZeroCopy(FileDescriptor /*socket*/) noexcept { return false; }
+
+//--------------------------------------------------------------------------------------------------
+// WriteVZeroCopy
+//--------------------------------------------------------------------------------------------------
+int WriteVZeroCopy(FileDescriptor socket, const IoVec* iov, int iovcnt,
+                   bool& zero_copy) noexcept {
+  zero_copy = false;
+  return WriteV(socket, iov, iovcnt);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ReadZeroCopyCompletion
+//--------------------------------------------------------------------------------------------------
+int ReadZeroCopyCompletion(FileDescriptor /*socket*/, uint32_t& /*first*/,
+                           uint32_t& /*last*/, bool& /*copied*/) noexcept {
+  return 0;
+}
+
 //--------------------------------------------------------------------------------------------------
 // CloseSocket
 //--------------------------------------------------------------------------------------------------
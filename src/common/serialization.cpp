@@ -1,11 +1,6 @@
 #include "common/serialization.h"
 
-const size_t KeyValueKeyField = 1;
-const size_t KeyValueStringValueField = 2;
-const size_t KeyValueIntValueField = 3;
-const size_t KeyValueDoubleValueField = 4;
-const size_t KeyValueBoolValueField = 5;
-const size_t KeyValueJsonValueField = 6;
+#include "common/json_serialization.h"
 
 namespace lightstep {
 //--------------------------------------------------------------------------------------------------
@@ -14,24 +9,19 @@ namespace lightstep {
 namespace {
 struct SerializationSizeValueVisitor {
   const opentracing::Value& original_value;
-  std::string& json;
-  int& json_counter;
+  size_t& json_size;
   size_t& result;
 
   void operator()(bool value) const noexcept {
-    result += ComputeVarintSerializationSize<KeyValueBoolValueField>(
-        static_cast<uint32_t>(value));
+    result += ComputeTypedValueSerializationSize(value);
   }
 
-  void operator()(double /*value*/) const noexcept {
-    result += StaticKeySerializationSize<KeyValueDoubleValueField,
-                                         WireType::Fixed64>::value +
-              sizeof(int64_t);
+  void operator()(double value) const noexcept {
+    result += ComputeTypedValueSerializationSize(value);
   }
 
   void operator()(int64_t value) const noexcept {
-    result += ComputeVarintSerializationSize<KeyValueIntValueField>(
-        static_cast<uint64_t>(value));
+    result += ComputeTypedValueSerializationSize(value);
   }
 
   void operator()(uint64_t value) const noexcept {
@@ -40,8 +30,7 @@ struct SerializationSizeValueVisitor {
   }
 
   void operator()(opentracing::string_view s) const noexcept {
-    result += ComputeLengthDelimitedSerializationSize<KeyValueStringValueField>(
-        s.size());
+    result += ComputeTypedValueSerializationSize(s);
   }
 
   void operator()(const std::string& s) const noexcept {
@@ -54,17 +43,18 @@ struct SerializationSizeValueVisitor {
     this->operator()(opentracing::string_view{s});
   }
 
-  void operator()(const opentracing::Values& /*unused*/) const { do_json(); }
+  void operator()(const opentracing::Values& /*unused*/) const noexcept {
+    do_json();
+  }
 
-  void operator()(const opentracing::Dictionary& /*unused*/) const {
+  void operator()(const opentracing::Dictionary& /*unused*/) const noexcept {
     do_json();
   }
 
-  void do_json() const {
-    json = ToJson(original_value);
-    ++json_counter;
+  void do_json() const noexcept {
+    json_size = ComputeJsonSerializationSize(original_value);
     result += ComputeLengthDelimitedSerializationSize<KeyValueJsonValueField>(
-        json.size());
+        json_size);
   }
 };
 }  // namespace
@@ -73,22 +63,24 @@ struct SerializationSizeValueVisitor {
 // SerializationValueVisitor
 //--------------------------------------------------------------------------------------------------
 namespace {
+struct JsonSerializer {
+  template <class Stream>
+  inline void operator()(Stream& stream,
+                         const opentracing::Value& value) const {
+    WriteJson(stream, value);
+  }
+};
+
 struct SerializationValueVisitor {
   google::protobuf::io::CodedOutputStream& stream;
-  const std::string* json_values;
-  int& json_counter;
+  const opentracing::Value& original_value;
+  size_t json_size;
 
-  void operator()(bool value) const {
-    WriteVarint<KeyValueBoolValueField>(stream, static_cast<uint32_t>(value));
-  }
+  void operator()(bool value) const { WriteTypedValue(stream, value); }
 
-  void operator()(double value) const {
-    WriteFixed64<KeyValueDoubleValueField>(stream, static_cast<void*>(&value));
-  }
+  void operator()(double value) const { WriteTypedValue(stream, value); }
 
-  void operator()(int64_t value) const {
-    WriteVarint<KeyValueIntValueField>(stream, static_cast<uint64_t>(value));
-  }
+  void operator()(int64_t value) const { WriteTypedValue(stream, value); }
 
   void operator()(uint64_t value) const {
     // There's no uint64_t value type so cast to an int64_t.
@@ -96,7 +88,7 @@ struct SerializationValueVisitor {
   }
 
   void operator()(opentracing::string_view s) const {
-    WriteString<KeyValueStringValueField>(stream, s);
+    WriteTypedValue(stream, s);
   }
 
   void operator()(const std::string& s) const {
@@ -116,24 +108,41 @@ struct SerializationValueVisitor {
   }
 
   void do_json() const {
-    WriteString<KeyValueJsonValueField>(stream, json_values[json_counter]);
-    ++json_counter;
+    WriteLengthDelimitedField<KeyValueJsonValueField>(
+        stream, json_size, JsonSerializer{}, original_value);
   }
 };
 }  // namespace
 
+//--------------------------------------------------------------------------------------------------
+// ComputeValueSerializationSize
+//--------------------------------------------------------------------------------------------------
+size_t ComputeValueSerializationSize(const opentracing::Value& value,
+                                     size_t& json_size) noexcept {
+  size_t result = 0;
+  SerializationSizeValueVisitor value_visitor{value, json_size, result};
+  apply_visitor(value_visitor, value);
+  return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 // ComputeKeyValueSerializationSize
 //--------------------------------------------------------------------------------------------------
 size_t ComputeKeyValueSerializationSize(opentracing::string_view key,
                                         const opentracing::Value& value,
-                                        std::string& json, int& json_counter) {
-  size_t result =
-      ComputeLengthDelimitedSerializationSize<KeyValueKeyField>(key.size());
-  SerializationSizeValueVisitor value_visitor{value, json, json_counter,
-                                              result};
+                                        size_t& json_size) noexcept {
+  return ComputeLengthDelimitedSerializationSize<KeyValueKeyField>(
+             key.size()) +
+         ComputeValueSerializationSize(value, json_size);
+}
+
+//--------------------------------------------------------------------------------------------------
+// WriteValue
+//--------------------------------------------------------------------------------------------------
+void WriteValue(google::protobuf::io::CodedOutputStream& stream,
+                const opentracing::Value& value, size_t json_size) {
+  SerializationValueVisitor value_visitor{stream, value, json_size};
   apply_visitor(value_visitor, value);
-  return result;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -141,10 +150,21 @@ size_t ComputeKeyValueSerializationSize(opentracing::string_view key,
 //--------------------------------------------------------------------------------------------------
 void WriteKeyValueImpl(google::protobuf::io::CodedOutputStream& stream,
                        opentracing::string_view key,
-                       const opentracing::Value& value,
-                       const std::string* json_values, int& json_counter) {
+                       const opentracing::Value& value, size_t json_size) {
   WriteString<KeyValueKeyField>(stream, key);
-  SerializationValueVisitor value_visitor{stream, json_values, json_counter};
-  apply_visitor(value_visitor, value);
+  WriteValue(stream, value, json_size);
+}
+
+//--------------------------------------------------------------------------------------------------
+// SerializeKey
+//--------------------------------------------------------------------------------------------------
+std::string SerializeKey(opentracing::string_view key) {
+  std::string result(
+      ComputeLengthDelimitedSerializationSize<KeyValueKeyField>(key.size()),
+      ' ');
+  DirectCodedOutputStream stream{
+      reinterpret_cast<google::protobuf::uint8*>(&result[0])};
+  WriteString<KeyValueKeyField>(stream, key);
+  return result;
 }
 }  // namespace lightstep
@@ -13,6 +13,14 @@ namespace lightstep {
 // Only lists wire types we use
 enum class WireType { Varint = 0, Fixed64 = 1, LengthDelimited = 2 };
 
+// Field numbers of collector.KeyValue.
+const size_t KeyValueKeyField = 1;
+const size_t KeyValueStringValueField = 2;
+const size_t KeyValueIntValueField = 3;
+const size_t KeyValueDoubleValueField = 4;
+const size_t KeyValueBoolValueField = 5;
+const size_t KeyValueJsonValueField = 6;
+
 /**
  * Compute the encoding of a field and its type at compile-time
  */
@@ -150,49 +158,69 @@ void WriteBigVarint(Stream& stream, uint64_t x) {
   WriteBigVarint64(stream, x);
 }
 
+/**
+ * Compute the serialization size of the value of a key-value.
+ * @param value the value of the serialization
+ * @param json_size set to the size of the value's json if the value requires
+ * conversion
+ * @return the serialization size
+ */
+size_t ComputeValueSerializationSize(const opentracing::Value& value,
+                                     size_t& json_size) noexcept;
+
+/**
+ * Serialize the value of a key-value.
+ * @param stream the stream to serialize into
+ * @param value the value of the serialization
+ * @param json_size the json size computed by ComputeValueSerializationSize
+ */
+void WriteValue(google::protobuf::io::CodedOutputStream& stream,
+                const opentracing::Value& value, size_t json_size);
+
+/**
+ * Compute the serialization of the key of a key-value.
+ * @param key the key to serialize
+ * @return the serialized key field
+ */
+std::string SerializeKey(opentracing::string_view key);
+
 /**
  * Compute the serialization size of a key-value not including its key field.
  * @param key the key of the serialization
  * @param value the value of the serialization
- * @param json the string to write json into if the value requires conversion
- * @param json_counter an integer to increment if json is set
+ * @param json_size set to the size of the value's json if the value requires
+ * conversion
  * @return the serialization size
  */
 size_t ComputeKeyValueSerializationSize(opentracing::string_view key,
                                         const opentracing::Value& value,
-                                        std::string& json, int& json_counter);
+                                        size_t& json_size) noexcept;
 
 /**
  * Serialize a key-value not including its key field.
  * @param stream the stream to serialize into
  * @param key the key of the serialization
  * @param value the value of the serialization
- * @param json_values an array of json values where json_values[json_counter]
- * references the json for this field if it's used.
- * @param json_counter an integer to increment if json is referenced
+ * @param json_size the json size computed by ComputeKeyValueSerializationSize
  */
 void WriteKeyValueImpl(google::protobuf::io::CodedOutputStream& stream,
                        opentracing::string_view key,
-                       const opentracing::Value& value,
-                       const std::string* json_values, int& json_counter);
+                       const opentracing::Value& value, size_t json_size);
 
 /**
  * Serialize a key-value with its key field.
  * @param stream the stream to serialize into
  * @param key the key of the serialization
  * @param value the value of the serialization
- * @param json_values an array of json values where json_values[json_counter]
- * references the json for this field if it's used.
- * @param json_counter an integer to increment if json is referenced
+ * @param json_size the json size computed by ComputeKeyValueSerializationSize
  */
 template <size_t FieldNumber>
 inline void WriteKeyValue(google::protobuf::io::CodedOutputStream& stream,
                           size_t serialization_size,
                           opentracing::string_view key,
-                          const opentracing::Value& value,
-                          const std::string* json_values, int& json_counter) {
+                          const opentracing::Value& value, size_t json_size) {
   WriteKeyLength<FieldNumber>(stream, serialization_size);
-  WriteKeyValueImpl(stream, key, value, json_values, json_counter);
+  WriteKeyValueImpl(stream, key, value, json_size);
 }
 
 /**
@@ -205,13 +233,11 @@ template <size_t FieldNumber>
 inline void WriteKeyValue(google::protobuf::io::CodedOutputStream& stream,
                           opentracing::string_view key,
                           const opentracing::Value& value) {
-  std::string json;
-  int json_counter = 0;
+  size_t json_size = 0;
   auto serialization_size =
-      ComputeKeyValueSerializationSize(key, value, json, json_counter);
-  json_counter = 0;
-  WriteKeyValue<FieldNumber>(stream, serialization_size, key, value, &json,
-                             json_counter);
+      ComputeKeyValueSerializationSize(key, value, json_size);
+  WriteKeyValue<FieldNumber>(stream, serialization_size, key, value,
+                             json_size);
 }
 
 /**
@@ -277,6 +303,100 @@ void WriteString(Stream& stream, opentracing::string_view s) {
                                          s);
 }
 
+/**
+ * Computes the serialization size of a KeyValue's value field for a value
+ * that's written directly instead of through an opentracing::Value.
+ * @param value the value to serialize
+ * @return the serialization size of the value field
+ */
+inline size_t ComputeTypedValueSerializationSize(bool value) noexcept {
+  return ComputeVarintSerializationSize<KeyValueBoolValueField>(
+      static_cast<uint32_t>(value));
+}
+
+inline size_t ComputeTypedValueSerializationSize(int64_t value) noexcept {
+  return ComputeVarintSerializationSize<KeyValueIntValueField>(
+      static_cast<uint64_t>(value));
+}
+
+inline size_t ComputeTypedValueSerializationSize(double /*value*/) noexcept {
+  return StaticKeySerializationSize<KeyValueDoubleValueField,
+                                    WireType::Fixed64>::value +
+         sizeof(int64_t);
+}
+
+inline size_t ComputeTypedValueSerializationSize(
+    opentracing::string_view value) noexcept {
+  return ComputeLengthDelimitedSerializationSize<KeyValueStringValueField>(
+      value.size());
+}
+
+/**
+ * Serializes a KeyValue's value field.
+ * @param stream the stream to serialize into
+ * @param value the value to serialize
+ */
+template <class Stream>
+inline void WriteTypedValue(Stream& stream, bool value) {
+  WriteVarint<KeyValueBoolValueField>(stream, static_cast<uint32_t>(value));
+}
+
+template <class Stream>
+inline void WriteTypedValue(Stream& stream, int64_t value) {
+  WriteVarint<KeyValueIntValueField>(stream, static_cast<uint64_t>(value));
+}
+
+template <class Stream>
+inline void WriteTypedValue(Stream& stream, double value) {
+  WriteFixed64<KeyValueDoubleValueField>(stream, static_cast<void*>(&value));
+}
+
+template <class Stream>
+inline void WriteTypedValue(Stream& stream, opentracing::string_view value) {
+  WriteString<KeyValueStringValueField>(stream, value);
+}
+
+/**
+ * Computes the serialization size of a KeyValue with a typed value.
+ * @param key the key of the KeyValue
+ * @param value the value of the KeyValue
+ * @return the serialization size of the KeyValue excluding its field header
+ */
+template <class T>
+inline size_t ComputeTypedKeyValueSerializationSize(
+    opentracing::string_view key, T value) noexcept {
+  return ComputeLengthDelimitedSerializationSize<KeyValueKeyField>(
+             key.size()) +
+         ComputeTypedValueSerializationSize(value);
+}
+
+/**
+ * Serialize the contents of a KeyValue with a typed value into an arbitrary
+ * Stream.
+ */
+struct TypedKeyValueSerializer {
+  template <class Stream, class T>
+  inline void operator()(Stream& stream, opentracing::string_view key,
+                         const T& value) const {
+    WriteString<KeyValueKeyField>(stream, key);
+    WriteTypedValue(stream, value);
+  }
+};
+
+/**
+ * Serialize a KeyValue with a typed value.
+ * @param stream the stream to serialize into
+ * @param key the key of the KeyValue
+ * @param value the value of the KeyValue
+ */
+template <size_t FieldNumber, class T>
+inline void WriteTypedKeyValue(google::protobuf::io::CodedOutputStream& stream,
+                               opentracing::string_view key, T value) {
+  WriteLengthDelimitedField<FieldNumber>(
+      stream, ComputeTypedKeyValueSerializationSize(key, value),
+      TypedKeyValueSerializer{}, key, value);
+}
+
 /**
  * Compute the serialization of a timestamp not including its key field.
  * @param seconds_since_epoch the seconds since the epoch
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "common/circular_buffer.h"
+#include "common/noncopyable.h"
+
+namespace lightstep {
+/**
+ * Splits a circular buffer into shards so that producers on different threads
+ * don't contend on the same head and tail counters.
+ *
+ * Each producer thread is assigned a shard and only falls back to the others
+ * when its shard is full. The consumer drains the shards individually.
+ */
+template <class T>
+class ShardedCircularBuffer : private Noncopyable {
+ public:
+  // The default maximum number of shards.
+  static const size_t MaxDefaultNumShards = 16;
+
+  /**
+   * @param max_size the maximum number of elements across all shards
+   * @param num_shards the number of shards or 0 to use the default
+   */
+  explicit ShardedCircularBuffer(size_t max_size, size_t num_shards = 0)
+      : num_shards_{ComputeNumShards(max_size, num_shards)} {
+    shards_.reset(new std::unique_ptr<Shard>[num_shards_]);
+    for (size_t i = 0; i < num_shards_; ++i) {
+      auto shard_max_size = max_size / num_shards_ +
+                            static_cast<size_t>(i < max_size % num_shards_);
+      shards_[i].reset(new Shard{shard_max_size});
+    }
+  }
+
+  /**
+   * Adds an element into the buffer.
+   * @param ptr a pointer to the element to add
+   * @return true if the element was successfully added; false, otherwise.
+   */
+  bool Add(std::unique_ptr<T>& ptr) noexcept {
+    return AddToShard(ptr) != nullptr;
+  }
+
+  /**
+   * Adds an element into the buffer.
+   * @param ptr a pointer to the element to add
+   * @return the shard the element was added to or nullptr if the buffer is
+   * full.
+   *
+   * Note: Producers can check the fill level of the returned shard without
+   * touching the counters of shards that other threads add to.
+   */
+  CircularBuffer<T>* AddToShard(std::unique_ptr<T>& ptr) noexcept {
+    auto first_index = GetThreadShardIndex() % num_shards_;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      auto index = first_index + i;
+      if (index >= num_shards_) {
+        index -= num_shards_;
+      }
+      auto& buffer = shards_[index]->buffer;
+      if (buffer.Add(ptr)) {
+        return &buffer;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Clear all of the shards.
+   *
+   * Note: This method must only be called from the consumer thread.
+   */
+  void Clear() noexcept {
+    for (size_t i = 0; i < num_shards_; ++i) {
+      shards_[i]->buffer.Clear();
+    }
+  }
+
+  /**
+   * @return the number of shards.
+   */
+  size_t num_shards() const noexcept { return num_shards_; }
+
+  /**
+   * @param index the index of the shard
+   * @return the shard
+   */
+  CircularBuffer<T>& shard(size_t index) noexcept {
+    return shards_[index]->buffer;
+  }
+
+  const CircularBuffer<T>& shard(size_t index) const noexcept {
+    return shards_[index]->buffer;
+  }
+
+  /**
+   * @return the maximum number of elements that can be stored in the buffer.
+   */
+  size_t max_size() const noexcept {
+    return SumOverShards(&CircularBuffer<T>::max_size);
+  }
+
+  /**
+   * @return true if all of the shards are empty.
+   */
+  bool empty() const noexcept {
+    for (size_t i = 0; i < num_shards_; ++i) {
+      if (!shards_[i]->buffer.empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @return the number of elements stored in the buffer.
+   *
+   * Note: this method will only return a correct snapshot of the size if called
+   * from the consumer thread.
+   */
+  size_t size() const noexcept {
+    return SumOverShards(&CircularBuffer<T>::size);
+  }
+
+  /**
+   * @return the number of elements consumed from the buffer.
+   */
+  int64_t consumption_count() const noexcept {
+    return SumOverShards(&CircularBuffer<T>::consumption_count);
+  }
+
+  /**
+   * @return the number of elements added to the buffer.
+   */
+  int64_t production_count() const noexcept {
+    return SumOverShards(&CircularBuffer<T>::production_count);
+  }
+
+ private:
+  // The padding keeps the counters of shards allocated next to each other on
+  // different cache lines.
+  struct Shard {
+    explicit Shard(size_t max_size) noexcept : buffer{max_size} {}
+
+    CircularBuffer<T> buffer;
+    char padding[64];
+  };
+
+  size_t num_shards_;
+  std::unique_ptr<std::unique_ptr<Shard>[]> shards_;
+
+  static size_t ComputeNumShards(size_t max_size, size_t num_shards) noexcept {
+    if (num_shards == 0) {
+      num_shards = std::min(
+          static_cast<size_t>(std::thread::hardware_concurrency()),
+          MaxDefaultNumShards);
+    }
+    // Every shard needs room for at least one element.
+    return std::max<size_t>(std::min(num_shards, max_size), 1);
+  }
+
+  static size_t GetThreadShardIndex() noexcept {
+    static std::atomic<size_t> next_index{0};
+    static thread_local size_t index =
+        next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+  }
+
+  template <class Result>
+  Result SumOverShards(Result (CircularBuffer<T>::*f)() const) const noexcept {
+    Result result = 0;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      result += (shards_[i]->buffer.*f)();
+    }
+    return result;
+  }
+};
+
+template <class T>
+const size_t ShardedCircularBuffer<T>::MaxDefaultNumShards;
+}  // namespace lightstep
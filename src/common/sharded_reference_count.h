@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common/noncopyable.h"
+#include "common/spin_lock_mutex.h"
+
+namespace lightstep {
+/**
+ * A reference count for an object with a single owner and many short-lived
+ * references, such as a tracer and its spans.
+ *
+ * While the owner holds its reference, the count is split into shards so that
+ * threads acquiring and releasing references don't contend on the same cache
+ * line. Once the owner releases, the shards are folded into a single atomic
+ * counter so that exactly one releaser sees the count reach zero.
+ */
+class ShardedReferenceCount : private Noncopyable {
+ public:
+  // The default maximum number of shards.
+  static const size_t MaxDefaultNumShards = 16;
+
+  /**
+   * @param num_shards the number of shards or 0 to use the default
+   */
+  explicit ShardedReferenceCount(size_t num_shards = 0)
+      : num_shards_{ComputeNumShards(num_shards)},
+        shards_{new Shard[num_shards_]} {}
+
+  /**
+   * Acquires a reference.
+   *
+   * Note: The caller must already hold a reference, either the owner's or one
+   * previously acquired.
+   */
+  void Acquire() noexcept {
+    auto& shard = GetThreadShard();
+    std::lock_guard<SpinLockMutex> lock_guard{shard.mutex};
+    if (owner_released_) {
+      count_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    ++shard.count;
+  }
+
+  /**
+   * Releases a reference acquired with Acquire. A reference can be released
+   * from a different thread than the one that acquired it.
+   * @return true if this was the last reference, in which case the object can
+   * be destroyed.
+   */
+  bool Release() noexcept {
+    {
+      auto& shard = GetThreadShard();
+      std::lock_guard<SpinLockMutex> lock_guard{shard.mutex};
+      if (!owner_released_) {
+        --shard.count;
+        return false;
+      }
+    }
+    return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  /**
+   * Releases the owner's reference.
+   * @return true if there are no other references, in which case the object
+   * can be destroyed.
+   */
+  bool ReleaseOwner() noexcept {
+    int64_t count = 1;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      shards_[i].mutex.lock();
+    }
+    owner_released_ = true;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      count += shards_[i].count;
+      shards_[i].count = 0;
+    }
+    count_.store(count, std::memory_order_relaxed);
+    for (size_t i = 0; i < num_shards_; ++i) {
+      shards_[i].mutex.unlock();
+    }
+    return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  /**
+   * @return the number of references held, not including the owner's.
+   *
+   * Note: this is only a snapshot if other threads are acquiring or releasing
+   * references.
+   */
+  int64_t count() const noexcept {
+    int64_t result = 0;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      std::lock_guard<SpinLockMutex> lock_guard{shards_[i].mutex};
+      if (owner_released_) {
+        return count_.load(std::memory_order_relaxed);
+      }
+      result += shards_[i].count;
+    }
+    return result;
+  }
+
+  /**
+   * @return the number of shards.
+   */
+  size_t num_shards() const noexcept { return num_shards_; }
+
+ private:
+  // The padding keeps the counters of shards allocated next to each other on
+  // different cache lines. Counts of individual shards can go negative when
+  // references are released from a different thread than acquired them.
+  struct Shard {
+    mutable SpinLockMutex mutex;
+    int64_t count{0};
+    char padding[64];
+  };
+
+  size_t num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+
+  // Only modified while every shard is locked.
+  bool owner_released_{false};
+
+  std::atomic<int64_t> count_{0};
+
+  Shard& GetThreadShard() noexcept {
+    return shards_[GetThreadShardIndex() % num_shards_];
+  }
+
+  static size_t ComputeNumShards(size_t num_shards) noexcept {
+    if (num_shards == 0) {
+      num_shards = std::thread::hardware_concurrency();
+      if (num_shards > MaxDefaultNumShards) {
+        num_shards = MaxDefaultNumShards;
+      }
+    }
+    return std::max<size_t>(num_shards, 1);
+  }
+
+  static size_t GetThreadShardIndex() noexcept {
+    static std::atomic<size_t> next_index{0};
+    static thread_local size_t index =
+        next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+  }
+};
+}  // namespace lightstep
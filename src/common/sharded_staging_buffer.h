@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/noncopyable.h"
+#include "common/spin_lock_mutex.h"
+
+namespace lightstep {
+/**
+ * A buffer that many producer threads stage elements into and a single
+ * consumer periodically drains.
+ *
+ * Each producer thread is assigned a shard that it appends to under the
+ * shard's own spin lock, so producers on different threads don't contend with
+ * each other. Shards are double-buffered: the consumer only holds a shard's
+ * lock long enough to swap its staged elements with an empty vector, and then
+ * processes them without blocking producers.
+ *
+ * Add and Emplace don't limit how many elements are staged. TryEmplace splits
+ * a limit across the shards so that the total staged stays within it, as long
+ * as the limit is at least the number of shards.
+ */
+template <class T>
+class ShardedStagingBuffer : private Noncopyable {
+ public:
+  // The default maximum number of shards.
+  static const size_t MaxDefaultNumShards = 16;
+
+  /**
+   * @param num_shards the number of shards or 0 to use the default
+   */
+  explicit ShardedStagingBuffer(size_t num_shards = 0)
+      : num_shards_{ComputeNumShards(num_shards)},
+        shards_{new Shard[num_shards_]} {}
+
+  /**
+   * Stages an element.
+   * @param value the element to add
+   */
+  void Add(T&& value) {
+    Emplace([&value] { return std::move(value); });
+  }
+
+  /**
+   * Constructs and stages an element.
+   * @param make_value a functor returning the element to add
+   *
+   * Note: make_value is called while holding the shard's lock, so the
+   * consumer can't swap the shard out between when the element is constructed
+   * and when it's staged.
+   */
+  template <class F>
+  void Emplace(F make_value) {
+    auto& shard = shards_[GetThreadShardIndex() % num_shards_];
+    std::lock_guard<SpinLockMutex> lock_guard{shard.mutex};
+    shard.staged.emplace_back(make_value());
+  }
+
+  /**
+   * Constructs and stages an element unless the calling thread's shard is
+   * full.
+   * @param max_size the maximum number of elements across all shards. Each
+   * shard gets an even share of it, but always has room for at least one
+   * element.
+   * @param make_value a functor returning the element to add
+   * @return the number of free slots the shard had before the element was
+   * added, so 0 if the shard was full and nothing was staged and 1 if the
+   * shard is full now
+   *
+   * Note: As with Emplace, make_value is called while holding the shard's lock.
+   */
+  template <class F>
+  size_t TryEmplace(size_t max_size, F make_value) {
+    auto shard_index = GetThreadShardIndex() % num_shards_;
+    auto max_shard_size = ComputeMaxShardSize(max_size, shard_index);
+    auto& shard = shards_[shard_index];
+    std::lock_guard<SpinLockMutex> lock_guard{shard.mutex};
+    auto num_staged = shard.staged.size();
+    if (num_staged >= max_shard_size) {
+      return 0;
+    }
+    shard.staged.emplace_back(make_value());
+    return max_shard_size - num_staged;
+  }
+
+  /**
+   * Removes all the staged elements.
+   * @param f a functor that is called with each element removed
+   *
+   * Note: This method must only be called from the consumer thread.
+   */
+  template <class F>
+  void Consume(F f) {
+    for (size_t i = 0; i < num_shards_; ++i) {
+      auto& shard = shards_[i];
+      {
+        std::lock_guard<SpinLockMutex> lock_guard{shard.mutex};
+        shard.staged.swap(shard.consumed);
+      }
+      for (auto& value : shard.consumed) {
+        f(std::move(value));
+      }
+      shard.consumed.clear();
+    }
+  }
+
+  /**
+   * @return true if no elements are staged.
+   *
+   * Note: This takes the lock of every shard, so it's meant for infrequent
+   * checks rather than the staging path.
+   */
+  bool empty() noexcept {
+    for (size_t i = 0; i < num_shards_; ++i) {
+      auto& shard = shards_[i];
+      std::lock_guard<SpinLockMutex> lock_guard{shard.mutex};
+      if (!shard.staged.empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @return the number of shards.
+   */
+  size_t num_shards() const noexcept { return num_shards_; }
+
+ private:
+  // The padding keeps the locks of shards allocated next to each other on
+  // different cache lines. Only the consumer accesses consumed, which holds on
+  // to its capacity so that steady-state staging doesn't reallocate.
+  struct Shard {
+    SpinLockMutex mutex;
+    std::vector<T> staged;
+    std::vector<T> consumed;
+    char padding[64];
+  };
+
+  size_t num_shards_;
+  std::unique_ptr<Shard[]> shards_;
+
+  static size_t ComputeNumShards(size_t num_shards) noexcept {
+    if (num_shards == 0) {
+      num_shards = std::thread::hardware_concurrency();
+      if (num_shards > MaxDefaultNumShards) {
+        num_shards = MaxDefaultNumShards;
+      }
+    }
+    return std::max<size_t>(num_shards, 1);
+  }
+
+  // Splits max_size across the shards the same way ShardedCircularBuffer
+  // does.
+  size_t ComputeMaxShardSize(size_t max_size, size_t shard_index) const
+      noexcept {
+    auto result = max_size / num_shards_ +
+                  static_cast<size_t>(shard_index < max_size % num_shards_);
+    return std::max<size_t>(result, 1);
+  }
+
+  static size_t GetThreadShardIndex() noexcept {
+    static std::atomic<size_t> next_index{0};
+    static thread_local size_t index =
+        next_index.fetch_add(1, std::memory_order_relaxed);
+    return index;
+  }
+};
+
+template <class T>
+const size_t ShardedStagingBuffer<T>::MaxDefaultNumShards;
+}  // namespace lightstep
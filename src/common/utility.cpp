@@ -2,14 +2,13 @@
 
 #include <array>
 #include <cctype>
-#include <cmath>
-#include <iomanip>
 #include <random>
-#include <sstream>
 #include <stdexcept>
 #include <system_error>
 
+#include "common/direct_coded_output_stream.h"
 #include "common/hex_conversion.h"
+#include "common/json_serialization.h"
 #include "common/platform/time.h"
 
 #include <opentracing/string_view.h>
@@ -43,129 +42,15 @@ timeval ToTimeval(std::chrono::microseconds microseconds) {
   return result;
 }
 
-//------------------------------------------------------------------------------
-// WriteEscapedString
-//------------------------------------------------------------------------------
-// The implementation is based off of this answer from StackOverflow:
-// https://stackoverflow.com/a/33799784
-static void WriteEscapedString(std::ostringstream& writer,
-                               opentracing::string_view s) {
-  writer << '"';
-  for (auto c_prime : s) {
-    auto c = static_cast<signed char>(c_prime);
-    switch (c) {
-      case '"':
-        writer << R"(\")";
-        break;
-      case '\\':
-        writer << R"(\\)";
-        break;
-      case '\b':
-        writer << R"(\b)";
-        break;
-      case '\n':
-        writer << R"(\n)";
-        break;
-      case '\r':
-        writer << R"(\r)";
-        break;
-      case '\t':
-        writer << R"(\t)";
-        break;
-      default:
-        if (static_cast<signed char>('\x00') <= c &&
-            c <= static_cast<signed char>('\x1f')) {
-          writer << R"(\u)";
-          writer << std::hex << std::setw(4) << std::setfill('0')
-                 << static_cast<int>(c);
-        } else {
-          writer << c;
-        }
-    }
-  }
-  writer << '"';
-}
-
 //------------------------------------------------------------------------------
 // ToJson
 //------------------------------------------------------------------------------
-static void ToJson(std::ostringstream& writer, const opentracing::Value& value);
-
-namespace {
-struct JsonValueVisitor {
-  std::ostringstream& writer;
-
-  void operator()(bool value) {
-    if (value) {
-      writer << "true";
-    } else {
-      writer << "false";
-    }
-  }
-
-  void operator()(double value) {
-    if (std::isnan(value)) {
-      writer << R"("NaN")";
-    } else if (std::isinf(value)) {
-      if (std::signbit(value)) {
-        writer << R"("-Inf")";
-      } else {
-        writer << R"("+Inf")";
-      }
-    } else {
-      writer << value;
-    }
-  }
-
-  void operator()(int64_t value) { writer << value; }
-
-  void operator()(uint64_t value) { writer << value; }
-
-  void operator()(const std::string& s) { WriteEscapedString(writer, s); }
-
-  void operator()(std::nullptr_t) { writer << "null"; }
-
-  void operator()(const char* s) { WriteEscapedString(writer, s); }
-
-  void operator()(const opentracing::Values& values) {
-    writer << '[';
-    size_t i = 0;
-    for (const auto& value : values) {
-      ToJson(writer, value);
-      if (++i < values.size()) {
-        writer << ',';
-      }
-    }
-    writer << ']';
-  }
-
-  void operator()(const opentracing::Dictionary& dictionary) {
-    writer << '{';
-    size_t i = 0;
-    for (const auto& key_value : dictionary) {
-      WriteEscapedString(writer, key_value.first);
-      writer << ':';
-      ToJson(writer, key_value.second);
-      if (++i < dictionary.size()) {
-        writer << ',';
-      }
-    }
-    writer << '}';
-  }
-};
-}  // anonymous namespace
-
-static void ToJson(std::ostringstream& writer,
-                   const opentracing::Value& value) {
-  JsonValueVisitor value_visitor{writer};
-  apply_visitor(value_visitor, value);
-}
-
 std::string ToJson(const opentracing::Value& value) {
-  std::ostringstream writer;
-  writer.exceptions(std::ios::badbit | std::ios::failbit);
-  ToJson(writer, value);
-  return writer.str();
+  std::string result(ComputeJsonSerializationSize(value), ' ');
+  DirectCodedOutputStream stream{
+      reinterpret_cast<google::protobuf::uint8*>(&result[0])};
+  WriteJson(stream, value);
+  return result;
 }
 
 //------------------------------------------------------------------------------
@@ -206,10 +91,18 @@ struct ValueVisitor {
 collector::KeyValue ToKeyValue(opentracing::string_view key,
                                const opentracing::Value& value) {
   collector::KeyValue key_value;
-  key_value.set_key(key);
+  SetKeyValue(key_value, key, value);
+  return key_value;
+}
+
+//------------------------------------------------------------------------------
+// SetKeyValue
+//------------------------------------------------------------------------------
+void SetKeyValue(collector::KeyValue& key_value, opentracing::string_view key,
+                 const opentracing::Value& value) {
+  key_value.set_key(key.data(), key.size());
   ValueVisitor value_visitor{key_value, value};
   apply_visitor(value_visitor, value);
-  return key_value;
 }
 
 //------------------------------------------------------------------------------
@@ -60,6 +60,31 @@ std::string ToJson(const opentracing::Value& value);
 collector::KeyValue ToKeyValue(opentracing::string_view key,
                                const opentracing::Value& value);
 
+// Sets key_value from an OpenTracing key-value pair. Unlike ToKeyValue, this
+// builds the message in place so that it stays on key_value's arena.
+void SetKeyValue(collector::KeyValue& key_value, opentracing::string_view key,
+                 const opentracing::Value& value);
+
+/**
+ * Sets the timestamp and fields of a protobuf log record in place.
+ * @param log the log record to set
+ * @param timestamp the timestamp for the log record
+ * @param field_first the first iterator for the log fields
+ * @param field_last the last iterator for the log fields
+ */
+template <class Iterator>
+void SetLog(collector::Log& log,
+            std::chrono::system_clock::time_point timestamp,
+            Iterator field_first, Iterator field_last) {
+  *log.mutable_timestamp() = ToTimestamp(timestamp);
+  auto& key_values = *log.mutable_fields();
+  key_values.Reserve(static_cast<int>(std::distance(field_first, field_last)));
+  for (Iterator field_iter = field_first; field_iter != field_last;
+       ++field_iter) {
+    SetKeyValue(*key_values.Add(), field_iter->first, field_iter->second);
+  }
+}
+
 /**
  * Creates a protobuf log record.
  * @param timestamp the timestamp for the log record
@@ -71,13 +96,7 @@ template <class Iterator>
 collector::Log ToLog(std::chrono::system_clock::time_point timestamp,
                      Iterator field_first, Iterator field_last) {
   collector::Log result;
-  *result.mutable_timestamp() = ToTimestamp(timestamp);
-  auto& key_values = *result.mutable_fields();
-  key_values.Reserve(static_cast<int>(std::distance(field_first, field_last)));
-  for (Iterator field_iter = field_first; field_iter != field_last;
-       ++field_iter) {
-    *key_values.Add() = ToKeyValue(field_iter->first, field_iter->second);
-  }
+  SetLog(result, timestamp, field_first, field_last);
   return result;
 }
 
@@ -0,0 +1,107 @@
+#include "network/event_notifier.h"
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+#include "common/platform/error.h"
+
+#include <event2/util.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// ThrowNotifierError
+//--------------------------------------------------------------------------------------------------
+[[noreturn]] static void ThrowNotifierError(const char* what) {
+  std::ostringstream oss;
+  oss << what << ": " << GetErrorCodeMessage(GetLastErrorCode());
+  throw std::runtime_error{oss.str()};
+}
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+EventNotifier::EventNotifier() {
+#ifdef __linux__
+  read_descriptor_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (read_descriptor_ == -1) {
+    ThrowNotifierError("failed to create eventfd");
+  }
+  write_descriptor_ = read_descriptor_;
+#else
+#ifdef _WIN32
+  const int family = AF_INET;
+#else
+  const int family = AF_UNIX;
+#endif
+  evutil_socket_t descriptors[2];
+  if (evutil_socketpair(family, SOCK_STREAM, 0, descriptors) != 0) {
+    ThrowNotifierError("failed to create socket pair");
+  }
+  read_descriptor_ = descriptors[0];
+  write_descriptor_ = descriptors[1];
+  if (evutil_make_socket_nonblocking(read_descriptor_) != 0 ||
+      evutil_make_socket_nonblocking(write_descriptor_) != 0) {
+    evutil_closesocket(read_descriptor_);
+    evutil_closesocket(write_descriptor_);
+    ThrowNotifierError("failed to set the socket pair as non-blocking");
+  }
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+// destructor
+//--------------------------------------------------------------------------------------------------
+EventNotifier::~EventNotifier() noexcept {
+  evutil_closesocket(read_descriptor_);
+  if (write_descriptor_ != read_descriptor_) {
+    evutil_closesocket(write_descriptor_);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Notify
+//--------------------------------------------------------------------------------------------------
+void EventNotifier::Notify() noexcept {
+  if (pending_.exchange(true)) {
+    return;
+  }
+  // Note: if the write fails, it's because the descriptor is already readable
+  // so there's nothing to handle.
+#ifdef __linux__
+  uint64_t value = 1;
+  auto rcode = ::write(write_descriptor_, static_cast<void*>(&value),
+                       sizeof(value));
+#else
+  char value = 0;
+  auto iovec = MakeIoVec(static_cast<void*>(&value), sizeof(value));
+  auto rcode = WriteV(write_descriptor_, &iovec, 1);
+#endif
+  (void)rcode;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Consume
+//--------------------------------------------------------------------------------------------------
+void EventNotifier::Consume() noexcept {
+  // Drain the descriptor before clearing the pending flag; otherwise, a
+  // notification written in between could be lost.
+#ifdef __linux__
+  uint64_t value;
+  auto rcode =
+      Read(read_descriptor_, static_cast<void*>(&value), sizeof(value));
+  (void)rcode;
+#else
+  char buffer[64];
+  while (Read(read_descriptor_, static_cast<void*>(buffer), sizeof(buffer)) >
+         0) {
+  }
+#endif
+  pending_.store(false);
+}
+}  // namespace lightstep
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+
+#include "common/noncopyable.h"
+#include "common/platform/network.h"
+
+namespace lightstep {
+/**
+ * Lets other threads wake up an event loop.
+ *
+ * The event loop watches file_descriptor() for reads and calls Consume when
+ * it becomes readable. Notifications are coalesced so that at most one is
+ * outstanding at a time; any thread can call Notify cheaply when the loop has
+ * already been woken up but hasn't yet consumed the notification.
+ *
+ * Uses an eventfd on linux and a socket pair elsewhere.
+ */
+class EventNotifier : private Noncopyable {
+ public:
+  EventNotifier();
+
+  ~EventNotifier() noexcept;
+
+  /**
+   * @return the file descriptor that becomes readable when notified.
+   */
+  FileDescriptor file_descriptor() const noexcept { return read_descriptor_; }
+
+  /**
+   * Wake up the event loop if a notification isn't already pending.
+   *
+   * Note: This method can be called from any thread.
+   */
+  void Notify() noexcept;
+
+  /**
+   * Clear a pending notification.
+   *
+   * Note: This method must only be called from the event loop's thread and
+   * before it checks for the work it was notified about.
+   */
+  void Consume() noexcept;
+
+  /**
+   * @return true if a notification is pending.
+   */
+  bool pending() const noexcept { return pending_.load(); }
+
+ private:
+  FileDescriptor read_descriptor_{InvalidSocket};
+  FileDescriptor write_descriptor_{InvalidSocket};
+  std::atomic<bool> pending_{false};
+};
+}  // namespace lightstep
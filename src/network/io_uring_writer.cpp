@@ -0,0 +1,598 @@
+#include "network/io_uring_writer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "network/event_base.h"
+
+#include <event2/event.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef IORING_FEAT_FAST_POLL
+#define LIGHTSTEP_HAS_IO_URING
+#endif
+#endif
+#endif
+
+#ifdef LIGHTSTEP_HAS_IO_URING
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lightstep {
+const uint32_t IoUringWriter::DefaultQueueDepth;
+
+//--------------------------------------------------------------------------------------------------
+// ThrowIoUringError
+//--------------------------------------------------------------------------------------------------
+[[noreturn]] static void ThrowIoUringError(const char* what,
+                                           ErrorCode error_code) {
+  std::ostringstream oss;
+  oss << what << ": " << GetErrorCodeMessage(error_code);
+  throw std::runtime_error{oss.str()};
+}
+
+//--------------------------------------------------------------------------------------------------
+// IoUringWrite constructor
+//--------------------------------------------------------------------------------------------------
+IoUringWrite::IoUringWrite(IoUringWriter& writer, Callback callback,
+                           void* context) noexcept
+    : writer_{writer}, callback_{callback}, context_{context} {}
+
+//--------------------------------------------------------------------------------------------------
+// IoUringWrite destructor
+//--------------------------------------------------------------------------------------------------
+IoUringWrite::~IoUringWrite() noexcept { Cancel(); }
+
+//--------------------------------------------------------------------------------------------------
+// Queue
+//--------------------------------------------------------------------------------------------------
+bool IoUringWrite::Queue(
+    FileDescriptor socket,
+    std::initializer_list<FragmentInputStream*> fragment_input_streams) {
+  assert(!pending_);
+  int num_fragments = 0;
+  for (auto fragment_input_stream : fragment_input_streams) {
+    num_fragments += fragment_input_stream->num_fragments();
+  }
+  iovecs_.clear();
+  iovecs_.reserve(static_cast<size_t>(num_fragments));
+  first_iovec_index_ = 0;
+  for (auto fragment_input_stream : fragment_input_streams) {
+    fragment_input_stream->ForEachFragment([this](void* data, int size) {
+      if (size > 0) {
+        iovecs_.push_back(MakeIoVec(data, static_cast<size_t>(size)));
+      }
+      return true;
+    });
+  }
+  if (!iovecs_.empty()) {
+    socket_ = socket;
+    canceled_ = false;
+    auto error_code = writer_.QueueEntries(*this);
+    if (error_code != 0) {
+      ThrowIoUringError("failed to queue io_uring write", error_code);
+    }
+    pending_ = true;
+  }
+  for (auto fragment_input_stream : fragment_input_streams) {
+    fragment_input_stream->Clear();
+  }
+  return pending_;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Cancel
+//--------------------------------------------------------------------------------------------------
+void IoUringWrite::Cancel() noexcept {
+  if (!pending_) {
+    return;
+  }
+  writer_.Cancel(*this);
+  pending_ = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnSubmit
+//--------------------------------------------------------------------------------------------------
+void IoUringWriter::OnSubmit(FileDescriptor /*file_descriptor*/,
+                             short /*what*/) noexcept {
+  submit_scheduled_ = false;
+
+  // If the kernel can't take the entries right now, they're submitted again
+  // when the next completions are handled.
+  Submit();
+}
+
+#ifdef LIGHTSTEP_HAS_IO_URING
+//--------------------------------------------------------------------------------------------------
+// Ring
+//--------------------------------------------------------------------------------------------------
+struct IoUringWriter::Ring {
+  int file_descriptor{-1};
+  int event_file_descriptor{-1};
+  io_uring_params params;
+
+  void* memory{MAP_FAILED};
+  size_t memory_size{0};
+  void* sqes_memory{MAP_FAILED};
+  size_t sqes_size{0};
+
+  unsigned* sq_head{nullptr};
+  unsigned* sq_tail{nullptr};
+  unsigned* sq_mask{nullptr};
+  unsigned* sq_flags{nullptr};
+  unsigned* sq_array{nullptr};
+  io_uring_sqe* sqes{nullptr};
+
+  unsigned* cq_head{nullptr};
+  unsigned* cq_tail{nullptr};
+  unsigned* cq_mask{nullptr};
+  io_uring_cqe* cqes{nullptr};
+
+  ~Ring() noexcept {
+    if (sqes_memory != MAP_FAILED) {
+      ::munmap(sqes_memory, sqes_size);
+    }
+    if (memory != MAP_FAILED) {
+      ::munmap(memory, memory_size);
+    }
+    if (file_descriptor >= 0) {
+      ::close(file_descriptor);
+    }
+    if (event_file_descriptor >= 0) {
+      ::close(event_file_descriptor);
+    }
+  }
+
+  uint32_t num_free_entries() const noexcept {
+    return params.sq_entries -
+           (*sq_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE));
+  }
+
+  bool cq_overflowed() const noexcept {
+#ifdef IORING_SQ_CQ_OVERFLOW
+    return (__atomic_load_n(sq_flags, __ATOMIC_RELAXED) &
+            IORING_SQ_CQ_OVERFLOW) != 0;
+#else
+    return false;
+#endif
+  }
+
+  // Only the writer advances the submission queue's tail, so it can be read
+  // without synchronization.
+  io_uring_sqe& entry(uint32_t offset) noexcept {
+    auto index = (*sq_tail + offset) & *sq_mask;
+    sq_array[index] = index;
+    auto& result = sqes[index];
+    std::memset(static_cast<void*>(&result), 0, sizeof(result));
+    return result;
+  }
+
+  void PublishEntries(uint32_t num_entries) noexcept {
+    __atomic_store_n(sq_tail, *sq_tail + num_entries, __ATOMIC_RELEASE);
+  }
+
+  uint32_t num_completions() const noexcept {
+    return __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) - *cq_head;
+  }
+
+  bool PopCompletion(uint64_t& user_data, int& result) noexcept {
+    auto head = *cq_head;
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    auto& cqe = cqes[head & *cq_mask];
+    user_data = cqe.user_data;
+    result = cqe.res;
+    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  int Enter(uint32_t to_submit, uint32_t min_complete) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, file_descriptor,
+                                      to_submit, min_complete,
+                                      IORING_ENTER_GETEVENTS, nullptr, 0));
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
+// RingPointer
+//--------------------------------------------------------------------------------------------------
+template <class T>
+static T* RingPointer(void* memory, uint32_t offset) noexcept {
+  return reinterpret_cast<T*>(static_cast<char*>(memory) + offset);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ToUserData
+//--------------------------------------------------------------------------------------------------
+// Cancellations are submitted with no user data so that their completions can
+// be told apart from those of writes.
+static uint64_t ToUserData(const IoUringWrite& write) noexcept {
+  return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&write));
+}
+
+//--------------------------------------------------------------------------------------------------
+// IoUringWriter constructor
+//--------------------------------------------------------------------------------------------------
+IoUringWriter::IoUringWriter(const EventBase& event_base, uint32_t queue_depth)
+    : ring_{new Ring{}} {
+  auto& ring = *ring_;
+  auto& params = ring.params;
+  std::memset(static_cast<void*>(&params), 0, sizeof(params));
+  ring.file_descriptor =
+      static_cast<int>(::syscall(__NR_io_uring_setup, queue_depth, &params));
+  if (ring.file_descriptor < 0) {
+    ThrowIoUringError("io_uring_setup failed", GetLastErrorCode());
+  }
+
+  // Besides mapping both rings at once, require that completions are never
+  // dropped and that writes to full sockets wait on a poll, which also makes
+  // them cancelable, rather than block a kernel worker thread.
+  const uint32_t required_features =
+      IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL;
+  if ((params.features & required_features) != required_features) {
+    throw std::runtime_error{"io_uring is missing required features"};
+  }
+  ring.memory_size =
+      std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+               params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+  ring.memory = ::mmap(nullptr, ring.memory_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring.file_descriptor,
+                       IORING_OFF_SQ_RING);
+  if (ring.memory == MAP_FAILED) {
+    ThrowIoUringError("failed to map io_uring", GetLastErrorCode());
+  }
+  ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  ring.sqes_memory = ::mmap(nullptr, ring.sqes_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring.file_descriptor,
+                            IORING_OFF_SQES);
+  if (ring.sqes_memory == MAP_FAILED) {
+    ThrowIoUringError("failed to map io_uring", GetLastErrorCode());
+  }
+  auto memory = ring.memory;
+  ring.sq_head = RingPointer<unsigned>(memory, params.sq_off.head);
+  ring.sq_tail = RingPointer<unsigned>(memory, params.sq_off.tail);
+  ring.sq_mask = RingPointer<unsigned>(memory, params.sq_off.ring_mask);
+  ring.sq_flags = RingPointer<unsigned>(memory, params.sq_off.flags);
+  ring.sq_array = RingPointer<unsigned>(memory, params.sq_off.array);
+  ring.sqes = static_cast<io_uring_sqe*>(ring.sqes_memory);
+  ring.cq_head = RingPointer<unsigned>(memory, params.cq_off.head);
+  ring.cq_tail = RingPointer<unsigned>(memory, params.cq_off.tail);
+  ring.cq_mask = RingPointer<unsigned>(memory, params.cq_off.ring_mask);
+  ring.cqes = RingPointer<io_uring_cqe>(memory, params.cq_off.cqes);
+
+  ring.event_file_descriptor = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (ring.event_file_descriptor < 0) {
+    ThrowIoUringError("failed to create eventfd", GetLastErrorCode());
+  }
+  if (::syscall(__NR_io_uring_register, ring.file_descriptor,
+                IORING_REGISTER_EVENTFD, &ring.event_file_descriptor, 1) != 0) {
+    ThrowIoUringError("failed to register eventfd with io_uring",
+                      GetLastErrorCode());
+  }
+
+  completion_event_ =
+      Event{event_base, ring.event_file_descriptor, EV_READ | EV_PERSIST,
+            MakeEventCallback<IoUringWriter,
+                              &IoUringWriter::OnCompletionsReady>(),
+            static_cast<void*>(this)};
+  completion_event_.Add(nullptr);
+  submit_event_ = Event{
+      event_base, -1, 0,
+      MakeEventCallback<IoUringWriter, &IoUringWriter::OnSubmit>(),
+      static_cast<void*>(this)};
+}
+
+//--------------------------------------------------------------------------------------------------
+// IoUringWriter destructor
+//--------------------------------------------------------------------------------------------------
+IoUringWriter::~IoUringWriter() noexcept = default;
+
+//--------------------------------------------------------------------------------------------------
+// Advance
+//--------------------------------------------------------------------------------------------------
+bool IoUringWrite::Advance(size_t num_bytes) noexcept {
+  while (first_iovec_index_ < iovecs_.size()) {
+    auto& iovec = iovecs_[first_iovec_index_];
+    if (num_bytes < iovec.iov_len) {
+      iovec = MakeIoVec(static_cast<char*>(iovec.iov_base) + num_bytes,
+                        iovec.iov_len - num_bytes);
+      return false;
+    }
+    num_bytes -= iovec.iov_len;
+    ++first_iovec_index_;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// QueueEntries
+//--------------------------------------------------------------------------------------------------
+ErrorCode IoUringWriter::QueueEntries(IoUringWrite& write) noexcept {
+  if (failed_) {
+    return EIO;
+  }
+  auto& ring = *ring_;
+
+  // A write with more fragments than fit in the submission queue writes the
+  // rest once the entries that did fit complete.
+  auto iovec_iter = write.iovecs_.data() + write.first_iovec_index_;
+  auto iovec_last = write.iovecs_.data() + write.iovecs_.size();
+  auto num_iovecs = static_cast<size_t>(iovec_last - iovec_iter);
+  auto max_batch_size = static_cast<size_t>(IoVecMax);
+  auto num_entries = static_cast<uint32_t>(
+      std::min<size_t>((num_iovecs + max_batch_size - 1) / max_batch_size,
+                       ring.params.sq_entries));
+  if (ring.num_free_entries() < num_entries) {
+    auto error_code = Submit();
+    if (error_code != 0) {
+      return error_code;
+    }
+  }
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    auto& sqe = ring.entry(i);
+    auto num_batch_iovecs =
+        std::min<ptrdiff_t>(IoVecMax, iovec_last - iovec_iter);
+    sqe.opcode = IORING_OP_WRITEV;
+    sqe.fd = write.socket_;
+    sqe.addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(iovec_iter));
+    sqe.len = static_cast<uint32_t>(num_batch_iovecs);
+    if (i + 1 < num_entries) {
+      sqe.flags = IOSQE_IO_LINK;
+    }
+    sqe.user_data = ToUserData(write);
+    iovec_iter += num_batch_iovecs;
+  }
+  ring.PublishEntries(num_entries);
+  num_unsubmitted_entries_ += num_entries;
+  write.num_queued_entries_ = static_cast<int>(num_entries);
+  write.num_bytes_written_ = 0;
+  write.blocked_ = false;
+  write.error_code_ = 0;
+
+  // Submit once the event loop is done with the callbacks it's running so
+  // that the writes they queue all go in the same system call.
+  if (!submit_scheduled_) {
+    event_active(submit_event_.libevent_handle(), EV_TIMEOUT, 0);
+    submit_scheduled_ = true;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Cancel
+//--------------------------------------------------------------------------------------------------
+void IoUringWriter::Cancel(IoUringWrite& write) noexcept {
+  write.canceled_ = true;
+  for (auto& completion : deferred_completions_) {
+    if (completion.first == &write) {
+      OnCompletion(write, completion.second);
+      completion.first = nullptr;
+    }
+  }
+  deferred_completions_.erase(
+      std::remove_if(deferred_completions_.begin(), deferred_completions_.end(),
+                     [](const std::pair<IoUringWrite*, int>& completion) {
+                       return completion.first == nullptr;
+                     }),
+      deferred_completions_.end());
+  if (write.num_queued_entries_ == 0 || failed_) {
+    return;
+  }
+
+  // Canceling the entry that's waiting on the socket fails the ones linked
+  // after it.
+  auto& ring = *ring_;
+  if (ring.num_free_entries() > 0 || Submit() == 0) {
+    auto& sqe = ring.entry(0);
+    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+    sqe.addr = ToUserData(write);
+    ring.PublishEntries(1);
+    ++num_unsubmitted_entries_;
+  }
+
+  // Wait for every entry of the write to complete, since until then the
+  // kernel can still reference its memory.
+  while (write.num_queued_entries_ > 0) {
+    if (DeferCompletions(&write) > 0) {
+      continue;
+    }
+    auto rcode = ring.Enter(num_unsubmitted_entries_, 1);
+    if (rcode >= 0) {
+      num_unsubmitted_entries_ -= static_cast<uint32_t>(rcode);
+      continue;
+    }
+    auto error_code = GetLastErrorCode();
+    if (error_code == EINTR || error_code == EBUSY || error_code == EAGAIN) {
+      continue;
+    }
+    // The ring is unusable, so stop submitting to it; entries that were never
+    // submitted then can't reference the write's memory.
+    failed_ = true;
+    return;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Submit
+//--------------------------------------------------------------------------------------------------
+ErrorCode IoUringWriter::Submit() noexcept {
+  while (num_unsubmitted_entries_ > 0) {
+    if (failed_) {
+      return EIO;
+    }
+    auto rcode = ring_->Enter(num_unsubmitted_entries_, 0);
+    if (rcode > 0) {
+      num_unsubmitted_entries_ -= static_cast<uint32_t>(rcode);
+      continue;
+    }
+    auto error_code = rcode < 0 ? GetLastErrorCode() : EAGAIN;
+    if (error_code == EINTR) {
+      continue;
+    }
+
+    // The kernel refuses entries while it has completions it can't post, so
+    // make room by reaping them.
+    if ((error_code == EBUSY || error_code == EAGAIN) &&
+        DeferCompletions(nullptr) > 0) {
+      continue;
+    }
+    return error_code;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnCompletion
+//--------------------------------------------------------------------------------------------------
+void IoUringWriter::OnCompletion(IoUringWrite& write, int result) noexcept {
+  assert(write.num_queued_entries_ > 0);
+  --write.num_queued_entries_;
+  if (result > 0) {
+    write.num_bytes_written_ += static_cast<size_t>(result);
+  } else if (result < 0 && result != -ECANCELED) {
+    // Entries linked after a short write are canceled and resubmitted.
+    auto error_code = -result;
+    if (IsBlockingErrorCode(error_code) || error_code == EINTR) {
+      write.blocked_ = true;
+    } else if (write.error_code_ == 0) {
+      write.error_code_ = error_code;
+    }
+  }
+  if (write.num_queued_entries_ > 0 || write.canceled_) {
+    return;
+  }
+  auto error_code = write.error_code_;
+  if (error_code == 0) {
+    auto made_progress = write.num_bytes_written_ > 0 || write.blocked_;
+    if (write.Advance(write.num_bytes_written_)) {
+      error_code = 0;
+    } else if (made_progress) {
+      error_code = QueueEntries(write);
+      if (error_code == 0) {
+        return;
+      }
+    } else {
+      error_code = EIO;
+    }
+  }
+  write.pending_ = false;
+  write.callback_(error_code, write.context_);
+}
+
+//--------------------------------------------------------------------------------------------------
+// DeferCompletions
+//--------------------------------------------------------------------------------------------------
+size_t IoUringWriter::DeferCompletions(IoUringWrite* canceled_write) noexcept {
+  auto& ring = *ring_;
+  auto num_completions = ring.num_completions();
+  try {
+    deferred_completions_.reserve(deferred_completions_.size() +
+                                  num_completions);
+  } catch (const std::exception& /*e*/) {
+    return 0;
+  }
+  uint64_t user_data;
+  int result;
+  for (uint32_t i = 0; i < num_completions; ++i) {
+    if (!ring.PopCompletion(user_data, result)) {
+      break;
+    }
+    if (user_data == 0) {
+      continue;
+    }
+    auto write = reinterpret_cast<IoUringWrite*>(user_data);
+    if (write == canceled_write) {
+      OnCompletion(*write, result);
+      continue;
+    }
+    deferred_completions_.emplace_back(write, result);
+  }
+  return num_completions;
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnCompletionsReady
+//--------------------------------------------------------------------------------------------------
+void IoUringWriter::OnCompletionsReady(FileDescriptor file_descriptor,
+                                       short /*what*/) noexcept {
+  // Note: The eventfd is reset before reaping so that completions posted in
+  // the meantime wake the event loop up again.
+  uint64_t value;
+  auto rcode =
+      ::read(file_descriptor, static_cast<void*>(&value), sizeof(value));
+  (void)rcode;
+  auto& ring = *ring_;
+  while (true) {
+    IoUringWrite* write;
+    int result;
+    if (!deferred_completions_.empty()) {
+      write = deferred_completions_.front().first;
+      result = deferred_completions_.front().second;
+      deferred_completions_.erase(deferred_completions_.begin());
+    } else {
+      uint64_t user_data;
+      if (!ring.PopCompletion(user_data, result)) {
+        // Completions that didn't fit in the queue are only posted from a
+        // system call.
+        if (!ring.cq_overflowed() || failed_ || ring.Enter(0, 0) < 0) {
+          break;
+        }
+        continue;
+      }
+      if (user_data == 0) {
+        continue;
+      }
+      write = reinterpret_cast<IoUringWrite*>(user_data);
+    }
+    OnCompletion(*write, result);
+  }
+  Submit();
+}
+#else
+//--------------------------------------------------------------------------------------------------
+// Ring
+//--------------------------------------------------------------------------------------------------
+struct IoUringWriter::Ring {};
+
+//--------------------------------------------------------------------------------------------------
+// IoUringWriter constructor
+//--------------------------------------------------------------------------------------------------
+IoUringWriter::IoUringWriter(const EventBase& /*event_base*/,
+                             uint32_t /*queue_depth*/) {
+  throw std::runtime_error{"io_uring isn't supported on this platform"};
+}
+
+//--------------------------------------------------------------------------------------------------
+// IoUringWriter destructor
+//--------------------------------------------------------------------------------------------------
+IoUringWriter::~IoUringWriter() noexcept = default;
+
+//--------------------------------------------------------------------------------------------------
+// QueueEntries
+//--------------------------------------------------------------------------------------------------
+ErrorCode IoUringWriter::QueueEntries(IoUringWrite& /*write*/) noexcept {
+  return EIO;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Cancel
+//--------------------------------------------------------------------------------------------------
+void IoUringWriter::Cancel(IoUringWrite& /*write*/) noexcept {}
+
+//--------------------------------------------------------------------------------------------------
+// Submit
+//--------------------------------------------------------------------------------------------------
+ErrorCode IoUringWriter::Submit() noexcept { return 0; }
+#endif
+}  // namespace lightstep
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/fragment_input_stream.h"
+#include "common/noncopyable.h"
+#include "common/platform/error.h"
+#include "common/platform/network.h"
+#include "network/event.h"
+
+namespace lightstep {
+class EventBase;
+class IoUringWriter;
+
+/**
+ * A write of fragments to a socket that's sent through an IoUringWriter.
+ *
+ * The write copies the iovecs of the fragments when it's queued, so their
+ * streams are consumed right away; but the memory the fragments point to has
+ * to stay valid until the write completes or is canceled. Short writes are
+ * resubmitted until every byte is written, and only then is the callback
+ * called.
+ */
+class IoUringWrite : private Noncopyable {
+ public:
+  using Callback = void (*)(ErrorCode error_code, void* context);
+
+  /**
+   * @param writer the IoUringWriter to send the write through
+   * @param callback called with 0 once every byte is written or with the
+   * error the write failed with
+   * @param context passed to the callback
+   */
+  IoUringWrite(IoUringWriter& writer, Callback callback,
+               void* context) noexcept;
+
+  /**
+   * Cancels the write if it's pending.
+   */
+  ~IoUringWrite() noexcept;
+
+  /**
+   * Queues a write of fragments to a socket and consumes them from their
+   * streams. The write is submitted along with every other write queued
+   * before the event loop gets to the IoUringWriter.
+   * @param socket the file descriptor of the socket
+   * @param fragment_input_streams the fragments to write
+   * @return true if a write was queued; false if there was nothing to write.
+   *
+   * Note: A write can only be queued if the last one isn't pending.
+   */
+  bool Queue(
+      FileDescriptor socket,
+      std::initializer_list<FragmentInputStream*> fragment_input_streams);
+
+  /**
+   * Cancels the write if it's pending and waits until the kernel is done with
+   * its memory. The callback isn't called.
+   */
+  void Cancel() noexcept;
+
+  /**
+   * @return true if the write was queued and hasn't completed.
+   */
+  bool pending() const noexcept { return pending_; }
+
+ private:
+  friend class IoUringWriter;
+
+  IoUringWriter& writer_;
+  Callback callback_;
+  void* context_;
+  FileDescriptor socket_{InvalidSocket};
+  std::vector<IoVec> iovecs_;
+  size_t first_iovec_index_{0};
+  bool pending_{false};
+  bool canceled_{false};
+
+  // The state of the entries last submitted for the write.
+  int num_queued_entries_{0};
+  size_t num_bytes_written_{0};
+  bool blocked_{false};
+  ErrorCode error_code_{0};
+
+  bool Advance(size_t num_bytes) noexcept;
+};
+
+/**
+ * Sends writes to sockets with io_uring.
+ *
+ * Every IoVecMax fragments of a write become an IORING_OP_WRITEV entry, and
+ * the entries of a write are linked so that a short write cancels the rest
+ * instead of leaving a gap. Writes queued while the event loop runs its
+ * callbacks are all submitted with a single system call, and their completions
+ * are reaped when an eventfd registered with the ring wakes up the event loop.
+ *
+ * The constructor throws if the kernel doesn't support io_uring or lacks
+ * the features relied on, so that callers can fall back to writev.
+ */
+class IoUringWriter : private Noncopyable {
+ public:
+  // The default number of entries in the submission queue.
+  static const uint32_t DefaultQueueDepth = 64;
+
+  /**
+   * @param event_base the event loop to submit and complete writes on
+   * @param queue_depth the number of entries in the submission queue
+   */
+  explicit IoUringWriter(const EventBase& event_base,
+                         uint32_t queue_depth = DefaultQueueDepth);
+
+  /**
+   * Note: Every write must be completed or canceled first.
+   */
+  ~IoUringWriter() noexcept;
+
+ private:
+  friend class IoUringWrite;
+  struct Ring;
+
+  std::unique_ptr<Ring> ring_;
+  Event completion_event_;
+  Event submit_event_;
+  bool submit_scheduled_{false};
+  bool failed_{false};
+  uint32_t num_unsubmitted_entries_{0};
+
+  // Completions reaped while waiting for a canceled write, which are handled
+  // the next time the event loop gets to the writer.
+  std::vector<std::pair<IoUringWrite*, int>> deferred_completions_;
+
+  ErrorCode QueueEntries(IoUringWrite& write) noexcept;
+
+  void Cancel(IoUringWrite& write) noexcept;
+
+  ErrorCode Submit() noexcept;
+
+  void OnCompletion(IoUringWrite& write, int result) noexcept;
+
+  size_t DeferCompletions(IoUringWrite* canceled_write) noexcept;
+
+  void OnCompletionsReady(FileDescriptor file_descriptor, short what) noexcept;
+
+  void OnSubmit(FileDescriptor file_descriptor, short what) noexcept;
+};
+
+/**
+ * For a given method, creates a callback that can be passed to IoUringWrite.
+ * @return a function pointer that can be passed to IoUringWrite.
+ */
+template <class T, void (T::*MemberFunction)(ErrorCode)>
+IoUringWrite::Callback MakeIoUringWriteCallback() noexcept {
+  return [](ErrorCode error_code, void* context) {
+    (static_cast<T*>(context)->*MemberFunction)(error_code);
+  };
+}
+}  // namespace lightstep
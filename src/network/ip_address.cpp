@@ -35,6 +35,11 @@ IpAddress::IpAddress(const sockaddr& addr) noexcept {
   } else if (addr.sa_family == AF_INET6) {
     reinterpret_cast<sockaddr_in6&>(data_) =
         reinterpret_cast<const sockaddr_in6&>(addr);
+#ifndef _WIN32
+  } else if (addr.sa_family == AF_UNIX) {
+    reinterpret_cast<sockaddr_un&>(data_) =
+        reinterpret_cast<const sockaddr_un&>(addr);
+#endif
   } else {
     assert(0 && "Unknown address family");
   }
@@ -65,6 +70,24 @@ IpAddress::IpAddress(const char* s, uint16_t port) : IpAddress{s} {
   set_port(port);
 }
 
+//--------------------------------------------------------------------------------------------------
+// addr_length
+//--------------------------------------------------------------------------------------------------
+size_t IpAddress::addr_length() const noexcept {
+  switch (family()) {
+    case AF_INET:
+      return sizeof(sockaddr_in);
+    case AF_INET6:
+      return sizeof(sockaddr_in6);
+#ifndef _WIN32
+    case AF_UNIX:
+      return sizeof(sockaddr_un);
+#endif
+  }
+  assert(0 && "Unknown address family");
+  return sizeof(data_);
+}
+
 //--------------------------------------------------------------------------------------------------
 // set_port
 //--------------------------------------------------------------------------------------------------
@@ -77,6 +100,12 @@ void IpAddress::set_port(uint16_t port) noexcept {
     reinterpret_cast<sockaddr_in6&>(data_).sin6_port = htons(port);
     return;
   }
+#ifndef _WIN32
+  if (family() == AF_UNIX) {
+    // Unix domain sockets don't have ports.
+    return;
+  }
+#endif
   assert(0 && "Unknown address family");
 }
 
@@ -97,6 +126,13 @@ bool operator==(const IpAddress& lhs, const IpAddress& rhs) noexcept {
                        static_cast<const void*>(&rhs.ipv6_address()),
                        sizeof(lhs.ipv6_address())) == 0;
   }
+#ifndef _WIN32
+  if (lhs.family() == AF_UNIX) {
+    auto& lhs_addr = reinterpret_cast<const sockaddr_un&>(lhs.addr());
+    auto& rhs_addr = reinterpret_cast<const sockaddr_un&>(rhs.addr());
+    return std::strcmp(lhs_addr.sun_path, rhs_addr.sun_path) == 0;
+  }
+#endif
   assert(0 && "Unknown address family");
   return false;
 }
@@ -113,6 +149,12 @@ std::ostream& operator<<(std::ostream& out, const IpAddress& ip_address) {
   } else if (ip_address.family() == AF_INET6) {
     s = inet_ntop(AF_INET6, &ip_address.ipv6_address().sin6_addr, buffer.data(),
                   sizeof(buffer));
+#ifndef _WIN32
+  } else if (ip_address.family() == AF_UNIX) {
+    return out << "unix://"
+               << reinterpret_cast<const sockaddr_un&>(ip_address.addr())
+                      .sun_path;
+#endif
   } else {
     assert(0 && "Unknown address family");
   }
@@ -120,6 +162,27 @@ std::ostream& operator<<(std::ostream& out, const IpAddress& ip_address) {
   return out;
 }
 
+//--------------------------------------------------------------------------------------------------
+// MakeUnixSocketAddress
+//--------------------------------------------------------------------------------------------------
+IpAddress MakeUnixSocketAddress(const std::string& path) {
+#ifdef _WIN32
+  (void)path;
+  throw std::runtime_error{"unix domain sockets aren't supported"};
+#else
+  sockaddr_un addr = {};
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    std::ostringstream oss;
+    oss << "invalid unix domain socket path " << path;
+    throw std::runtime_error{oss.str()};
+  }
+  addr.sun_family = AF_UNIX;
+  std::memcpy(static_cast<void*>(addr.sun_path),
+              static_cast<const void*>(path.data()), path.size());
+  return IpAddress{reinterpret_cast<const sockaddr&>(addr)};
+#endif
+}
+
 //--------------------------------------------------------------------------------------------------
 // ToString
 //--------------------------------------------------------------------------------------------------
@@ -9,6 +9,9 @@
 namespace lightstep {
 /**
  * Wraps the system objects for an ip address.
+ *
+ * Note: The address can also be that of a unix domain socket. See
+ * MakeUnixSocketAddress.
  */
 class IpAddress {
  public:
@@ -31,6 +34,11 @@ class IpAddress {
     return reinterpret_cast<const sockaddr&>(data_);
   }
 
+  /**
+   * @return the size of the system sockaddr object for this address.
+   */
+  size_t addr_length() const noexcept;
+
   /**
    * @return the family of the ip address.
    */
@@ -70,6 +78,13 @@ inline bool operator!=(const IpAddress& lhs, const IpAddress& rhs) noexcept {
 
 std::ostream& operator<<(std::ostream& out, const IpAddress& ip_address);
 
+/**
+ * Constructs the address of a unix domain socket.
+ * @param path the file system path of the socket.
+ * @return the address of the socket.
+ */
+IpAddress MakeUnixSocketAddress(const std::string& path);
+
 /**
  * Obtains a readable string for the given ip address.
  * @param ip_address supplies the address to obtain a string for.
@@ -97,12 +97,11 @@ Socket Connect(const IpAddress& ip_address) {
   int rcode;
   switch (ip_address.family()) {
     case AF_INET:
-      rcode =
-          socket.Connect(ip_address.addr(), sizeof(ip_address.ipv4_address()));
-      break;
     case AF_INET6:
-      rcode =
-          socket.Connect(ip_address.addr(), sizeof(ip_address.ipv6_address()));
+#ifndef _WIN32
+    case AF_UNIX:
+#endif
+      rcode = socket.Connect(ip_address.addr(), ip_address.addr_length());
       break;
     default:
       throw std::runtime_error{"Unknown socket family."};
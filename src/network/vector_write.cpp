@@ -14,11 +14,121 @@
 #include "common/platform/network.h"
 
 namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// FragmentCoalescer constructor
+//--------------------------------------------------------------------------------------------------
+FragmentCoalescer::FragmentCoalescer(int min_average_fragment_size,
+                                     int max_fragment_size,
+                                     size_t buffer_size) noexcept
+    : min_average_fragment_size_{min_average_fragment_size},
+      max_fragment_size_{max_fragment_size},
+      buffer_size_{buffer_size} {}
+
+//--------------------------------------------------------------------------------------------------
+// buffer
+//--------------------------------------------------------------------------------------------------
+char* FragmentCoalescer::buffer() {
+  if (buffer_ == nullptr) {
+    buffer_.reset(new char[buffer_size_]);
+  }
+  return buffer_.get();
+}
+
+//--------------------------------------------------------------------------------------------------
+// ZeroCopySendTracker constructor
+//--------------------------------------------------------------------------------------------------
+ZeroCopySendTracker::ZeroCopySendTracker(size_t min_write_size) noexcept
+    : min_write_size_{min_write_size} {}
+
+//--------------------------------------------------------------------------------------------------
+// OnCompletion
+//--------------------------------------------------------------------------------------------------
+void ZeroCopySendTracker::OnCompletion(uint32_t first, uint32_t last,
+                                       bool copied) {
+  copied_ = copied_ || copied;
+
+  // Send numbers wrap around, so compare them by their distance.
+  auto is_before = [](uint32_t lhs, uint32_t rhs) {
+    return static_cast<int32_t>(lhs - rhs) < 0;
+  };
+  if (is_before(num_completed_sends_, first)) {
+    out_of_order_completions_.emplace_back(first, last);
+    return;
+  }
+  if (!is_before(last, num_completed_sends_)) {
+    num_completed_sends_ = last + 1;
+  }
+  bool advanced = true;
+  while (advanced) {
+    advanced = false;
+    for (auto iter = out_of_order_completions_.begin();
+         iter != out_of_order_completions_.end(); ++iter) {
+      if (is_before(num_completed_sends_, iter->first)) {
+        continue;
+      }
+      if (!is_before(iter->second, num_completed_sends_)) {
+        num_completed_sends_ = iter->second + 1;
+      }
+      out_of_order_completions_.erase(iter);
+      advanced = true;
+      break;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// ReadCompletions
+//--------------------------------------------------------------------------------------------------
+void ZeroCopySendTracker::ReadCompletions(FileDescriptor socket) {
+  while (has_pending_sends()) {
+    uint32_t first;
+    uint32_t last;
+    bool copied;
+    auto rcode = ReadZeroCopyCompletion(socket, first, last, copied);
+    if (rcode == 0) {
+      return;
+    }
+    if (rcode < 0) {
+      std::ostringstream oss;
+      oss << "failed to read zero-copy completions: "
+          << GetErrorCodeMessage(GetLastErrorCode());
+      throw std::runtime_error{oss.str()};
+    }
+    OnCompletion(first, last, copied);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Reset
+//--------------------------------------------------------------------------------------------------
+void ZeroCopySendTracker::Reset() noexcept {
+  num_sends_ = 0;
+  num_completed_sends_ = 0;
+  copied_ = false;
+  out_of_order_completions_.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+// CountBytes
+//--------------------------------------------------------------------------------------------------
+static int64_t CountBytes(std::initializer_list<FragmentInputStream*>
+                              fragment_input_streams) noexcept {
+  int64_t result = 0;
+  for (auto fragment_input_stream : fragment_input_streams) {
+    fragment_input_stream->ForEachFragment([&result](void* /*data*/, int size) {
+      result += size;
+      return true;
+    });
+  }
+  return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Write
 //--------------------------------------------------------------------------------------------------
 bool Write(int socket,
-           std::initializer_list<FragmentInputStream*> fragment_input_streams) {
+           std::initializer_list<FragmentInputStream*> fragment_input_streams,
+           FragmentCoalescer* coalescer, ZeroCopySendTracker* zero_copy) {
   int num_fragments = 0;
   for (auto fragment_input_stream : fragment_input_streams) {
     num_fragments += fragment_input_stream->num_fragments();
@@ -26,6 +136,17 @@ bool Write(int socket,
   if (num_fragments == 0) {
     return true;
   }
+  if (coalescer != nullptr || zero_copy != nullptr) {
+    auto num_bytes = CountBytes(fragment_input_streams);
+    if (coalescer != nullptr &&
+        !coalescer->ShouldCoalesce(num_fragments, num_bytes)) {
+      coalescer = nullptr;
+    }
+    if (zero_copy != nullptr &&
+        (coalescer != nullptr || !zero_copy->ShouldUseZeroCopy(num_bytes))) {
+      zero_copy = nullptr;
+    }
+  }
   const auto max_batch_size =
       std::min(static_cast<int>(IoVecMax), num_fragments);
   auto fragments = static_cast<IoVec*>(alloca(sizeof(IoVec) * max_batch_size));
@@ -37,10 +158,28 @@ bool Write(int socket,
   bool blocked = false;
   ErrorCode error_code;
 
+  // When coalescing, small fragments are copied into the staging buffer and
+  // each contiguous run of copied fragments is written as a single iovec.
+  char* staging_buffer = nullptr;
+  size_t staging_size = 0;
+  char* run_data = nullptr;
+  int run_size = 0;
+  if (coalescer != nullptr) {
+    staging_buffer = coalescer->buffer();
+  }
+
   auto do_write = [&]() noexcept {
-    auto rcode =
-        WriteV(socket, fragments,
-               static_cast<int>(std::distance(fragments, fragment_iter)));
+    auto num_iovecs = static_cast<int>(std::distance(fragments, fragment_iter));
+    int rcode;
+    if (zero_copy != nullptr) {
+      bool sent_zero_copy;
+      rcode = WriteVZeroCopy(socket, fragments, num_iovecs, sent_zero_copy);
+      if (sent_zero_copy) {
+        zero_copy->OnSend();
+      }
+    } else {
+      rcode = WriteV(socket, fragments, num_iovecs);
+    }
     if (rcode < 0) {
       error_code = GetLastErrorCode();
       if (IsBlockingErrorCode(error_code)) {
@@ -57,23 +196,58 @@ bool Write(int socket,
       blocked = true;
     }
   };
-  auto do_fragment = [&](void* data, int size) noexcept {
+  auto write_batch = [&]() noexcept {
+    do_write();
+    fragment_iter = fragments;
+    batch_num_bytes = 0;
+    staging_size = 0;
+    return !(error || blocked);
+  };
+  auto add_iovec = [&](void* data, int size) noexcept {
     *fragment_iter++ = MakeIoVec(data, static_cast<size_t>(size));
     batch_num_bytes += size;
     if (fragment_iter != fragment_last) {
       return true;
     }
-    do_write();
-    fragment_iter = fragments;
-    batch_num_bytes = 0;
-    return !(error || blocked);
+    return write_batch();
+  };
+  auto end_run = [&]() noexcept {
+    if (run_size == 0) {
+      return true;
+    }
+    auto size = run_size;
+    run_size = 0;
+    return add_iovec(static_cast<void*>(run_data), size);
+  };
+  auto do_fragment = [&](void* data, int size) noexcept {
+    if (coalescer == nullptr || size > coalescer->max_fragment_size() ||
+        static_cast<size_t>(size) > coalescer->buffer_size()) {
+      return end_run() && add_iovec(data, size);
+    }
+    if (staging_size + static_cast<size_t>(size) > coalescer->buffer_size()) {
+      // Write out what's pending so that the staging buffer can be reused.
+      if (!end_run()) {
+        return false;
+      }
+      if (staging_size > 0 && !write_batch()) {
+        return false;
+      }
+    }
+    if (run_size == 0) {
+      run_data = staging_buffer + staging_size;
+    }
+    std::memcpy(static_cast<void*>(staging_buffer + staging_size), data,
+                static_cast<size_t>(size));
+    staging_size += static_cast<size_t>(size);
+    run_size += size;
+    return true;
   };
   for (auto fragment_input_stream : fragment_input_streams) {
     if (!fragment_input_stream->ForEachFragment(do_fragment)) {
       break;
     }
   }
-  if (batch_num_bytes > 0) {
+  if (!(error || blocked) && end_run() && batch_num_bytes > 0) {
     do_write();
   }
   auto result = Consume(fragment_input_streams, num_bytes_written);
@@ -1,17 +1,160 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "common/fragment_input_stream.h"
+#include "common/noncopyable.h"
+#include "common/platform/network.h"
 
 namespace lightstep {
+/**
+ * Copies runs of small fragments into a reusable staging buffer so that a
+ * write needs fewer iovecs, and hence fewer system calls, to send them.
+ */
+class FragmentCoalescer : private Noncopyable {
+ public:
+  /**
+   * @param min_average_fragment_size fragments are only coalesced if the
+   * average fragment size of a write is below this
+   * @param max_fragment_size the largest fragment to copy
+   * @param buffer_size the size of the staging buffer
+   */
+  FragmentCoalescer(int min_average_fragment_size, int max_fragment_size,
+                    size_t buffer_size) noexcept;
+
+  /**
+   * @param num_fragments the number of fragments in a write
+   * @param num_bytes the number of bytes in a write
+   * @return true if the fragments of the write should be coalesced.
+   */
+  bool ShouldCoalesce(int num_fragments, int64_t num_bytes) const noexcept {
+    return num_bytes < static_cast<int64_t>(num_fragments) *
+                           static_cast<int64_t>(min_average_fragment_size_);
+  }
+
+  /**
+   * @return the largest fragment to copy.
+   */
+  int max_fragment_size() const noexcept { return max_fragment_size_; }
+
+  /**
+   * @return the size of the staging buffer.
+   */
+  size_t buffer_size() const noexcept { return buffer_size_; }
+
+  /**
+   * @return the staging buffer.
+   *
+   * Note: The buffer is allocated on first use.
+   */
+  char* buffer();
+
+ private:
+  int min_average_fragment_size_;
+  int max_fragment_size_;
+  size_t buffer_size_;
+  std::unique_ptr<char[]> buffer_;
+};
+
+/**
+ * Tracks the sends made on a socket with MSG_ZEROCOPY.
+ *
+ * The kernel numbers zero-copy sends sequentially and reports on the socket's
+ * error queue when it no longer references their memory. Pinning the memory
+ * and processing the notifications costs more than copying small writes, so
+ * zero-copy is only used for writes of at least a minimum size; and if the
+ * kernel reports that it copied the data anyway (e.g. for loopback), it isn't
+ * used again until Reset.
+ */
+class ZeroCopySendTracker : private Noncopyable {
+ public:
+  /**
+   * @param min_write_size the fewest bytes to send with MSG_ZEROCOPY
+   */
+  explicit ZeroCopySendTracker(size_t min_write_size) noexcept;
+
+  /**
+   * @param num_bytes the number of bytes in a write
+   * @return true if the write should be sent with MSG_ZEROCOPY.
+   */
+  bool ShouldUseZeroCopy(int64_t num_bytes) const noexcept {
+    return !copied_ && num_bytes >= static_cast<int64_t>(min_write_size_);
+  }
+
+  /**
+   * Records a send made with MSG_ZEROCOPY.
+   */
+  void OnSend() noexcept { ++num_sends_; }
+
+  /**
+   * Records a completion notification for the sends [first, last].
+   * @param first the first completed send
+   * @param last the last completed send
+   * @param copied true if the kernel copied the data
+   */
+  void OnCompletion(uint32_t first, uint32_t last, bool copied);
+
+  /**
+   * Reads the completion notifications queued on a socket.
+   * @param socket the socket the sends were made on
+   */
+  void ReadCompletions(FileDescriptor socket);
+
+  /**
+   * Resets the tracker for a new socket.
+   */
+  void Reset() noexcept;
+
+  /**
+   * @return the number of sends made with MSG_ZEROCOPY.
+   */
+  uint32_t num_sends() const noexcept { return num_sends_; }
+
+  /**
+   * @return the number of sends such that every send numbered below it is
+   * complete.
+   */
+  uint32_t num_completed_sends() const noexcept { return num_completed_sends_; }
+
+  /**
+   * @return true if the kernel may still reference memory from a send.
+   */
+  bool has_pending_sends() const noexcept {
+    return num_sends_ != num_completed_sends_;
+  }
+
+ private:
+  size_t min_write_size_;
+  uint32_t num_sends_{0};
+  uint32_t num_completed_sends_{0};
+  bool copied_{false};
+
+  // Completions that arrived before those of earlier sends.
+  std::vector<std::pair<uint32_t, uint32_t>> out_of_order_completions_;
+};
+
 /**
  * Uses the writev system call to send fragments over a given socket. After
  * writing, consumes the number of written bytes from the streams.
  * @param socket the file descriptor of the socket.
  * @param fragment_input_streams the list of fragments to send.
+ * @param coalescer if provided, used to copy small fragments together before
+ * writing them.
+ * @param zero_copy if provided and the write is large enough, the fragments
+ * are sent with MSG_ZEROCOPY. The caller is then responsible for keeping the
+ * fragments' memory alive until the tracker reports the sends complete.
  * @return true if everything in the streams was written; false, otherwise.
+ *
+ * Note: Writes that are coalesced are never sent with MSG_ZEROCOPY since the
+ * coalescer's buffer is reused.
  */
 bool Write(int socket,
-           std::initializer_list<FragmentInputStream*> fragment_input_streams);
+           std::initializer_list<FragmentInputStream*> fragment_input_streams,
+           FragmentCoalescer* coalescer = nullptr,
+           ZeroCopySendTracker* zero_copy = nullptr);
 }  // namespace lightstep
@@ -5,6 +5,29 @@
 #include <exception>
 
 namespace lightstep {
+// The size of the blocks report arenas allocate. Each arena holds on to one
+// block across reports.
+const size_t ReportArenaBlockSize = 64 * 1024;
+
+//------------------------------------------------------------------------------
+// MakeReportArenaOptions
+//------------------------------------------------------------------------------
+static google::protobuf::ArenaOptions MakeReportArenaOptions(
+    char* initial_block) noexcept {
+  google::protobuf::ArenaOptions result;
+  result.max_block_size = ReportArenaBlockSize;
+  result.initial_block = initial_block;
+  result.initial_block_size = ReportArenaBlockSize;
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// ReportArena Constructor
+//------------------------------------------------------------------------------
+AutoRecorder::ReportArena::ReportArena()
+    : initial_block{new char[ReportArenaBlockSize]},
+      arena{MakeReportArenaOptions(initial_block.get())} {}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -17,9 +40,11 @@ AutoRecorder::AutoRecorder(Logger& logger, LightStepTracerOptions&& options,
 AutoRecorder::AutoRecorder(
     Logger& logger, LightStepTracerOptions&& options,
     std::unique_ptr<SyncTransporter>&& transporter,
-    std::unique_ptr<ConditionVariableWrapper>&& write_cond)
+    std::unique_ptr<ConditionVariableWrapper>&& write_cond,
+    size_t num_staging_shards)
     : logger_{logger},
       options_{std::move(options)},
+      staged_spans_{num_staging_shards},
       builder_{options_.access_token, options_.tags},
       transporter_{std::move(transporter)},
       write_cond_{std::move(write_cond)} {
@@ -43,15 +68,28 @@ AutoRecorder::~AutoRecorder() {
 // RecordSpan
 //------------------------------------------------------------------------------
 void AutoRecorder::RecordSpan(const collector::Span& span) noexcept try {
-  std::lock_guard<std::mutex> lock_guard{write_mutex_};
-  if (builder_.num_pending_spans() >= max_buffered_spans_snapshot_ ||
-      write_exit_) {
-    dropped_spans_++;
+  auto max_buffered_spans =
+      max_buffered_spans_snapshot_.load(std::memory_order_relaxed);
+  size_t shard_room = 0;
+  if (!write_exit_) {
+    // Each shard stages its share of max_buffered_spans so that threads don't
+    // share a counter. The arena is loaded under the shard's lock so that the
+    // writer thread can't reset it until the span is staged.
+    shard_room = staged_spans_.TryEmplace(max_buffered_spans, [&span, this] {
+      auto result = google::protobuf::Arena::CreateMessage<collector::Span>(
+          span_arena_.load(std::memory_order_relaxed));
+      result->CopyFrom(span);
+      return result;
+    });
+  }
+  if (shard_room == 0) {
+    ++dropped_spans_;
     options_.metrics_observer->OnSpansDropped(1);
     return;
   }
-  builder_.AddSpan(span);
-  if (builder_.num_pending_spans() >= max_buffered_spans_snapshot_) {
+  if (shard_room == 1) {
+    std::lock_guard<std::mutex> lock_guard{write_mutex_};
+    staged_spans_full_ = true;
     write_cond_->NotifyAll();
   }
 } catch (const std::exception& e) {
@@ -68,7 +106,7 @@ bool AutoRecorder::FlushWithTimeout(
   // operations to clear out all the presently pending data.
   std::unique_lock<std::mutex> lock{write_mutex_};
 
-  bool has_encoded = builder_.num_pending_spans() != 0;
+  bool has_encoded = !staged_spans_.empty();
 
   if (!has_encoded && encoding_seqno_ == 1 + flushed_seqno_) {
     return true;
@@ -142,35 +180,58 @@ void AutoRecorder::FlushOne() {
 
   size_t save_dropped;
   size_t save_pending;
+  google::protobuf::Arena* report_arena;
+  collector::ReportRequest* report;
   {
-    // Swap the pending encoder with the inflight encoder, then use
-    // inflight without a lock. Assumption is that this thread is the
-    // only place inflight_ is used.
+    // Switch span staging onto the other arena, then move the staged spans
+    // into a report on the arena they were copied onto and use the report
+    // without a lock. Assumption is that this thread is the only place the
+    // arenas are switched or reset.
     std::lock_guard<std::mutex> lock_guard{write_mutex_};
-    save_pending = builder_.num_pending_spans();
+    report_arena = span_arena_;
+    span_arena_ = report_arena == &report_arenas_[0].arena
+                      ? &report_arenas_[1].arena
+                      : &report_arenas_[0].arena;
+    report = builder_.MakeReport(*report_arena);
+    auto& spans = *report->mutable_spans();
+    staged_spans_full_ = false;
+    auto max_buffered_spans = max_buffered_spans_snapshot_.load();
+    int num_excess_spans = 0;
+    staged_spans_.Consume([&](collector::Span* span) {
+      // Spans past the limit are left on the arena to be freed with it.
+      if (static_cast<size_t>(spans.size()) < max_buffered_spans) {
+        spans.AddAllocated(span);
+      } else {
+        ++num_excess_spans;
+      }
+    });
+    if (num_excess_spans > 0) {
+      dropped_spans_ += static_cast<size_t>(num_excess_spans);
+      options_.metrics_observer->OnSpansDropped(num_excess_spans);
+    }
+    save_pending = static_cast<size_t>(spans.size());
     if (save_pending == 0) {
+      report_arena->Reset();
       return;
     }
     options_.metrics_observer->OnSpansSent(static_cast<int>(save_pending));
     // TODO(rnburn): Compute and set timestamp_offset_micros
-    save_dropped = dropped_spans_;
-    builder_.set_pending_client_dropped_spans(save_dropped);
-    dropped_spans_ = 0;
-    std::swap(builder_.pending(), inflight_);
+    save_dropped = dropped_spans_.exchange(0);
+    ReportBuilder::SetClientDroppedSpans(*report, save_dropped);
     ++encoding_seqno_;
   }
-  bool success = WriteReport(inflight_);
+  bool success = WriteReport(*report);
   {
     std::lock_guard<std::mutex> lock_guard{write_mutex_};
     ++flushed_seqno_;
     write_cond_->NotifyAll();
-    inflight_.Clear();
 
     if (!success) {
       options_.metrics_observer->OnSpansDropped(static_cast<int>(save_pending));
       dropped_spans_ += save_dropped + save_pending;
     }
   }
+  report_arena->Reset();
 }
 
 //------------------------------------------------------------------------------
@@ -190,8 +251,7 @@ bool AutoRecorder::WaitForNextWrite(
   std::unique_lock<std::mutex> lock{write_mutex_};
   max_buffered_spans_snapshot_ = options_.max_buffered_spans.value();
   write_cond_->WaitUntil(lock, next, [this]() {
-    return this->write_exit_ ||
-           this->builder_.num_pending_spans() >= max_buffered_spans_snapshot_;
+    return this->write_exit_ || this->staged_spans_full_;
   });
   return !write_exit_;
 }
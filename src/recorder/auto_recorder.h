@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -8,7 +9,10 @@
 #include "common/condition_variable_wrapper.h"
 #include "common/logger.h"
 #include "common/noncopyable.h"
+#include "common/sharded_staging_buffer.h"
 #include "lightstep-tracer-common/collector.pb.h"
+
+#include <google/protobuf/arena.h>
 #include "lightstep/tracer.h"
 #include "lightstep/transporter.h"
 #include "recorder/recorder.h"
@@ -18,14 +22,22 @@ namespace lightstep {
 // AutoRecorder buffers spans finished by a tracer and sends them over to
 // the provided SyncTransporter. It uses an internal thread to regularly send
 // the reports according to the rate specified by LightStepTracerOptions.
+//
+// Finished spans are staged in per-thread shards that the writer thread swaps
+// out when it assembles a report, so recording a span never waits on report
+// assembly or on the transporter. Staged spans are copied onto a protobuf arena
+// that the report is then assembled on, so the whole report is freed at once.
 class AutoRecorder final : public Recorder, private Noncopyable {
  public:
   AutoRecorder(Logger& logger, LightStepTracerOptions&& options,
                std::unique_ptr<SyncTransporter>&& transporter);
 
+  // num_staging_shards is the number of shards to stage spans in, or 0 to use
+  // the default.
   AutoRecorder(Logger& logger, LightStepTracerOptions&& options,
                std::unique_ptr<SyncTransporter>&& transporter,
-               std::unique_ptr<ConditionVariableWrapper>&& write_cond);
+               std::unique_ptr<ConditionVariableWrapper>&& write_cond,
+               size_t num_staging_shards = 0);
 
   ~AutoRecorder() override;
 
@@ -35,12 +47,18 @@ class AutoRecorder final : public Recorder, private Noncopyable {
       std::chrono::system_clock::duration timeout) noexcept override;
 
   // used for testing only.
-  bool is_writer_running() const {
-    std::lock_guard<std::mutex> lock_guard{write_mutex_};
-    return !write_exit_;
-  }
+  bool is_writer_running() const { return !write_exit_; }
 
  private:
+  // A report arena keeps its first block across resets, so that assembling
+  // reports in steady state rarely calls malloc.
+  struct ReportArena {
+    ReportArena();
+
+    std::unique_ptr<char[]> initial_block;
+    google::protobuf::Arena arena;
+  };
+
   void Write() noexcept;
   bool WriteReport(const collector::ReportRequest& report);
   void FlushOne();
@@ -57,17 +75,30 @@ class AutoRecorder final : public Recorder, private Noncopyable {
   LightStepTracerOptions options_;
 
   // Writer state.
-  mutable std::mutex write_mutex_;
-  bool write_exit_ = false;
+  std::mutex write_mutex_;
+  std::atomic<bool> write_exit_{false};
   std::thread writer_;
 
-  // Buffer state (protected by write_mutex_).
+  // Staging state (safe to access from any thread). Each shard of
+  // staged_spans_ holds its share of max_buffered_spans_snapshot_ spans. Spans
+  // past the limit, which can be staged if it drops below the number of
+  // shards, are dropped when a report is assembled.
+  //
+  // Spans are copied onto span_arena_, one of two report arenas that the
+  // writer thread alternates between. An arena is only reset after the report
+  // assembled on it is written, once no span can still be copied onto it.
+  ReportArena report_arenas_[2];
+  std::atomic<google::protobuf::Arena*> span_arena_{&report_arenas_[0].arena};
+  ShardedStagingBuffer<collector::Span*> staged_spans_;
+  std::atomic<size_t> max_buffered_spans_snapshot_;
+  std::atomic<size_t> dropped_spans_{0};
+
+  // Buffer state (protected by write_mutex_). staged_spans_full_ is set when a
+  // shard of staged_spans_ fills up.
   ReportBuilder builder_;
-  collector::ReportRequest inflight_;
-  size_t max_buffered_spans_snapshot_;
+  bool staged_spans_full_{false};
   size_t flushed_seqno_ = 0;
   size_t encoding_seqno_ = 1;
-  size_t dropped_spans_ = 0;
 
   // SyncTransporter through which to send span reports.
   std::unique_ptr<SyncTransporter> transporter_;
@@ -6,4 +6,15 @@
 namespace lightstep {
 std::unique_ptr<SyncTransporter> MakeGrpcTransporter(
     Logger& logger, const LightStepTracerOptions& options);
+
+/**
+ * Makes a transporter that sends serialized ReportRequests to the collector
+ * with gRPC, without parsing them into protobuf messages.
+ *
+ * Reports complete on a background thread, so callbacks are invoked from that
+ * thread. Send only blocks when max_concurrent_reports reports are already
+ * waiting on the collector.
+ */
+std::unique_ptr<AsyncTransporter> MakeGrpcAsyncTransporter(
+    Logger& logger, const LightStepTracerOptions& options);
 }  // namespace lightstep
@@ -1,13 +1,26 @@
 #include "recorder/grpc_transporter.h"
 
 #include <grpc++/create_channel.h>
+#include <grpc++/generic/generic_stub.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "common/noncopyable.h"
+#include "common/utility.h"
 #include "lightstep-tracer-common/collector.grpc.pb.h"
 #include "lightstep-tracer-common/collector.pb.h"
 
 namespace lightstep {
+const char* const ReportMethodName =
+    "/lightstep.collector.CollectorService/Report";
+
 //------------------------------------------------------------------------------
 // HostPortOf
 //------------------------------------------------------------------------------
@@ -41,9 +54,9 @@ static std::error_code MakeErrorCode(grpc::StatusCode status_code) {
 }
 
 //------------------------------------------------------------------------------
-// MakeGrpcClient
+// MakeGrpcChannel
 //------------------------------------------------------------------------------
-static collector::CollectorService::Stub MakeGrpcClient(
+static std::shared_ptr<grpc::Channel> MakeGrpcChannel(
     const LightStepTracerOptions& options) {
   std::shared_ptr<grpc::ChannelCredentials> channel_credentials;
   if (options.collector_plaintext) {
@@ -53,8 +66,51 @@ static collector::CollectorService::Stub MakeGrpcClient(
     credentials_options.pem_root_certs = options.ssl_root_certificates;
     channel_credentials = grpc::SslCredentials(credentials_options);
   }
-  return collector::CollectorService::Stub{
-      grpc::CreateChannel(HostPortOf(options), channel_credentials)};
+  return grpc::CreateChannel(HostPortOf(options), channel_credentials);
+}
+
+//------------------------------------------------------------------------------
+// MakeGrpcClient
+//------------------------------------------------------------------------------
+static collector::CollectorService::Stub MakeGrpcClient(
+    const LightStepTracerOptions& options) {
+  return collector::CollectorService::Stub{MakeGrpcChannel(options)};
+}
+
+//------------------------------------------------------------------------------
+// MakeByteBuffer
+//------------------------------------------------------------------------------
+// Makes a ByteBuffer that references the fragments of a BufferChain without
+// copying them. The BufferChain must outlive the call it's sent with.
+static grpc::ByteBuffer MakeByteBuffer(const BufferChain& message) {
+  std::vector<grpc::Slice> slices;
+  slices.reserve(message.num_fragments());
+  message.ForEachFragment(
+      [](void* context, const void* data, size_t size) {
+        static_cast<std::vector<grpc::Slice>*>(context)->emplace_back(
+            data, size, grpc::Slice::STATIC_SLICE);
+        return true;
+      },
+      static_cast<void*>(&slices));
+  return grpc::ByteBuffer{slices.data(), slices.size()};
+}
+
+//------------------------------------------------------------------------------
+// ParseByteBuffer
+//------------------------------------------------------------------------------
+static bool ParseByteBuffer(const grpc::ByteBuffer& buffer,
+                            google::protobuf::Message& message) {
+  std::vector<grpc::Slice> slices;
+  if (!buffer.Dump(&slices).ok()) {
+    return false;
+  }
+  std::string serialization;
+  serialization.reserve(buffer.Length());
+  for (auto& slice : slices) {
+    serialization.append(reinterpret_cast<const char*>(slice.begin()),
+                         slice.size());
+  }
+  return message.ParseFromString(serialization);
 }
 
 //------------------------------------------------------------------------------
@@ -94,6 +150,150 @@ class GrpcTransporter : public SyncTransporter {
 };
 }  // anonymous namespace
 
+//------------------------------------------------------------------------------
+// GrpcAsyncTransporter
+//------------------------------------------------------------------------------
+namespace {
+// GrpcAsyncTransporter sends serialized ReportRequests to the specified host
+// via gRPC's generic stub, so that they don't need to be parsed into protobuf
+// messages.
+//
+// Reports are sent over a single channel and completed on a shared completion
+// queue polled by a background thread, so up to max_concurrent_reports
+// reports can be waiting on the collector at once.
+class GrpcAsyncTransporter final : public AsyncTransporter,
+                                   private Noncopyable {
+ public:
+  GrpcAsyncTransporter(Logger& logger, const LightStepTracerOptions& options)
+      : logger_{logger},
+        verbose_{options.verbose},
+        stub_{MakeGrpcChannel(options)},
+        report_timeout_{options.report_timeout},
+        max_concurrent_reports_{
+            std::max<size_t>(options.max_concurrent_reports, 1)} {
+    calls_.reserve(max_concurrent_reports_);
+    poller_ = std::thread{&GrpcAsyncTransporter::Poll, this};
+  }
+
+  ~GrpcAsyncTransporter() override {
+    {
+      std::lock_guard<std::mutex> lock_guard{mutex_};
+      for (auto call : calls_) {
+        call->context.TryCancel();
+      }
+    }
+    // Pending calls are still delivered to Poll, which completes them, before
+    // the completion queue reports that it's shut down.
+    completion_queue_.Shutdown();
+    poller_.join();
+  }
+
+  // AsyncTransporter
+  void Send(std::unique_ptr<BufferChain>&& message,
+            Callback& callback) noexcept override {
+    if (disabled_) {
+      return callback.OnFailure(*message);
+    }
+    // The message is moved into the call, so keep a reference to report it on
+    // failure.
+    auto& message_ref = *message;
+    std::unique_ptr<ReportCall> call;
+    try {
+      call.reset(new ReportCall{std::move(message), callback});
+      call->context.set_fail_fast(true);
+      call->request = MakeByteBuffer(*call->message);
+    } catch (const std::exception& e) {
+      logger_.Error("Report RPC failed: ", e.what());
+      return callback.OnFailure(message_ref);
+    }
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      call_completed_.wait(lock, [this] {
+        return calls_.size() < max_concurrent_reports_;
+      });
+      calls_.push_back(call.get());
+    }
+    // Start the timeout only once the call has a slot, so that reports queued
+    // behind max_concurrent_reports don't spend it waiting.
+    call->context.set_deadline(std::chrono::system_clock::now() +
+                               report_timeout_);
+    call->reader = stub_.PrepareUnaryCall(&call->context, ReportMethodName,
+                                          call->request, &completion_queue_);
+    call->reader->StartCall();
+    auto tag = static_cast<void*>(call.get());
+    call->reader->Finish(&call->response, &call->status, tag);
+    call.release();
+  }
+
+ private:
+  // The state of a Report call from when it's sent until it completes.
+  struct ReportCall {
+    ReportCall(std::unique_ptr<BufferChain>&& message_, Callback& callback_)
+        : message{std::move(message_)}, callback{callback_} {}
+
+    std::unique_ptr<BufferChain> message;
+    Callback& callback;
+    grpc::ClientContext context;
+    grpc::ByteBuffer request;
+    std::unique_ptr<grpc::GenericClientAsyncResponseReader> reader;
+    grpc::ByteBuffer response;
+    grpc::Status status;
+  };
+
+  Logger& logger_;
+  bool verbose_;
+  grpc::GenericStub stub_;
+  std::chrono::system_clock::duration report_timeout_;
+  size_t max_concurrent_reports_;
+  std::atomic<bool> disabled_{false};
+
+  grpc::CompletionQueue completion_queue_;
+
+  // The calls in flight, protected by mutex_. Capacity for
+  // max_concurrent_reports_ calls is reserved up front.
+  std::mutex mutex_;
+  std::condition_variable call_completed_;
+  std::vector<ReportCall*> calls_;
+
+  std::thread poller_;
+
+  void Poll() noexcept {
+    void* tag;
+    bool ok;
+    while (completion_queue_.Next(&tag, &ok)) {
+      std::unique_ptr<ReportCall> call{static_cast<ReportCall*>(tag)};
+      {
+        std::lock_guard<std::mutex> lock_guard{mutex_};
+        calls_.erase(std::find(calls_.begin(), calls_.end(), call.get()));
+      }
+      call_completed_.notify_all();
+      OnCallCompleted(*call);
+    }
+  }
+
+  void OnCallCompleted(ReportCall& call) noexcept try {
+    if (!call.status.ok()) {
+      logger_.Error("Report RPC failed: ", call.status.error_message());
+      return call.callback.OnFailure(*call.message);
+    }
+    collector::ReportResponse response;
+    if (ParseByteBuffer(call.response, response)) {
+      LogReportResponse(logger_, verbose_, response);
+      for (auto& command : response.commands()) {
+        if (command.disable()) {
+          logger_.Warn("Tracer disabled by collector");
+          disabled_ = true;
+        }
+      }
+    }
+    call.callback.OnSuccess(*call.message);
+  } catch (const std::exception& e) {
+    logger_.Error("Report RPC failed: ", e.what());
+    call.callback.OnFailure(*call.message);
+  }
+};
+}  // anonymous namespace
+
 //------------------------------------------------------------------------------
 // MakeGrpcTransporter
 //------------------------------------------------------------------------------
@@ -101,4 +301,13 @@ std::unique_ptr<SyncTransporter> MakeGrpcTransporter(
     Logger& logger, const LightStepTracerOptions& options) {
   return std::unique_ptr<SyncTransporter>{new GrpcTransporter{logger, options}};
 }
+
+//------------------------------------------------------------------------------
+// MakeGrpcAsyncTransporter
+//------------------------------------------------------------------------------
+std::unique_ptr<AsyncTransporter> MakeGrpcAsyncTransporter(
+    Logger& logger, const LightStepTracerOptions& options) {
+  return std::unique_ptr<AsyncTransporter>{
+      new GrpcAsyncTransporter{logger, options}};
+}
 }  // namespace lightstep
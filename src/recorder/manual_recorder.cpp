@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <exception>
+#include <vector>
 
 #include "common/random.h"
 #include "common/report_request_framing.h"
@@ -28,10 +29,14 @@ ManualRecorder::ManualRecorder(Logger& logger, LightStepTracerOptions options,
     : logger_{logger},
       tracer_options_{std::move(options)},
       transporter_{std::move(transporter)},
-      report_request_header_{new std::string{
-          WriteReportRequestHeader(tracer_options_, GenerateId())}},
       metrics_{GetMetricsObserver(tracer_options_)},
-      span_buffer_{tracer_options_.max_buffered_spans.value()} {}
+      report_splitter_{std::make_shared<const std::string>(
+                           WriteReportRequestHeader(tracer_options_,
+                                                    GenerateId())),
+                       tracer_options_.max_report_spans,
+                       tracer_options_.max_report_bytes},
+      span_buffer_{tracer_options_.max_buffered_spans.value()},
+      span_buffer_budget_{tracer_options_.max_buffered_bytes} {}
 
 //--------------------------------------------------------------------------------------------------
 // ReserveHeaderSpace
@@ -65,15 +70,17 @@ void ManualRecorder::RecordSpan(
   // Advance past reserved header space we didn't use.
   span->Seek(0, static_cast<int>(reserved_header_size - protobuf_header_size));
 
-  auto was_added = span_buffer_.Add(span);
+  auto num_bytes = static_cast<size_t>(span->ByteCount());
+  auto was_added = AddSpan(span, num_bytes);
   if (was_added) {
     return;
   }
   transporter_->OnSpanBufferFull();
 
   // Attempt to add the span again in case the transporter decided to flush
-  if (!span_buffer_.Add(span)) {
+  if (!AddSpan(span, num_bytes)) {
     metrics_.OnSpansDropped(1);
+    metrics_.OnBytesDropped(num_bytes);
   }
 }
 
@@ -82,29 +89,24 @@ void ManualRecorder::RecordSpan(
 //--------------------------------------------------------------------------------------------------
 bool ManualRecorder::FlushWithTimeout(
     std::chrono::system_clock::duration /*timeout*/) noexcept try {
-  std::unique_ptr<ReportRequest> report_request{new ReportRequest{
-      report_request_header_, metrics_.ConsumeDroppedSpans()}};
+  auto num_dropped_spans = metrics_.ConsumeDroppedSpans();
+  std::vector<std::unique_ptr<ReportRequest>> reports;
   {
     std::lock_guard<std::mutex> lock_guard{flush_mutex_};
-    auto num_spans = span_buffer_.size();
-    if (num_spans == 0 && report_request->num_dropped_spans() == 0) {
+    if (span_buffer_.empty() && num_dropped_spans == 0) {
       // Nothing to do
       return true;
     }
-    span_buffer_.Consume(
-        num_spans, [&](CircularBufferRange<AtomicUniquePtr<ChainedStream>> &
-                       spans) noexcept {
-          spans.ForEach([&](AtomicUniquePtr<ChainedStream> & span) noexcept {
-            std::unique_ptr<ChainedStream> span_out;
-            span.Swap(span_out);
-            report_request->AddSpan(std::move(span_out));
-            return true;
-          });
-          return true;
-        });
+    report_splitter_.Split(num_dropped_spans, span_buffer_,
+                           span_buffer_budget_, reports, metrics_);
+  }
+
+  // Hand off every report at once so that the transporter can send them
+  // concurrently.
+  for (auto& report_request : reports) {
+    transporter_->Send(std::unique_ptr<BufferChain>{report_request.release()},
+                       *this);
   }
-  transporter_->Send(std::unique_ptr<BufferChain>{report_request.release()},
-                     *this);
   metrics_.OnFlush();
   return true;
 } catch (const std::exception& e) {
@@ -117,7 +119,22 @@ bool ManualRecorder::FlushWithTimeout(
 //--------------------------------------------------------------------------------------------------
 void ManualRecorder::OnForkedChild() noexcept {
   metrics_.ConsumeDroppedSpans();
-  span_buffer_.Clear();
+  size_t num_bytes = 0;
+  for (size_t i = 0; i < span_buffer_.num_shards(); ++i) {
+    auto& shard = span_buffer_.shard(i);
+    shard.Consume(
+        shard.size(),
+        [&num_bytes](CircularBufferRange<AtomicUniquePtr<ChainedStream>> &
+                     spans) noexcept {
+          spans.ForEach([&num_bytes](AtomicUniquePtr<ChainedStream> &
+                                     span) noexcept {
+            num_bytes += static_cast<size_t>(span->ByteCount());
+            span.Reset();
+            return true;
+          });
+        });
+  }
+  span_buffer_budget_.Release(num_bytes);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -144,6 +161,22 @@ void ManualRecorder::OnFailure(BufferChain& message) noexcept {
     return;
   }
   metrics_.OnSpansDropped(report_request->num_spans());
+  metrics_.OnBytesDropped(report_request->num_bytes());
   metrics_.UnconsumeDroppedSpans(report_request->num_dropped_spans());
 }
+
+//--------------------------------------------------------------------------------------------------
+// AddSpan
+//--------------------------------------------------------------------------------------------------
+bool ManualRecorder::AddSpan(std::unique_ptr<ChainedStream>& span,
+                             size_t num_bytes) noexcept {
+  if (!span_buffer_budget_.Reserve(num_bytes)) {
+    return false;
+  }
+  if (span_buffer_.Add(span)) {
+    return true;
+  }
+  span_buffer_budget_.Release(num_bytes);
+  return false;
+}
 }  // namespace lightstep
@@ -2,12 +2,14 @@
 
 #include <mutex>
 
-#include "common/circular_buffer.h"
+#include "common/byte_budget.h"
 #include "common/logger.h"
 #include "common/noncopyable.h"
+#include "common/sharded_circular_buffer.h"
 #include "lightstep/transporter.h"
 #include "recorder/fork_aware_recorder.h"
 #include "recorder/metrics_tracker.h"
+#include "recorder/report_splitter.h"
 
 namespace lightstep {
 /**
@@ -41,10 +43,13 @@ class ManualRecorder : public ForkAwareRecorder,
   Logger& logger_;
   LightStepTracerOptions tracer_options_;
   std::unique_ptr<AsyncTransporter> transporter_;
-  std::shared_ptr<const std::string> report_request_header_;
 
   MetricsTracker metrics_;
   std::mutex flush_mutex_;
-  CircularBuffer<ChainedStream> span_buffer_;
+  ReportSplitter report_splitter_;
+  ShardedCircularBuffer<ChainedStream> span_buffer_;
+  ByteBudget span_buffer_budget_;
+
+  bool AddSpan(std::unique_ptr<ChainedStream>& span, size_t num_bytes) noexcept;
 };
 }  // namespace lightstep
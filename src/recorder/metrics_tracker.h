@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 
 #include <lightstep/metrics_observer.h>
 
@@ -21,6 +22,14 @@ class MetricsTracker {
     num_dropped_spans_ += num_spans;
   }
 
+  /**
+   * Record the serialized size of dropped spans.
+   * @param num_bytes the number of bytes dropped.
+   */
+  inline void OnBytesDropped(size_t num_bytes) noexcept {
+    metrics_observer_.OnBytesDropped(num_bytes);
+  }
+
   /**
    * Record spans sent.
    * @param num_spans the number of spans sent.
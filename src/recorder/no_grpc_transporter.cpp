@@ -9,4 +9,11 @@ std::unique_ptr<SyncTransporter> MakeGrpcTransporter(
       "LightStep was not built with gRPC support, so a transporter must be "
       "supplied."};
 }
+
+std::unique_ptr<AsyncTransporter> MakeGrpcAsyncTransporter(
+    Logger& /*logger*/, const LightStepTracerOptions& /*options*/) {
+  throw std::runtime_error{
+      "LightStep was not built with gRPC support, so a transporter must be "
+      "supplied."};
+}
 }  // namespace lightstep
@@ -31,11 +31,30 @@ void ReportBuilder::AddSpan(const collector::Span& span) {
   *pending_.mutable_spans()->Add() = span;
 }
 
+//------------------------------------------------------------------------------
+// MakeReport
+//------------------------------------------------------------------------------
+collector::ReportRequest* ReportBuilder::MakeReport(
+    google::protobuf::Arena& arena) const {
+  auto result =
+      google::protobuf::Arena::CreateMessage<collector::ReportRequest>(&arena);
+  result->CopyFrom(preamble_);
+  return result;
+}
+
 //------------------------------------------------------------------------------
 // set_pending_client_dropped_spans
 //------------------------------------------------------------------------------
 void ReportBuilder::set_pending_client_dropped_spans(uint64_t spans) {
-  auto count = pending_.mutable_internal_metrics()->add_counts();
+  SetClientDroppedSpans(pending_, spans);
+}
+
+//------------------------------------------------------------------------------
+// SetClientDroppedSpans
+//------------------------------------------------------------------------------
+void ReportBuilder::SetClientDroppedSpans(collector::ReportRequest& report,
+                                          uint64_t spans) {
+  auto count = report.mutable_internal_metrics()->add_counts();
   count->set_name("spans.dropped");
   count->set_int_value(spans);
 }
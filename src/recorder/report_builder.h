@@ -1,5 +1,6 @@
 #pragma once
 
+#include <google/protobuf/arena.h>
 #include <lightstep/tracer.h>
 #include <opentracing/value.h>
 #include <string>
@@ -18,11 +19,21 @@ class ReportBuilder {
   // AddSpan adds the span to the currently-building ReportRequest.
   void AddSpan(const collector::Span& span);
 
+  // MakeReport creates an empty ReportRequest with the reporter and auth
+  // fields set, allocated on arena so that it and any spans allocated on the
+  // same arena can be added without copying and freed together.
+  collector::ReportRequest* MakeReport(google::protobuf::Arena& arena) const;
+
   // num_pending_spans() is the number of pending spans.
   size_t num_pending_spans() const { return pending_.spans_size(); }
 
   void set_pending_client_dropped_spans(uint64_t spans);
 
+  // SetClientDroppedSpans records the number of spans dropped by the client
+  // in report's internal metrics.
+  static void SetClientDroppedSpans(collector::ReportRequest& report,
+                                    uint64_t spans);
+
   // pending() returns a mutable object, appropriate for swapping with
   // another ReportRequest object.
   collector::ReportRequest& pending() {
@@ -0,0 +1,88 @@
+#include "recorder/report_splitter.h"
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+ReportSplitter::ReportSplitter(std::shared_ptr<const std::string> header,
+                               size_t max_report_spans,
+                               size_t max_report_bytes) noexcept
+    : header_{std::move(header)},
+      max_report_spans_{max_report_spans},
+      max_report_bytes_{max_report_bytes} {}
+
+//--------------------------------------------------------------------------------------------------
+// Split
+//--------------------------------------------------------------------------------------------------
+void ReportSplitter::Split(
+    int num_dropped_spans, ShardedCircularBuffer<ChainedStream>& span_buffer,
+    ByteBudget& span_buffer_budget,
+    std::vector<std::unique_ptr<ReportRequest>>& reports,
+    MetricsTracker& metrics) {
+  spans_.clear();
+  auto first_report = reports.size();
+  size_t num_bytes = 0;
+  try {
+    SplitSpans(num_dropped_spans, span_buffer, num_bytes, reports);
+  } catch (...) {
+    reports.erase(reports.begin() + static_cast<std::ptrdiff_t>(first_report),
+                  reports.end());
+    span_buffer_budget.Release(num_bytes);
+    metrics.UnconsumeDroppedSpans(num_dropped_spans);
+    metrics.OnSpansDropped(static_cast<int>(spans_.size()));
+    metrics.OnBytesDropped(num_bytes);
+    spans_.clear();
+    throw;
+  }
+  span_buffer_budget.Release(num_bytes);
+  spans_.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+// SplitSpans
+//--------------------------------------------------------------------------------------------------
+void ReportSplitter::SplitSpans(
+    int num_dropped_spans, ShardedCircularBuffer<ChainedStream>& span_buffer,
+    size_t& num_bytes, std::vector<std::unique_ptr<ReportRequest>>& reports) {
+  for (size_t i = 0; i < span_buffer.num_shards(); ++i) {
+    auto& shard = span_buffer.shard(i);
+    auto num_spans = shard.size();
+    spans_.reserve(spans_.size() + num_spans);
+    shard.Consume(
+        num_spans,
+        [&](CircularBufferRange<AtomicUniquePtr<ChainedStream>> &
+            spans) noexcept {
+          spans.ForEach([&](AtomicUniquePtr<ChainedStream> & span) noexcept {
+            std::unique_ptr<ChainedStream> span_out;
+            span.Swap(span_out);
+            num_bytes += static_cast<size_t>(span_out->ByteCount());
+            spans_.emplace_back(std::move(span_out));
+            return true;
+          });
+          return true;
+        });
+  }
+
+  reports.emplace_back(std::unique_ptr<ReportRequest>{
+      new ReportRequest{header_, num_dropped_spans}});
+  size_t report_spans = 0;
+  size_t report_bytes = 0;
+  for (auto& span : spans_) {
+    auto span_bytes = static_cast<size_t>(span->ByteCount());
+    auto is_full =
+        report_spans > 0 &&
+        ((max_report_spans_ != 0 && report_spans + 1 > max_report_spans_) ||
+         (max_report_bytes_ != 0 &&
+          report_bytes + span_bytes > max_report_bytes_));
+    if (is_full) {
+      reports.emplace_back(
+          std::unique_ptr<ReportRequest>{new ReportRequest{header_, 0}});
+      report_spans = 0;
+      report_bytes = 0;
+    }
+    ++report_spans;
+    report_bytes += span_bytes;
+    reports.back()->AddSpan(std::move(span));
+  }
+}
+}  // namespace lightstep
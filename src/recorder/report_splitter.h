@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/byte_budget.h"
+#include "common/chained_stream.h"
+#include "common/noncopyable.h"
+#include "common/sharded_circular_buffer.h"
+#include "recorder/metrics_tracker.h"
+#include "recorder/serialization/report_request.h"
+
+namespace lightstep {
+/**
+ * Drains a span buffer into ReportRequests that are each bounded by a maximum
+ * number of spans and bytes of serialized spans, so that a large flush can be
+ * sent as several reports in parallel.
+ */
+class ReportSplitter : private Noncopyable {
+ public:
+  /**
+   * @param header the serialized header of the ReportRequests
+   * @param max_report_spans the maximum number of spans in a report or 0 for
+   * no limit
+   * @param max_report_bytes the maximum number of bytes of serialized spans in
+   * a report or 0 for no limit
+   */
+  ReportSplitter(std::shared_ptr<const std::string> header,
+                 size_t max_report_spans, size_t max_report_bytes) noexcept;
+
+  /**
+   * Removes all the spans from a span buffer and adds them to ReportRequests.
+   * @param num_dropped_spans the number of dropped spans to record in the
+   * first ReportRequest
+   * @param span_buffer the buffer to consume spans from
+   * @param span_buffer_budget the budget to release the consumed spans' bytes
+   * to
+   * @param reports the vector to append the ReportRequests to
+   * @param metrics the tracker to count the consumed spans as dropped with if
+   * the ReportRequests can't be allocated
+   *
+   * Note: At least one ReportRequest is appended, even if span_buffer is
+   * empty. A span larger than max_report_bytes gets a ReportRequest of its
+   * own.
+   *
+   * Note: If an exception is thrown, no ReportRequests are appended, the
+   * consumed spans are counted as dropped, and num_dropped_spans is added back
+   * to metrics.
+   *
+   * Note: This method must only be called from one thread at a time.
+   */
+  void Split(int num_dropped_spans,
+             ShardedCircularBuffer<ChainedStream>& span_buffer,
+             ByteBudget& span_buffer_budget,
+             std::vector<std::unique_ptr<ReportRequest>>& reports,
+             MetricsTracker& metrics);
+
+ private:
+  std::shared_ptr<const std::string> header_;
+  size_t max_report_spans_;
+  size_t max_report_bytes_;
+
+  // Spans are staged here while draining the buffer since consuming a shard
+  // can't throw, but allocating ReportRequests can. Holds on to its capacity
+  // across flushes.
+  //
+  // Note: Spans moved into a ReportRequest leave an empty slot behind, so the
+  // size is the number of spans consumed.
+  std::vector<std::unique_ptr<ChainedStream>> spans_;
+
+  void SplitSpans(int num_dropped_spans,
+                  ShardedCircularBuffer<ChainedStream>& span_buffer,
+                  size_t& num_bytes,
+                  std::vector<std::unique_ptr<ReportRequest>>& reports);
+};
+}  // namespace lightstep
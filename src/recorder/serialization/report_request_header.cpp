@@ -1,5 +1,7 @@
 #include "recorder/serialization/report_request_header.h"
 
+#include <sstream>
+
 #include "common/protobuf.h"
 #include "common/utility.h"
 #include "lightstep-tracer-common/collector.pb.h"
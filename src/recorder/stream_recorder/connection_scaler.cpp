@@ -0,0 +1,39 @@
+#include "recorder/stream_recorder/connection_scaler.h"
+
+#include <algorithm>
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+ConnectionScaler::ConnectionScaler(int min_connections, int max_connections,
+                                   double max_write_blocked_fraction,
+                                   size_t min_connection_throughput) noexcept
+    : min_connections_{std::max(min_connections, 1)},
+      max_connections_{std::max(max_connections, min_connections_)},
+      max_write_blocked_fraction_{max_write_blocked_fraction},
+      min_connection_throughput_{
+          static_cast<double>(min_connection_throughput)} {}
+
+//--------------------------------------------------------------------------------------------------
+// ComputeNumConnections
+//--------------------------------------------------------------------------------------------------
+int ConnectionScaler::ComputeNumConnections(const ConnectionLoad& load) const
+    noexcept {
+  auto num_connections = load.num_connections;
+
+  // Grow quickly when the connections can't keep up so that spans aren't
+  // dropped, but shrink one connection at a time.
+  if (load.backlogged &&
+      load.write_blocked_fraction > max_write_blocked_fraction_) {
+    num_connections += std::max(num_connections / 2, 1);
+  } else if (!load.backlogged &&
+             load.write_blocked_fraction < max_write_blocked_fraction_ / 2 &&
+             load.bytes_per_second <
+                 min_connection_throughput_ * (num_connections - 1)) {
+    --num_connections;
+  }
+  return std::min(std::max(num_connections, min_connections_),
+                  max_connections_);
+}
+}  // namespace lightstep
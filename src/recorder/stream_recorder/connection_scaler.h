@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lightstep {
+/**
+ * Load on a set of satellite connections measured over a scaling period.
+ */
+struct ConnectionLoad {
+  int num_connections = 0;
+
+  // The average fraction of the period each connection spent blocked on
+  // writes.
+  double write_blocked_fraction = 0;
+
+  // The number of span bytes streamed per second.
+  double bytes_per_second = 0;
+
+  // True if spans were left in the span buffer because no connection could
+  // take more data.
+  bool backlogged = false;
+};
+
+/**
+ * Decides how many satellite connections to keep open for a given load.
+ */
+class ConnectionScaler {
+ public:
+  /**
+   * @param min_connections the fewest connections to keep open
+   * @param max_connections the most connections to keep open
+   * @param max_write_blocked_fraction connections are added when the span
+   * buffer is backlogged and they're blocked for more than this fraction of
+   * the time
+   * @param min_connection_throughput connections are removed while the
+   * remaining ones would each stream fewer than this many bytes per second
+   */
+  ConnectionScaler(int min_connections, int max_connections,
+                   double max_write_blocked_fraction,
+                   size_t min_connection_throughput) noexcept;
+
+  /**
+   * @return true if the number of connections can change.
+   */
+  bool enabled() const noexcept { return min_connections_ < max_connections_; }
+
+  /**
+   * @return the fewest connections to keep open.
+   */
+  int min_connections() const noexcept { return min_connections_; }
+
+  /**
+   * @return the most connections to keep open.
+   */
+  int max_connections() const noexcept { return max_connections_; }
+
+  /**
+   * @param load the load measured over the last scaling period
+   * @return the number of connections to use for the next period.
+   */
+  int ComputeNumConnections(const ConnectionLoad& load) const noexcept;
+
+ private:
+  int min_connections_;
+  int max_connections_;
+  double max_write_blocked_fraction_;
+  double min_connection_throughput_;
+};
+}  // namespace lightstep
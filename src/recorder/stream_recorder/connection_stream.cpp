@@ -1,7 +1,12 @@
 #include "recorder/stream_recorder/connection_stream.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdio>
+#include <stdexcept>
+
+#include "common/chunked_http_framing.h"
 
 namespace lightstep {
 //--------------------------------------------------------------------------------------------------
@@ -35,15 +40,76 @@ static Fragment WriteChunkHeader(char* buffer, size_t buffer_size,
   return {static_cast<void*>(buffer), static_cast<int>(num_chunk_header_chars)};
 }
 
+//--------------------------------------------------------------------------------------------------
+// CompressChunkPayloads
+//--------------------------------------------------------------------------------------------------
+// Spans are framed as http/1.1 chunks with a fixed-width header. When the body
+// is compressed, the framing has to be applied to the compressed data instead,
+// so only the payloads of the chunks are fed to the compressor.
+static bool CompressChunkPayloads(const FragmentInputStream& stream,
+                                  StreamCompressor& compressor,
+                                  int& num_chunks) noexcept {
+  std::array<char, Num32BitHexDigits> chunk_size_hex;
+  size_t header_position = 0;
+  size_t payload_remaining = 0;
+  size_t footer_remaining = 0;
+  return stream.ForEachFragment([&](void* data, int size) noexcept {
+    auto iter = static_cast<const char*>(data);
+    auto last = iter + size;
+    while (iter != last) {
+      auto num_available = static_cast<size_t>(last - iter);
+      if (footer_remaining > 0) {
+        auto n = std::min(footer_remaining, num_available);
+        footer_remaining -= n;
+        iter += n;
+        continue;
+      }
+      if (payload_remaining > 0) {
+        auto n = std::min(payload_remaining, num_available);
+        if (!compressor.Compress(static_cast<const void*>(iter), n)) {
+          return false;
+        }
+        payload_remaining -= n;
+        iter += n;
+        if (payload_remaining == 0) {
+          footer_remaining = ChunkedHttpFooter.size();
+        }
+        continue;
+      }
+      if (header_position < chunk_size_hex.size()) {
+        chunk_size_hex[header_position] = *iter;
+      }
+      ++header_position;
+      ++iter;
+      if (header_position < ChunkedHttpMaxHeaderSize) {
+        continue;
+      }
+      header_position = 0;
+      auto chunk_size = HexToUint64(opentracing::string_view{
+          chunk_size_hex.data(), chunk_size_hex.size()});
+      if (!chunk_size) {
+        return false;
+      }
+      ++num_chunks;
+      payload_remaining = static_cast<size_t>(*chunk_size);
+      if (payload_remaining == 0) {
+        footer_remaining = ChunkedHttpFooter.size();
+      }
+    }
+    return true;
+  });
+}
+
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
-ConnectionStream::ConnectionStream(Fragment host_header_fragment,
-                                   Fragment header_common_fragment,
-                                   SpanStream& span_stream)
+ConnectionStream::ConnectionStream(
+    Fragment host_header_fragment, Fragment header_common_fragment,
+    SpanStream& span_stream, std::unique_ptr<StreamCompressor>&& compressor)
     : host_header_fragment_{std::move(host_header_fragment)},
       header_common_fragment_{std::move(header_common_fragment)},
-      span_stream_{span_stream} {
+      span_stream_{span_stream},
+      compressor_{std::move(compressor)} {
   InitializeStream();
 }
 
@@ -51,15 +117,21 @@ ConnectionStream::ConnectionStream(Fragment host_header_fragment,
 // Reset
 //--------------------------------------------------------------------------------------------------
 void ConnectionStream::Reset() {
-  if (!header_stream_.empty()) {
+  if (!header_stream_.empty() || compressed_metrics_pending_) {
     // We weren't able to upload the metrics so add the counters back
     span_stream_.metrics().UnconsumeDroppedSpans(
         embedded_metrics_message_.num_dropped_spans());
   }
   if (span_remnant_ != nullptr && !span_remnant_->empty()) {
     span_stream_.metrics().OnSpansDropped(1);
+    span_stream_.metrics().OnBytesDropped(
+        static_cast<size_t>(span_remnant_->ByteCount()));
   }
   span_remnant_.reset();
+  if (num_compressed_spans_ > 0) {
+    // The chunk holding the compressed spans never made it out.
+    span_stream_.metrics().OnSpansDropped(num_compressed_spans_);
+  }
   InitializeStream();
 }
 
@@ -72,6 +144,9 @@ void ConnectionStream::Shutdown() noexcept { shutting_down_ = true; }
 // Flush
 //--------------------------------------------------------------------------------------------------
 bool ConnectionStream::Flush(Writer writer) {
+  if (compressor_ != nullptr) {
+    return FlushCompressed(writer);
+  }
   if (shutting_down_) {
     return FlushShutdown(writer);
   }
@@ -84,6 +159,7 @@ bool ConnectionStream::Flush(Writer writer) {
   auto result = writer({&header_stream_, span_remnant_.get(), &span_stream_});
   if (span_remnant_->empty()) {
     span_stream_.metrics().OnSpansSent(1);
+    span_stream_.ReleaseSpan(std::move(span_remnant_));
     span_remnant_ = span_stream_.ConsumeRemnant();
   }
   return result;
@@ -100,6 +176,10 @@ void ConnectionStream::InitializeStream() {
       span_stream_.metrics().ConsumeDroppedSpans());
   auto metrics_fragment = embedded_metrics_message_.MakeFragment();
 
+  if (compressor_ != nullptr) {
+    return InitializeCompressedStream(metrics_fragment);
+  }
+
   auto header_chunk_size =
       header_common_fragment_.second + metrics_fragment.second;
 
@@ -114,12 +194,40 @@ void ConnectionStream::InitializeStream() {
       EndOfLineFragment};
 }
 
+//--------------------------------------------------------------------------------------------------
+// InitializeCompressedStream
+//--------------------------------------------------------------------------------------------------
+void ConnectionStream::InitializeCompressedStream(Fragment metrics_fragment) {
+  header_stream_ = {HttpRequestCommonFragment,
+                    compressor_->content_encoding_header(),
+                    host_header_fragment_, EndOfLineFragment};
+  compressed_chunk_stream_ = {};
+  num_compressed_spans_ = 0;
+  compressor_finished_ = false;
+
+  // The report header and metrics are part of the body, so they get compressed
+  // into the first chunk along with any spans.
+  compressed_metrics_pending_ = true;
+  auto compress = [this](Fragment fragment) {
+    return compressor_->Compress(fragment.first,
+                                 static_cast<size_t>(fragment.second));
+  };
+  if (!compressor_->Reset() || !compress(header_common_fragment_) ||
+      !compress(metrics_fragment)) {
+    throw std::runtime_error{"failed to compress the stream header"};
+  }
+}
+
 //--------------------------------------------------------------------------------------------------
 // first_chunk_position
 //--------------------------------------------------------------------------------------------------
 int ConnectionStream::first_chunk_position() const noexcept {
-  return HttpRequestCommonFragment.second + host_header_fragment_.second +
-         EndOfLineFragment.second;
+  auto result = HttpRequestCommonFragment.second +
+                host_header_fragment_.second + EndOfLineFragment.second;
+  if (compressor_ != nullptr) {
+    result += compressor_->content_encoding_header().second;
+  }
+  return result;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -133,8 +241,70 @@ bool ConnectionStream::FlushShutdown(Writer writer) {
       writer({&header_stream_, span_remnant_.get(), &terminal_stream_});
   if (span_remnant_->empty()) {
     span_stream_.metrics().OnSpansSent(1);
-    span_remnant_.reset();
+    span_stream_.ReleaseSpan(std::move(span_remnant_));
   }
   return result;
 }
+
+//--------------------------------------------------------------------------------------------------
+// FlushCompressed
+//--------------------------------------------------------------------------------------------------
+bool ConnectionStream::FlushCompressed(Writer writer) {
+  while (true) {
+    if (compressed_chunk_stream_.empty() && !compressor_finished_) {
+      CompressChunk();
+    }
+    bool result;
+    if (compressor_finished_) {
+      result = writer(
+          {&header_stream_, &compressed_chunk_stream_, &terminal_stream_});
+    } else {
+      result = writer({&header_stream_, &compressed_chunk_stream_});
+    }
+    if (compressed_chunk_stream_.empty()) {
+      compressor_->ClearOutput();
+      compressed_metrics_pending_ = false;
+      span_stream_.metrics().OnSpansSent(num_compressed_spans_);
+      num_compressed_spans_ = 0;
+    }
+
+    // If we're shutting down and wrote out a chunk compressed before the
+    // shutdown, loop around to finish the stream.
+    if (!result || !shutting_down_ || compressor_finished_) {
+      return result;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// CompressChunk
+//--------------------------------------------------------------------------------------------------
+void ConnectionStream::CompressChunk() {
+  span_stream_.Allot();
+  int num_spans = 0;
+  if (!CompressChunkPayloads(span_stream_, *compressor_, num_spans)) {
+    throw std::runtime_error{"failed to compress spans"};
+  }
+  // Only count the spans as sent once the chunk holding them is written.
+  span_stream_.ConsumeAllotment();
+  num_compressed_spans_ = num_spans;
+  if (shutting_down_) {
+    if (!compressor_->Finish()) {
+      throw std::runtime_error{"failed to finish the compressed stream"};
+    }
+    compressor_finished_ = true;
+  } else if (!compressor_->Flush()) {
+    throw std::runtime_error{"failed to flush the compressed stream"};
+  }
+  auto output = compressor_->output();
+  if (output.second == 0) {
+    // Don't write an empty chunk since that would terminate the body.
+    compressed_chunk_stream_ = {};
+    return;
+  }
+  compressed_chunk_stream_ = {
+      WriteChunkHeader(chunk_header_buffer_.data(), chunk_header_buffer_.size(),
+                       output.second),
+      output, EndOfLineFragment};
+}
 }  // namespace lightstep
@@ -11,6 +11,7 @@
 #include "common/utility.h"
 #include "recorder/serialization/embedded_metrics_message.h"
 #include "recorder/stream_recorder/span_stream.h"
+#include "recorder/stream_recorder/stream_compressor.h"
 
 namespace lightstep {
 /**
@@ -24,8 +25,16 @@ class ConnectionStream {
   using Writer = FunctionRef<bool(
       std::initializer_list<FragmentInputStream*> fragment_input_streams)>;
 
+  /**
+   * @param host_header_fragment the http host header
+   * @param header_common_fragment the serialized fields common to every report
+   * @param span_stream the stream of spans to send
+   * @param compressor if non-null, the compressor to apply a Content-Encoding
+   * to the request body with
+   */
   ConnectionStream(Fragment host_header_fragment,
-                   Fragment header_common_fragment, SpanStream& span_stream);
+                   Fragment header_common_fragment, SpanStream& span_stream,
+                   std::unique_ptr<StreamCompressor>&& compressor = nullptr);
 
   /**
    * Reset so as to begin a new streaming session.
@@ -37,6 +46,11 @@ class ConnectionStream {
    */
   void Shutdown() noexcept;
 
+  /**
+   * @return true if the request body is compressed.
+   */
+  bool compressed() const noexcept { return compressor_ != nullptr; }
+
   /**
    * @return true if the stream is in the process of shutting down.
    */
@@ -74,10 +88,22 @@ class ConnectionStream {
 
   std::unique_ptr<ChainedStream> span_remnant_;
 
+  std::unique_ptr<StreamCompressor> compressor_;
+  FragmentArrayInputStream compressed_chunk_stream_;
+  int num_compressed_spans_{0};
+  bool compressed_metrics_pending_{false};
+  bool compressor_finished_{false};
+
   bool shutting_down_;
 
   void InitializeStream();
 
+  void InitializeCompressedStream(Fragment metrics_fragment);
+
   bool FlushShutdown(Writer writer);
+
+  bool FlushCompressed(Writer writer);
+
+  void CompressChunk();
 };
 }  // namespace lightstep
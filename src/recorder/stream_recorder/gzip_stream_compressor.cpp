@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "recorder/stream_recorder/stream_compressor.h"
+
+#include <zlib.h>
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// ContentEncodingHeaderFragment
+//--------------------------------------------------------------------------------------------------
+static const Fragment ContentEncodingHeaderFragment =
+    MakeFragment("Content-Encoding:gzip\r\n");
+
+//--------------------------------------------------------------------------------------------------
+// GzipWindowBits
+//--------------------------------------------------------------------------------------------------
+// Adding 16 to the window bits tells zlib to write a gzip header and trailer
+// instead of a zlib wrapper.
+static const int GzipWindowBits = 15 + 16;
+
+//--------------------------------------------------------------------------------------------------
+// MinOutputSpace
+//--------------------------------------------------------------------------------------------------
+static const size_t MinOutputSpace = 4096;
+
+//--------------------------------------------------------------------------------------------------
+// GzipStreamCompressor
+//--------------------------------------------------------------------------------------------------
+namespace {
+class GzipStreamCompressor final : public StreamCompressor {
+ public:
+  GzipStreamCompressor(int level, CompressionBudget& budget) noexcept
+      : level_{level}, budget_{budget} {
+    std::memset(static_cast<void*>(&stream_), 0, sizeof(stream_));
+  }
+
+  ~GzipStreamCompressor() noexcept override {
+    if (initialized_) {
+      deflateEnd(&stream_);
+    }
+  }
+
+  bool Init() noexcept {
+    initialized_ = deflateInit2(&stream_, level_, Z_DEFLATED, GzipWindowBits,
+                                8, Z_DEFAULT_STRATEGY) == Z_OK;
+    current_level_ = level_;
+    return initialized_;
+  }
+
+  // StreamCompressor
+  Fragment content_encoding_header() const noexcept override {
+    return ContentEncodingHeaderFragment;
+  }
+
+  bool Reset() noexcept override {
+    ClearOutput();
+    return deflateReset(&stream_) == Z_OK && AdjustLevel();
+  }
+
+  bool Compress(const void* data, size_t size) noexcept override {
+    stream_.next_in =
+        static_cast<Bytef*>(static_cast<void*>(const_cast<void*>(data)));
+    while (size > 0) {
+      auto num_bytes = static_cast<uInt>(
+          std::min<size_t>(size, std::numeric_limits<uInt>::max()));
+      stream_.avail_in = num_bytes;
+      if (!Deflate(Z_NO_FLUSH)) {
+        return false;
+      }
+      size -= num_bytes;
+    }
+    return true;
+  }
+
+  bool Flush() noexcept override {
+    // Switch levels right after a flush so that deflateParams doesn't have to
+    // end a partial block.
+    return Deflate(Z_SYNC_FLUSH) && AdjustLevel();
+  }
+
+  bool Finish() noexcept override { return Deflate(Z_FINISH); }
+
+  Fragment output() const noexcept override {
+    return {const_cast<char*>(output_.data()), static_cast<int>(output_size_)};
+  }
+
+  void ClearOutput() noexcept override { output_size_ = 0; }
+
+ private:
+  z_stream stream_;
+  bool initialized_{false};
+  int level_;
+  int current_level_;
+  CompressionBudget& budget_;
+  std::string output_;
+  size_t output_size_{0};
+
+  bool AdjustLevel() noexcept {
+    auto level = budget_.exhausted(std::chrono::steady_clock::now())
+                     ? Z_NO_COMPRESSION
+                     : level_;
+    if (level == current_level_) {
+      return true;
+    }
+    while (true) {
+      if (!ReserveOutput()) {
+        return false;
+      }
+      auto result = deflateParams(&stream_, level, Z_DEFAULT_STRATEGY);
+      CommitOutput();
+      if (result == Z_OK) {
+        current_level_ = level;
+        return true;
+      }
+      if (result != Z_BUF_ERROR) {
+        return false;
+      }
+    }
+  }
+
+  bool Deflate(int flush) noexcept {
+    auto start = std::chrono::steady_clock::now();
+    auto result = DeflateImpl(flush);
+    budget_.Charge(std::chrono::steady_clock::now() - start);
+    return result;
+  }
+
+  bool DeflateImpl(int flush) noexcept {
+    while (true) {
+      if (!ReserveOutput()) {
+        return false;
+      }
+      auto result = deflate(&stream_, flush);
+      CommitOutput();
+      if (result == Z_STREAM_END) {
+        return true;
+      }
+      if (result != Z_OK && result != Z_BUF_ERROR) {
+        return false;
+      }
+      // Unless we're finishing the stream, zlib has consumed and flushed
+      // everything once it stops filling the output buffer.
+      if (flush != Z_FINISH && stream_.avail_in == 0 &&
+          stream_.avail_out != 0) {
+        return true;
+      }
+    }
+  }
+
+  bool ReserveOutput() noexcept try {
+    if (output_.size() - output_size_ < MinOutputSpace) {
+      output_.resize(
+          std::max(2 * output_.size(), output_size_ + MinOutputSpace));
+    }
+    auto available = std::min<size_t>(output_.size() - output_size_,
+                                      std::numeric_limits<uInt>::max());
+    stream_.next_out =
+        static_cast<Bytef*>(static_cast<void*>(&output_[output_size_]));
+    stream_.avail_out = static_cast<uInt>(available);
+    return true;
+  } catch (const std::exception& /*e*/) {
+    return false;
+  }
+
+  void CommitOutput() noexcept {
+    output_size_ = static_cast<size_t>(
+        static_cast<char*>(static_cast<void*>(stream_.next_out)) -
+        &output_[0]);
+  }
+};
+}  // namespace
+
+//--------------------------------------------------------------------------------------------------
+// MakeStreamCompressor
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<StreamCompressor> MakeStreamCompressor(
+    Logger& logger, const StreamRecorderOptions& options,
+    CompressionBudget& budget) {
+  if (options.compression_level == 0) {
+    return nullptr;
+  }
+  std::unique_ptr<GzipStreamCompressor> result{
+      new GzipStreamCompressor{options.compression_level, budget}};
+  if (!result->Init()) {
+    logger.Warn("Failed to initialize gzip compression at level ",
+                options.compression_level,
+                ": streaming satellite data uncompressed");
+    return nullptr;
+  }
+  return std::unique_ptr<StreamCompressor>{result.release()};
+}
+}  // namespace lightstep
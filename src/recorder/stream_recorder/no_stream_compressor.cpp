@@ -0,0 +1,17 @@
+#include "recorder/stream_recorder/stream_compressor.h"
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// MakeStreamCompressor
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<StreamCompressor> MakeStreamCompressor(
+    Logger& logger, const StreamRecorderOptions& options,
+    CompressionBudget& /*budget*/) {
+  if (options.compression_level != 0) {
+    logger.Warn(
+        "Streaming satellite data uncompressed: the tracer needs to be "
+        "rebuilt with zlib support to use compression.");
+  }
+  return nullptr;
+}
+}  // namespace lightstep
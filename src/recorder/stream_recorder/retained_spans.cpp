@@ -0,0 +1,104 @@
+#include "recorder/stream_recorder/retained_spans.h"
+
+#include <cassert>
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// SealEntries
+//--------------------------------------------------------------------------------------------------
+template <class T>
+static void SealEntries(std::vector<std::pair<uint32_t, T>>& entries,
+                        size_t& num_sealed, uint32_t num_sends) noexcept {
+  for (auto i = num_sealed; i < entries.size(); ++i) {
+    entries[i].first = num_sends;
+  }
+  num_sealed = entries.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+// ReleaseEntries
+//--------------------------------------------------------------------------------------------------
+template <class T>
+static void ReleaseEntries(std::vector<std::pair<uint32_t, T>>& entries,
+                           size_t& num_sealed,
+                           uint32_t num_completed_sends) noexcept {
+  // Entries are sealed in order, so the ones that can be freed form a prefix.
+  // Send numbers wrap around, so compare them by their distance.
+  size_t num_released = 0;
+  while (num_released < num_sealed &&
+         static_cast<int32_t>(entries[num_released].first -
+                              num_completed_sends) <= 0) {
+    ++num_released;
+  }
+  if (num_released == 0) {
+    return;
+  }
+  entries.erase(entries.begin(),
+                entries.begin() + static_cast<std::ptrdiff_t>(num_released));
+  num_sealed -= num_released;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Reserve
+//--------------------------------------------------------------------------------------------------
+void RetainedSpans::Reserve(size_t n) {
+  spans_.reserve(spans_.size() + n);
+  ring_positions_.reserve(ring_positions_.size() + n);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Retain
+//--------------------------------------------------------------------------------------------------
+void RetainedSpans::Retain(std::unique_ptr<ChainedStream>&& span) noexcept {
+  assert(spans_.size() < spans_.capacity());
+  spans_.emplace_back(0, std::move(span));
+}
+
+//--------------------------------------------------------------------------------------------------
+// RetainRing
+//--------------------------------------------------------------------------------------------------
+void RetainedSpans::RetainRing(uint64_t position) noexcept {
+  assert(ring_positions_.size() < ring_positions_.capacity());
+  ring_positions_.emplace_back(0, position);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Seal
+//--------------------------------------------------------------------------------------------------
+void RetainedSpans::Seal(uint32_t num_sends) noexcept {
+  SealEntries(spans_, num_sealed_spans_, num_sends);
+  SealEntries(ring_positions_, num_sealed_ring_positions_, num_sends);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Release
+//--------------------------------------------------------------------------------------------------
+void RetainedSpans::Release(uint32_t num_completed_sends) noexcept {
+  ReleaseEntries(spans_, num_sealed_spans_, num_completed_sends);
+  ReleaseEntries(ring_positions_, num_sealed_ring_positions_,
+                 num_completed_sends);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Clear
+//--------------------------------------------------------------------------------------------------
+void RetainedSpans::Clear() noexcept {
+  spans_.clear();
+  num_sealed_spans_ = 0;
+  ring_positions_.clear();
+  num_sealed_ring_positions_ = 0;
+  num_unsent_spans_ = 0;
+  num_unsent_bytes_ = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// oldest_ring_position
+//--------------------------------------------------------------------------------------------------
+bool RetainedSpans::oldest_ring_position(uint64_t& position) const noexcept {
+  if (ring_positions_.empty()) {
+    return false;
+  }
+  position = ring_positions_.front().second;
+  return true;
+}
+}  // namespace lightstep
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/chained_stream.h"
+#include "common/noncopyable.h"
+
+namespace lightstep {
+/**
+ * Keeps spans that were written to a satellite with MSG_ZEROCOPY alive until
+ * the kernel is done sending them.
+ *
+ * Spans are retained as they're consumed from the span buffer and then sealed
+ * with the number of zero-copy sends made so far. Once every one of those
+ * sends completes, the spans can be freed. Spans streamed from a contiguous
+ * span buffer are retained by the position they start at, which holds back
+ * the buffer's consumption (see SpanStream::ReleaseRing).
+ */
+class RetainedSpans : private Noncopyable {
+ public:
+  /**
+   * Makes room for more spans so that Retain and RetainRing won't need to
+   * allocate.
+   * @param n the number of spans and of ranges of the contiguous span buffer
+   * to make room for
+   */
+  void Reserve(size_t n);
+
+  /**
+   * Takes ownership of a span.
+   * @param span the span to retain
+   *
+   * Note: Room must have been made for the span with Reserve.
+   */
+  void Retain(std::unique_ptr<ChainedStream>&& span) noexcept;
+
+  /**
+   * Retains the spans of the contiguous span buffer from a given position.
+   * @param position the position of the first byte to retain
+   *
+   * Note: Room must have been made for the range with Reserve.
+   */
+  void RetainRing(uint64_t position) noexcept;
+
+  /**
+   * Marks the spans retained since the last call as referenced by sends
+   * numbered below num_sends.
+   * @param num_sends the number of zero-copy sends made
+   */
+  void Seal(uint32_t num_sends) noexcept;
+
+  /**
+   * Frees the sealed spans that are no longer referenced by a pending send.
+   * @param num_completed_sends the number of sends such that every send
+   * numbered below it is complete
+   */
+  void Release(uint32_t num_completed_sends) noexcept;
+
+  /**
+   * Tallies spans that were consumed into a write that hasn't completed, so
+   * that they're only counted as sent once it does.
+   * @param num_spans the number of spans
+   * @param num_bytes the number of bytes the spans take up
+   */
+  void AddUnsentSpans(int num_spans, size_t num_bytes) noexcept {
+    num_unsent_spans_ += num_spans;
+    num_unsent_bytes_ += num_bytes;
+  }
+
+  /**
+   * Frees all the spans and resets the tally of unsent spans.
+   */
+  void Clear() noexcept;
+
+  /**
+   * @return the number of spans retained.
+   */
+  size_t size() const noexcept { return spans_.size(); }
+
+  /**
+   * @return the number of spans tallied with AddUnsentSpans.
+   */
+  int num_unsent_spans() const noexcept { return num_unsent_spans_; }
+
+  /**
+   * @return the number of bytes tallied with AddUnsentSpans.
+   */
+  size_t num_unsent_bytes() const noexcept { return num_unsent_bytes_; }
+
+  /**
+   * @param position set to the position of the first byte retained from the
+   * contiguous span buffer
+   * @return true if any of the contiguous span buffer is retained.
+   */
+  bool oldest_ring_position(uint64_t& position) const noexcept;
+
+ private:
+  std::vector<std::pair<uint32_t, std::unique_ptr<ChainedStream>>> spans_;
+  size_t num_sealed_spans_{0};
+  std::vector<std::pair<uint32_t, uint64_t>> ring_positions_;
+  size_t num_sealed_ring_positions_{0};
+  int num_unsent_spans_{0};
+  size_t num_unsent_bytes_{0};
+};
+}  // namespace lightstep
@@ -13,6 +13,31 @@
 #include <event2/event.h>
 
 namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// CanUseZeroCopy
+//--------------------------------------------------------------------------------------------------
+static bool CanUseZeroCopy(SatelliteStreamer& streamer,
+                           const ConnectionStream& connection_stream) noexcept {
+  return streamer.recorder_options().min_zero_copy_write_size > 0 &&
+         !connection_stream.compressed();
+}
+
+//--------------------------------------------------------------------------------------------------
+// MakeIoUringWrite
+//--------------------------------------------------------------------------------------------------
+static std::unique_ptr<IoUringWrite> MakeIoUringWrite(
+    SatelliteStreamer& streamer, const ConnectionStream& connection_stream,
+    SatelliteConnection& connection, IoUringWrite::Callback callback) {
+  // A compressed stream reuses the memory it writes from right away, so it
+  // can't leave writes in flight.
+  auto writer = streamer.io_uring_writer();
+  if (writer == nullptr || connection_stream.compressed()) {
+    return nullptr;
+  }
+  return std::unique_ptr<IoUringWrite>{
+      new IoUringWrite{*writer, callback, static_cast<void*>(&connection)}};
+}
+
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
@@ -21,7 +46,12 @@ SatelliteConnection::SatelliteConnection(SatelliteStreamer& streamer)
       host_header_{streamer.tracer_options()},
       connection_stream_{host_header_.fragment(),
                          streamer.header_common_fragment(),
-                         streamer.span_stream()},
+                         streamer.span_stream(),
+                         MakeStreamCompressor(streamer.logger(),
+                                              streamer.recorder_options(),
+                                              streamer.compression_budget())},
+      write_latency_{streamer.recorder_options().satellite_latency_weight},
+      zero_copy_tracker_{streamer.recorder_options().min_zero_copy_write_size},
       reconnect_timer_{
           streamer_.event_base(), -1, 0,
           MakeTimerCallback<SatelliteConnection,
@@ -31,18 +61,40 @@ SatelliteConnection::SatelliteConnection(SatelliteStreamer& streamer)
           streamer.event_base(), -1, 0,
           MakeTimerCallback<SatelliteConnection,
                             &SatelliteConnection::GracefulShutdownTimeout>(),
-          static_cast<void*>(this)} {}
+          static_cast<void*>(this)},
+      write_timeout_{streamer.event_base(), -1, 0,
+                     MakeTimerCallback<SatelliteConnection,
+                                       &SatelliteConnection::OnWriteTimeout>(),
+                     static_cast<void*>(this)} {
+  io_uring_write_ = MakeIoUringWrite(
+      streamer_, connection_stream_, *this,
+      MakeIoUringWriteCallback<SatelliteConnection,
+                               &SatelliteConnection::OnWriteComplete>());
+  if (io_uring_write_ != nullptr ||
+      CanUseZeroCopy(streamer_, connection_stream_)) {
+    streamer_.span_stream().AddRingRetainer(retained_spans_);
+  }
+}
 
 //--------------------------------------------------------------------------------------------------
 // destructor
 //--------------------------------------------------------------------------------------------------
 SatelliteConnection::~SatelliteConnection() noexcept {
+  // A write still in flight can't complete once the connection's gone, and
+  // the stream can only be closed with writev since the event loop won't run
+  // again to submit a write.
+  CancelIoUringWrite();
+  io_uring_write_.reset();
+
   // If there's a streaming session open, attempt to cleanly close it if we can
   // do so without blocking.
   if (writable_) {
     connection_stream_.Shutdown();
     Flush();
   }
+  retained_spans_.Clear();
+  streamer_.span_stream().RemoveRingRetainer(retained_spans_);
+  streamer_.span_stream().ReleaseRing();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -54,18 +106,29 @@ void SatelliteConnection::Start() noexcept { Connect(); }
 // Flush
 //--------------------------------------------------------------------------------------------------
 bool SatelliteConnection::Flush() noexcept try {
-  auto flushed_everything = connection_stream_.Flush(
-      [this](std::initializer_list<FragmentInputStream*> fragment_streams) {
-        return Write(socket_.file_descriptor(), fragment_streams);
-      });
+  if (io_uring_write_ != nullptr) {
+    return FlushIoUring();
+  }
+  auto start_timestamp = std::chrono::steady_clock::now();
+  auto flushed_everything = FlushConnectionStream();
+  if (flushed_everything && !write_blocked_) {
+    RecordWriteLatency(std::chrono::steady_clock::now() - start_timestamp);
+  }
+  SetWriteBlocked(!flushed_everything);
+  SampleUnacknowledgedBytes();
+  // Flushes happen constantly, so limit how often they're logged.
   if (flushed_everything) {
     writable_ = true;
-    streamer_.logger().Info("Flushed everything to file_descriptor ",
+    static LogRateLimiter rate_limiter;
+    streamer_.logger().Info(rate_limiter,
+                            "Flushed everything to file_descriptor ",
                             socket_.file_descriptor());
   } else {
     writable_ = false;
     write_event_.Add(streamer_.recorder_options().satellite_write_timeout);
-    streamer_.logger().Info("Flushed partially to file_descriptor ",
+    static LogRateLimiter rate_limiter;
+    streamer_.logger().Info(rate_limiter,
+                            "Flushed partially to file_descriptor ",
                             socket_.file_descriptor());
   }
   return flushed_everything;
@@ -90,14 +153,42 @@ bool SatelliteConnection::ready() const noexcept {
   return writable_ && !connection_stream_.shutting_down();
 }
 
+//--------------------------------------------------------------------------------------------------
+// cost
+//--------------------------------------------------------------------------------------------------
+double SatelliteConnection::cost() const noexcept {
+  return ComputeSatelliteCost(write_latency_.value(),
+                              static_cast<double>(num_unacknowledged_bytes_));
+}
+
+//--------------------------------------------------------------------------------------------------
+// ConsumeWriteBlockedDuration
+//--------------------------------------------------------------------------------------------------
+std::chrono::steady_clock::duration
+SatelliteConnection::ConsumeWriteBlockedDuration(
+    std::chrono::steady_clock::time_point now) noexcept {
+  auto result = write_blocked_duration_;
+  if (write_blocked_) {
+    result += now - write_blocked_timestamp_;
+    write_blocked_timestamp_ = now;
+  }
+  write_blocked_duration_ = std::chrono::steady_clock::duration{0};
+  return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Connect
 //--------------------------------------------------------------------------------------------------
 void SatelliteConnection::Connect() noexcept try {
   auto endpoint = streamer_.endpoint_manager().RequestEndpoint();
+  endpoint_ = endpoint.first;
+  has_endpoint_ = true;
   streamer_.logger().Info("Connecting to satellite on ip ", endpoint.first);
   socket_ = lightstep::Connect(endpoint.first);
   host_header_.set_host(endpoint.second);
+  zero_copy_ = io_uring_write_ == nullptr &&
+               CanUseZeroCopy(streamer_, connection_stream_) &&
+               EnableZeroCopy(socket_.file_descriptor());
   ScheduleReconnect();
 
   read_event_ =
@@ -122,14 +213,174 @@ void SatelliteConnection::Connect() noexcept try {
 // FreeSocket
 //--------------------------------------------------------------------------------------------------
 void SatelliteConnection::FreeSocket() {
+  CancelIoUringWrite();
   socket_ = Socket{InvalidSocket};
   read_event_ = Event{};
   write_event_ = Event{};
   reconnect_timer_.Remove();
   graceful_shutdown_timeout_.Remove();
+  write_timeout_.Remove();
   writable_ = false;
+  SetWriteBlocked(false);
+  if (has_endpoint_) {
+    streamer_.endpoint_manager().ReleaseEndpoint(endpoint_);
+    has_endpoint_ = false;
+  }
+  write_latency_.Reset();
+  num_unacknowledged_bytes_ = 0;
   connection_stream_.Reset();
   status_line_parser_.Reset();
+
+  // Any data still queued on the closed socket belongs to a stream that was
+  // either fully received or abandoned, so the spans can be freed.
+  zero_copy_ = false;
+  zero_copy_tracker_.Reset();
+  retained_spans_.Clear();
+  streamer_.span_stream().ReleaseRing();
+}
+
+//--------------------------------------------------------------------------------------------------
+// FlushConnectionStream
+//--------------------------------------------------------------------------------------------------
+bool SatelliteConnection::FlushConnectionStream() {
+  auto writer = [this](
+      std::initializer_list<FragmentInputStream*> fragment_streams) {
+    return Write(socket_.file_descriptor(), fragment_streams,
+                 streamer_.coalescer(),
+                 zero_copy_ ? &zero_copy_tracker_ : nullptr);
+  };
+  if (!zero_copy_) {
+    return connection_stream_.Flush(writer);
+  }
+
+  // The spans consumed by the flush may be referenced by zero-copy sends, so
+  // hold onto them until the sends complete. Besides an allotment of spans,
+  // a flush can finish the span partially written by the last flush.
+  ReleaseZeroCopySpans();
+  auto& span_stream = streamer_.span_stream();
+  retained_spans_.Reserve(span_stream.max_allotment_size() + 1);
+  span_stream.set_retained_spans(&retained_spans_);
+  bool result;
+  try {
+    result = connection_stream_.Flush(writer);
+  } catch (...) {
+    span_stream.set_retained_spans(nullptr);
+    throw;
+  }
+  span_stream.set_retained_spans(nullptr);
+  retained_spans_.Seal(zero_copy_tracker_.num_sends());
+  retained_spans_.Release(zero_copy_tracker_.num_completed_sends());
+  span_stream.ReleaseRing();
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// FlushIoUring
+//--------------------------------------------------------------------------------------------------
+bool SatelliteConnection::FlushIoUring() {
+  if (io_uring_write_->pending()) {
+    return false;
+  }
+
+  // The write consumes everything it's queued with, so the spans are taken
+  // from the span buffer right away; but they're kept alive, and only counted
+  // as sent, once the write completes.
+  auto& span_stream = streamer_.span_stream();
+  retained_spans_.Reserve(span_stream.max_allotment_size() + 1);
+  span_stream.set_retained_spans(&retained_spans_, true);
+  auto writer = [this](
+      std::initializer_list<FragmentInputStream*> fragment_streams) {
+    io_uring_write_->Queue(socket_.file_descriptor(), fragment_streams);
+    return true;
+  };
+  try {
+    connection_stream_.Flush(writer);
+  } catch (...) {
+    span_stream.set_retained_spans(nullptr);
+    throw;
+  }
+  span_stream.set_retained_spans(nullptr);
+  if (!io_uring_write_->pending()) {
+    writable_ = true;
+    return true;
+  }
+  writable_ = false;
+  SetWriteBlocked(true);
+  SampleUnacknowledgedBytes();
+  write_timeout_.Add(streamer_.recorder_options().satellite_write_timeout);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// CancelIoUringWrite
+//--------------------------------------------------------------------------------------------------
+void SatelliteConnection::CancelIoUringWrite() noexcept {
+  if (io_uring_write_ != nullptr) {
+    io_uring_write_->Cancel();
+  }
+
+  // The spans of a canceled or failed write may have been partially written,
+  // but the stream they were written to is abandoned with the socket.
+  if (retained_spans_.num_unsent_spans() == 0) {
+    return;
+  }
+  auto& metrics = streamer_.span_stream().metrics();
+  metrics.OnSpansDropped(retained_spans_.num_unsent_spans());
+  metrics.OnBytesDropped(retained_spans_.num_unsent_bytes());
+  retained_spans_.Clear();
+  streamer_.span_stream().ReleaseRing();
+}
+
+//--------------------------------------------------------------------------------------------------
+// ReleaseZeroCopySpans
+//--------------------------------------------------------------------------------------------------
+void SatelliteConnection::ReleaseZeroCopySpans() {
+  zero_copy_tracker_.ReadCompletions(socket_.file_descriptor());
+  retained_spans_.Release(zero_copy_tracker_.num_completed_sends());
+  streamer_.span_stream().ReleaseRing();
+}
+
+//--------------------------------------------------------------------------------------------------
+// SetWriteBlocked
+//--------------------------------------------------------------------------------------------------
+void SatelliteConnection::SetWriteBlocked(bool write_blocked) noexcept {
+  if (write_blocked == write_blocked_) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (write_blocked) {
+    write_blocked_timestamp_ = now;
+  } else {
+    auto duration = now - write_blocked_timestamp_;
+    write_blocked_duration_ += duration;
+    RecordWriteLatency(duration);
+  }
+  write_blocked_ = write_blocked;
+}
+
+//--------------------------------------------------------------------------------------------------
+// SampleUnacknowledgedBytes
+//--------------------------------------------------------------------------------------------------
+void SatelliteConnection::SampleUnacknowledgedBytes() noexcept {
+  // Connections are compared by cost every time the streamer picks one to
+  // flush, so query the socket once per flush here rather than on each
+  // comparison.
+  if (!streamer_.recorder_options().load_aware_satellite_selection) {
+    return;
+  }
+  num_unacknowledged_bytes_ =
+      GetNumUnacknowledgedBytes(socket_.file_descriptor());
+}
+
+//--------------------------------------------------------------------------------------------------
+// RecordWriteLatency
+//--------------------------------------------------------------------------------------------------
+void SatelliteConnection::RecordWriteLatency(
+    std::chrono::steady_clock::duration latency) noexcept {
+  write_latency_.Add(latency);
+  if (has_endpoint_) {
+    streamer_.endpoint_manager().RecordLatency(endpoint_, latency);
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -211,6 +462,11 @@ void SatelliteConnection::OnReadable(FileDescriptor file_descriptor,
                                      short /*what*/) noexcept try {
   streamer_.logger().Info("Satellite file_descriptor ", file_descriptor,
                           " is readable");
+  if (zero_copy_) {
+    // Completed zero-copy sends are reported on the socket's error queue,
+    // which also wakes up the read event.
+    ReleaseZeroCopySpans();
+  }
   std::array<char, 512> buffer;
   int rcode;
 
@@ -267,12 +523,50 @@ void SatelliteConnection::OnWritable(FileDescriptor file_descriptor,
     return OnSocketError();
   }
   assert((what & EV_WRITE) != 0);
+  if (zero_copy_) {
+    ReleaseZeroCopySpans();
+  }
   Flush();
 } catch (const std::exception& e) {
   streamer_.logger().Error("OnWritable failed: ", e.what());
   return HandleFailure();
 }
 
+//--------------------------------------------------------------------------------------------------
+// OnWriteComplete
+//--------------------------------------------------------------------------------------------------
+void SatelliteConnection::OnWriteComplete(ErrorCode error_code) noexcept try {
+  write_timeout_.Remove();
+  if (error_code != 0) {
+    streamer_.logger().Error("Satellite socket error: ",
+                             GetErrorCodeMessage(error_code));
+    return OnSocketError();
+  }
+  auto& span_stream = streamer_.span_stream();
+  span_stream.metrics().OnSpansSent(retained_spans_.num_unsent_spans());
+  retained_spans_.Clear();
+  span_stream.ReleaseRing();
+  SetWriteBlocked(false);
+  writable_ = true;
+  if (connection_stream_.shutting_down()) {
+    // Finish closing the stream.
+    Flush();
+    return;
+  }
+  streamer_.Flush();
+} catch (const std::exception& e) {
+  streamer_.logger().Error("OnWriteComplete failed: ", e.what());
+  return HandleFailure();
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnWriteTimeout
+//--------------------------------------------------------------------------------------------------
+void SatelliteConnection::OnWriteTimeout() noexcept {
+  streamer_.logger().Error("Satellite connection timed out");
+  OnSocketError();
+}
+
 //--------------------------------------------------------------------------------------------------
 // OnSocketError
 //--------------------------------------------------------------------------------------------------
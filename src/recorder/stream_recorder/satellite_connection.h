@@ -1,11 +1,19 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+
 #include "common/noncopyable.h"
 #include "common/platform/network.h"
 #include "network/event.h"
+#include "network/io_uring_writer.h"
+#include "network/ip_address.h"
 #include "network/socket.h"
+#include "network/vector_write.h"
 #include "recorder/stream_recorder/connection_stream.h"
 #include "recorder/stream_recorder/host_header.h"
+#include "recorder/stream_recorder/retained_spans.h"
+#include "recorder/stream_recorder/satellite_load.h"
 #include "recorder/stream_recorder/status_line_parser.h"
 
 namespace lightstep {
@@ -47,24 +55,65 @@ class SatelliteConnection : private Noncopyable {
    */
   bool is_active() const noexcept { return !was_shutdown_; }
 
+  /**
+   * @return the cost of writing more data to the connection, combining the
+   * moving average of its write latency with the number of bytes the satellite
+   * had yet to acknowledge as of the last flush.
+   */
+  double cost() const noexcept;
+
+  /**
+   * @param now the current time
+   * @return the amount of time the connection has spent waiting for its socket
+   * to become writable since the last call.
+   */
+  std::chrono::steady_clock::duration ConsumeWriteBlockedDuration(
+      std::chrono::steady_clock::time_point now) noexcept;
+
  private:
   SatelliteStreamer& streamer_;
   HostHeader host_header_;
   ConnectionStream connection_stream_;
   StatusLineParser status_line_parser_;
   Socket socket_{InvalidSocket};
+  IpAddress endpoint_;
+  bool has_endpoint_{false};
+  LatencyEwma write_latency_;
+  int num_unacknowledged_bytes_{0};
+  bool zero_copy_{false};
+  ZeroCopySendTracker zero_copy_tracker_;
+  RetainedSpans retained_spans_;
+  std::unique_ptr<IoUringWrite> io_uring_write_;
   bool writable_{false};
   bool is_shutting_down_{false};
   bool was_shutdown_{false};
+  bool write_blocked_{false};
+  std::chrono::steady_clock::time_point write_blocked_timestamp_;
+  std::chrono::steady_clock::duration write_blocked_duration_{0};
   Event read_event_;
   Event write_event_;
   Event reconnect_timer_;
   Event graceful_shutdown_timeout_;
+  Event write_timeout_;
 
   void Connect() noexcept;
 
   void FreeSocket();
 
+  bool FlushConnectionStream();
+
+  bool FlushIoUring();
+
+  void CancelIoUringWrite() noexcept;
+
+  void ReleaseZeroCopySpans();
+
+  void SetWriteBlocked(bool write_blocked) noexcept;
+
+  void SampleUnacknowledgedBytes() noexcept;
+
+  void RecordWriteLatency(std::chrono::steady_clock::duration latency) noexcept;
+
   void HandleFailure() noexcept;
 
   void ScheduleReconnect();
@@ -79,6 +128,10 @@ class SatelliteConnection : private Noncopyable {
 
   void OnWritable(FileDescriptor file_descriptor, short what) noexcept;
 
+  void OnWriteComplete(ErrorCode error_code) noexcept;
+
+  void OnWriteTimeout() noexcept;
+
   void OnSocketError() noexcept;
 };
 }  // namespace lightstep
@@ -5,6 +5,12 @@
 #include "recorder/stream_recorder/utility.h"
 
 namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// UnixSocketHost
+//--------------------------------------------------------------------------------------------------
+// The value of the Host header sent to satellites on unix domain sockets.
+static const char* const UnixSocketHost = "localhost";
+
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
@@ -13,7 +19,9 @@ SatelliteEndpointManager::SatelliteEndpointManager(
     const LightStepTracerOptions& tracer_options,
     const StreamRecorderOptions& recorder_options,
     std::function<void()> on_ready_callback)
-    : on_ready_callback_{std::move(on_ready_callback)} {
+    : on_ready_callback_{std::move(on_ready_callback)},
+      load_aware_{recorder_options.load_aware_satellite_selection},
+      loads_{recorder_options.satellite_latency_weight} {
   if (tracer_options.satellite_endpoints.empty()) {
     throw std::runtime_error{"no satellite endpoints provided"};
   }
@@ -25,6 +33,14 @@ SatelliteEndpointManager::SatelliteEndpointManager(
   auto on_resolution_ready = [this] { this->OnResolutionReady(); };
   for (auto& name : hosts) {
     SatelliteHostManager host_manager;
+    auto unix_socket_path = GetUnixSocketPath(name);
+    if (unix_socket_path != nullptr) {
+      host_manager.unix_socket_address.reset(
+          new IpAddress{MakeUnixSocketAddress(unix_socket_path)});
+      has_unix_sockets_ = true;
+      host_managers_.emplace_back(std::move(host_manager));
+      continue;
+    }
     host_manager.ipv4_resolutions.reset(
         new SatelliteDnsResolutionManager{logger, event_base, recorder_options,
                                           AF_INET, name, on_resolution_ready});
@@ -40,9 +56,17 @@ SatelliteEndpointManager::SatelliteEndpointManager(
 //--------------------------------------------------------------------------------------------------
 void SatelliteEndpointManager::Start() noexcept {
   for (auto& host_manager : host_managers_) {
+    if (host_manager.unix_socket_address != nullptr) {
+      continue;
+    }
     host_manager.ipv4_resolutions->Start();
     host_manager.ipv6_resolutions->Start();
   }
+
+  // Unix domain sockets can be connected to right away.
+  if (has_unix_sockets_) {
+    OnResolutionReady();
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -50,6 +74,24 @@ void SatelliteEndpointManager::Start() noexcept {
 //--------------------------------------------------------------------------------------------------
 std::pair<IpAddress, const char*>
 SatelliteEndpointManager::RequestEndpoint() noexcept {
+  auto result = NextEndpoint();
+  if (load_aware_) {
+    // Comparing two candidates rather than searching every endpoint keeps the
+    // round robin spread while still avoiding slow satellites.
+    auto candidate = NextEndpoint();
+    if (loads_.cost(candidate.first) < loads_.cost(result.first)) {
+      result = candidate;
+    }
+  }
+  loads_.OnConnect(result.first);
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// NextEndpoint
+//--------------------------------------------------------------------------------------------------
+std::pair<IpAddress, const char*>
+SatelliteEndpointManager::NextEndpoint() noexcept {
   auto endpoint_index_start = endpoint_index_;
   (void)endpoint_index_start;
   while (true) {
@@ -62,6 +104,10 @@ SatelliteEndpointManager::RequestEndpoint() noexcept {
     std::tie(host_index, port) =
         endpoints_[endpoint_index_++ % endpoints_.size()];
     auto& host_manager = host_managers_[host_index];
+    if (host_manager.unix_socket_address != nullptr) {
+      return std::make_pair(*host_manager.unix_socket_address,
+                            UnixSocketHost);
+    }
 
     auto& ip_addresses = !host_manager.ipv4_resolutions->ip_addresses().empty()
                              ? host_manager.ipv4_resolutions->ip_addresses()
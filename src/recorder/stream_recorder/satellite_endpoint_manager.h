@@ -8,6 +8,7 @@
 #include "lightstep/tracer.h"
 #include "network/dns_resolver.h"
 #include "recorder/stream_recorder/satellite_dns_resolution_manager.h"
+#include "recorder/stream_recorder/satellite_load.h"
 
 namespace lightstep {
 /**
@@ -18,6 +19,10 @@ class SatelliteEndpointManager : private Noncopyable {
     std::unique_ptr<SatelliteDnsResolutionManager> ipv4_resolutions;
     std::unique_ptr<SatelliteDnsResolutionManager> ipv6_resolutions;
     uint32_t address_index{0};
+
+    // Set if the host is a unix domain socket, in which case there's nothing
+    // to resolve.
+    std::unique_ptr<IpAddress> unix_socket_address;
   };
 
  public:
@@ -32,17 +37,43 @@ class SatelliteEndpointManager : private Noncopyable {
   void Start() noexcept;
 
   /**
-   * Assigns satellite endpoints using round robin.
+   * Assigns satellite endpoints using round robin or, if load aware selection
+   * is enabled, the cheaper of the next two endpoints in round robin order.
    * @return a satellite endpoint.
+   *
+   * Note: Every requested endpoint must be released with ReleaseEndpoint.
    */
   std::pair<IpAddress, const char*> RequestEndpoint() noexcept;
 
+  /**
+   * Releases an endpoint assigned by RequestEndpoint.
+   * @param endpoint the endpoint to release
+   */
+  void ReleaseEndpoint(const IpAddress& endpoint) noexcept {
+    loads_.OnDisconnect(endpoint);
+  }
+
+  /**
+   * Records how long an endpoint took to accept a write.
+   * @param endpoint the endpoint written to
+   * @param latency the time it took
+   */
+  void RecordLatency(const IpAddress& endpoint,
+                     std::chrono::steady_clock::duration latency) noexcept {
+    loads_.RecordLatency(endpoint, latency);
+  }
+
  private:
   std::function<void()> on_ready_callback_;
   std::vector<SatelliteHostManager> host_managers_;
   std::vector<std::pair<int, uint16_t>> endpoints_;
   uint32_t endpoint_index_{0};
   int num_resolutions_ready_{0};
+  bool has_unix_sockets_{false};
+  bool load_aware_;
+  SatelliteEndpointLoads loads_;
+
+  std::pair<IpAddress, const char*> NextEndpoint() noexcept;
 
   void OnResolutionReady() noexcept;
 };
@@ -0,0 +1,109 @@
+#include "recorder/stream_recorder/satellite_load.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// MaxUnusedEndpoints
+//--------------------------------------------------------------------------------------------------
+// The latencies of endpoints without connections are remembered so that slow
+// satellites stay disfavored, but only up to a point so that the entries of
+// endpoints removed from DNS don't accumulate.
+const size_t MaxUnusedEndpoints = 64;
+
+//--------------------------------------------------------------------------------------------------
+// Add
+//--------------------------------------------------------------------------------------------------
+void LatencyEwma::Add(std::chrono::steady_clock::duration latency) noexcept {
+  auto sample = std::chrono::duration<double, std::micro>{latency}.count();
+  if (!has_value_) {
+    value_ = sample;
+    has_value_ = true;
+    return;
+  }
+  value_ += weight_ * (sample - value_);
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnConnect
+//--------------------------------------------------------------------------------------------------
+void SatelliteEndpointLoads::OnConnect(const IpAddress& endpoint) noexcept {
+  auto entry = Find(endpoint);
+  if (entry != nullptr) {
+    ++entry->num_connections;
+    return;
+  }
+  try {
+    entries_.push_back(Entry{endpoint, 1, LatencyEwma{latency_weight_}});
+  } catch (const std::exception& /*e*/) {
+    // Without an entry the endpoint is treated as unloaded.
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnDisconnect
+//--------------------------------------------------------------------------------------------------
+void SatelliteEndpointLoads::OnDisconnect(const IpAddress& endpoint) noexcept {
+  auto entry = Find(endpoint);
+  if (entry == nullptr) {
+    return;
+  }
+  --entry->num_connections;
+  if (entry->num_connections > 0) {
+    return;
+  }
+  auto num_unused = std::count_if(
+      entries_.begin(), entries_.end(),
+      [](const Entry& entry) { return entry.num_connections == 0; });
+  if (static_cast<size_t>(num_unused) <= MaxUnusedEndpoints) {
+    return;
+  }
+  *entry = std::move(entries_.back());
+  entries_.pop_back();
+}
+
+//--------------------------------------------------------------------------------------------------
+// RecordLatency
+//--------------------------------------------------------------------------------------------------
+void SatelliteEndpointLoads::RecordLatency(
+    const IpAddress& endpoint,
+    std::chrono::steady_clock::duration latency) noexcept {
+  auto entry = Find(endpoint);
+  if (entry != nullptr) {
+    entry->latency.Add(latency);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// cost
+//--------------------------------------------------------------------------------------------------
+double SatelliteEndpointLoads::cost(const IpAddress& endpoint) const noexcept {
+  auto entry = Find(endpoint);
+  if (entry == nullptr) {
+    return ComputeSatelliteCost(0, 0);
+  }
+  return ComputeSatelliteCost(entry->latency.value(),
+                              static_cast<double>(entry->num_connections));
+}
+
+//--------------------------------------------------------------------------------------------------
+// Find
+//--------------------------------------------------------------------------------------------------
+SatelliteEndpointLoads::Entry* SatelliteEndpointLoads::Find(
+    const IpAddress& endpoint) noexcept {
+  return const_cast<Entry*>(
+      static_cast<const SatelliteEndpointLoads*>(this)->Find(endpoint));
+}
+
+const SatelliteEndpointLoads::Entry* SatelliteEndpointLoads::Find(
+    const IpAddress& endpoint) const noexcept {
+  auto iter = std::find_if(
+      entries_.begin(), entries_.end(),
+      [&](const Entry& entry) { return entry.endpoint == endpoint; });
+  if (iter == entries_.end()) {
+    return nullptr;
+  }
+  return &*iter;
+}
+}  // namespace lightstep
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "network/ip_address.h"
+
+namespace lightstep {
+/**
+ * Maintains an exponentially weighted moving average of the time it takes a
+ * satellite to accept writes.
+ */
+class LatencyEwma {
+ public:
+  /**
+   * @param weight the weight given to each new sample, between 0 and 1
+   */
+  explicit LatencyEwma(double weight) noexcept : weight_{weight} {}
+
+  /**
+   * Adds a latency sample to the average.
+   * @param latency the sample to add
+   */
+  void Add(std::chrono::steady_clock::duration latency) noexcept;
+
+  /**
+   * Forgets all samples.
+   */
+  void Reset() noexcept { has_value_ = false; }
+
+  /**
+   * @return the average latency in microseconds or 0 if there are no samples.
+   */
+  double value() const noexcept { return has_value_ ? value_ : 0; }
+
+ private:
+  double weight_;
+  double value_{0};
+  bool has_value_{false};
+};
+
+/**
+ * Combines the responsiveness of a satellite with how much load it's already
+ * carrying into a single cost so that the cheapest can be sent more data.
+ * @param latency the average write latency in microseconds
+ * @param load the outstanding work, e.g. unacknowledged bytes or connections
+ * @return the cost of sending more data to the satellite
+ */
+inline double ComputeSatelliteCost(double latency, double load) noexcept {
+  return (latency + 1) * (load + 1);
+}
+
+/**
+ * Tracks the connections to and write latencies of each satellite endpoint so
+ * that new connections can be steered away from slow or overloaded
+ * satellites.
+ */
+class SatelliteEndpointLoads {
+ public:
+  /**
+   * @param latency_weight the weight given to new latency samples
+   */
+  explicit SatelliteEndpointLoads(double latency_weight) noexcept
+      : latency_weight_{latency_weight} {}
+
+  /**
+   * Records that a connection was assigned an endpoint.
+   * @param endpoint the endpoint connected to
+   */
+  void OnConnect(const IpAddress& endpoint) noexcept;
+
+  /**
+   * Records that a connection to an endpoint was closed.
+   * @param endpoint the endpoint disconnected from
+   */
+  void OnDisconnect(const IpAddress& endpoint) noexcept;
+
+  /**
+   * Records how long an endpoint took to accept a write.
+   * @param endpoint the endpoint written to
+   * @param latency the time it took
+   */
+  void RecordLatency(const IpAddress& endpoint,
+                     std::chrono::steady_clock::duration latency) noexcept;
+
+  /**
+   * @param endpoint the endpoint to look up
+   * @return the cost of assigning another connection to the endpoint.
+   */
+  double cost(const IpAddress& endpoint) const noexcept;
+
+  /**
+   * @return the number of endpoints tracked.
+   */
+  size_t size() const noexcept { return entries_.size(); }
+
+ private:
+  struct Entry {
+    IpAddress endpoint;
+    int num_connections;
+    LatencyEwma latency;
+  };
+
+  double latency_weight_;
+  std::vector<Entry> entries_;
+
+  Entry* Find(const IpAddress& endpoint) noexcept;
+
+  const Entry* Find(const IpAddress& endpoint) const noexcept;
+};
+}  // namespace lightstep
@@ -7,6 +7,39 @@
 #include "recorder/serialization/report_request_header.h"
 
 namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// MakeCoalescer
+//--------------------------------------------------------------------------------------------------
+static std::unique_ptr<FragmentCoalescer> MakeCoalescer(
+    const StreamRecorderOptions& recorder_options) {
+  if (recorder_options.min_average_fragment_size <= 0 ||
+      recorder_options.coalescing_buffer_size == 0) {
+    return nullptr;
+  }
+  return std::unique_ptr<FragmentCoalescer>{
+      new FragmentCoalescer{recorder_options.min_average_fragment_size,
+                            recorder_options.max_coalesced_fragment_size,
+                            recorder_options.coalescing_buffer_size}};
+}
+
+//--------------------------------------------------------------------------------------------------
+// MakeIoUringWriter
+//--------------------------------------------------------------------------------------------------
+static std::unique_ptr<IoUringWriter> MakeIoUringWriter(
+    Logger& logger, const EventBase& event_base,
+    const StreamRecorderOptions& recorder_options) {
+  if (!recorder_options.use_io_uring) {
+    return nullptr;
+  }
+  try {
+    return std::unique_ptr<IoUringWriter>{new IoUringWriter{event_base}};
+  } catch (const std::exception& e) {
+    logger.Warn("Falling back to writev for satellite connections: ",
+                e.what());
+    return nullptr;
+  }
+}
+
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
@@ -14,7 +47,10 @@ SatelliteStreamer::SatelliteStreamer(
     Logger& logger, EventBase& event_base,
     const LightStepTracerOptions& tracer_options,
     const StreamRecorderOptions& recorder_options, MetricsTracker& metrics,
-    CircularBuffer<ChainedStream>& span_buffer)
+    ShardedCircularBuffer<ChainedStream>& span_buffer,
+    ByteBudget& span_buffer_budget, ByteRing* span_ring, int num_connections,
+    int min_connections, int max_connections, size_t first_shard_index,
+    size_t shard_stride)
     : logger_{logger},
       event_base_{event_base},
       tracer_options_{tracer_options},
@@ -23,13 +59,28 @@ SatelliteStreamer::SatelliteStreamer(
           WriteReportRequestHeader(tracer_options, GenerateId())},
       endpoint_manager_{logger, event_base, tracer_options, recorder_options,
                         [this] { this->OnEndpointManagerReady(); }},
-      span_buffer_{span_buffer},
-      span_stream_{span_buffer, metrics},
-      connection_traverser_{recorder_options_.num_satellite_connections} {
-  connections_.reserve(recorder_options.num_satellite_connections);
-  for (int i = 0; i < recorder_options.num_satellite_connections; ++i) {
+      span_stream_{span_buffer, span_buffer_budget, metrics, span_ring,
+                   first_shard_index, shard_stride},
+      coalescer_{MakeCoalescer(recorder_options)},
+      io_uring_writer_{
+          MakeIoUringWriter(logger, event_base, recorder_options)},
+      compression_budget_{recorder_options.max_compression_time_fraction,
+                          recorder_options.compression_budget_period},
+      connection_traverser_{num_connections},
+      connection_scaler_{min_connections, max_connections,
+                         recorder_options.max_write_blocked_fraction,
+                         recorder_options.min_satellite_connection_throughput} {
+  connections_.reserve(num_connections);
+  for (int i = 0; i < num_connections; ++i) {
     connections_.emplace_back(new SatelliteConnection{*this});
   }
+  if (connection_scaler_.enabled()) {
+    scaling_timer_ = TimerEvent{
+        event_base, recorder_options.connection_scaling_period,
+        MakeTimerCallback<SatelliteStreamer, &SatelliteStreamer::Rescale>(),
+        static_cast<void*>(this)};
+    last_scaling_timestamp_ = std::chrono::steady_clock::now();
+  }
   endpoint_manager_.Start();
 }
 
@@ -42,6 +93,11 @@ bool SatelliteStreamer::is_active() const noexcept {
       return true;
     }
   }
+  for (auto& connection : retired_connections_) {
+    if (connection->is_active()) {
+      return true;
+    }
+  }
   return false;
 }
 
@@ -49,22 +105,66 @@ bool SatelliteStreamer::is_active() const noexcept {
 // Flush
 //--------------------------------------------------------------------------------------------------
 void SatelliteStreamer::Flush() noexcept {
-  if (span_buffer_.empty()) {
-    return;
+  // Each flush of a connection only writes out a single shard of the span
+  // buffer, so keep going until either the buffer's empty or none of the
+  // connections can take more data.
+  for (size_t i = 0; i < span_stream_.num_shards(); ++i) {
+    if (span_stream_.buffer_empty()) {
+      return;
+    }
+    bool flushed_everything = false;
+    if (recorder_options_.load_aware_satellite_selection) {
+      // A connection that doesn't take everything stops being ready, so this
+      // moves on to the next cheapest until none are left.
+      SatelliteConnection* connection;
+      while (!flushed_everything &&
+             (connection = FindCheapestReadyConnection()) != nullptr) {
+        flushed_everything = connection->Flush();
+      }
+    } else {
+      connection_traverser_.ForEachIndex([&](int index) {
+        auto& connection = connections_[index];
+        if (!connection->ready()) {
+          return true;
+        }
+        flushed_everything = connection->Flush();
+        return !flushed_everything;
+      });
+    }
+    if (!flushed_everything) {
+      backlogged_ = true;
+      return;
+    }
   }
-  connection_traverser_.ForEachIndex([this](int index) {
+}
+
+//--------------------------------------------------------------------------------------------------
+// FindCheapestReadyConnection
+//--------------------------------------------------------------------------------------------------
+SatelliteConnection* SatelliteStreamer::FindCheapestReadyConnection() noexcept {
+  // Visit the connections in random order so that ties are broken randomly.
+  SatelliteConnection* result = nullptr;
+  double result_cost = 0;
+  connection_traverser_.ForEachIndex([&](int index) {
     auto& connection = connections_[index];
     if (!connection->ready()) {
       return true;
     }
-    return !connection->Flush();
+    auto cost = connection->cost();
+    if (result == nullptr || cost < result_cost) {
+      result = connection.get();
+      result_cost = cost;
+    }
+    return true;
   });
+  return result;
 }
 
 //--------------------------------------------------------------------------------------------------
 // InitiateShutdown
 //--------------------------------------------------------------------------------------------------
 void SatelliteStreamer::InitiateShutdown() noexcept {
+  shutting_down_ = true;
   for (auto& connection : connections_) {
     connection->InitiateShutdown();
   }
@@ -74,8 +174,101 @@ void SatelliteStreamer::InitiateShutdown() noexcept {
 // OnEndpointManagerReady
 //--------------------------------------------------------------------------------------------------
 void SatelliteStreamer::OnEndpointManagerReady() noexcept {
+  started_ = true;
   for (auto& connection : connections_) {
     connection->Start();
   }
 }
+
+//--------------------------------------------------------------------------------------------------
+// Rescale
+//--------------------------------------------------------------------------------------------------
+void SatelliteStreamer::Rescale() noexcept try {
+  FreeRetiredConnections();
+  auto load = MeasureLoad();
+  if (!started_ || shutting_down_) {
+    return;
+  }
+  auto num_connections = connection_scaler_.ComputeNumConnections(load);
+  if (num_connections == load.num_connections) {
+    return;
+  }
+  while (static_cast<int>(connections_.size()) < num_connections) {
+    connections_.emplace_back(new SatelliteConnection{*this});
+    connections_.back()->Start();
+  }
+  while (static_cast<int>(connections_.size()) > num_connections) {
+    if (!RetireConnection()) {
+      break;
+    }
+  }
+  connection_traverser_ =
+      RandomTraverser{static_cast<int>(connections_.size())};
+  logger_.Info("Scaled satellite connections from ", load.num_connections,
+               " to ", connections_.size());
+} catch (const std::exception& e) {
+  logger_.Error("Failed to scale satellite connections: ", e.what());
+}
+
+//--------------------------------------------------------------------------------------------------
+// MeasureLoad
+//--------------------------------------------------------------------------------------------------
+ConnectionLoad SatelliteStreamer::MeasureLoad() noexcept {
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = now - last_scaling_timestamp_;
+  last_scaling_timestamp_ = now;
+
+  ConnectionLoad result;
+  result.num_connections = static_cast<int>(connections_.size());
+  std::chrono::duration<double> write_blocked_duration{0};
+  for (auto& connection : connections_) {
+    write_blocked_duration += connection->ConsumeWriteBlockedDuration(now);
+  }
+  auto num_bytes_consumed = span_stream_.num_bytes_consumed();
+  if (elapsed.count() > 0 && result.num_connections > 0) {
+    result.write_blocked_fraction =
+        write_blocked_duration / (elapsed * result.num_connections);
+    result.bytes_per_second =
+        static_cast<double>(num_bytes_consumed - last_num_bytes_consumed_) /
+        elapsed.count();
+  }
+  last_num_bytes_consumed_ = num_bytes_consumed;
+  result.backlogged = backlogged_;
+  backlogged_ = false;
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// RetireConnection
+//--------------------------------------------------------------------------------------------------
+bool SatelliteStreamer::RetireConnection() noexcept {
+  // Only retire connections that are established so that no reconnect is left
+  // pending when they're freed.
+  auto iter = std::find_if(
+      connections_.rbegin(), connections_.rend(),
+      [](const std::unique_ptr<SatelliteConnection>& connection) {
+        return connection->ready();
+      });
+  if (iter == connections_.rend()) {
+    return false;
+  }
+  std::swap(*iter, connections_.back());
+  retired_connections_.emplace_back(std::move(connections_.back()));
+  connections_.pop_back();
+  retired_connections_.back()->InitiateShutdown();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// FreeRetiredConnections
+//--------------------------------------------------------------------------------------------------
+void SatelliteStreamer::FreeRetiredConnections() noexcept {
+  retired_connections_.erase(
+      std::remove_if(
+          retired_connections_.begin(), retired_connections_.end(),
+          [](const std::unique_ptr<SatelliteConnection>& connection) {
+            return !connection->is_active();
+          }),
+      retired_connections_.end());
+}
 }  // namespace lightstep
@@ -1,14 +1,20 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <vector>
 
 #include "common/noncopyable.h"
 #include "common/random_traverser.h"
+#include "network/io_uring_writer.h"
+#include "network/timer_event.h"
+#include "network/vector_write.h"
 #include "recorder/metrics_tracker.h"
+#include "recorder/stream_recorder/connection_scaler.h"
 #include "recorder/stream_recorder/satellite_connection.h"
 #include "recorder/stream_recorder/satellite_endpoint_manager.h"
 #include "recorder/stream_recorder/span_stream.h"
+#include "recorder/stream_recorder/stream_compressor.h"
 
 namespace lightstep {
 /**
@@ -16,11 +22,25 @@ namespace lightstep {
  */
 class SatelliteStreamer : private Noncopyable {
  public:
+  /**
+   * @param num_connections the number of satellite connections to make
+   * @param min_connections the fewest satellite connections to scale down to
+   * @param max_connections the most satellite connections to scale up to
+   * @param first_shard_index the index of the first span buffer shard to
+   * stream from
+   * @param shard_stride the number of shards between the shards to stream from
+   *
+   * See SpanStream for the remaining parameters.
+   */
   SatelliteStreamer(Logger& logger, EventBase& event_base,
                     const LightStepTracerOptions& tracer_options,
                     const StreamRecorderOptions& recorder_options,
                     MetricsTracker& metrics,
-                    CircularBuffer<ChainedStream>& span_buffer);
+                    ShardedCircularBuffer<ChainedStream>& span_buffer,
+                    ByteBudget& span_buffer_budget, ByteRing* span_ring,
+                    int num_connections, int min_connections,
+                    int max_connections, size_t first_shard_index,
+                    size_t shard_stride);
 
   /**
    * @return the associated Logger.
@@ -46,6 +66,25 @@ class SatelliteStreamer : private Noncopyable {
     return recorder_options_;
   }
 
+  /**
+   * @return the coalescer for writes to satellites or nullptr if coalescing is
+   * disabled.
+   */
+  FragmentCoalescer* coalescer() noexcept { return coalescer_.get(); }
+
+  /**
+   * @return the writer to send data to satellites with io_uring or nullptr if
+   * writev is used.
+   */
+  IoUringWriter* io_uring_writer() noexcept { return io_uring_writer_.get(); }
+
+  /**
+   * @return the budget for time spent compressing data sent to satellites.
+   */
+  CompressionBudget& compression_budget() noexcept {
+    return compression_budget_;
+  }
+
   /**
    * @return the SpanStream formed from the StreamRecorder's message buffer.
    */
@@ -68,6 +107,13 @@ class SatelliteStreamer : private Noncopyable {
     return endpoint_manager_;
   }
 
+  /**
+   * @return the number of satellite connections being streamed to.
+   */
+  int num_connections() const noexcept {
+    return static_cast<int>(connections_.size());
+  }
+
   /**
    * @return true any satellite connections have open sockets.
    */
@@ -90,11 +136,34 @@ class SatelliteStreamer : private Noncopyable {
   const StreamRecorderOptions& recorder_options_;
   std::string header_common_fragment_;
   SatelliteEndpointManager endpoint_manager_;
-  CircularBuffer<ChainedStream>& span_buffer_;
   SpanStream span_stream_;
+  std::unique_ptr<FragmentCoalescer> coalescer_;
+  std::unique_ptr<IoUringWriter> io_uring_writer_;
+  CompressionBudget compression_budget_;
   std::vector<std::unique_ptr<SatelliteConnection>> connections_;
   RandomTraverser connection_traverser_;
+  bool started_{false};
+  bool shutting_down_{false};
+
+  // Connections that have been removed from the pool and are being shut down.
+  std::vector<std::unique_ptr<SatelliteConnection>> retired_connections_;
+
+  ConnectionScaler connection_scaler_;
+  TimerEvent scaling_timer_;
+  std::chrono::steady_clock::time_point last_scaling_timestamp_;
+  uint64_t last_num_bytes_consumed_{0};
+  bool backlogged_{false};
 
   void OnEndpointManagerReady() noexcept;
+
+  SatelliteConnection* FindCheapestReadyConnection() noexcept;
+
+  void Rescale() noexcept;
+
+  ConnectionLoad MeasureLoad() noexcept;
+
+  bool RetireConnection() noexcept;
+
+  void FreeRetiredConnections() noexcept;
 };
 }  // namespace lightstep
@@ -1,17 +1,96 @@
 #include "recorder/stream_recorder/span_stream.h"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <exception>
+
+#include "common/chunked_http_framing.h"
+
+#include <google/protobuf/io/coded_stream.h>
+
 namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// FindSpanEnd
+//--------------------------------------------------------------------------------------------------
+// Spans are written to the contiguous span buffer as http/1.1 chunks with a
+// fixed-width header, so the end of a span can be found from its chunk size.
+static uint64_t FindSpanEnd(const ByteRing& span_ring,
+                            uint64_t position) noexcept {
+  std::array<char, Num32BitHexDigits> chunk_size_hex;
+  for (auto& c : chunk_size_hex) {
+    c = span_ring.at(position++);
+  }
+  auto chunk_size = HexToUint64(
+      opentracing::string_view{chunk_size_hex.data(), chunk_size_hex.size()});
+  assert(chunk_size);
+  return position + (ChunkedHttpMaxHeaderSize - Num32BitHexDigits) +
+         *chunk_size + ChunkedHttpFooter.size();
+}
+
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
-SpanStream::SpanStream(CircularBuffer<ChainedStream>& span_buffer,
-                       MetricsTracker& metrics) noexcept
-    : span_buffer_{span_buffer}, metrics_{metrics} {}
+SpanStream::SpanStream(ShardedCircularBuffer<ChainedStream>& span_buffer,
+                       ByteBudget& span_buffer_budget, MetricsTracker& metrics,
+                       ByteRing* span_ring, size_t first_shard_index,
+                       size_t shard_stride) noexcept
+    : span_buffer_{span_buffer},
+      span_buffer_budget_{span_buffer_budget},
+      metrics_{metrics},
+      first_shard_index_{first_shard_index},
+      shard_stride_{shard_stride},
+      num_shards_{(span_buffer.num_shards() - first_shard_index +
+                   shard_stride - 1) /
+                  shard_stride},
+      allotment_shard_{&span_buffer.shard(first_shard_index)},
+      span_ring_{span_ring} {
+  assert(first_shard_index < span_buffer.num_shards() && shard_stride > 0);
+  for (size_t i = 0; i < num_shards_; ++i) {
+    max_allotment_size_ = std::max(max_allotment_size_, shard(i).max_size());
+  }
+}
 
 //--------------------------------------------------------------------------------------------------
 // Allot
 //--------------------------------------------------------------------------------------------------
-void SpanStream::Allot() noexcept { allotment_ = span_buffer_.Peek(); }
+void SpanStream::Allot() noexcept {
+  if (span_ring_ != nullptr) {
+    // Spans that were sent but are still retained for zero-copy writes remain
+    // in the ring until they're released.
+    ring_allotment_first_ =
+        std::max(ring_sent_position_, span_ring_->consumer_position());
+    ring_allotment_last_ = span_ring_->committed_position();
+    return;
+  }
+
+  // Visit the shards round-robin so that none of them are starved.
+  for (size_t i = 0; i < num_shards_; ++i) {
+    allotment_shard_ = &shard(next_shard_index_);
+    next_shard_index_ = (next_shard_index_ + 1) % num_shards_;
+    allotment_ = allotment_shard_->Peek();
+    if (!allotment_.empty()) {
+      return;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// buffer_empty
+//--------------------------------------------------------------------------------------------------
+bool SpanStream::buffer_empty() const noexcept {
+  if (span_ring_ != nullptr) {
+    return std::max(ring_sent_position_, span_ring_->consumer_position()) ==
+           span_ring_->committed_position();
+  }
+  for (size_t i = first_shard_index_; i < span_buffer_.num_shards();
+       i += shard_stride_) {
+    if (!span_buffer_.shard(i).empty()) {
+      return false;
+    }
+  }
+  return true;
+}
 
 //--------------------------------------------------------------------------------------------------
 // ConsumeRemnant
@@ -20,11 +99,66 @@ std::unique_ptr<ChainedStream> SpanStream::ConsumeRemnant() noexcept {
   return std::unique_ptr<ChainedStream>{remnant_.release()};
 }
 
+//--------------------------------------------------------------------------------------------------
+// ReleaseSpan
+//--------------------------------------------------------------------------------------------------
+void SpanStream::ReleaseSpan(std::unique_ptr<ChainedStream>&& span) noexcept {
+  if (retained_spans_ != nullptr && span != nullptr) {
+    return retained_spans_->Retain(std::move(span));
+  }
+  span.reset();
+}
+
+//--------------------------------------------------------------------------------------------------
+// AddRingRetainer
+//--------------------------------------------------------------------------------------------------
+void SpanStream::AddRingRetainer(const RetainedSpans& retained_spans) {
+  ring_retainers_.push_back(&retained_spans);
+}
+
+//--------------------------------------------------------------------------------------------------
+// RemoveRingRetainer
+//--------------------------------------------------------------------------------------------------
+void SpanStream::RemoveRingRetainer(
+    const RetainedSpans& retained_spans) noexcept {
+  ring_retainers_.erase(std::remove(ring_retainers_.begin(),
+                                    ring_retainers_.end(), &retained_spans),
+                        ring_retainers_.end());
+}
+
+//--------------------------------------------------------------------------------------------------
+// ReleaseRing
+//--------------------------------------------------------------------------------------------------
+void SpanStream::ReleaseRing() noexcept {
+  if (span_ring_ == nullptr) {
+    return;
+  }
+  auto position = ring_sent_position_;
+  for (auto retained_spans : ring_retainers_) {
+    uint64_t oldest_position;
+    if (retained_spans->oldest_ring_position(oldest_position)) {
+      position = std::min(position, oldest_position);
+    }
+  }
+  auto consumer_position = span_ring_->consumer_position();
+  if (position > consumer_position) {
+    span_ring_->Consume(static_cast<size_t>(position - consumer_position));
+  }
+}
+
 //--------------------------------------------------------------------------------------------------
 // num_fragments
 //--------------------------------------------------------------------------------------------------
 int SpanStream::num_fragments() const noexcept {
   int result = 0;
+  if (span_ring_ != nullptr) {
+    span_ring_->ForEachFragment(ring_allotment_first_, ring_allotment_last_,
+                                [&result](void* /*data*/, int /*size*/) {
+                                  ++result;
+                                  return true;
+                                });
+    return result;
+  }
   allotment_.ForEach([&result](
       const AtomicUniquePtr<ChainedStream>& span) noexcept {
     result += span->num_fragments();
@@ -37,6 +171,10 @@ int SpanStream::num_fragments() const noexcept {
 // ForEachFragment
 //--------------------------------------------------------------------------------------------------
 bool SpanStream::ForEachFragment(Callback callback) const noexcept {
+  if (span_ring_ != nullptr) {
+    return span_ring_->ForEachFragment(ring_allotment_first_,
+                                       ring_allotment_last_, callback);
+  }
   return allotment_.ForEach(
       [callback](const AtomicUniquePtr<ChainedStream>& span) {
         return span->ForEachFragment(callback);
@@ -47,17 +185,60 @@ bool SpanStream::ForEachFragment(Callback callback) const noexcept {
 // Clear
 //--------------------------------------------------------------------------------------------------
 void SpanStream::Clear() noexcept {
-  remnant_.reset();
-  metrics_.OnSpansSent(allotment_.size());
-  span_buffer_.Consume(allotment_.size());
+  auto num_bytes_consumed = num_bytes_consumed_;
+  auto num_spans = ConsumeAllotment();
+  if (defer_sent_spans_) {
+    return retained_spans_->AddUnsentSpans(
+        num_spans,
+        static_cast<size_t>(num_bytes_consumed_ - num_bytes_consumed));
+  }
+  metrics_.OnSpansSent(num_spans);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ConsumeAllotment
+//--------------------------------------------------------------------------------------------------
+int SpanStream::ConsumeAllotment() noexcept {
+  ReleaseSpan(std::move(remnant_));
+  if (span_ring_ != nullptr) {
+    return RingConsumeAllotment();
+  }
+  auto num_spans = static_cast<int>(allotment_.size());
+  size_t num_bytes = 0;
+  allotment_.ForEach([&num_bytes](
+      const AtomicUniquePtr<ChainedStream>& span) noexcept {
+    num_bytes += static_cast<size_t>(span->ByteCount());
+    return true;
+  });
+  num_bytes_consumed_ += num_bytes;
+  span_buffer_budget_.Release(num_bytes);
+  if (retained_spans_ == nullptr) {
+    allotment_shard_->Consume(allotment_.size());
+  } else {
+    allotment_shard_->Consume(
+        allotment_.size(),
+        [this](CircularBufferRange<AtomicUniquePtr<ChainedStream>>
+                   range) noexcept {
+          range.ForEach([this](AtomicUniquePtr<ChainedStream> & span) noexcept {
+            std::unique_ptr<ChainedStream> consumed_span;
+            span.Swap(consumed_span);
+            ReleaseSpan(std::move(consumed_span));
+            return true;
+          });
+        });
+  }
   allotment_ = CircularBufferRange<const AtomicUniquePtr<ChainedStream>>{};
+  return num_spans;
 }
 
 //--------------------------------------------------------------------------------------------------
 // Seek
 //--------------------------------------------------------------------------------------------------
 void SpanStream::Seek(int fragment_index, int position) noexcept {
-  remnant_.reset();
+  ReleaseSpan(std::move(remnant_));
+  if (span_ring_ != nullptr) {
+    return RingSeek(fragment_index, position);
+  }
   int full_span_count = 0;
   int span_count = 0;
   allotment_.ForEach([&, fragment_index ](
@@ -77,15 +258,19 @@ void SpanStream::Seek(int fragment_index, int position) noexcept {
     ++span_count;
     return false;
   });
-  span_buffer_.Consume(
-      span_count, [ this, fragment_index, position ](
+  size_t num_bytes = 0;
+  allotment_shard_->Consume(
+      span_count, [ this, fragment_index, position, &num_bytes ](
                       CircularBufferRange<AtomicUniquePtr<ChainedStream>>
                           range) mutable noexcept {
         range.ForEach([&](AtomicUniquePtr<ChainedStream> & span) noexcept {
+          num_bytes += static_cast<size_t>(span->ByteCount());
           auto num_fragments = span->num_fragments();
           if (num_fragments <= fragment_index) {
             fragment_index -= num_fragments;
-            span.Reset();
+            std::unique_ptr<ChainedStream> consumed_span;
+            span.Swap(consumed_span);
+            ReleaseSpan(std::move(consumed_span));
             return true;
           }
           span->Seek(fragment_index, position);
@@ -93,7 +278,86 @@ void SpanStream::Seek(int fragment_index, int position) noexcept {
           return true;
         });
       });
+  num_bytes_consumed_ += num_bytes;
+  span_buffer_budget_.Release(num_bytes);
   metrics_.OnSpansSent(full_span_count);
   allotment_ = CircularBufferRange<const AtomicUniquePtr<ChainedStream>>{};
 }
+
+//--------------------------------------------------------------------------------------------------
+// RingConsumeAllotment
+//--------------------------------------------------------------------------------------------------
+int SpanStream::RingConsumeAllotment() noexcept {
+  int num_spans = 0;
+  for (auto span_first = ring_allotment_first_;
+       span_first != ring_allotment_last_;
+       span_first = FindSpanEnd(*span_ring_, span_first)) {
+    ++num_spans;
+  }
+  num_bytes_consumed_ += ring_allotment_last_ - ring_allotment_first_;
+  RingSend(ring_allotment_first_, ring_allotment_last_);
+  ring_allotment_first_ = ring_allotment_last_;
+  return num_spans;
+}
+
+//--------------------------------------------------------------------------------------------------
+// RingSeek
+//--------------------------------------------------------------------------------------------------
+void SpanStream::RingSeek(int fragment_index, int position) noexcept {
+  auto target = ring_allotment_first_;
+  span_ring_->ForEachFragment(ring_allotment_first_, ring_allotment_last_,
+                              [&](void* /*data*/, int size) {
+                                if (fragment_index-- == 0) {
+                                  return false;
+                                }
+                                target += static_cast<uint64_t>(size);
+                                return true;
+                              });
+  target += static_cast<uint64_t>(position);
+
+  int num_spans = 0;
+  auto span_first = ring_allotment_first_;
+  while (span_first < target) {
+    auto span_last = FindSpanEnd(*span_ring_, span_first);
+    if (span_last > target) {
+      // We seeked into the middle of a span. Copy out the rest of it so that
+      // its space in the ring can be reused.
+      try {
+        remnant_.reset(new ChainedStream{});
+        {
+          google::protobuf::io::CodedOutputStream stream{remnant_.get()};
+          span_ring_->ForEachFragment(target, span_last,
+                                      [&stream](void* data, int size) {
+                                        stream.WriteRaw(data, size);
+                                        return true;
+                                      });
+        }
+        remnant_->CloseOutput();
+      } catch (const std::exception& /*e*/) {
+        remnant_.reset();
+        metrics_.OnSpansDropped(1);
+        metrics_.OnBytesDropped(static_cast<size_t>(span_last - span_first));
+      }
+      span_first = span_last;
+      break;
+    }
+    ++num_spans;
+    span_first = span_last;
+  }
+  metrics_.OnSpansSent(num_spans);
+  num_bytes_consumed_ += span_first - ring_allotment_first_;
+  RingSend(ring_allotment_first_, span_first);
+  ring_allotment_first_ = ring_allotment_last_;
+}
+
+//--------------------------------------------------------------------------------------------------
+// RingSend
+//--------------------------------------------------------------------------------------------------
+void SpanStream::RingSend(uint64_t first, uint64_t last) noexcept {
+  if (retained_spans_ != nullptr && first != last) {
+    retained_spans_->RetainRing(first);
+  }
+  ring_sent_position_ = last;
+  ReleaseRing();
+}
 }  // namespace lightstep
@@ -1,30 +1,125 @@
 #pragma once
 
+#include <vector>
+
+#include "common/byte_budget.h"
+#include "common/byte_ring.h"
 #include "common/chained_stream.h"
-#include "common/circular_buffer.h"
+#include "common/sharded_circular_buffer.h"
 #include "recorder/metrics_tracker.h"
+#include "recorder/stream_recorder/retained_spans.h"
 
 namespace lightstep {
 /**
  * Manages the stream of data comming from the circular buffer of completed
  * spans.
+ *
+ * If a contiguous span buffer is provided, spans are streamed from it instead
+ * of the circular buffer.
  */
 class SpanStream final : public FragmentInputStream {
  public:
-  SpanStream(CircularBuffer<ChainedStream>& span_buffer,
-             MetricsTracker& metrics) noexcept;
+  /**
+   * @param span_buffer the buffer of spans to stream from
+   * @param span_buffer_budget the budget to release bytes of streamed spans to
+   * @param metrics the tracker to record sent spans with
+   * @param span_ring the contiguous span buffer, if spans are buffered in one
+   * @param first_shard_index the index of the first shard to stream from
+   * @param shard_stride the number of shards between the shards to stream from
+   *
+   * Note: The span stream is the consumer for every shard it streams from, so
+   * span streams on different threads must be given disjoint sets of shards.
+   */
+  SpanStream(ShardedCircularBuffer<ChainedStream>& span_buffer,
+             ByteBudget& span_buffer_budget, MetricsTracker& metrics,
+             ByteRing* span_ring = nullptr, size_t first_shard_index = 0,
+             size_t shard_stride = 1) noexcept;
 
   /**
-   * Allots spans from the associated circular buffer to stream to satellites.
+   * Allots spans from the next non-empty shard of the associated circular
+   * buffer (or all spans in the contiguous span buffer) to stream to
+   * satellites.
    */
   void Allot() noexcept;
 
+  /**
+   * @return true if there are no buffered spans left to allot.
+   */
+  bool buffer_empty() const noexcept;
+
+  /**
+   * @return the number of shards of the span buffer that are streamed from.
+   */
+  size_t num_shards() const noexcept { return num_shards_; }
+
+  /**
+   * @return the most spans that can be consumed from a single allotment.
+   *
+   * Note: A contiguous span buffer's allotment is retained as a single range.
+   */
+  size_t max_allotment_size() const noexcept { return max_allotment_size_; }
+
+  /**
+   * Sets where to move spans once they're consumed instead of freeing them.
+   * @param retained_spans the RetainedSpans to move spans to or nullptr to
+   * free them
+   * @param defer_sent_spans if true, spans consumed with Clear are tallied in
+   * retained_spans instead of being counted as sent
+   *
+   * Note: retained_spans must have room for max_allotment_size() spans plus
+   * any remnant released with ReleaseSpan.
+   */
+  void set_retained_spans(RetainedSpans* retained_spans,
+                          bool defer_sent_spans = false) noexcept {
+    retained_spans_ = retained_spans;
+    defer_sent_spans_ = retained_spans != nullptr && defer_sent_spans;
+  }
+
+  /**
+   * Frees or retains a span consumed from the stream.
+   * @param span the span to release
+   */
+  void ReleaseSpan(std::unique_ptr<ChainedStream>&& span) noexcept;
+
+  /**
+   * Registers RetainedSpans whose ranges of the contiguous span buffer hold
+   * back its consumption.
+   * @param retained_spans the RetainedSpans to register
+   */
+  void AddRingRetainer(const RetainedSpans& retained_spans);
+
+  /**
+   * Deregisters RetainedSpans added with AddRingRetainer.
+   * @param retained_spans the RetainedSpans to deregister
+   */
+  void RemoveRingRetainer(const RetainedSpans& retained_spans) noexcept;
+
+  /**
+   * Consumes the contiguous span buffer up to the oldest range that's either
+   * retained or not yet streamed.
+   */
+  void ReleaseRing() noexcept;
+
+  /**
+   * @return the total number of span bytes consumed from the buffer.
+   */
+  uint64_t num_bytes_consumed() const noexcept { return num_bytes_consumed_; }
+
   /**
    * Returns and removes the last partially written span.
    * @return the last partially written span
    */
   std::unique_ptr<ChainedStream> ConsumeRemnant() noexcept;
 
+  /**
+   * Consumes the allotted spans without counting them as sent.
+   * @return the number of spans consumed
+   *
+   * Note: The caller is responsible for counting the spans as either sent or
+   * dropped.
+   */
+  int ConsumeAllotment() noexcept;
+
   /**
    * @return the associagted MetricsTracker
    */
@@ -40,9 +135,35 @@ class SpanStream final : public FragmentInputStream {
   void Seek(int fragment_index, int position) noexcept override;
 
  private:
-  CircularBuffer<ChainedStream>& span_buffer_;
+  ShardedCircularBuffer<ChainedStream>& span_buffer_;
+  ByteBudget& span_buffer_budget_;
   MetricsTracker& metrics_;
+  size_t first_shard_index_;
+  size_t shard_stride_;
+  size_t num_shards_;
+  size_t next_shard_index_{0};
+  size_t max_allotment_size_{0};
+  uint64_t num_bytes_consumed_{0};
+  CircularBuffer<ChainedStream>* allotment_shard_;
   CircularBufferRange<const AtomicUniquePtr<ChainedStream>> allotment_;
   std::unique_ptr<ChainedStream> remnant_;
+  RetainedSpans* retained_spans_{nullptr};
+  bool defer_sent_spans_{false};
+
+  ByteRing* span_ring_;
+  uint64_t ring_allotment_first_{0};
+  uint64_t ring_allotment_last_{0};
+  uint64_t ring_sent_position_{0};
+  std::vector<const RetainedSpans*> ring_retainers_;
+
+  CircularBuffer<ChainedStream>& shard(size_t index) noexcept {
+    return span_buffer_.shard(first_shard_index_ + index * shard_stride_);
+  }
+
+  int RingConsumeAllotment() noexcept;
+
+  void RingSend(uint64_t first, uint64_t last) noexcept;
+
+  void RingSeek(int fragment_index, int position) noexcept;
 };
 }  // namespace lightstep
@@ -0,0 +1,29 @@
+#include "recorder/stream_recorder/stream_compressor.h"
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+CompressionBudget::CompressionBudget(
+    double max_fraction, std::chrono::steady_clock::duration period) noexcept
+    : max_spent_{std::chrono::duration_cast<
+          std::chrono::steady_clock::duration>(period * max_fraction)},
+      period_{period},
+      window_start_{std::chrono::steady_clock::now()},
+      spent_{0} {}
+
+//--------------------------------------------------------------------------------------------------
+// exhausted
+//--------------------------------------------------------------------------------------------------
+bool CompressionBudget::exhausted(
+    std::chrono::steady_clock::time_point now) noexcept {
+  if (max_spent_.count() <= 0) {
+    return false;
+  }
+  if (now - window_start_ >= period_) {
+    window_start_ = now;
+    spent_ = std::chrono::steady_clock::duration{0};
+  }
+  return spent_ >= max_spent_;
+}
+}  // namespace lightstep
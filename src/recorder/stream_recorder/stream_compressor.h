@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include "common/fragment_input_stream.h"
+#include "common/logger.h"
+#include "recorder/stream_recorder/stream_recorder_options.h"
+
+namespace lightstep {
+/**
+ * Tracks the time spent compressing streams against a fraction of wall time.
+ *
+ * Compressors sharing a budget back off to storing data uncompressed while the
+ * budget is exhausted so that compression can't starve the streaming thread.
+ */
+class CompressionBudget {
+ public:
+  /**
+   * @param max_fraction the maximum fraction of time that can be spent
+   * compressing or 0 for no limit
+   * @param period the window of time the fraction is measured over
+   */
+  CompressionBudget(double max_fraction,
+                    std::chrono::steady_clock::duration period) noexcept;
+
+  /**
+   * Record time spent compressing.
+   * @param duration the amount of time spent
+   */
+  void Charge(std::chrono::steady_clock::duration duration) noexcept {
+    spent_ += duration;
+  }
+
+  /**
+   * @param now the current time
+   * @return true if no more time can be spent compressing in the current
+   * window.
+   */
+  bool exhausted(std::chrono::steady_clock::time_point now) noexcept;
+
+ private:
+  std::chrono::steady_clock::duration max_spent_;
+  std::chrono::steady_clock::duration period_;
+  std::chrono::steady_clock::time_point window_start_;
+  std::chrono::steady_clock::duration spent_;
+};
+
+/**
+ * Applies a Content-Encoding to the body of a streaming satellite request.
+ */
+class StreamCompressor {
+ public:
+  virtual ~StreamCompressor() noexcept = default;
+
+  /**
+   * @return the http header declaring the compressor's Content-Encoding.
+   */
+  virtual Fragment content_encoding_header() const noexcept = 0;
+
+  /**
+   * Begin a new compressed stream, discarding any output.
+   * @return false if the stream couldn't be reset.
+   */
+  virtual bool Reset() noexcept = 0;
+
+  /**
+   * Compress data into the stream.
+   * @param data the data to compress
+   * @param size the number of bytes to compress
+   * @return false if compression failed.
+   *
+   * Note: compressed data is only guaranteed to be available as output after
+   * calling Flush or Finish.
+   */
+  virtual bool Compress(const void* data, size_t size) noexcept = 0;
+
+  /**
+   * Make everything compressed so far available as output.
+   * @return false if compression failed.
+   */
+  virtual bool Flush() noexcept = 0;
+
+  /**
+   * End the compressed stream.
+   * @return false if compression failed.
+   */
+  virtual bool Finish() noexcept = 0;
+
+  /**
+   * @return the compressed data not yet cleared.
+   */
+  virtual Fragment output() const noexcept = 0;
+
+  /**
+   * Discard the compressed output.
+   */
+  virtual void ClearOutput() noexcept = 0;
+};
+
+/**
+ * Interface to construct a StreamCompressor.
+ * @param logger supplies the place to write logs.
+ * @param options sets the compression level.
+ * @param budget supplies the budget for time spent compressing.
+ * @return the compressor or nullptr if compression is disabled or
+ * unsupported.
+ */
+std::unique_ptr<StreamCompressor> MakeStreamCompressor(
+    Logger& logger, const StreamRecorderOptions& options,
+    CompressionBudget& budget);
+}  // namespace lightstep
@@ -1,7 +1,9 @@
 #include "recorder/stream_recorder/stream_recorder.h"
 
+#include <algorithm>
 #include <cassert>
 #include <exception>
+#include <limits>
 
 #include "common/chunked_http_framing.h"
 #include "common/protobuf.h"
@@ -19,6 +21,74 @@ static MetricsObserver& GetMetricsObserver(
   return *tracer_options.metrics_observer;
 }
 
+//--------------------------------------------------------------------------------------------------
+// MakeSpanRing
+//--------------------------------------------------------------------------------------------------
+static std::unique_ptr<ByteRing> MakeSpanRing(
+    const LightStepTracerOptions& tracer_options) {
+  if (!tracer_options.use_contiguous_span_buffer) {
+    return nullptr;
+  }
+  size_t size = tracer_options.max_buffered_bytes;
+  if (size == 0) {
+    size = DefaultContiguousSpanBufferSize;
+  }
+  // Fragments are sized with ints.
+  size = std::min(size, static_cast<size_t>(std::numeric_limits<int>::max()));
+  return std::unique_ptr<ByteRing>{new ByteRing{size}};
+}
+
+//--------------------------------------------------------------------------------------------------
+// MakeBackgroundLogSink
+//--------------------------------------------------------------------------------------------------
+static std::unique_ptr<BackgroundLogSink> MakeBackgroundLogSink(
+    Logger& logger, const StreamRecorderOptions& recorder_options) {
+  if (recorder_options.max_queued_log_records == 0) {
+    return nullptr;
+  }
+  return std::unique_ptr<BackgroundLogSink>{new BackgroundLogSink{
+      [&logger](LogLevel level, opentracing::string_view message) {
+        logger.Log(level, message);
+      },
+      recorder_options.max_queued_log_records}};
+}
+
+//--------------------------------------------------------------------------------------------------
+// MakeStreamerLoggerSink
+//--------------------------------------------------------------------------------------------------
+static std::function<void(LogLevel, opentracing::string_view)>
+MakeStreamerLoggerSink(Logger& logger, BackgroundLogSink* background_log_sink) {
+  if (background_log_sink == nullptr) {
+    return [&logger](LogLevel level, opentracing::string_view message) {
+      logger.Log(level, message);
+    };
+  }
+  return [background_log_sink](LogLevel level,
+                               opentracing::string_view message) {
+    (*background_log_sink)(level, message);
+  };
+}
+
+//--------------------------------------------------------------------------------------------------
+// ComputeNumStreamerThreads
+//--------------------------------------------------------------------------------------------------
+static size_t ComputeNumStreamerThreads(
+    const StreamRecorderOptions& recorder_options, size_t num_shards,
+    const ByteRing* span_ring) noexcept {
+  // The contiguous span buffer can only be consumed from a single thread.
+  if (span_ring != nullptr || recorder_options.num_streamer_threads <= 1) {
+    return 1;
+  }
+  auto result = static_cast<size_t>(recorder_options.num_streamer_threads);
+  result = std::min(result, num_shards);
+  if (recorder_options.num_satellite_connections > 0) {
+    result = std::min(
+        result,
+        static_cast<size_t>(recorder_options.num_satellite_connections));
+  }
+  return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
@@ -28,9 +98,31 @@ StreamRecorder::StreamRecorder(Logger& logger,
     : logger_{logger},
       tracer_options_{std::move(tracer_options)},
       recorder_options_{std::move(recorder_options)},
+      background_log_sink_{MakeBackgroundLogSink(logger_, recorder_options_)},
+      streamer_logger_{
+          MakeStreamerLoggerSink(logger_, background_log_sink_.get())},
       metrics_{GetMetricsObserver(tracer_options_)},
-      span_buffer_{tracer_options_.max_buffered_spans.value()} {
-  stream_recorder_impl_.reset(new StreamRecorderImpl{*this});
+      span_buffer_{tracer_options_.max_buffered_spans.value(),
+                   recorder_options_.num_span_buffer_shards},
+      span_buffer_budget_{tracer_options_.max_buffered_bytes},
+      span_ring_{MakeSpanRing(tracer_options_)},
+      early_flush_marker_{static_cast<size_t>(
+          tracer_options_.max_buffered_spans.value() *
+          recorder_options_.early_flush_threshold)},
+      early_flush_bytes_marker_{static_cast<size_t>(
+          max_buffered_bytes() * recorder_options_.early_flush_threshold)},
+      num_streamer_threads_{ComputeNumStreamerThreads(
+          recorder_options_, span_buffer_.num_shards(), span_ring_.get())},
+      consumption_counts_(span_buffer_.num_shards() +
+                              static_cast<size_t>(span_ring_ != nullptr),
+                          0),
+      active_streamers_{new std::atomic<bool>[num_streamer_threads_]} {
+  streamer_logger_.set_level(logger_.level());
+  for (size_t i = 0; i < num_streamer_threads_; ++i) {
+    active_streamers_[i] = true;
+  }
+  MakeNotifiers();
+  StartStreamerThreads();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -93,19 +185,33 @@ void StreamRecorder::RecordSpan(
   span->Seek(0, static_cast<int>(reserved_header_size - protobuf_header_size -
                                  chunk_header_size));
 
-  if (!span_buffer_.Add(span)) {
-    // Note: the compiler doesn't want to inline this logger call and it shows
-    // up in profiling with high span droppage even if the logging isn't turned
-    // on.
-    //
-    // Hence, the additional checking to avoid a function call.
-    if (static_cast<int>(logger_.level()) <=
-        static_cast<int>(LogLevel::debug)) {
-      logger_.Debug("Dropping span");
+  if (span_ring_ != nullptr) {
+    auto chunk_size =
+        chunk_header_size + chunk_body_size + ChunkedHttpFooter.size();
+    return RecordSpanInRing(std::move(span), chunk_size);
+  }
+
+  auto num_bytes = static_cast<size_t>(span->ByteCount());
+  if (span_buffer_budget_.Reserve(num_bytes)) {
+    auto shard = span_buffer_.AddToShard(span);
+    if (shard != nullptr) {
+      return NotifyIfPastEarlyFlushThreshold(shard);
     }
-    metrics_.OnSpansDropped(1);
-    span.reset();
+    span_buffer_budget_.Release(num_bytes);
+  }
+
+  // Note: the compiler doesn't want to inline this logger call and it shows
+  // up in profiling with high span droppage even if the logging isn't turned
+  // on.
+  //
+  // Hence, the additional checking to avoid a function call.
+  if (static_cast<int>(logger_.level()) <= static_cast<int>(LogLevel::debug)) {
+    static LogRateLimiter rate_limiter;
+    logger_.Debug(rate_limiter, "Dropping span");
   }
+  metrics_.OnSpansDropped(1);
+  metrics_.OnBytesDropped(num_bytes);
+  span.reset();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -113,16 +219,24 @@ void StreamRecorder::RecordSpan(
 //--------------------------------------------------------------------------------------------------
 bool StreamRecorder::FlushWithTimeout(
     std::chrono::system_clock::duration timeout) noexcept try {
-  auto num_spans_produced = span_buffer_.production_count();
+  // Spans are only consumed in order within a shard, so track progress per
+  // shard.
+  std::vector<int64_t> production_counts(consumption_counts_.size());
+  for (size_t i = 0; i < production_counts.size(); ++i) {
+    production_counts[i] = production_count(i);
+  }
   std::unique_lock<std::mutex> lock{flush_mutex_};
-  if (num_spans_consumed_ >= num_spans_produced) {
+  if (IsFlushed(production_counts)) {
     return true;
   }
-  ++pending_flush_counter_;
-  flush_condition_variable_.wait_for(lock, timeout, [this, num_spans_produced] {
-    return exit_ || num_spans_consumed_ >= num_spans_produced;
+  ++flush_request_count_;
+  ++num_flush_waiters_;
+  NotifyAll();
+  flush_condition_variable_.wait_for(lock, timeout, [&] {
+    return exit_ || IsFlushed(production_counts);
   });
-  return num_spans_consumed_ >= num_spans_produced;
+  --num_flush_waiters_;
+  return IsFlushed(production_counts);
 } catch (const std::exception& e) {
   logger_.Error("StreamRecorder::FlushWithTimeout failed: ", e.what());
   return false;
@@ -133,10 +247,23 @@ bool StreamRecorder::FlushWithTimeout(
 //--------------------------------------------------------------------------------------------------
 bool StreamRecorder::ShutdownWithTimeout(
     std::chrono::system_clock::duration timeout) noexcept try {
+  auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
   std::unique_lock<std::mutex> lock{shutdown_mutex_};
-  ++shutdown_counter_;
-  shutdown_condition_variable_.wait_for(
-      lock, timeout, [this] { return exit_ || !last_is_active_; });
+  ++shutdown_request_count_;
+  NotifyAll();
+  shutdown_condition_variable_.wait_until(
+      lock, deadline, [this] { return exit_ || !last_is_active_; });
+  if (background_log_sink_ != nullptr) {
+    // Give what was logged while shutting down the rest of the timeout to
+    // reach the tracer's logger.
+    auto remaining = std::max(deadline - std::chrono::steady_clock::now(),
+                              std::chrono::steady_clock::duration::zero());
+    background_log_sink_->FlushWithTimeout(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            remaining));
+  }
   return !last_is_active_;
 } catch (const std::exception& e) {
   logger_.Error("StreamRecorder::FlushWithTimeout failed: ", e.what());
@@ -149,14 +276,21 @@ bool StreamRecorder::ShutdownWithTimeout(
 void StreamRecorder::PrepareForFork() noexcept {
   // We don't want parent and child processes to share sockets so close any open
   // connections.
-  stream_recorder_impl_.reset(nullptr);
+  stream_recorder_impls_.clear();
+
+  if (background_log_sink_ != nullptr) {
+    background_log_sink_->Stop();
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
 // OnForkedParent
 //--------------------------------------------------------------------------------------------------
 void StreamRecorder::OnForkedParent() noexcept {
-  stream_recorder_impl_.reset(new StreamRecorderImpl{*this});
+  if (background_log_sink_ != nullptr) {
+    background_log_sink_->Start();
+  }
+  StartStreamerThreads();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -166,36 +300,233 @@ void StreamRecorder::OnForkedChild() noexcept {
   // Clear any buffered data since it will already be recorded from the parent
   // process.
   metrics_.ConsumeDroppedSpans();
-  span_buffer_.Clear();
-  num_spans_consumed_ = span_buffer_.production_count();
-  pending_flush_counter_ = 0;
+  ClearSpanBuffer();
+  if (span_ring_ != nullptr) {
+    // Another thread may have been in the middle of recording a span when the
+    // process forked, so discard any space it reserved.
+    span_ring_->Reset();
+  }
+  for (size_t i = 0; i < consumption_counts_.size(); ++i) {
+    consumption_counts_[i] = production_count(i);
+  }
+
+  // The notifiers' descriptors are shared with the parent process so replace
+  // them.
+  MakeNotifiers();
 
-  stream_recorder_impl_.reset(new StreamRecorderImpl{*this});
+  if (background_log_sink_ != nullptr) {
+    background_log_sink_->Start();
+  }
+  StartStreamerThreads();
 }
 
 //--------------------------------------------------------------------------------------------------
 // Poll
 //--------------------------------------------------------------------------------------------------
-void StreamRecorder::Poll(StreamRecorderImpl& stream_recorder_impl) noexcept {
-  auto num_spans_consumed = span_buffer_.consumption_count();
-  if (num_spans_consumed > num_spans_consumed_) {
+bool StreamRecorder::Poll(StreamRecorderImpl& stream_recorder_impl) noexcept {
+  auto thread_index = stream_recorder_impl.index();
+  auto num_counts = consumption_counts_.size();
+  bool spans_consumed = false;
+  for (size_t i = 0; i < num_counts; ++i) {
+    spans_consumed |= consumer_thread(i) == thread_index &&
+                      consumption_count(i) > consumption_counts_[i];
+  }
+  if (spans_consumed) {
     {
       std::lock_guard<std::mutex> lock_guard{flush_mutex_};
-      num_spans_consumed_ = num_spans_consumed;
+      for (size_t i = 0; i < num_counts; ++i) {
+        if (consumer_thread(i) == thread_index) {
+          consumption_counts_[i] = consumption_count(i);
+        }
+      }
     }
     flush_condition_variable_.notify_all();
   }
 
-  if (shutdown_counter_.exchange(0) > 0) {
-    stream_recorder_impl.InitiateShutdown();
+  active_streamers_[thread_index] = stream_recorder_impl.is_active();
+  if (last_is_active_) {
+    bool is_active = false;
+    for (size_t i = 0; i < num_streamer_threads_; ++i) {
+      is_active |= active_streamers_[i];
+    }
+    if (!is_active) {
+      {
+        std::lock_guard<std::mutex> lock_guard{shutdown_mutex_};
+        last_is_active_ = false;
+      }
+      shutdown_condition_variable_.notify_all();
+    }
+  }
+
+  return num_flush_waiters_ > 0 ||
+         (stream_recorder_impl.shutdown_initiated() && last_is_active_);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ClearSpanBuffer
+//--------------------------------------------------------------------------------------------------
+void StreamRecorder::ClearSpanBuffer() noexcept {
+  if (span_ring_ != nullptr) {
+    span_ring_->Clear();
+  }
+  for (size_t i = 0; i < span_buffer_.num_shards(); ++i) {
+    ClearShard(i);
+  }
+}
+
+void StreamRecorder::ClearSpanBuffer(size_t thread_index) noexcept {
+  if (span_ring_ != nullptr && thread_index == 0) {
+    span_ring_->Clear();
   }
+  for (size_t i = thread_index; i < span_buffer_.num_shards();
+       i += num_streamer_threads_) {
+    ClearShard(i);
+  }
+}
 
-  if (last_is_active_ && !stream_recorder_impl.is_active()) {
-    {
-      std::lock_guard<std::mutex> lock_guard{shutdown_mutex_};
-      last_is_active_ = false;
+//--------------------------------------------------------------------------------------------------
+// production_count
+//--------------------------------------------------------------------------------------------------
+int64_t StreamRecorder::production_count(size_t index) const noexcept {
+  if (index < span_buffer_.num_shards()) {
+    return span_buffer_.shard(index).production_count();
+  }
+  return static_cast<int64_t>(span_ring_->committed_position());
+}
+
+//--------------------------------------------------------------------------------------------------
+// consumption_count
+//--------------------------------------------------------------------------------------------------
+int64_t StreamRecorder::consumption_count(size_t index) const noexcept {
+  if (index < span_buffer_.num_shards()) {
+    return span_buffer_.shard(index).consumption_count();
+  }
+  return static_cast<int64_t>(span_ring_->consumer_position());
+}
+
+//--------------------------------------------------------------------------------------------------
+// consumer_thread
+//--------------------------------------------------------------------------------------------------
+size_t StreamRecorder::consumer_thread(size_t index) const noexcept {
+  // Mirrors the striping of shards in SpanStream.
+  if (index < span_buffer_.num_shards()) {
+    return index % num_streamer_threads_;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// ClearShard
+//--------------------------------------------------------------------------------------------------
+void StreamRecorder::ClearShard(size_t index) noexcept {
+  auto& shard = span_buffer_.shard(index);
+  if (!span_buffer_budget_.is_limited()) {
+    return shard.Clear();
+  }
+  size_t num_bytes = 0;
+  shard.Consume(
+      shard.size(),
+      [&num_bytes](CircularBufferRange<AtomicUniquePtr<ChainedStream>> &
+                   spans) noexcept {
+        spans.ForEach([&num_bytes](AtomicUniquePtr<ChainedStream> &
+                                   span) noexcept {
+          num_bytes += static_cast<size_t>(span->ByteCount());
+          span.Reset();
+          return true;
+        });
+      });
+  span_buffer_budget_.Release(num_bytes);
+}
+
+//--------------------------------------------------------------------------------------------------
+// MakeNotifiers
+//--------------------------------------------------------------------------------------------------
+void StreamRecorder::MakeNotifiers() {
+  notifiers_.clear();
+  notifiers_.reserve(num_streamer_threads_);
+  for (size_t i = 0; i < num_streamer_threads_; ++i) {
+    notifiers_.emplace_back(new EventNotifier{});
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// StartStreamerThreads
+//--------------------------------------------------------------------------------------------------
+void StreamRecorder::StartStreamerThreads() {
+  stream_recorder_impls_.reserve(num_streamer_threads_);
+  for (size_t i = 0; i < num_streamer_threads_; ++i) {
+    stream_recorder_impls_.emplace_back(new StreamRecorderImpl{*this, i});
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// NotifyAll
+//--------------------------------------------------------------------------------------------------
+void StreamRecorder::NotifyAll() noexcept {
+  for (auto& notifier : notifiers_) {
+    notifier->Notify();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// IsFlushed
+//--------------------------------------------------------------------------------------------------
+bool StreamRecorder::IsFlushed(
+    const std::vector<int64_t>& production_counts) const noexcept {
+  for (size_t i = 0; i < production_counts.size(); ++i) {
+    if (consumption_counts_[i] < production_counts[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// RecordSpanInRing
+//--------------------------------------------------------------------------------------------------
+void StreamRecorder::RecordSpanInRing(std::unique_ptr<ChainedStream>&& span,
+                                      size_t num_bytes) noexcept {
+  uint64_t position;
+  if (!span_ring_->Reserve(num_bytes, position)) {
+    if (static_cast<int>(logger_.level()) <=
+        static_cast<int>(LogLevel::debug)) {
+      static LogRateLimiter rate_limiter;
+      logger_.Debug(rate_limiter, "Dropping span");
+    }
+    metrics_.OnSpansDropped(1);
+    metrics_.OnBytesDropped(num_bytes);
+    span.reset();
+    return;
+  }
+  auto write_position = position;
+  span->ForEachFragment([&](void* data, int size) {
+    span_ring_->Write(write_position, data, static_cast<size_t>(size));
+    write_position += static_cast<uint64_t>(size);
+    return true;
+  });
+  assert(write_position == position + num_bytes);
+  span_ring_->Commit(position, num_bytes);
+  span.reset();
+  NotifyIfPastEarlyFlushThreshold(nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// NotifyIfPastEarlyFlushThreshold
+//--------------------------------------------------------------------------------------------------
+void StreamRecorder::NotifyIfPastEarlyFlushThreshold(
+    const CircularBuffer<ChainedStream>* shard) noexcept {
+  // Only the fill level of the shard the span was added to is checked so that
+  // recording spans doesn't pull in the counters of every other shard.
+  bool is_past_threshold = false;
+  for (auto& notifier : notifiers_) {
+    if (notifier->pending()) {
+      continue;
+    }
+    if (!is_past_threshold && !IsPastEarlyFlushThreshold(shard)) {
+      return;
     }
-    shutdown_condition_variable_.notify_all();
+    is_past_threshold = true;
+    notifier->Notify();
   }
 }
 
@@ -5,16 +5,21 @@
 #include <cstdint>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "stream_recorder_impl.h"
 
+#include "common/background_log_sink.h"
+#include "common/byte_budget.h"
+#include "common/byte_ring.h"
 #include "common/chained_stream.h"
-#include "common/circular_buffer.h"
 #include "common/logger.h"
 #include "common/noncopyable.h"
+#include "common/sharded_circular_buffer.h"
 #include "common/platform/network_environment.h"
 #include "lightstep/tracer.h"
 #include "network/event_base.h"
+#include "network/event_notifier.h"
 #include "network/timer_event.h"
 #include "recorder/fork_aware_recorder.h"
 #include "recorder/metrics_tracker.h"
@@ -22,6 +27,9 @@
 #include "recorder/stream_recorder/stream_recorder_options.h"
 
 namespace lightstep {
+// The size of the contiguous span buffer if max_buffered_bytes isn't set.
+const size_t DefaultContiguousSpanBufferSize = 4 * 1024 * 1024;
+
 /**
  * A Recorder that load balances and streams spans to multiple satellites.
  */
@@ -37,30 +45,92 @@ class StreamRecorder : public ForkAwareRecorder, private Noncopyable {
    * Checks whether any threads blocked on flush calls can be resumed.
    * @param stream_recorder_impl a reference to the stream recorder
    * implementation that invoked poll.
+   * @return true if a thread is still waiting on a flush or shutdown, in which
+   * case the recorder should continue to poll frequently.
    *
    * Note: stream_recorder_impl is redundant since it can also be accessed
-   * through the member variable stream_recorder_impl_, but it's structured this
-   * way to avoid false positives from TSAN.
+   * through the member variable stream_recorder_impls_, but it's structured
+   * this way to avoid false positives from TSAN.
+   */
+  bool Poll(StreamRecorderImpl& stream_recorder_impl) noexcept;
+
+  /**
+   * @return the number of times a flush has been requested.
+   *
+   * Note: Each recording thread compares this against the count it last saw
+   * so that a request is seen by all of them.
+   */
+  int64_t flush_request_count() const noexcept { return flush_request_count_; }
+
+  /**
+   * @return the number of times a shutdown has been requested.
+   */
+  int64_t shutdown_request_count() const noexcept {
+    return shutdown_request_count_;
+  }
+
+  /**
+   * @return true if the span buffer has filled past the point where it should
+   * be flushed early.
+   */
+  bool IsPastEarlyFlushThreshold() const noexcept {
+    return span_buffer_.size() > early_flush_marker_ ||
+           num_buffered_bytes() > early_flush_bytes_marker_;
+  }
+
+  /**
+   * @param shard the shard of the span buffer a span was just added to or
+   * nullptr if it was added to the contiguous span buffer.
+   * @return true if the shard or the buffered bytes have filled past the point
+   * where the span buffer should be flushed early.
+   *
+   * Note: Unlike IsPastEarlyFlushThreshold, this doesn't read the counters of
+   * every shard, so it's cheap enough to call whenever a span is recorded.
+   */
+  bool IsPastEarlyFlushThreshold(
+      const CircularBuffer<ChainedStream>* shard) const noexcept {
+    if (shard != nullptr &&
+        static_cast<double>(shard->size()) >
+            static_cast<double>(shard->max_size()) *
+                recorder_options_.early_flush_threshold) {
+      return true;
+    }
+    return num_buffered_bytes() > early_flush_bytes_marker_;
+  }
+
+  /**
+   * @param index the index of a recording thread.
+   * @return the notifier used to wake up the recording thread.
    */
-  void Poll(StreamRecorderImpl& stream_recorder_impl) noexcept;
+  EventNotifier& notifier(size_t index) noexcept { return *notifiers_[index]; }
 
   /**
-   * Gets the pending flush count and resets the counter.
-   * @return the pending flush count.
+   * @return the number of threads streaming spans to satellites.
    */
-  int ConsumePendingFlushCount() noexcept {
-    return pending_flush_counter_.exchange(0);
+  size_t num_streamer_threads() const noexcept {
+    return num_streamer_threads_;
   }
 
   /**
    * @return true if no spans are buffered in the recorder.
    */
-  bool empty() const noexcept { return span_buffer_.empty(); }
+  bool empty() const noexcept {
+    return span_buffer_.empty() &&
+           (span_ring_ == nullptr || span_ring_->empty());
+  }
 
   /**
-   * @return the associated Logger.
+   * @return the Logger for streamer threads to use.
+   *
+   * Note: If StreamRecorderOptions::max_queued_log_records is set, messages
+   * are handed to a background thread before they reach the tracer's logger.
    */
-  Logger& logger() const noexcept { return logger_; }
+  Logger& logger() noexcept { return streamer_logger_; }
+
+  /**
+   * @return the tracer's Logger, which logs synchronously.
+   */
+  Logger& tracer_logger() const noexcept { return logger_; }
 
   /**
    * @return the associated LightStepTracerOptions
@@ -84,7 +154,56 @@ class StreamRecorder : public ForkAwareRecorder, private Noncopyable {
   /**
    * @return the associated span buffer.
    */
-  CircularBuffer<ChainedStream>& span_buffer() noexcept { return span_buffer_; }
+  ShardedCircularBuffer<ChainedStream>& span_buffer() noexcept {
+    return span_buffer_;
+  }
+
+  /**
+   * @return the budget for the number of bytes in the span buffer.
+   */
+  ByteBudget& span_buffer_budget() noexcept { return span_buffer_budget_; }
+
+  /**
+   * @return the contiguous span buffer or nullptr if spans are buffered
+   * individually.
+   */
+  ByteRing* span_ring() noexcept { return span_ring_.get(); }
+
+  /**
+   * @return the maximum number of bytes of spans buffered or 0 if there's no
+   * limit.
+   */
+  size_t max_buffered_bytes() const noexcept {
+    return span_ring_ != nullptr ? span_ring_->capacity()
+                                 : span_buffer_budget_.max_bytes();
+  }
+
+  /**
+   * @return the number of bytes of spans buffered.
+   *
+   * Note: this is always 0 if there's no limit on the number of bytes.
+   */
+  size_t num_buffered_bytes() const noexcept {
+    return span_ring_ != nullptr ? span_ring_->size()
+                                 : span_buffer_budget_.num_bytes_used();
+  }
+
+  /**
+   * Removes all spans from the span buffer without sending them.
+   *
+   * Note: This method must only be called when no recording threads are
+   * running.
+   */
+  void ClearSpanBuffer() noexcept;
+
+  /**
+   * Removes the spans consumed by a given recording thread without sending
+   * them.
+   * @param thread_index the index of the recording thread.
+   *
+   * Note: This method must only be called from that recording thread.
+   */
+  void ClearSpanBuffer(size_t thread_index) noexcept;
 
   // Recorder
   Fragment ReserveHeaderSpace(ChainedStream& stream) override;
@@ -102,14 +221,14 @@ class StreamRecorder : public ForkAwareRecorder, private Noncopyable {
       std::chrono::system_clock::duration timeout) noexcept override;
 
   int64_t ComputeSystemSteadyTimestampDelta() const noexcept override {
-    return stream_recorder_impl_->timestamp_delta();
+    return stream_recorder_impls_.front()->timestamp_delta();
   }
 
   std::chrono::system_clock::time_point ComputeCurrentSystemTimestamp(
       std::chrono::steady_clock::time_point steady_now) const
       noexcept override {
-    return ToSystemTimestamp(stream_recorder_impl_->timestamp_delta(),
-                             steady_now);
+    return ToSystemTimestamp(
+        stream_recorder_impls_.front()->timestamp_delta(), steady_now);
   }
 
   const MetricsObserver* metrics_observer() const noexcept override {
@@ -129,24 +248,60 @@ class StreamRecorder : public ForkAwareRecorder, private Noncopyable {
 
   LightStepTracerOptions tracer_options_;
   StreamRecorderOptions recorder_options_;
+  std::unique_ptr<BackgroundLogSink> background_log_sink_;
+  Logger streamer_logger_;
   MetricsTracker metrics_;
-  CircularBuffer<ChainedStream> span_buffer_;
+  ShardedCircularBuffer<ChainedStream> span_buffer_;
+  ByteBudget span_buffer_budget_;
+  std::unique_ptr<ByteRing> span_ring_;
+  size_t early_flush_marker_;
+  size_t early_flush_bytes_marker_;
+  size_t num_streamer_threads_;
+  std::vector<std::unique_ptr<EventNotifier>> notifiers_;
 
   std::atomic<bool> exit_{false};
 
   std::mutex flush_mutex_;
   std::condition_variable flush_condition_variable_;
-  std::atomic<int> pending_flush_counter_{0};
-  int64_t num_spans_consumed_{0};
+  std::atomic<int64_t> flush_request_count_{0};
+  std::atomic<int> num_flush_waiters_{0};
+  // The amount consumed from each shard of the span buffer (followed by the
+  // contiguous span buffer, if used) as of the last poll of the recording
+  // thread that consumes it.
+  std::vector<int64_t> consumption_counts_;
 
   std::mutex shutdown_mutex_;
   std::condition_variable shutdown_condition_variable_;
-  std::atomic<int> shutdown_counter_{0};
+  std::atomic<int64_t> shutdown_request_count_{0};
+
+  // Used by polling to track when the satellite connections of every recording
+  // thread become inactive so that any threads waiting on shutdown can be
+  // notified.
+  std::unique_ptr<std::atomic<bool>[]> active_streamers_;
+  std::atomic<bool> last_is_active_{true};
+
+  std::vector<std::unique_ptr<StreamRecorderImpl>> stream_recorder_impls_;
+
+  int64_t production_count(size_t index) const noexcept;
+
+  int64_t consumption_count(size_t index) const noexcept;
+
+  size_t consumer_thread(size_t index) const noexcept;
+
+  void ClearShard(size_t index) noexcept;
+
+  void MakeNotifiers();
+
+  void StartStreamerThreads();
+
+  void NotifyAll() noexcept;
+
+  bool IsFlushed(const std::vector<int64_t>& production_counts) const noexcept;
 
-  // Used by polling to track when the satellite connections become inactive so
-  // that any threads waiting on shutdown can be notified.
-  bool last_is_active_{true};
+  void RecordSpanInRing(std::unique_ptr<ChainedStream>&& span,
+                        size_t num_bytes) noexcept;
 
-  std::unique_ptr<StreamRecorderImpl> stream_recorder_impl_;
+  void NotifyIfPastEarlyFlushThreshold(
+      const CircularBuffer<ChainedStream>* shard) noexcept;
 };
 }  // namespace lightstep
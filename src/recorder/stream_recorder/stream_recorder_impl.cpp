@@ -1,18 +1,94 @@
 #include "stream_recorder_impl.h"
 
+#include <algorithm>
+
+#include "common/utility.h"
 #include "recorder/stream_recorder/stream_recorder.h"
 
+#include <event2/event.h>
+
 namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// ShareConnections
+//--------------------------------------------------------------------------------------------------
+// Split a number of satellite connections evenly between the recording
+// threads.
+static int ShareConnections(const StreamRecorder& stream_recorder,
+                            int num_connections, size_t index) noexcept {
+  auto num_threads = static_cast<int>(stream_recorder.num_streamer_threads());
+  return num_connections / num_threads +
+         static_cast<int>(static_cast<int>(index) <
+                          num_connections % num_threads);
+}
+
+//--------------------------------------------------------------------------------------------------
+// IsScalingConnections
+//--------------------------------------------------------------------------------------------------
+static bool IsScalingConnections(
+    const StreamRecorderOptions& options) noexcept {
+  return options.max_satellite_connections > options.min_satellite_connections;
+}
+
+//--------------------------------------------------------------------------------------------------
+// ComputeMinConnections
+//--------------------------------------------------------------------------------------------------
+static int ComputeMinConnections(const StreamRecorder& stream_recorder,
+                                 size_t index) noexcept {
+  auto& options = stream_recorder.recorder_options();
+  if (!IsScalingConnections(options)) {
+    return ShareConnections(stream_recorder, options.num_satellite_connections,
+                            index);
+  }
+  return std::max(
+      ShareConnections(stream_recorder, options.min_satellite_connections,
+                       index),
+      1);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ComputeMaxConnections
+//--------------------------------------------------------------------------------------------------
+static int ComputeMaxConnections(const StreamRecorder& stream_recorder,
+                                 size_t index) noexcept {
+  auto& options = stream_recorder.recorder_options();
+  if (!IsScalingConnections(options)) {
+    return ShareConnections(stream_recorder, options.num_satellite_connections,
+                            index);
+  }
+  return std::max(
+      ShareConnections(stream_recorder, options.max_satellite_connections,
+                       index),
+      1);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ComputeNumConnections
+//--------------------------------------------------------------------------------------------------
+static int ComputeNumConnections(const StreamRecorder& stream_recorder,
+                                 size_t index) noexcept {
+  auto num_connections = ShareConnections(
+      stream_recorder,
+      stream_recorder.recorder_options().num_satellite_connections, index);
+  return std::min(
+      std::max(num_connections, ComputeMinConnections(stream_recorder, index)),
+      ComputeMaxConnections(stream_recorder, index));
+}
+
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
-StreamRecorderImpl::StreamRecorderImpl(StreamRecorder& stream_recorder)
+StreamRecorderImpl::StreamRecorderImpl(StreamRecorder& stream_recorder,
+                                       size_t index)
     : stream_recorder_{stream_recorder},
-      early_flush_marker_{static_cast<size_t>(
-          stream_recorder_.tracer_options().max_buffered_spans.value() *
-          stream_recorder_.recorder_options().early_flush_threshold)},
+      index_{index},
+      notification_event_{
+          event_base_, stream_recorder_.notifier(index).file_descriptor(),
+          EV_READ | EV_PERSIST,
+          MakeEventCallback<StreamRecorderImpl,
+                            &StreamRecorderImpl::OnNotification>(),
+          static_cast<void*>(this)},
       poll_timer_{
-          event_base_, stream_recorder_.recorder_options().polling_period,
+          event_base_, stream_recorder_.recorder_options().idle_polling_period,
           MakeTimerCallback<StreamRecorderImpl, &StreamRecorderImpl::Poll>(),
           static_cast<void*>(this)},
       timestamp_delta_timer_{
@@ -30,7 +106,17 @@ StreamRecorderImpl::StreamRecorderImpl(StreamRecorder& stream_recorder)
                 stream_recorder_.tracer_options(),
                 stream_recorder_.recorder_options(),
                 stream_recorder_.metrics(),
-                stream_recorder_.span_buffer()} {
+                stream_recorder_.span_buffer(),
+                stream_recorder_.span_buffer_budget(),
+                stream_recorder_.span_ring(),
+                ComputeNumConnections(stream_recorder, index),
+                ComputeMinConnections(stream_recorder, index),
+                ComputeMaxConnections(stream_recorder, index),
+                index,
+                stream_recorder_.num_streamer_threads()},
+      flush_request_count_{stream_recorder_.flush_request_count()},
+      shutdown_request_count_{stream_recorder_.shutdown_request_count()} {
+  notification_event_.Add(nullptr);
   thread_ = std::thread{&StreamRecorderImpl::Run, this};
 }
 
@@ -39,6 +125,7 @@ StreamRecorderImpl::StreamRecorderImpl(StreamRecorder& stream_recorder)
 //--------------------------------------------------------------------------------------------------
 StreamRecorderImpl::~StreamRecorderImpl() noexcept {
   exit_ = true;
+  stream_recorder_.notifier(index_).Notify();
   thread_.join();
 }
 
@@ -51,6 +138,15 @@ void StreamRecorderImpl::Run() noexcept try {
   stream_recorder_.logger().Error("StreamRecorder::Run failed: ", e.what());
 }
 
+//--------------------------------------------------------------------------------------------------
+// OnNotification
+//--------------------------------------------------------------------------------------------------
+void StreamRecorderImpl::OnNotification(FileDescriptor /*file_descriptor*/,
+                                        short /*what*/) noexcept {
+  stream_recorder_.notifier(index_).Consume();
+  Poll();
+}
+
 //--------------------------------------------------------------------------------------------------
 // Poll
 //--------------------------------------------------------------------------------------------------
@@ -66,19 +162,45 @@ void StreamRecorderImpl::Poll() noexcept {
       // Shut down the event loop.
       return event_base_.LoopBreak();
     } catch (const std::exception& e) {
-      stream_recorder_.logger().Error(
+      // Log synchronously since the process is about to terminate.
+      stream_recorder_.tracer_logger().Error(
           "StreamRecorder: failed to break out of event loop: ", e.what());
       std::terminate();
     }
   }
 
-  auto pending_flush_count = stream_recorder_.ConsumePendingFlushCount();
-  if (pending_flush_count > 0 ||
-      stream_recorder_.span_buffer().size() > early_flush_marker_) {
+  auto flush_request_count = stream_recorder_.flush_request_count();
+  if (flush_request_count != flush_request_count_ ||
+      stream_recorder_.IsPastEarlyFlushThreshold()) {
+    flush_request_count_ = flush_request_count;
     Flush();
   }
 
-  stream_recorder_.Poll(*this);
+  auto shutdown_request_count = stream_recorder_.shutdown_request_count();
+  if (shutdown_request_count != shutdown_request_count_) {
+    shutdown_request_count_ = shutdown_request_count;
+    streamer_.InitiateShutdown();
+    shutdown_initiated_ = true;
+  }
+
+  SetPollingPeriod(stream_recorder_.Poll(*this));
+}
+
+//--------------------------------------------------------------------------------------------------
+// SetPollingPeriod
+//--------------------------------------------------------------------------------------------------
+void StreamRecorderImpl::SetPollingPeriod(bool poll_frequently) noexcept try {
+  if (poll_frequently == is_polling_frequently_) {
+    return;
+  }
+  auto& recorder_options = stream_recorder_.recorder_options();
+  auto tv = ToTimeval(poll_frequently ? recorder_options.polling_period
+                                      : recorder_options.idle_polling_period);
+  poll_timer_.Reset(&tv);
+  is_polling_frequently_ = poll_frequently;
+} catch (const std::exception& e) {
+  stream_recorder_.logger().Error(
+      "StreamRecorder: failed to set the polling period: ", e.what());
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -92,9 +214,8 @@ void StreamRecorderImpl::RefreshTimestampDelta() noexcept {
 // Flush
 //--------------------------------------------------------------------------------------------------
 void StreamRecorderImpl::Flush() noexcept try {
-  auto& span_buffer = stream_recorder_.span_buffer();
   if (stream_recorder_.recorder_options().throw_away_spans) {
-    span_buffer.Clear();
+    stream_recorder_.ClearSpanBuffer(index_);
   } else {
     streamer_.Flush();
   }
@@ -5,6 +5,7 @@
 
 #include "common/noncopyable.h"
 #include "common/timestamp.h"
+#include "network/event.h"
 #include "network/event_base.h"
 #include "network/timer_event.h"
 #include "recorder/stream_recorder/satellite_streamer.h"
@@ -13,18 +14,30 @@ namespace lightstep {
 class StreamRecorder;
 
 /**
- * Implements the part of StreamRecorder that manages the recording thread and
- * satellite connections.
+ * Implements the part of StreamRecorder that manages a recording thread and
+ * its satellite connections.
  *
  * This functionality is broken out into a separate class so that the resources
  * can be brought down and resumed so as to support forking.
+ *
+ * A StreamRecorder can run several of these, each streaming from its own
+ * shards of the span buffer.
  */
 class StreamRecorderImpl : private Noncopyable {
  public:
-  explicit StreamRecorderImpl(StreamRecorder& stream_recorder);
+  /**
+   * @param stream_recorder the recorder to stream spans from
+   * @param index the index of the recording thread
+   */
+  StreamRecorderImpl(StreamRecorder& stream_recorder, size_t index);
 
   ~StreamRecorderImpl() noexcept;
 
+  /**
+   * @return the index of the recording thread.
+   */
+  size_t index() const noexcept { return index_; }
+
   /**
    * A cached delta of difference between std::chrono::system_clock and
    * std::chrono::steady_clock.
@@ -32,9 +45,10 @@ class StreamRecorderImpl : private Noncopyable {
   int64_t timestamp_delta() const noexcept { return timestamp_delta_; }
 
   /**
-   * Schedule the recorder to cleanly close all satellite connections.
+   * @return true if the recorder has started to cleanly close its satellite
+   * connections.
    */
-  void InitiateShutdown() noexcept { streamer_.InitiateShutdown(); }
+  bool shutdown_initiated() const noexcept { return shutdown_initiated_; }
 
   /**
    * @return true if any satellite connections are active.
@@ -43,23 +57,35 @@ class StreamRecorderImpl : private Noncopyable {
 
  private:
   StreamRecorder& stream_recorder_;
+  size_t index_;
 
   EventBase event_base_;
-  size_t early_flush_marker_;
+  Event notification_event_;
   TimerEvent poll_timer_;
+  bool is_polling_frequently_{false};
   TimerEvent timestamp_delta_timer_;
   TimerEvent flush_timer_;
 
   SatelliteStreamer streamer_;
 
+  // The number of flush and shutdown requests made to the StreamRecorder as
+  // of the last poll.
+  int64_t flush_request_count_;
+  int64_t shutdown_request_count_;
+  bool shutdown_initiated_{false};
+
   std::thread thread_;
   std::atomic<bool> exit_{false};
   std::atomic<int64_t> timestamp_delta_{ComputeSystemSteadyTimestampDelta()};
 
   void Run() noexcept;
 
+  void OnNotification(FileDescriptor file_descriptor, short what) noexcept;
+
   void Poll() noexcept;
 
+  void SetPollingPeriod(bool poll_frequently) noexcept;
+
   void RefreshTimestampDelta() noexcept;
 
   void Flush() noexcept;
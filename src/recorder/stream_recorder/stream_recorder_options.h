@@ -19,22 +19,46 @@ struct StreamRecorderOptions {
   // It's meant to be used as a mode for benchmarking only.
   bool throw_away_spans = false;
 
-  // The amount of time between executions of StreamRecorder's polling callback.
-  //
-  // Note: This should be a short duration; otherwise, the recorder can hang the
-  // process when exiting.
+  // The amount of time between executions of StreamRecorder's polling callback
+  // while a thread is waiting on a flush or shutdown to complete.
   std::chrono::microseconds polling_period =
       std::chrono::duration_cast<std::chrono::microseconds>(
           std::chrono::milliseconds{1});
 
+  // The amount of time between executions of StreamRecorder's polling callback
+  // when no thread is waiting on it.
+  //
+  // Note: Flush requests, shutdown, and the span buffer filling past
+  // early_flush_threshold wake up the recorder immediately, so this only
+  // serves as a backstop.
+  std::chrono::microseconds idle_polling_period =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::seconds{1});
+
   std::chrono::microseconds timestamp_delta_period =
       std::chrono::duration_cast<std::chrono::microseconds>(
           std::chrono::milliseconds{500});
 
-  // If the span buffer fills past this fraction of its max size, then we do
-  // flush the span buffer early.
+  // If a shard of the span buffer fills past this fraction of its max size or
+  // the span buffer fills past this fraction of its byte budget
+  // (LightStepTracerOptions::max_buffered_bytes), then we flush the span
+  // buffer early.
   double early_flush_threshold = 0.5;
 
+  // The number of shards to split the span buffer into so that threads
+  // finishing spans don't contend with each other. If 0, a default based off of
+  // the hardware concurrency is used.
+  size_t num_span_buffer_shards = 0;
+
+  // If greater than 0, messages logged from the streamer threads are queued,
+  // up to this many at a time, and passed to the tracer's logger from a
+  // background thread so that a slow logger sink never stalls streaming.
+  // Messages that don't fit in the queue are dropped.
+  //
+  // Note: The queue is preallocated and the background thread is started with
+  // the recorder, so this is off (0, logging synchronously) by default.
+  size_t max_queued_log_records = 0;
+
   // Options to use when resolving satellite host names.
   DnsResolverOptions dns_resolver_options;
 
@@ -53,9 +77,88 @@ struct StreamRecorderOptions {
       std::chrono::duration_cast<std::chrono::microseconds>(
           std::chrono::seconds{5});
 
+  // If the average size of the fragments in a write to a satellite falls below
+  // this, runs of fragments no larger than max_coalesced_fragment_size are
+  // copied into a staging buffer of coalescing_buffer_size bytes so that they
+  // can be written with fewer iovecs. 0 disables coalescing.
+  int min_average_fragment_size = 512;
+  int max_coalesced_fragment_size = 512;
+  size_t coalescing_buffer_size = 1024 * 1024;
+
+  // The zlib level (1-9) to gzip the spans streamed to satellites with. 0
+  // disables compression.
+  int compression_level = 0;
+
+  // The maximum fraction of each compression_budget_period that can be spent
+  // compressing. Once it's used up, spans are stored uncompressed in the gzip
+  // stream until the next period. 0 removes the limit.
+  double max_compression_time_fraction = 0.1;
+  std::chrono::microseconds compression_budget_period =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::seconds{1});
+
+  // If greater than 0 and the kernel supports it, writes of at least this many
+  // bytes to satellite connections are sent with MSG_ZEROCOPY so that span data
+  // isn't copied into the kernel. The spans are kept alive until the kernel
+  // reports that it's done sending them; in a contiguous span buffer, they
+  // keep taking up space until then.
+  //
+  // Note: This is most effective with a contiguous span buffer since its
+  // fragments are large. Writes whose fragments get coalesced aren't sent with
+  // MSG_ZEROCOPY, and zero-copy writes aren't used with compression since it
+  // reuses the written memory right away.
+  size_t min_zero_copy_write_size = 0;
+
+  // If true and the kernel supports it, writes to satellite connections are
+  // sent with io_uring instead of writev: the writes of all the connections
+  // flushed together are submitted with one system call, and their spans are
+  // kept alive until the writes complete. If io_uring can't be set up, a
+  // warning is logged and writev is used.
+  //
+  // Note: Compressed connections still write with writev, and writes sent with
+  // io_uring aren't coalesced or sent with MSG_ZEROCOPY.
+  bool use_io_uring = false;
+
   // The number of connections to make to satellites for streaming.
   int num_satellite_connections = 8;
 
+  // If max_satellite_connections is greater than min_satellite_connections,
+  // then the number of connections starts at num_satellite_connections and is
+  // adjusted within those bounds every connection_scaling_period.
+  //
+  // Connections are added when spans back up in the span buffer while the
+  // connections spend more than max_write_blocked_fraction of their time
+  // blocked on writes. They're removed while the remaining connections would
+  // each stream fewer than min_satellite_connection_throughput bytes per
+  // second.
+  int min_satellite_connections = 0;
+  int max_satellite_connections = 0;
+  std::chrono::microseconds connection_scaling_period =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::seconds{10});
+  double max_write_blocked_fraction = 0.25;
+  size_t min_satellite_connection_throughput = 256 * 1024;
+
+  // The number of threads to stream spans to satellites from. Each thread runs
+  // its own event loop and is given a share of the satellite connections and
+  // of the span buffer's shards.
+  //
+  // Note: This is capped at the number of satellite connections and span
+  // buffer shards, and a contiguous span buffer only supports a single thread.
+  int num_streamer_threads = 1;
+
+  // If true, spans are written to the ready satellite connection with the
+  // lowest cost and new connections are made to the satellite endpoint with
+  // the lowest cost. Cost combines a moving average of how long the satellite
+  // takes to accept writes with its load: unacknowledged bytes for a
+  // connection, and the number of connections for an endpoint. Otherwise,
+  // connections are picked at random and endpoints round robin.
+  bool load_aware_satellite_selection = true;
+
+  // The weight given to each new sample in the moving average of a
+  // satellite's write latency.
+  double satellite_latency_weight = 0.3;
+
   // The amount of time to wait for a satellite connection to be writable before
   // reconnecting.
   std::chrono::microseconds satellite_write_timeout =
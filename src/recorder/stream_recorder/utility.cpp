@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iterator>
 #include <sstream>
 
@@ -39,4 +40,16 @@ SeparateEndpoints(
   }
   return {std::move(hosts), std::move(indexed_endpoints)};
 }
+
+//--------------------------------------------------------------------------------------------------
+// GetUnixSocketPath
+//--------------------------------------------------------------------------------------------------
+const char* GetUnixSocketPath(const char* host) noexcept {
+  static const char UnixSocketPrefix[] = "unix://";
+  const auto prefix_length = sizeof(UnixSocketPrefix) - 1;
+  if (std::strncmp(host, UnixSocketPrefix, prefix_length) != 0) {
+    return nullptr;
+  }
+  return host + prefix_length;
+}
 }  // namespace lightstep
@@ -15,4 +15,13 @@ namespace lightstep {
 std::pair<std::vector<const char*>, std::vector<std::pair<int, uint16_t>>>
 SeparateEndpoints(
     const std::vector<std::pair<std::string, uint16_t>>& endpoints);
+
+/**
+ * Checks whether a satellite host names a unix domain socket, i.e. has the
+ * form unix:///path/to/socket.
+ * @param host the host to check.
+ * @return the path of the socket or nullptr if host isn't a unix domain
+ * socket.
+ */
+const char* GetUnixSocketPath(const char* host) noexcept;
 }  // namespace lightstep
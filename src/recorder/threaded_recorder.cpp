@@ -0,0 +1,255 @@
+#include "recorder/threaded_recorder.h"
+
+#include <cassert>
+#include <exception>
+#include <vector>
+
+#include "common/random.h"
+#include "common/report_request_framing.h"
+#include "recorder/serialization/report_request.h"
+#include "recorder/serialization/report_request_header.h"
+
+namespace lightstep {
+// The fraction of a span buffer shard's max size past which the span buffer is
+// flushed before the end of the reporting period.
+const double EarlyFlushThreshold = 0.5;
+
+//--------------------------------------------------------------------------------------------------
+// GetMetricsObserver
+//--------------------------------------------------------------------------------------------------
+static MetricsObserver& GetMetricsObserver(
+    LightStepTracerOptions& tracer_options) {
+  if (tracer_options.metrics_observer == nullptr) {
+    tracer_options.metrics_observer.reset(new MetricsObserver{});
+  }
+  return *tracer_options.metrics_observer;
+}
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+ThreadedRecorder::ThreadedRecorder(
+    Logger& logger, LightStepTracerOptions&& options,
+    std::unique_ptr<AsyncTransporter>&& transporter)
+    : ThreadedRecorder{logger, std::move(options), std::move(transporter),
+                       std::unique_ptr<ConditionVariableWrapper>{
+                           new StandardConditionVariableWrapper{}}} {}
+
+ThreadedRecorder::ThreadedRecorder(
+    Logger& logger, LightStepTracerOptions&& options,
+    std::unique_ptr<AsyncTransporter>&& transporter,
+    std::unique_ptr<ConditionVariableWrapper>&& write_cond)
+    : logger_{logger},
+      tracer_options_{std::move(options)},
+      metrics_{GetMetricsObserver(tracer_options_)},
+      report_splitter_{std::make_shared<const std::string>(
+                           WriteReportRequestHeader(tracer_options_,
+                                                    GenerateId())),
+                       tracer_options_.max_report_spans,
+                       tracer_options_.max_report_bytes},
+      span_buffer_{tracer_options_.max_buffered_spans.value()},
+      span_buffer_budget_{tracer_options_.max_buffered_bytes},
+      write_cond_{std::move(write_cond)},
+      transporter_{std::move(transporter)} {
+  writer_ = std::thread{&ThreadedRecorder::Write, this};
+}
+
+//--------------------------------------------------------------------------------------------------
+// destructor
+//--------------------------------------------------------------------------------------------------
+ThreadedRecorder::~ThreadedRecorder() noexcept {
+  {
+    std::lock_guard<std::mutex> lock_guard{write_mutex_};
+    write_exit_ = true;
+    write_cond_->NotifyAll();
+  }
+  writer_.join();
+}
+
+//--------------------------------------------------------------------------------------------------
+// ReserveHeaderSpace
+//--------------------------------------------------------------------------------------------------
+Fragment ThreadedRecorder::ReserveHeaderSpace(ChainedStream& stream) {
+  const size_t max_header_size = ReportRequestSpansMaxHeaderSize;
+  static_assert(ChainedStream::BlockSize >= max_header_size,
+                "BockSize too small");
+  void* data;
+  int size;
+  if (!stream.Next(&data, &size)) {
+    throw std::bad_alloc{};
+  }
+  stream.BackUp(size - static_cast<int>(max_header_size));
+  return {data, static_cast<int>(max_header_size)};
+}
+
+//--------------------------------------------------------------------------------------------------
+// RecordSpan
+//--------------------------------------------------------------------------------------------------
+void ThreadedRecorder::RecordSpan(
+    Fragment header_fragment, std::unique_ptr<ChainedStream>&& span) noexcept {
+  // Frame the Span
+  auto header_data = static_cast<char*>(header_fragment.first);
+  auto reserved_header_size = static_cast<size_t>(header_fragment.second);
+  auto protobuf_body_size = span->ByteCount() - header_fragment.second;
+  auto protobuf_header_size = WriteReportRequestSpansHeader(
+      header_data, reserved_header_size, protobuf_body_size);
+  span->CloseOutput();
+
+  // Advance past reserved header space we didn't use.
+  span->Seek(0, static_cast<int>(reserved_header_size - protobuf_header_size));
+
+  auto num_bytes = static_cast<size_t>(span->ByteCount());
+  if (span_buffer_budget_.Reserve(num_bytes)) {
+    auto shard = span_buffer_.AddToShard(span);
+    if (shard != nullptr) {
+      return NotifyIfPastEarlyFlushThreshold(shard);
+    }
+    span_buffer_budget_.Release(num_bytes);
+  }
+  if (static_cast<int>(logger_.level()) <= static_cast<int>(LogLevel::debug)) {
+    static LogRateLimiter rate_limiter;
+    logger_.Debug(rate_limiter, "Dropping span");
+  }
+  metrics_.OnSpansDropped(1);
+  metrics_.OnBytesDropped(num_bytes);
+  span.reset();
+  NotifyIfPastEarlyFlushThreshold(nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// FlushWithTimeout
+//--------------------------------------------------------------------------------------------------
+bool ThreadedRecorder::FlushWithTimeout(
+    std::chrono::system_clock::duration timeout) noexcept try {
+  std::unique_lock<std::mutex> lock{write_mutex_};
+  if (write_exit_) {
+    return false;
+  }
+  auto flush_request = ++num_flush_requests_;
+  write_cond_->NotifyAll();
+  auto result = write_cond_->WaitFor(lock, timeout, [&] {
+    return write_exit_ || (num_flushes_ >= flush_request &&
+                           num_reports_completed_ >= flushed_reports_marker_);
+  });
+  return result && !write_exit_;
+} catch (const std::exception& e) {
+  logger_.Error("Failed to flush recorder: ", e.what());
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnSuccess
+//--------------------------------------------------------------------------------------------------
+void ThreadedRecorder::OnSuccess(BufferChain& message) noexcept {
+  auto report_request = dynamic_cast<ReportRequest*>(&message);
+  assert(report_request != nullptr);
+  if (report_request != nullptr) {
+    metrics_.OnSpansSent(report_request->num_spans());
+  }
+  OnReportCompleted();
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnFailure
+//--------------------------------------------------------------------------------------------------
+void ThreadedRecorder::OnFailure(BufferChain& message) noexcept {
+  auto report_request = dynamic_cast<ReportRequest*>(&message);
+  assert(report_request != nullptr);
+  if (report_request != nullptr) {
+    metrics_.OnSpansDropped(report_request->num_spans());
+    metrics_.OnBytesDropped(report_request->num_bytes());
+    metrics_.UnconsumeDroppedSpans(report_request->num_dropped_spans());
+  }
+  OnReportCompleted();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Write
+//--------------------------------------------------------------------------------------------------
+void ThreadedRecorder::Write() noexcept {
+  auto next = write_cond_->Now() + tracer_options_.reporting_period;
+  uint64_t flush_request;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{write_mutex_};
+      write_cond_->WaitUntil(lock, next, [this] {
+        return write_exit_ || num_flush_requests_ > num_flushes_ ||
+               early_flush_pending_.load(std::memory_order_relaxed);
+      });
+      if (write_exit_) {
+        return;
+      }
+      flush_request = num_flush_requests_;
+    }
+    early_flush_pending_.store(false, std::memory_order_relaxed);
+
+    FlushOne();
+
+    {
+      std::lock_guard<std::mutex> lock_guard{write_mutex_};
+      num_flushes_ = flush_request;
+      flushed_reports_marker_ = num_reports_sent_;
+      write_cond_->NotifyAll();
+    }
+
+    auto now = write_cond_->Now();
+    if (now >= next) {
+      next = now + tracer_options_.reporting_period;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// FlushOne
+//--------------------------------------------------------------------------------------------------
+void ThreadedRecorder::FlushOne() noexcept try {
+  auto num_dropped_spans = metrics_.ConsumeDroppedSpans();
+  if (span_buffer_.empty() && num_dropped_spans == 0) {
+    return;
+  }
+  std::vector<std::unique_ptr<ReportRequest>> reports;
+  report_splitter_.Split(num_dropped_spans, span_buffer_, span_buffer_budget_,
+                         reports, metrics_);
+  {
+    std::lock_guard<std::mutex> lock_guard{write_mutex_};
+    num_reports_sent_ += reports.size();
+  }
+  metrics_.OnFlush();
+  for (auto& report_request : reports) {
+    transporter_->Send(std::unique_ptr<BufferChain>{report_request.release()},
+                       *this);
+  }
+} catch (const std::exception& e) {
+  logger_.Error("Failed to flush report: ", e.what());
+}
+
+//--------------------------------------------------------------------------------------------------
+// OnReportCompleted
+//--------------------------------------------------------------------------------------------------
+void ThreadedRecorder::OnReportCompleted() noexcept {
+  std::lock_guard<std::mutex> lock_guard{write_mutex_};
+  ++num_reports_completed_;
+  write_cond_->NotifyAll();
+}
+
+//--------------------------------------------------------------------------------------------------
+// NotifyIfPastEarlyFlushThreshold
+//--------------------------------------------------------------------------------------------------
+void ThreadedRecorder::NotifyIfPastEarlyFlushThreshold(
+    const CircularBuffer<ChainedStream>* shard) noexcept {
+  // Only the fill level of the shard the span was added to is checked so that
+  // recording spans doesn't pull in the counters of every other shard. If the
+  // span was dropped instead, the buffer is already full.
+  if (early_flush_pending_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (shard != nullptr && static_cast<double>(shard->size()) <
+                              static_cast<double>(shard->max_size()) *
+                                  EarlyFlushThreshold) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock_guard{write_mutex_};
+  early_flush_pending_.store(true, std::memory_order_relaxed);
+  write_cond_->NotifyAll();
+}
+}  // namespace lightstep
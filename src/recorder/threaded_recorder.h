@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common/byte_budget.h"
+#include "common/condition_variable_wrapper.h"
+#include "common/logger.h"
+#include "common/noncopyable.h"
+#include "common/sharded_circular_buffer.h"
+#include "lightstep/transporter.h"
+#include "recorder/metrics_tracker.h"
+#include "recorder/recorder.h"
+#include "recorder/report_splitter.h"
+
+namespace lightstep {
+/**
+ * A Recorder that buffers serialized spans and sends them as ReportRequests
+ * from a background thread every reporting period.
+ *
+ * Recording threads only add spans to a sharded buffer, so they never wait on
+ * the background thread or the transporter.
+ */
+class ThreadedRecorder final : public Recorder,
+                               public AsyncTransporter::Callback,
+                               private Noncopyable {
+ public:
+  ThreadedRecorder(Logger& logger, LightStepTracerOptions&& options,
+                   std::unique_ptr<AsyncTransporter>&& transporter);
+
+  ThreadedRecorder(Logger& logger, LightStepTracerOptions&& options,
+                   std::unique_ptr<AsyncTransporter>&& transporter,
+                   std::unique_ptr<ConditionVariableWrapper>&& write_cond);
+
+  ~ThreadedRecorder() noexcept override;
+
+  // Recorder
+  Fragment ReserveHeaderSpace(ChainedStream& stream) override;
+
+  void RecordSpan(Fragment header_fragment,
+                  std::unique_ptr<ChainedStream>&& span) noexcept override;
+
+  bool FlushWithTimeout(
+      std::chrono::system_clock::duration timeout) noexcept override;
+
+  // AsyncTransporter::Callback
+  void OnSuccess(BufferChain& message) noexcept override;
+
+  void OnFailure(BufferChain& message) noexcept override;
+
+ private:
+  Logger& logger_;
+  LightStepTracerOptions tracer_options_;
+
+  MetricsTracker metrics_;
+  ReportSplitter report_splitter_;
+  ShardedCircularBuffer<ChainedStream> span_buffer_;
+  ByteBudget span_buffer_budget_;
+  std::atomic<bool> early_flush_pending_{false};
+
+  // Writer state.
+  std::mutex write_mutex_;
+  std::unique_ptr<ConditionVariableWrapper> write_cond_;
+  bool write_exit_{false};
+  uint64_t num_flush_requests_{0};
+  uint64_t num_flushes_{0};
+  uint64_t num_reports_sent_{0};
+  uint64_t num_reports_completed_{0};
+  uint64_t flushed_reports_marker_{0};
+  std::thread writer_;
+
+  // Declared last so that it's destroyed, and finishes calling back into the
+  // recorder for any outstanding reports, before the rest of the recorder.
+  std::unique_ptr<AsyncTransporter> transporter_;
+
+  void Write() noexcept;
+
+  void FlushOne() noexcept;
+
+  void OnReportCompleted() noexcept;
+
+  void NotifyIfPastEarlyFlushThreshold(
+      const CircularBuffer<ChainedStream>* shard) noexcept;
+};
+}  // namespace lightstep
@@ -17,8 +17,13 @@ struct CountingMetricsObserver : MetricsObserver {
 
   void OnFlush() noexcept override { ++num_flushes; }
 
+  void OnBytesDropped(size_t num_bytes) noexcept override {
+    num_bytes_dropped += num_bytes;
+  }
+
   std::atomic<int> num_flushes{0};
   std::atomic<int> num_spans_sent{0};
   std::atomic<int> num_spans_dropped{0};
+  std::atomic<size_t> num_bytes_dropped{0};
 };
 }  // namespace lightstep
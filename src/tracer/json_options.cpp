@@ -55,6 +55,26 @@ static PropagationMode GetPropagationMode(opentracing::string_view s) {
   throw std::runtime_error{oss.str()};
 }
 
+//--------------------------------------------------------------------------------------------------
+// MakeSampler
+//--------------------------------------------------------------------------------------------------
+static std::unique_ptr<Sampler> MakeSampler(
+    const tracer_configuration::Sampler& sampler) {
+  const auto& type = sampler.type();
+  if (type == "trace_id_ratio") {
+    return MakeTraceIdRatioSampler(sampler.ratio());
+  }
+  if (type == "rate_limiting") {
+    return MakeRateLimitingSampler(sampler.spans_per_second());
+  }
+  if (type == "adaptive") {
+    return MakeAdaptiveSampler(sampler.spans_per_second());
+  }
+  std::ostringstream oss;
+  oss << "invalid sampler type " << type;
+  throw std::runtime_error{oss.str()};
+}
+
 //--------------------------------------------------------------------------------------------------
 // MakeTracerOptions
 //--------------------------------------------------------------------------------------------------
@@ -85,6 +105,9 @@ opentracing::expected<LightStepTracerOptions> MakeTracerOptions(
     options.max_buffered_spans = tracer_configuration.max_buffered_spans();
   }
 
+  options.max_buffered_bytes =
+      static_cast<size_t>(tracer_configuration.max_buffered_bytes());
+
   if (tracer_configuration.reporting_period() != 0) {
     options.reporting_period =
         std::chrono::microseconds{tracer_configuration.reporting_period()};
@@ -95,7 +118,18 @@ opentracing::expected<LightStepTracerOptions> MakeTracerOptions(
         std::chrono::microseconds{tracer_configuration.report_timeout()};
   }
 
+  if (tracer_configuration.max_concurrent_reports() != 0) {
+    options.max_concurrent_reports =
+        tracer_configuration.max_concurrent_reports();
+  }
+
+  options.max_report_spans = tracer_configuration.max_report_spans();
+  options.max_report_bytes =
+      static_cast<size_t>(tracer_configuration.max_report_bytes());
+
   options.use_stream_recorder = tracer_configuration.use_stream_recorder();
+  options.use_contiguous_span_buffer =
+      tracer_configuration.use_contiguous_span_buffer();
 
   options.satellite_endpoints = GetSatelliteEndpoints(tracer_configuration);
 
@@ -111,6 +145,10 @@ opentracing::expected<LightStepTracerOptions> MakeTracerOptions(
     options.tags.emplace(tag.first, tag.second);
   }
 
+  if (tracer_configuration.has_sampler()) {
+    options.sampler = MakeSampler(tracer_configuration.sampler());
+  }
+
   return options;
 } catch (const std::exception& e) {
   std::cerr << "Invalid options: " << e.what() << "\n";
@@ -11,14 +11,31 @@ using opentracing::SystemClock;
 using opentracing::SystemTime;
 
 namespace lightstep {
+const size_t LegacySpan::InitialArenaBlockSize;
+
+//------------------------------------------------------------------------------
+// MakeArenaOptions
+//------------------------------------------------------------------------------
+static google::protobuf::ArenaOptions MakeArenaOptions(char* initial_block,
+                                                       size_t size) noexcept {
+  google::protobuf::ArenaOptions result;
+  result.initial_block = initial_block;
+  result.initial_block_size = size;
+  return result;
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 LegacySpan::LegacySpan(std::shared_ptr<const opentracing::Tracer>&& tracer,
-                       Logger& logger, Recorder& recorder,
+                       Logger& logger, Recorder& recorder, Sampler* sampler,
                        opentracing::string_view operation_name,
                        const opentracing::StartSpanOptions& options)
-    : tracer_{std::move(tracer)}, logger_{logger}, recorder_{recorder} {
+    : arena_{MakeArenaOptions(initial_arena_block_, InitialArenaBlockSize)},
+      span_{*google::protobuf::Arena::CreateMessage<collector::Span>(&arena_)},
+      tracer_{std::move(tracer)},
+      logger_{logger},
+      recorder_{recorder} {
   span_.set_operation_name(operation_name.data(), operation_name.size());
   auto& span_context = *span_.mutable_span_context();
   auto& baggage = *span_context.mutable_baggage();
@@ -50,16 +67,21 @@ LegacySpan::LegacySpan(std::shared_ptr<const opentracing::Tracer>&& tracer,
   }
 
   // If there are any span references, sampled should be true if any of the
-  // references are sampled; with no refences, we set sampled to true.
+  // references are sampled; with no refences, the sampler decides.
   if (references.empty()) {
-    trace_flags_ = SetTraceFlag<SampledFlagMask>(trace_flags_, true);
+    trace_id_high_ = 0;
+    span_context.set_trace_id(GenerateId());
+    trace_flags_ = SetTraceFlag<SampledFlagMask>(
+        trace_flags_,
+        sampler == nullptr ||
+            sampler->ShouldSample(span_context.trace_id(), operation_name));
   }
 
   // Set tags.
   auto& tags = *span_.mutable_tags();
   tags.Reserve(static_cast<int>(options.tags.size()));
   for (auto& tag : options.tags) {
-    *tags.Add() = ToKeyValue(tag.first, tag.second);
+    SetKeyValue(*tags.Add(), tag.first, tag.second);
 
     // If sampling_priority is set, it overrides whatever sampling decision was
     // derived from the referenced spans.
@@ -70,10 +92,6 @@ LegacySpan::LegacySpan(std::shared_ptr<const opentracing::Tracer>&& tracer,
   }
 
   // Set opentracing::SpanContext.
-  if (references.empty()) {
-    trace_id_high_ = 0;
-    span_context.set_trace_id(GenerateId());
-  }
   span_context.set_span_id(GenerateId());
 }
 
@@ -145,7 +163,7 @@ void LegacySpan::SetOperationName(opentracing::string_view name) noexcept try {
 void LegacySpan::SetTag(opentracing::string_view key,
                         const opentracing::Value& value) noexcept try {
   std::lock_guard<std::mutex> lock_guard{mutex_};
-  *span_.mutable_tags()->Add() = ToKeyValue(key, value);
+  SetKeyValue(*span_.mutable_tags()->Add(), key, value);
 
   if (key == SamplingPriorityKey) {
     trace_flags_ =
@@ -195,8 +213,8 @@ void LegacySpan::Log(std::initializer_list<
                          fields) noexcept try {
   auto timestamp = SystemClock::now();
   std::lock_guard<std::mutex> lock_guard{mutex_};
-  *span_.mutable_logs()->Add() =
-      ToLog(timestamp, std::begin(fields), std::end(fields));
+  SetLog(*span_.mutable_logs()->Add(), timestamp, std::begin(fields),
+         std::end(fields));
 } catch (const std::exception& e) {
   logger_.Error("Log failed: ", e.what());
 }
@@ -9,13 +9,14 @@
 #include "recorder/recorder.h"
 #include "tracer/lightstep_span_context.h"
 
+#include <google/protobuf/arena.h>
 #include <opentracing/span.h>
 
 namespace lightstep {
-class LegacySpan final : public opentracing::Span, public LightStepSpanContext {
+class LegacySpan final : public LightStepSpan, public LightStepSpanContext {
  public:
   LegacySpan(std::shared_ptr<const opentracing::Tracer>&& tracer,
-             Logger& logger, Recorder& recorder,
+             Logger& logger, Recorder& recorder, Sampler* sampler,
              opentracing::string_view operation_name,
              const opentracing::StartSpanOptions& options);
 
@@ -34,6 +35,14 @@ class LegacySpan final : public opentracing::Span, public LightStepSpanContext {
   void SetTag(opentracing::string_view key,
               const opentracing::Value& value) noexcept override;
 
+  using LightStepSpan::Log;
+  using LightStepSpan::SetTag;
+
+  void SetTag(const TagKeyHandle& key,
+              const opentracing::Value& value) noexcept override {
+    SetTag(key.value(), value);
+  }
+
   void SetBaggageItem(opentracing::string_view restricted_key,
                       opentracing::string_view value) noexcept override;
 
@@ -89,11 +98,69 @@ class LegacySpan final : public opentracing::Span, public LightStepSpanContext {
     return this->InjectImpl(propagation_options, writer);
   }
 
+ protected:
+  // LightStepSpan
+  //
+  // Legacy spans are stored as protobuf messages, so typed values are
+  // converted to opentracing::Values.
+  void SetTypedTag(opentracing::string_view key,
+                   const TagKeyHandle* /*key_handle*/,
+                   bool value) noexcept override {
+    SetTag(key, opentracing::Value{value});
+  }
+
+  void SetTypedTag(opentracing::string_view key,
+                   const TagKeyHandle* /*key_handle*/,
+                   int64_t value) noexcept override {
+    SetTag(key, opentracing::Value{value});
+  }
+
+  void SetTypedTag(opentracing::string_view key,
+                   const TagKeyHandle* /*key_handle*/,
+                   double value) noexcept override {
+    SetTag(key, opentracing::Value{value});
+  }
+
+  void SetTypedTag(opentracing::string_view key,
+                   const TagKeyHandle* /*key_handle*/,
+                   opentracing::string_view value) noexcept override {
+    SetTag(key, opentracing::Value{value});
+  }
+
+  void LogTypedField(opentracing::string_view key,
+                     bool value) noexcept override {
+    Log({{key, value}});
+  }
+
+  void LogTypedField(opentracing::string_view key,
+                     int64_t value) noexcept override {
+    Log({{key, value}});
+  }
+
+  void LogTypedField(opentracing::string_view key,
+                     double value) noexcept override {
+    Log({{key, value}});
+  }
+
+  void LogTypedField(opentracing::string_view key,
+                     opentracing::string_view value) noexcept override {
+    Log({{key, value}});
+  }
+
  private:
+  // The size of the arena block stored inline in the span.
+  static const size_t InitialArenaBlockSize = 1024;
+
   // Fields set in StartSpan() are not protected by a mutex.
   uint64_t trace_id_high_{0};
   uint8_t trace_flags_;
-  collector::Span span_;
+
+  // The protobuf span and all of its tags and logs are allocated on arena_,
+  // whose first block is stored inline, so that building a span rarely calls
+  // malloc and destroying it frees everything at once.
+  alignas(8) char initial_arena_block_[InitialArenaBlockSize];
+  google::protobuf::Arena arena_;
+  collector::Span& span_;
   std::string trace_state_;
   std::chrono::steady_clock::time_point start_steady_;
   mutable std::mutex mutex_;
@@ -53,17 +53,21 @@ opentracing::expected<std::unique_ptr<opentracing::SpanContext>> ExtractImpl(
 //------------------------------------------------------------------------------
 LegacyTracerImpl::LegacyTracerImpl(
     PropagationOptions&& propagation_options,
-    std::unique_ptr<Recorder>&& recorder) noexcept
+    std::unique_ptr<Recorder>&& recorder,
+    std::unique_ptr<Sampler>&& sampler) noexcept
     : logger_{std::make_shared<Logger>()},
       propagation_options_{std::move(propagation_options)},
-      recorder_{std::move(recorder)} {}
+      recorder_{std::move(recorder)},
+      sampler_{std::move(sampler)} {}
 
 LegacyTracerImpl::LegacyTracerImpl(
     std::shared_ptr<Logger> logger, PropagationOptions&& propagation_options,
-    std::unique_ptr<Recorder>&& recorder) noexcept
+    std::unique_ptr<Recorder>&& recorder,
+    std::unique_ptr<Sampler>&& sampler) noexcept
     : logger_{std::move(logger)},
       propagation_options_{std::move(propagation_options)},
-      recorder_{std::move(recorder)} {}
+      recorder_{std::move(recorder)},
+      sampler_{std::move(sampler)} {}
 
 //------------------------------------------------------------------------------
 // StartSpanWithOptions
@@ -72,7 +76,19 @@ std::unique_ptr<opentracing::Span> LegacyTracerImpl::StartSpanWithOptions(
     opentracing::string_view operation_name,
     const opentracing::StartSpanOptions& options) const noexcept try {
   return std::unique_ptr<opentracing::Span>{new LegacySpan{
-      shared_from_this(), *logger_, *recorder_, operation_name, options}};
+      shared_from_this(), *logger_, *recorder_, sampler_.get(), operation_name,
+      options}};
+} catch (const std::exception& e) {
+  logger_->Error("StartSpanWithOptions failed: ", e.what());
+  return nullptr;
+}
+
+std::unique_ptr<LightStepSpan> LegacyTracerImpl::StartSpanWithOptions(
+    const OperationNameHandle& operation_name,
+    const opentracing::StartSpanOptions& options) const noexcept try {
+  return std::unique_ptr<LightStepSpan>{new LegacySpan{
+      shared_from_this(), *logger_, *recorder_, sampler_.get(),
+      operation_name.value(), options}};
 } catch (const std::exception& e) {
   logger_->Error("StartSpanWithOptions failed: ", e.what());
   return nullptr;
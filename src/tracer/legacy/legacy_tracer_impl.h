@@ -12,16 +12,22 @@ class LegacyTracerImpl final
       public std::enable_shared_from_this<LegacyTracerImpl> {
  public:
   LegacyTracerImpl(PropagationOptions&& propagation_options,
-                   std::unique_ptr<Recorder>&& recorder) noexcept;
+                   std::unique_ptr<Recorder>&& recorder,
+                   std::unique_ptr<Sampler>&& sampler = nullptr) noexcept;
 
   LegacyTracerImpl(std::shared_ptr<Logger> logger,
                    PropagationOptions&& propagation_options,
-                   std::unique_ptr<Recorder>&& recorder) noexcept;
+                   std::unique_ptr<Recorder>&& recorder,
+                   std::unique_ptr<Sampler>&& sampler = nullptr) noexcept;
 
   std::unique_ptr<opentracing::Span> StartSpanWithOptions(
       opentracing::string_view operation_name,
       const opentracing::StartSpanOptions& options) const noexcept override;
 
+  std::unique_ptr<LightStepSpan> StartSpanWithOptions(
+      const OperationNameHandle& operation_name,
+      const opentracing::StartSpanOptions& options) const noexcept override;
+
   opentracing::expected<void> Inject(
       const opentracing::SpanContext& span_context,
       std::ostream& writer) const override;
@@ -54,5 +60,6 @@ class LegacyTracerImpl final
   std::shared_ptr<Logger> logger_;
   PropagationOptions propagation_options_;
   std::unique_ptr<Recorder> recorder_;
+  std::unique_ptr<Sampler> sampler_;
 };
 }  // namespace lightstep
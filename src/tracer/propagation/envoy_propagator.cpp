@@ -1,5 +1,7 @@
 #include "tracer/propagation/envoy_propagator.h"
 
+#include <sstream>
+
 #include <lightstep/base64/base64.h>
 
 #include "common/in_memory_stream.h"
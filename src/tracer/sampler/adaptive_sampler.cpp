@@ -0,0 +1,80 @@
+#include "tracer/sampler/adaptive_sampler.h"
+
+#include <algorithm>
+
+#include "tracer/sampler/trace_id_ratio_sampler.h"
+
+namespace lightstep {
+const std::chrono::steady_clock::duration AdaptiveSampler::AdjustmentPeriod =
+    std::chrono::seconds{1};
+
+// The weight given to the latest period when updating the estimated rate of
+// traces.
+const double RateSmoothingFactor = 0.5;
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+AdaptiveSampler::AdaptiveSampler(
+    double spans_per_second, std::chrono::steady_clock::time_point now) noexcept
+    : spans_per_second_{std::max(spans_per_second, 0.0)},
+      threshold_{ComputeTraceIdThreshold(spans_per_second_ > 0 ? 1.0 : 0.0)},
+      period_end_{(now + AdjustmentPeriod).time_since_epoch().count()},
+      token_bucket_{spans_per_second_,
+                    spans_per_second_ > 0 ? std::max(spans_per_second_, 1.0)
+                                          : 0.0,
+                    now} {}
+
+//--------------------------------------------------------------------------------------------------
+// ShouldSample
+//--------------------------------------------------------------------------------------------------
+bool AdaptiveSampler::ShouldSample(
+    uint64_t trace_id, std::chrono::steady_clock::time_point now) noexcept {
+  num_traces_.fetch_add(1, std::memory_order_relaxed);
+
+  auto now_count = now.time_since_epoch().count();
+  auto period_end = period_end_.load(std::memory_order_acquire);
+  if (now_count >= period_end &&
+      period_end_.compare_exchange_strong(
+          period_end, (now + AdjustmentPeriod).time_since_epoch().count(),
+          std::memory_order_acq_rel)) {
+    Adjust(AdjustmentPeriod +
+           std::chrono::steady_clock::duration{now_count - period_end});
+  }
+
+  if (!IsTraceIdSampled(trace_id, threshold_.load(std::memory_order_relaxed))) {
+    return false;
+  }
+  SpinLockGuard lock_guard{mutex_};
+  return token_bucket_.Consume(now);
+}
+
+//--------------------------------------------------------------------------------------------------
+// ratio
+//--------------------------------------------------------------------------------------------------
+double AdaptiveSampler::ratio() const noexcept {
+  return static_cast<double>(threshold_.load(std::memory_order_relaxed)) /
+         static_cast<double>(ComputeTraceIdThreshold(1.0));
+}
+
+//--------------------------------------------------------------------------------------------------
+// Adjust
+//--------------------------------------------------------------------------------------------------
+void AdaptiveSampler::Adjust(
+    std::chrono::steady_clock::duration elapsed) noexcept {
+  auto num_traces = num_traces_.exchange(0, std::memory_order_relaxed);
+  auto rate = static_cast<double>(num_traces) /
+              std::chrono::duration<double>{elapsed}.count();
+  if (traces_per_second_ == 0) {
+    traces_per_second_ = rate;
+  } else {
+    traces_per_second_ = RateSmoothingFactor * rate +
+                         (1.0 - RateSmoothingFactor) * traces_per_second_;
+  }
+  auto ratio = 1.0;
+  if (traces_per_second_ > spans_per_second_) {
+    ratio = spans_per_second_ / traces_per_second_;
+  }
+  threshold_.store(ComputeTraceIdThreshold(ratio), std::memory_order_relaxed);
+}
+}  // namespace lightstep
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "common/spin_lock_mutex.h"
+#include "lightstep/sampler.h"
+#include "tracer/sampler/token_bucket.h"
+
+namespace lightstep {
+/**
+ * Samples a fraction of traces chosen to meet a target rate of sampled traces.
+ *
+ * Every AdjustmentPeriod, the fraction is recomputed from a smoothed estimate
+ * of the rate of new traces. Traces selected by trace id additionally need a
+ * token from a bucket refilled at the target rate so that bursts between
+ * adjustments don't overshoot the budget.
+ */
+class AdaptiveSampler final : public Sampler {
+ public:
+  static const std::chrono::steady_clock::duration AdjustmentPeriod;
+
+  AdaptiveSampler(double spans_per_second,
+                  std::chrono::steady_clock::time_point now) noexcept;
+
+  explicit AdaptiveSampler(double spans_per_second) noexcept
+      : AdaptiveSampler{spans_per_second, std::chrono::steady_clock::now()} {}
+
+  /**
+   * Decide whether to sample a trace.
+   * @param trace_id the id of the trace
+   * @param now the current time
+   * @return true if the trace should be sampled
+   */
+  bool ShouldSample(uint64_t trace_id,
+                    std::chrono::steady_clock::time_point now) noexcept;
+
+  /**
+   * @return the fraction of traces currently selected by trace id.
+   */
+  double ratio() const noexcept;
+
+  // Sampler
+  bool ShouldSample(
+      uint64_t trace_id,
+      opentracing::string_view /*operation_name*/) noexcept override {
+    return this->ShouldSample(trace_id, std::chrono::steady_clock::now());
+  }
+
+ private:
+  double spans_per_second_;
+
+  std::atomic<uint64_t> threshold_;
+  std::atomic<uint64_t> num_traces_{0};
+
+  // The end of the current adjustment period. Whichever thread advances it
+  // recomputes the threshold, so traces_per_second_ is only accessed by one
+  // thread at a time.
+  std::atomic<int64_t> period_end_;
+  double traces_per_second_{0};
+
+  SpinLockMutex mutex_;
+  TokenBucket token_bucket_;
+
+  void Adjust(std::chrono::steady_clock::duration elapsed) noexcept;
+};
+}  // namespace lightstep
@@ -0,0 +1,51 @@
+#include "tracer/sampler/rate_limiting_sampler.h"
+
+#include <algorithm>
+
+namespace lightstep {
+const size_t RateLimitingSampler::MaxOperations;
+
+//--------------------------------------------------------------------------------------------------
+// HashOperationName
+//--------------------------------------------------------------------------------------------------
+static uint64_t HashOperationName(opentracing::string_view s) noexcept {
+  // Uses FNV-1a. See http://www.isthe.com/chongo/tech/comp/fnv/
+  uint64_t result = 14695981039346656037ull;
+  for (auto c : s) {
+    result ^= static_cast<unsigned char>(c);
+    result *= 1099511628211ull;
+  }
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+RateLimitingSampler::RateLimitingSampler(double spans_per_second) noexcept
+    : spans_per_second_{std::max(spans_per_second, 0.0)},
+      max_burst_{spans_per_second_ > 0 ? std::max(spans_per_second_, 1.0)
+                                       : 0.0},
+      overflow_bucket_{spans_per_second_, max_burst_,
+                       std::chrono::steady_clock::now()} {}
+
+//--------------------------------------------------------------------------------------------------
+// ShouldSample
+//--------------------------------------------------------------------------------------------------
+bool RateLimitingSampler::ShouldSample(
+    opentracing::string_view operation_name,
+    std::chrono::steady_clock::time_point now) noexcept try {
+  auto hash = HashOperationName(operation_name);
+  SpinLockGuard lock_guard{mutex_};
+  auto iter = buckets_.find(hash);
+  if (iter != buckets_.end()) {
+    return iter->second.Consume(now);
+  }
+  if (buckets_.size() >= MaxOperations) {
+    return overflow_bucket_.Consume(now);
+  }
+  return buckets_.emplace(hash, TokenBucket{spans_per_second_, max_burst_, now})
+      .first->second.Consume(now);
+} catch (const std::exception& /*e*/) {
+  return false;
+}
+}  // namespace lightstep
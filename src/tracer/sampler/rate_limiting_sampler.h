@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+#include "common/spin_lock_mutex.h"
+#include "lightstep/sampler.h"
+#include "tracer/sampler/token_bucket.h"
+
+namespace lightstep {
+/**
+ * Samples at most a fixed number of traces per second for each root operation.
+ */
+class RateLimitingSampler final : public Sampler {
+ public:
+  // The maximum number of operations tracked separately. Operations beyond
+  // this share a single token bucket.
+  static const size_t MaxOperations = 1000;
+
+  explicit RateLimitingSampler(double spans_per_second) noexcept;
+
+  /**
+   * Decide whether to sample a trace.
+   * @param operation_name the root operation of the trace
+   * @param now the current time
+   * @return true if the trace should be sampled
+   */
+  bool ShouldSample(opentracing::string_view operation_name,
+                    std::chrono::steady_clock::time_point now) noexcept;
+
+  // Sampler
+  bool ShouldSample(
+      uint64_t /*trace_id*/,
+      opentracing::string_view operation_name) noexcept override {
+    return this->ShouldSample(operation_name,
+                              std::chrono::steady_clock::now());
+  }
+
+ private:
+  double spans_per_second_;
+  double max_burst_;
+
+  SpinLockMutex mutex_;
+
+  // Buckets are keyed by a hash of the operation name so that looking them up
+  // doesn't allocate. Operations with colliding hashes share a bucket.
+  std::unordered_map<uint64_t, TokenBucket> buckets_;
+  TokenBucket overflow_bucket_;
+};
+}  // namespace lightstep
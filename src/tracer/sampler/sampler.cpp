@@ -0,0 +1,28 @@
+#include "lightstep/sampler.h"
+
+#include "tracer/sampler/adaptive_sampler.h"
+#include "tracer/sampler/rate_limiting_sampler.h"
+#include "tracer/sampler/trace_id_ratio_sampler.h"
+
+namespace lightstep {
+//--------------------------------------------------------------------------------------------------
+// MakeTraceIdRatioSampler
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<Sampler> MakeTraceIdRatioSampler(double ratio) {
+  return std::unique_ptr<Sampler>{new TraceIdRatioSampler{ratio}};
+}
+
+//--------------------------------------------------------------------------------------------------
+// MakeRateLimitingSampler
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<Sampler> MakeRateLimitingSampler(double spans_per_second) {
+  return std::unique_ptr<Sampler>{new RateLimitingSampler{spans_per_second}};
+}
+
+//--------------------------------------------------------------------------------------------------
+// MakeAdaptiveSampler
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<Sampler> MakeAdaptiveSampler(double spans_per_second) {
+  return std::unique_ptr<Sampler>{new AdaptiveSampler{spans_per_second}};
+}
+}  // namespace lightstep
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+namespace lightstep {
+/**
+ * Limits the rate of events using the token bucket algorithm.
+ *
+ * Note: TokenBucket isn't thread-safe.
+ */
+class TokenBucket {
+ public:
+  /**
+   * @param tokens_per_second the rate at which tokens are added
+   * @param max_tokens the maximum number of tokens the bucket can hold
+   * @param now the current time
+   */
+  TokenBucket(double tokens_per_second, double max_tokens,
+              std::chrono::steady_clock::time_point now) noexcept
+      : tokens_per_second_{tokens_per_second},
+        max_tokens_{max_tokens},
+        tokens_{max_tokens},
+        last_refill_timestamp_{now} {}
+
+  /**
+   * Try to take a token from the bucket.
+   * @param now the current time
+   * @return true if a token was available
+   */
+  bool Consume(std::chrono::steady_clock::time_point now) noexcept {
+    if (now > last_refill_timestamp_) {
+      auto elapsed =
+          std::chrono::duration<double>{now - last_refill_timestamp_}.count();
+      tokens_ = std::min(max_tokens_, tokens_ + elapsed * tokens_per_second_);
+      last_refill_timestamp_ = now;
+    }
+    if (tokens_ < 1.0) {
+      return false;
+    }
+    tokens_ -= 1.0;
+    return true;
+  }
+
+ private:
+  double tokens_per_second_;
+  double max_tokens_;
+  double tokens_;
+  std::chrono::steady_clock::time_point last_refill_timestamp_;
+};
+}  // namespace lightstep
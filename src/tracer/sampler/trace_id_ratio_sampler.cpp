@@ -0,0 +1,25 @@
+#include "tracer/sampler/trace_id_ratio_sampler.h"
+
+#include <algorithm>
+
+namespace lightstep {
+// 2^53
+const double MaxTraceIdThreshold = 9007199254740992.0;
+
+//--------------------------------------------------------------------------------------------------
+// ComputeTraceIdThreshold
+//--------------------------------------------------------------------------------------------------
+uint64_t ComputeTraceIdThreshold(double ratio) noexcept {
+  // Note: The comparisons are written so that NaN maps to 0.
+  if (!(ratio > 0.0)) {
+    return 0;
+  }
+  return static_cast<uint64_t>(std::min(ratio, 1.0) * MaxTraceIdThreshold);
+}
+
+//--------------------------------------------------------------------------------------------------
+// constructor
+//--------------------------------------------------------------------------------------------------
+TraceIdRatioSampler::TraceIdRatioSampler(double ratio) noexcept
+    : threshold_{ComputeTraceIdThreshold(ratio)} {}
+}  // namespace lightstep
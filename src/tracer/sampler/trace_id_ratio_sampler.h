@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lightstep/sampler.h"
+
+namespace lightstep {
+/**
+ * Compute the threshold used by IsTraceIdSampled for a sampling ratio.
+ * @param ratio the fraction of traces to sample
+ * @return the threshold
+ */
+uint64_t ComputeTraceIdThreshold(double ratio) noexcept;
+
+/**
+ * @param trace_id the trace id to sample
+ * @param threshold a threshold computed by ComputeTraceIdThreshold
+ * @return true if the trace should be sampled
+ */
+inline bool IsTraceIdSampled(uint64_t trace_id, uint64_t threshold) noexcept {
+  // Only use the high 53 bits so that the threshold can be computed exactly
+  // from a double.
+  return (trace_id >> 11) < threshold;
+}
+
+/**
+ * Samples a fixed fraction of traces based off of their trace id.
+ */
+class TraceIdRatioSampler final : public Sampler {
+ public:
+  explicit TraceIdRatioSampler(double ratio) noexcept;
+
+  // Sampler
+  bool ShouldSample(
+      uint64_t trace_id,
+      opentracing::string_view /*operation_name*/) noexcept override {
+    return IsTraceIdSampled(trace_id, threshold_);
+  }
+
+ private:
+  uint64_t threshold_;
+};
+}  // namespace lightstep
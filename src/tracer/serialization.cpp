@@ -107,6 +107,22 @@ static void WriteSpanContext(
                                        span_id, baggage);
 }
 
+//--------------------------------------------------------------------------------------------------
+// PreEncodedKeyValueSerializer
+//--------------------------------------------------------------------------------------------------
+namespace {
+struct PreEncodedKeyValueSerializer {
+  template <class Stream, class T>
+  inline void operator()(Stream& stream,
+                         opentracing::string_view key_serialization,
+                         const T& value) const {
+    stream.WriteRaw(static_cast<const void*>(key_serialization.data()),
+                    key_serialization.size());
+    WriteTypedValue(stream, value);
+  }
+};
+}  // namespace
+
 //--------------------------------------------------------------------------------------------------
 // WriteLogImpl
 //--------------------------------------------------------------------------------------------------
@@ -118,9 +134,8 @@ static void WriteLogImpl(google::protobuf::io::CodedOutputStream& stream,
 
   auto field_serialization_sizes =
       static_cast<size_t*>(alloca(num_key_values * sizeof(size_t)));
-  std::vector<std::string> json_values;
-  std::string json;
-  int json_counter = 0;
+  auto json_sizes =
+      static_cast<size_t*>(alloca(num_key_values * sizeof(size_t)));
 
   uint64_t seconds_since_epoch;
   uint32_t nano_fraction;
@@ -135,11 +150,9 @@ static void WriteLogImpl(google::protobuf::io::CodedOutputStream& stream,
 
   int field_index = 0;
   for (auto iter = first; iter != last; ++iter) {
+    json_sizes[field_index] = 0;
     auto field_serialization_size = ComputeKeyValueSerializationSize(
-        iter->first, iter->second, json, json_counter);
-    if (static_cast<size_t>(json_counter) > json_values.size()) {
-      json_values.emplace_back(std::move(json));
-    }
+        iter->first, iter->second, json_sizes[field_index]);
     field_serialization_sizes[field_index] = field_serialization_size;
     serialization_size +=
         ComputeLengthDelimitedSerializationSize<LogFieldsField>(
@@ -151,11 +164,10 @@ static void WriteLogImpl(google::protobuf::io::CodedOutputStream& stream,
   WriteTimestamp<LogTimestampField>(stream, timestamp_serialization_size,
                                     seconds_since_epoch, nano_fraction);
   field_index = 0;
-  json_counter = 0;
   for (auto iter = first; iter != last; ++iter) {
     WriteKeyValue<LogFieldsField>(
         stream, field_serialization_sizes[field_index], iter->first,
-        iter->second, json_values.data(), json_counter);
+        iter->second, json_sizes[field_index]);
     ++field_index;
   }
 }
@@ -168,6 +180,27 @@ void WriteOperationName(google::protobuf::io::CodedOutputStream& stream,
   WriteString<OperationNameField>(stream, operation_name);
 }
 
+void WriteOperationName(google::protobuf::io::CodedOutputStream& stream,
+                        const OperationNameHandle& operation_name) {
+  auto serialization = operation_name.serialization();
+  stream.WriteRaw(static_cast<const void*>(serialization.data()),
+                  static_cast<int>(serialization.size()));
+}
+
+//--------------------------------------------------------------------------------------------------
+// SerializeOperationName
+//--------------------------------------------------------------------------------------------------
+std::string SerializeOperationName(opentracing::string_view operation_name) {
+  std::string result(
+      ComputeLengthDelimitedSerializationSize<OperationNameField>(
+          operation_name.size()),
+      ' ');
+  DirectCodedOutputStream stream{
+      reinterpret_cast<google::protobuf::uint8*>(&result[0])};
+  WriteString<OperationNameField>(stream, operation_name);
+  return result;
+}
+
 //--------------------------------------------------------------------------------------------------
 // WriteTag
 //--------------------------------------------------------------------------------------------------
@@ -176,6 +209,54 @@ void WriteTag(google::protobuf::io::CodedOutputStream& stream,
   WriteKeyValue<TagsField>(stream, key, value);
 }
 
+void WriteTag(google::protobuf::io::CodedOutputStream& stream,
+              const TagKeyHandle& key, const opentracing::Value& value) {
+  size_t json_size = 0;
+  auto key_serialization = key.serialization();
+  auto serialization_size = key_serialization.size() +
+                            ComputeValueSerializationSize(value, json_size);
+  WriteKeyLength<TagsField>(stream, serialization_size);
+  stream.WriteRaw(static_cast<const void*>(key_serialization.data()),
+                  static_cast<int>(key_serialization.size()));
+  WriteValue(stream, value, json_size);
+}
+
+template <class T>
+void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                   opentracing::string_view key, T value) {
+  WriteTypedKeyValue<TagsField>(stream, key, value);
+}
+
+template <class T>
+void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                   const TagKeyHandle& key, T value) {
+  auto key_serialization = key.serialization();
+  auto serialization_size =
+      key_serialization.size() + ComputeTypedValueSerializationSize(value);
+  WriteLengthDelimitedField<TagsField>(stream, serialization_size,
+                                       PreEncodedKeyValueSerializer{},
+                                       key_serialization, value);
+}
+
+template void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                            opentracing::string_view key, bool value);
+template void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                            opentracing::string_view key, int64_t value);
+template void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                            opentracing::string_view key, double value);
+template void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                            opentracing::string_view key,
+                            opentracing::string_view value);
+template void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                            const TagKeyHandle& key, bool value);
+template void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                            const TagKeyHandle& key, int64_t value);
+template void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                            const TagKeyHandle& key, double value);
+template void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                            const TagKeyHandle& key,
+                            opentracing::string_view value);
+
 //--------------------------------------------------------------------------------------------------
 // WriteStartTimestamp
 //--------------------------------------------------------------------------------------------------
@@ -243,6 +324,46 @@ void WriteLog(google::protobuf::io::CodedOutputStream& stream,
   WriteLogImpl(stream, timestamp, first, last);
 }
 
+template <class T>
+void WriteTypedLog(google::protobuf::io::CodedOutputStream& stream,
+                   opentracing::SystemTime timestamp,
+                   opentracing::string_view key, T value) {
+  uint64_t seconds_since_epoch;
+  uint32_t nano_fraction;
+  std::tie(seconds_since_epoch, nano_fraction) =
+      ProtobufFormatTimestamp(timestamp);
+  auto timestamp_serialization_size =
+      ComputeTimestampSerializationSize(seconds_since_epoch, nano_fraction);
+  auto field_serialization_size =
+      ComputeTypedKeyValueSerializationSize(key, value);
+  auto serialization_size =
+      ComputeLengthDelimitedSerializationSize<LogTimestampField>(
+          timestamp_serialization_size) +
+      ComputeLengthDelimitedSerializationSize<LogFieldsField>(
+          field_serialization_size);
+
+  WriteKeyLength<LogsField>(stream, serialization_size);
+  WriteTimestamp<LogTimestampField>(stream, timestamp_serialization_size,
+                                    seconds_since_epoch, nano_fraction);
+  WriteLengthDelimitedField<LogFieldsField>(stream, field_serialization_size,
+                                            TypedKeyValueSerializer{}, key,
+                                            value);
+}
+
+template void WriteTypedLog(google::protobuf::io::CodedOutputStream& stream,
+                            opentracing::SystemTime timestamp,
+                            opentracing::string_view key, bool value);
+template void WriteTypedLog(google::protobuf::io::CodedOutputStream& stream,
+                            opentracing::SystemTime timestamp,
+                            opentracing::string_view key, int64_t value);
+template void WriteTypedLog(google::protobuf::io::CodedOutputStream& stream,
+                            opentracing::SystemTime timestamp,
+                            opentracing::string_view key, double value);
+template void WriteTypedLog(google::protobuf::io::CodedOutputStream& stream,
+                            opentracing::SystemTime timestamp,
+                            opentracing::string_view key,
+                            opentracing::string_view value);
+
 //--------------------------------------------------------------------------------------------------
 // WriteSpanContext
 //--------------------------------------------------------------------------------------------------
@@ -4,6 +4,7 @@
 #include <utility>
 #include <vector>
 
+#include <lightstep/tracer.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <opentracing/propagation.h>
 #include <opentracing/span.h>
@@ -18,6 +19,21 @@ namespace lightstep {
 void WriteOperationName(google::protobuf::io::CodedOutputStream& stream,
                         opentracing::string_view operation_name);
 
+/**
+ * Serializes a pre-encoded operation name of a span.
+ * @param stream the stream to serialize into
+ * @param operation_name the operation name to serialize
+ */
+void WriteOperationName(google::protobuf::io::CodedOutputStream& stream,
+                        const OperationNameHandle& operation_name);
+
+/**
+ * Computes the serialization of an operation name.
+ * @param operation_name the operation name to serialize
+ * @return the serialized operation name field
+ */
+std::string SerializeOperationName(opentracing::string_view operation_name);
+
 /**
  * Serializes a tag for a span.
  * @param stream the stream to serialize into
@@ -27,6 +43,31 @@ void WriteOperationName(google::protobuf::io::CodedOutputStream& stream,
 void WriteTag(google::protobuf::io::CodedOutputStream& stream,
               opentracing::string_view key, const opentracing::Value& value);
 
+/**
+ * Serializes a tag with a pre-encoded key for a span.
+ * @param stream the stream to serialize into
+ * @param key the key for the tag
+ * @param value the value of the tag
+ */
+void WriteTag(google::protobuf::io::CodedOutputStream& stream,
+              const TagKeyHandle& key, const opentracing::Value& value);
+
+/**
+ * Serializes a tag whose value is written directly instead of through an
+ * opentracing::Value.
+ * @param stream the stream to serialize into
+ * @param key the key for the tag
+ * @param value the value of the tag; one of bool, int64_t, double, or
+ * opentracing::string_view
+ */
+template <class T>
+void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                   opentracing::string_view key, T value);
+
+template <class T>
+void WriteTypedTag(google::protobuf::io::CodedOutputStream& stream,
+                   const TagKeyHandle& key, T value);
+
 /**
  * Serializes the start timestamp of a span.
  * @param stream the stream to serialize into
@@ -79,6 +120,19 @@ void WriteLog(google::protobuf::io::CodedOutputStream& stream,
               const std::pair<std::string, opentracing::Value>* first,
               const std::pair<std::string, opentracing::Value>* last);
 
+/**
+ * Serialize a log record with a single typed field into a span.
+ * @param stream the stream to serialize into
+ * @param timestamp the timestamp of the log
+ * @param key the key of the log record's field
+ * @param value the value of the log record's field; one of bool, int64_t,
+ * double, or opentracing::string_view
+ */
+template <class T>
+void WriteTypedLog(google::protobuf::io::CodedOutputStream& stream,
+                   opentracing::SystemTime timestamp,
+                   opentracing::string_view key, T value);
+
 /**
  * Serialize a span context into a span.
  * @param stream the stream to serialize into
@@ -19,59 +19,95 @@ namespace lightstep {
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
-Span::Span(std::shared_ptr<const TracerImpl>&& tracer,
-           opentracing::string_view operation_name,
+Span::Span(const TracerImpl& tracer, opentracing::string_view operation_name,
            const opentracing::StartSpanOptions& options)
-    : chained_stream_{new ChainedStream{}},
-      header_fragment_{tracer->recorder().ReserveHeaderSpace(*chained_stream_)},
-      coded_stream_{chained_stream_.get()},
-      tracer_{std::move(tracer)} {
-  WriteOperationName(coded_stream_, operation_name);
+    : Span{tracer, operation_name, nullptr, options} {}
 
-  // Set the start timestamps.
-  std::chrono::system_clock::time_point start_timestamp;
-  std::tie(start_timestamp, start_steady_) = ComputeStartTimestamps(
-      tracer_->recorder(), options.start_system_timestamp,
-      options.start_steady_timestamp);
-  WriteStartTimestamp(coded_stream_, start_timestamp);
+Span::Span(const TracerImpl& tracer, const OperationNameHandle& operation_name,
+           const opentracing::StartSpanOptions& options)
+    : Span{tracer, operation_name.value(), &operation_name, options} {}
 
+Span::Span(const TracerImpl& tracer, opentracing::string_view operation_name,
+           const OperationNameHandle* operation_name_handle,
+           const opentracing::StartSpanOptions& options)
+    : tracer_{tracer} {
   // Set any span references.
   trace_flags_ = 0;
-  int reference_count = 0;
+  const LightStepSpanContext* parent_context = nullptr;
+  size_t parent_index = 0;
   for (auto& reference : options.references) {
-    uint64_t trace_id_high;
-    uint64_t trace_id;
-    auto valid_reference = SetSpanReference(reference, trace_id_high, trace_id);
-    reference_count += static_cast<int>(valid_reference);
-    if (reference_count == 1 && valid_reference) {
-      trace_id_high_ = trace_id_high;
-      trace_id_ = trace_id;
+    auto referenced_context = SetSpanReference(reference);
+    if (referenced_context != nullptr && parent_context == nullptr) {
+      parent_context = referenced_context;
+      parent_reference_type_ = reference.first;
+      trace_id_high_ = referenced_context->trace_id_high();
+      trace_id_ = referenced_context->trace_id_low();
+      parent_span_id_ = referenced_context->span_id();
     }
+    parent_index += static_cast<size_t>(parent_context == nullptr);
   }
 
   // If there are any span references, sampled should be true if any of the
-  // references are sampled; with no refences, we set sampled to true.
-  if (reference_count == 0) {
-    trace_flags_ = SetTraceFlag<SampledFlagMask>(trace_flags_, true);
+  // references are sampled; with no refences, the sampler decides.
+  if (parent_context == nullptr) {
     auto ids = GenerateIds<2>();
     trace_id_high_ = 0;
     trace_id_ = ids[0];
     span_id_ = ids[1];
+    auto sampler = tracer_->sampler();
+    trace_flags_ = SetTraceFlag<SampledFlagMask>(
+        trace_flags_, sampler == nullptr ||
+                          sampler->ShouldSample(trace_id_, operation_name));
   } else {
     span_id_ = GenerateId();
   }
 
-  // Set tags.
+  // If sampling_priority is set, it overrides whatever sampling decision was
+  // derived from the referenced spans.
   for (auto& tag : options.tags) {
-    WriteTag(coded_stream_, tag.first, tag.second);
-
-    // If sampling_priority is set, it overrides whatever sampling decision was
-    // derived from the referenced spans.
     if (tag.first == SamplingPriorityKey) {
       trace_flags_ =
           SetTraceFlag<SampledFlagMask>(trace_flags_, is_sampled(tag.second));
     }
   }
+
+  // Unsampled spans only need what's required for propagation, so skip
+  // serializing anything.
+  if (!IsTraceFlagSet<SampledFlagMask>(trace_flags_)) {
+    operation_name_ = operation_name;
+    start_steady_ = ComputeStartSteadyTimestamp(tracer_->recorder(),
+                                                options.start_system_timestamp,
+                                                options.start_steady_timestamp);
+    return;
+  }
+
+  // Set the start timestamps.
+  std::chrono::system_clock::time_point start_timestamp;
+  std::tie(start_timestamp, start_steady_) = ComputeStartTimestamps(
+      tracer_->recorder(), options.start_system_timestamp,
+      options.start_steady_timestamp);
+  StartRecording(operation_name, operation_name_handle, start_timestamp);
+
+  // Serialize the references. Any references before the parent were invalid.
+  auto& coded_stream = this->coded_stream();
+  for (auto i = parent_index; i < options.references.size(); ++i) {
+    auto& reference = options.references[i];
+    auto referenced_context =
+        i == parent_index
+            ? parent_context
+            : dynamic_cast<const LightStepSpanContext*>(reference.second);
+    if (referenced_context == nullptr) {
+      continue;
+    }
+    WriteSpanReference(coded_stream, reference.first,
+                       referenced_context->trace_id_low(),
+                       referenced_context->span_id());
+  }
+
+  // Set tags.
+  for (auto& tag : options.tags) {
+    WriteTag(coded_stream, tag.first, tag.second);
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -80,6 +116,7 @@ Span::Span(std::shared_ptr<const TracerImpl>&& tracer,
 Span::~Span() noexcept {
   opentracing::FinishSpanOptions options;
   FinishImpl(options);
+  StopRecording();
 }
 
 //------------------------------------------------------------------------------
@@ -101,7 +138,11 @@ void Span::SetOperationName(opentracing::string_view name) noexcept try {
   if (is_finished_) {
     return;
   }
-  WriteOperationName(coded_stream_, name);
+  if (chained_stream_ == nullptr) {
+    operation_name_ = name;
+    return;
+  }
+  WriteOperationName(coded_stream(), name);
 } catch (const std::exception& e) {
   tracer_->logger().Error("SetOperationName failed: ", e.what());
 }
@@ -111,19 +152,106 @@ void Span::SetOperationName(opentracing::string_view name) noexcept try {
 //------------------------------------------------------------------------------
 void Span::SetTag(opentracing::string_view key,
                   const opentracing::Value& value) noexcept try {
+  SetTagImpl(key, nullptr, value);
+} catch (const std::exception& e) {
+  tracer_->logger().Error("SetTag failed: ", e.what());
+}
+
+void Span::SetTag(const TagKeyHandle& key,
+                  const opentracing::Value& value) noexcept try {
+  SetTagImpl(key.value(), &key, value);
+} catch (const std::exception& e) {
+  tracer_->logger().Error("SetTag failed: ", e.what());
+}
+
+//------------------------------------------------------------------------------
+// SetTypedTagImpl
+//------------------------------------------------------------------------------
+template <class T>
+void Span::SetTypedTagImpl(opentracing::string_view key,
+                           const TagKeyHandle* key_handle,
+                           T value) noexcept try {
+  if (key == SamplingPriorityKey) {
+    return SetTagImpl(key, key_handle, opentracing::Value{value});
+  }
+  if (!is_recording_.load(std::memory_order_acquire)) {
+    return;
+  }
   SpinLockGuard lock_guard{mutex_};
-  if (is_finished_) {
+  if (is_finished_ || chained_stream_ == nullptr) {
     return;
   }
-  WriteTag(coded_stream_, key, value);
-  if (key == SamplingPriorityKey) {
-    trace_flags_ =
-        SetTraceFlag<SampledFlagMask>(trace_flags_, is_sampled(value));
+  if (key_handle != nullptr) {
+    WriteTypedTag(coded_stream(), *key_handle, value);
+  } else {
+    WriteTypedTag(coded_stream(), key, value);
   }
 } catch (const std::exception& e) {
   tracer_->logger().Error("SetTag failed: ", e.what());
 }
 
+//------------------------------------------------------------------------------
+// LogTypedFieldImpl
+//------------------------------------------------------------------------------
+template <class T>
+void Span::LogTypedFieldImpl(opentracing::string_view key,
+                             T value) noexcept try {
+  if (!is_recording_.load(std::memory_order_acquire)) {
+    return;
+  }
+  auto timestamp = SystemClock::now();
+  SpinLockGuard lock_guard{mutex_};
+  if (is_finished_ || chained_stream_ == nullptr) {
+    return;
+  }
+  WriteTypedLog(coded_stream(), timestamp, key, value);
+} catch (const std::exception& e) {
+  tracer_->logger().Error("Log failed: ", e.what());
+}
+
+//------------------------------------------------------------------------------
+// SetTagImpl
+//------------------------------------------------------------------------------
+void Span::SetTagImpl(opentracing::string_view key,
+                      const TagKeyHandle* key_handle,
+                      const opentracing::Value& value) {
+  auto is_sampling_priority = key == SamplingPriorityKey;
+  if (!is_sampling_priority &&
+      !is_recording_.load(std::memory_order_acquire)) {
+    return;
+  }
+  SpinLockGuard lock_guard{mutex_};
+  if (is_finished_) {
+    return;
+  }
+  if (is_sampling_priority) {
+    auto sampled = is_sampled(value);
+    trace_flags_ = SetTraceFlag<SampledFlagMask>(trace_flags_, sampled);
+
+    // Tags, logs and references other than the parent from before the span
+    // was sampled weren't kept, so they're missing from the recorded span.
+    if (sampled && chained_stream_ == nullptr) {
+      auto timestamp_delta =
+          tracer_->recorder().ComputeSystemSteadyTimestampDelta();
+      StartRecording(operation_name_, nullptr,
+                     ToSystemTimestamp(timestamp_delta, start_steady_));
+      if (parent_span_id_ != 0) {
+        WriteSpanReference(coded_stream(), parent_reference_type_, trace_id_,
+                           parent_span_id_);
+      }
+      std::string{}.swap(operation_name_);
+    }
+  }
+  if (chained_stream_ == nullptr) {
+    return;
+  }
+  if (key_handle != nullptr) {
+    WriteTag(coded_stream(), *key_handle, value);
+  } else {
+    WriteTag(coded_stream(), key, value);
+  }
+}
+
 //------------------------------------------------------------------------------
 // SetBaggageItem
 //------------------------------------------------------------------------------
@@ -163,16 +291,65 @@ std::string Span::BaggageItem(opentracing::string_view restricted_key) const
 void Span::Log(std::initializer_list<
                std::pair<opentracing::string_view, opentracing::Value>>
                    fields) noexcept try {
+  if (!is_recording_.load(std::memory_order_acquire)) {
+    return;
+  }
   auto timestamp = SystemClock::now();
   SpinLockGuard lock_guard{mutex_};
-  if (is_finished_) {
+  if (is_finished_ || chained_stream_ == nullptr) {
     return;
   }
-  WriteLog(coded_stream_, timestamp, fields.begin(), fields.end());
+  WriteLog(coded_stream(), timestamp, fields.begin(), fields.end());
 } catch (const std::exception& e) {
   tracer_->logger().Error("Log failed: ", e.what());
 }
 
+//------------------------------------------------------------------------------
+// SetTypedTag
+//------------------------------------------------------------------------------
+void Span::SetTypedTag(opentracing::string_view key,
+                       const TagKeyHandle* key_handle, bool value) noexcept {
+  SetTypedTagImpl(key, key_handle, value);
+}
+
+void Span::SetTypedTag(opentracing::string_view key,
+                       const TagKeyHandle* key_handle,
+                       int64_t value) noexcept {
+  SetTypedTagImpl(key, key_handle, value);
+}
+
+void Span::SetTypedTag(opentracing::string_view key,
+                       const TagKeyHandle* key_handle, double value) noexcept {
+  SetTypedTagImpl(key, key_handle, value);
+}
+
+void Span::SetTypedTag(opentracing::string_view key,
+                       const TagKeyHandle* key_handle,
+                       opentracing::string_view value) noexcept {
+  SetTypedTagImpl(key, key_handle, value);
+}
+
+//------------------------------------------------------------------------------
+// LogTypedField
+//------------------------------------------------------------------------------
+void Span::LogTypedField(opentracing::string_view key, bool value) noexcept {
+  LogTypedFieldImpl(key, value);
+}
+
+void Span::LogTypedField(opentracing::string_view key,
+                         int64_t value) noexcept {
+  LogTypedFieldImpl(key, value);
+}
+
+void Span::LogTypedField(opentracing::string_view key, double value) noexcept {
+  LogTypedFieldImpl(key, value);
+}
+
+void Span::LogTypedField(opentracing::string_view key,
+                         opentracing::string_view value) noexcept {
+  LogTypedFieldImpl(key, value);
+}
+
 //------------------------------------------------------------------------------
 // ForeachBaggageItem
 //------------------------------------------------------------------------------
@@ -198,24 +375,19 @@ uint8_t Span::trace_flags() const noexcept {
 //--------------------------------------------------------------------------------------------------
 // SetSpanReference
 //--------------------------------------------------------------------------------------------------
-bool Span::SetSpanReference(
+const LightStepSpanContext* Span::SetSpanReference(
     const std::pair<opentracing::SpanReferenceType,
-                    const opentracing::SpanContext*>& reference,
-    uint64_t& trace_id_high, uint64_t& trace_id) {
+                    const opentracing::SpanContext*>& reference) {
   if (reference.second == nullptr) {
     tracer_->logger().Warn("Passed in null span reference.");
-    return false;
+    return nullptr;
   }
   auto referenced_context =
       dynamic_cast<const LightStepSpanContext*>(reference.second);
   if (referenced_context == nullptr) {
     tracer_->logger().Warn("Passed in span reference of unexpected type.");
-    return false;
+    return nullptr;
   }
-  trace_id_high = referenced_context->trace_id_high();
-  trace_id = referenced_context->trace_id_low();
-  WriteSpanReference(coded_stream_, reference.first, trace_id,
-                     referenced_context->span_id());
   trace_flags_ |= referenced_context->trace_flags();
   AppendTraceState(trace_state_, referenced_context->trace_state());
   referenced_context->ForeachBaggageItem(
@@ -223,7 +395,38 @@ bool Span::SetSpanReference(
         this->baggage_.insert_or_assign(std::string{key}, std::string{value});
         return true;
       });
-  return true;
+  return referenced_context;
+}
+
+//--------------------------------------------------------------------------------------------------
+// StartRecording
+//--------------------------------------------------------------------------------------------------
+void Span::StartRecording(opentracing::string_view operation_name,
+                          const OperationNameHandle* operation_name_handle,
+                          SystemTime start_timestamp) {
+  std::unique_ptr<ChainedStream> chained_stream{new ChainedStream{}};
+  header_fragment_ = tracer_->recorder().ReserveHeaderSpace(*chained_stream);
+  chained_stream_ = std::move(chained_stream);
+  auto& coded_stream =
+      *new (&coded_stream_storage_) CodedOutputStream{chained_stream_.get()};
+  is_recording_.store(true, std::memory_order_release);
+  if (operation_name_handle != nullptr) {
+    WriteOperationName(coded_stream, *operation_name_handle);
+  } else {
+    WriteOperationName(coded_stream, operation_name);
+  }
+  WriteStartTimestamp(coded_stream, start_timestamp);
+}
+
+//--------------------------------------------------------------------------------------------------
+// StopRecording
+//--------------------------------------------------------------------------------------------------
+void Span::StopRecording() noexcept {
+  if (chained_stream_ == nullptr) {
+    return;
+  }
+  coded_stream().~CodedOutputStream();
+  chained_stream_.reset();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -236,9 +439,11 @@ void Span::FinishImpl(
     return;
   }
 
-  if (!IsTraceFlagSet<SampledFlagMask>(trace_flags_)) {
+  if (chained_stream_ == nullptr ||
+      !IsTraceFlagSet<SampledFlagMask>(trace_flags_)) {
     return;
   }
+  auto& coded_stream = this->coded_stream();
 
   auto finish_timestamp = options.finish_steady_timestamp;
   if (finish_timestamp == SteadyTime()) {
@@ -247,24 +452,29 @@ void Span::FinishImpl(
 
   // Set timing information.
   auto duration = finish_timestamp - start_steady_;
-  WriteDuration(coded_stream_, duration);
+  WriteDuration(coded_stream, duration);
 
   // Set logs
   for (auto& log_record : options.log_records) {
     try {
-      WriteLog(coded_stream_, log_record.timestamp, log_record.fields.data(),
+      WriteLog(coded_stream, log_record.timestamp, log_record.fields.data(),
                log_record.fields.data() + log_record.fields.size());
     } catch (const std::exception& e) {
       tracer_->logger().Error("Dropping log record: ", e.what());
     }
   }
 
-  WriteSpanContext(coded_stream_, trace_id_, span_id_, baggage_.as_vector());
+  WriteSpanContext(coded_stream, trace_id_, span_id_, baggage_.as_vector());
 
   // Record the span
-  tracer_->recorder().WriteFooter(coded_stream_);
-  coded_stream_.Trim();
-  tracer_->recorder().RecordSpan(header_fragment_, std::move(chained_stream_));
+  tracer_->recorder().WriteFooter(coded_stream);
+
+  // Note: Destroying the coded stream trims it and must happen before the
+  // stream is handed off to the recorder.
+  coded_stream.~CodedOutputStream();
+  is_recording_.store(false, std::memory_order_release);
+  auto chained_stream = std::move(chained_stream_);
+  tracer_->recorder().RecordSpan(header_fragment_, std::move(chained_stream));
 } catch (const std::exception& e) {
   tracer_->logger().Error("FinishWithOptions failed: ", e.what());
 }
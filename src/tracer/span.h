@@ -4,6 +4,7 @@
 #include <exception>
 #include <memory>
 #include <mutex>
+#include <type_traits>
 
 #include "common/chained_stream.h"
 #include "common/spin_lock_mutex.h"
@@ -11,6 +12,7 @@
 #include "tracer/lightstep_span_context.h"
 #include "tracer/propagation/propagation.h"
 #include "tracer/tracer_impl.h"
+#include "tracer/utility.h"
 
 #include <google/protobuf/io/coded_stream.h>
 #include <opentracing/span.h>
@@ -19,10 +21,12 @@ namespace lightstep {
 /**
  * LightStep's implementation of the OpenTracing Span class.
  */
-class Span final : public opentracing::Span, public LightStepSpanContext {
+class Span final : public LightStepSpan, public LightStepSpanContext {
  public:
-  Span(std::shared_ptr<const TracerImpl>&& tracer,
-       opentracing::string_view operation_name,
+  Span(const TracerImpl& tracer, opentracing::string_view operation_name,
+       const opentracing::StartSpanOptions& options);
+
+  Span(const TracerImpl& tracer, const OperationNameHandle& operation_name,
        const opentracing::StartSpanOptions& options);
 
   ~Span() noexcept override;
@@ -53,6 +57,13 @@ class Span final : public opentracing::Span, public LightStepSpanContext {
     return *tracer_;
   }
 
+  // LightStepSpan
+  using LightStepSpan::Log;
+  using LightStepSpan::SetTag;
+
+  void SetTag(const TagKeyHandle& key,
+              const opentracing::Value& value) noexcept override;
+
   // opentracing::SpanContext
   void ForeachBaggageItem(
       std::function<bool(const std::string& key, const std::string& value)> f)
@@ -89,6 +100,32 @@ class Span final : public opentracing::Span, public LightStepSpanContext {
     return trace_state_;
   }
 
+ protected:
+  // LightStepSpan
+  void SetTypedTag(opentracing::string_view key, const TagKeyHandle* key_handle,
+                   bool value) noexcept override;
+
+  void SetTypedTag(opentracing::string_view key, const TagKeyHandle* key_handle,
+                   int64_t value) noexcept override;
+
+  void SetTypedTag(opentracing::string_view key, const TagKeyHandle* key_handle,
+                   double value) noexcept override;
+
+  void SetTypedTag(opentracing::string_view key, const TagKeyHandle* key_handle,
+                   opentracing::string_view value) noexcept override;
+
+  void LogTypedField(opentracing::string_view key,
+                     bool value) noexcept override;
+
+  void LogTypedField(opentracing::string_view key,
+                     int64_t value) noexcept override;
+
+  void LogTypedField(opentracing::string_view key,
+                     double value) noexcept override;
+
+  void LogTypedField(opentracing::string_view key,
+                     opentracing::string_view value) noexcept override;
+
  private:
   // Profiling shows that even with no contention, locking and unlocking a
   // standard mutex represents a significant portion of the cost of
@@ -98,14 +135,31 @@ class Span final : public opentracing::Span, public LightStepSpanContext {
   // more sense to use a spin lock for this use case.
   mutable SpinLockMutex mutex_;
 
+  // Spans whose sampling decision is negative when they're started don't
+  // allocate a stream and skip all serialization, unless they're later sampled
+  // by setting the sampling priority tag.
+  //
+  // is_recording_ mirrors chained_stream_ != nullptr so that SetTag and Log can
+  // return early without taking the lock.
+  std::atomic<bool> is_recording_{false};
   std::unique_ptr<ChainedStream> chained_stream_;
   Fragment header_fragment_;
-  google::protobuf::io::CodedOutputStream coded_stream_;
+
+  // Only constructed while chained_stream_ is non-null.
+  using CodedOutputStream = google::protobuf::io::CodedOutputStream;
+  std::aligned_storage<sizeof(CodedOutputStream),
+                       alignof(CodedOutputStream)>::type coded_stream_storage_;
 
   std::chrono::steady_clock::time_point start_steady_;
   std::atomic<bool> is_finished_{false};
 
-  std::shared_ptr<const TracerImpl> tracer_;
+  // Enough information to start recording an unsampled span if it's later
+  // sampled.
+  std::string operation_name_;
+  opentracing::SpanReferenceType parent_reference_type_;
+  uint64_t parent_span_id_{0};
+
+  TracerImplReference tracer_;
   uint64_t trace_id_high_{0};
   uint64_t trace_id_;
   uint64_t span_id_;
@@ -126,10 +180,33 @@ class Span final : public opentracing::Span, public LightStepSpanContext {
                              trace_state_, baggage_);
   }
 
-  bool SetSpanReference(
+  CodedOutputStream& coded_stream() noexcept {
+    return *reinterpret_cast<CodedOutputStream*>(&coded_stream_storage_);
+  }
+
+  Span(const TracerImpl& tracer, opentracing::string_view operation_name,
+       const OperationNameHandle* operation_name_handle,
+       const opentracing::StartSpanOptions& options);
+
+  void SetTagImpl(opentracing::string_view key, const TagKeyHandle* key_handle,
+                  const opentracing::Value& value);
+
+  template <class T>
+  void SetTypedTagImpl(opentracing::string_view key,
+                       const TagKeyHandle* key_handle, T value) noexcept;
+
+  template <class T>
+  void LogTypedFieldImpl(opentracing::string_view key, T value) noexcept;
+
+  const LightStepSpanContext* SetSpanReference(
       const std::pair<opentracing::SpanReferenceType,
-                      const opentracing::SpanContext*>& reference,
-      uint64_t& trace_id_high, uint64_t& trace_id);
+                      const opentracing::SpanContext*>& reference);
+
+  void StartRecording(opentracing::string_view operation_name,
+                      const OperationNameHandle* operation_name_handle,
+                      SystemTime start_timestamp);
+
+  void StopRecording() noexcept;
 
   void FinishImpl(const opentracing::FinishSpanOptions& options) noexcept;
 };
@@ -9,6 +9,7 @@
 
 #include "common/logger.h"
 #include "common/platform/utility.h"
+#include "common/serialization.h"
 #include "common/utility.h"
 #include "lightstep-tracer-common/collector.pb.h"
 #include "lightstep/version.h"
@@ -17,8 +18,10 @@
 #include "recorder/legacy_manual_recorder.h"
 #include "recorder/manual_recorder.h"
 #include "recorder/stream_recorder.h"
+#include "recorder/threaded_recorder.h"
 #include "tracer/immutable_span_context.h"
 #include "tracer/legacy/legacy_tracer_impl.h"
+#include "tracer/serialization.h"
 #include "tracer/tracer_impl.h"
 
 #include "opentracing/string_view.h"
@@ -84,6 +87,22 @@ LightStepTracer::GetTraceSpanIdsSampled(
   return result;
 }
 
+//------------------------------------------------------------------------------
+// RegisterOperationName
+//------------------------------------------------------------------------------
+OperationNameHandle LightStepTracer::RegisterOperationName(
+    opentracing::string_view operation_name) {
+  return OperationNameHandle{SerializeOperationName(operation_name),
+                             operation_name.size()};
+}
+
+//------------------------------------------------------------------------------
+// RegisterTagKey
+//------------------------------------------------------------------------------
+TagKeyHandle LightStepTracer::RegisterTagKey(opentracing::string_view key) {
+  return TagKeyHandle{SerializeKey(key), key.size()};
+}
+
 //------------------------------------------------------------------------------
 // MakeSpanContext
 //------------------------------------------------------------------------------
@@ -99,29 +118,69 @@ LightStepTracer::MakeSpanContext(
       std::make_error_code(std::errc::not_enough_memory));
 }
 
+//------------------------------------------------------------------------------
+// StartSpanWithOptions
+//------------------------------------------------------------------------------
+std::unique_ptr<LightStepSpan> LightStepTracer::StartSpanWithOptions(
+    const OperationNameHandle& operation_name,
+    const opentracing::StartSpanOptions& options) const noexcept {
+  auto span = this->StartSpanWithOptions(operation_name.value(), options);
+  std::unique_ptr<LightStepSpan> result{
+      dynamic_cast<LightStepSpan*>(span.get())};
+  if (result != nullptr) {
+    span.release();
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// MakeLegacyThreadedTracer
+//------------------------------------------------------------------------------
+static std::shared_ptr<LightStepTracer> MakeLegacyThreadedTracer(
+    std::shared_ptr<Logger> logger, LightStepTracerOptions&& options) {
+  std::unique_ptr<SyncTransporter> transporter{
+      dynamic_cast<SyncTransporter*>(options.transporter.get())};
+  if (transporter == nullptr) {
+    logger->Error(
+        "`options.transporter` must be derived from SyncTransporter or "
+        "AsyncTransporter");
+    return nullptr;
+  }
+  options.transporter.release();
+  auto propagation_options = MakePropagationOptions(options);
+  auto sampler = std::move(options.sampler);
+  auto recorder = std::unique_ptr<Recorder>{
+      new AutoRecorder{*logger, std::move(options), std::move(transporter)}};
+  return std::shared_ptr<LightStepTracer>{
+      new LegacyTracerImpl{std::move(logger), std::move(propagation_options),
+                           std::move(recorder), std::move(sampler)}};
+}
+
 //------------------------------------------------------------------------------
 // MakeThreadedTracer
 //------------------------------------------------------------------------------
 static std::shared_ptr<LightStepTracer> MakeThreadedTracer(
     std::shared_ptr<Logger> logger, LightStepTracerOptions&& options) {
-  std::unique_ptr<SyncTransporter> transporter;
+  std::unique_ptr<AsyncTransporter> transporter;
   if (options.transporter != nullptr) {
-    transporter = std::unique_ptr<SyncTransporter>{
-        dynamic_cast<SyncTransporter*>(options.transporter.get())};
+    // SyncTransporters are given ReportRequest messages, so they stay on the
+    // legacy recorder instead of having the serialized reports parsed back
+    // into messages for them.
+    transporter = std::unique_ptr<AsyncTransporter>{
+        dynamic_cast<AsyncTransporter*>(options.transporter.get())};
     if (transporter == nullptr) {
-      logger->Error(
-          "`options.transporter` must be derived from SyncTransporter");
-      return nullptr;
+      return MakeLegacyThreadedTracer(logger, std::move(options));
     }
     options.transporter.release();
   } else {
-    transporter = MakeGrpcTransporter(*logger, options);
+    transporter = MakeGrpcAsyncTransporter(*logger, options);
   }
   auto propagation_options = MakePropagationOptions(options);
-  auto recorder = std::unique_ptr<Recorder>{
-      new AutoRecorder{*logger, std::move(options), std::move(transporter)}};
-  return std::shared_ptr<LightStepTracer>{new LegacyTracerImpl{
-      std::move(logger), std::move(propagation_options), std::move(recorder)}};
+  auto sampler = std::move(options.sampler);
+  auto recorder = std::unique_ptr<Recorder>{new ThreadedRecorder{
+      *logger, std::move(options), std::move(transporter)}};
+  return MakeTracerImpl(std::move(logger), std::move(propagation_options),
+                        std::move(recorder), std::move(sampler));
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -130,9 +189,10 @@ static std::shared_ptr<LightStepTracer> MakeThreadedTracer(
 static std::shared_ptr<LightStepTracer> MakeStreamTracer(
     std::shared_ptr<Logger> logger, LightStepTracerOptions&& options) {
   auto propagation_options = MakePropagationOptions(options);
+  auto sampler = std::move(options.sampler);
   auto recorder = MakeStreamRecorder(*logger, std::move(options));
-  return std::shared_ptr<LightStepTracer>{new TracerImpl{
-      std::move(logger), std::move(propagation_options), std::move(recorder)}};
+  return MakeTracerImpl(std::move(logger), std::move(propagation_options),
+                        std::move(recorder), std::move(sampler));
 }
 
 //------------------------------------------------------------------------------
@@ -157,10 +217,12 @@ static std::shared_ptr<LightStepTracer> MakeLegacySingleThreadedTracer(
     return nullptr;
   }
   auto propagation_options = MakePropagationOptions(options);
+  auto sampler = std::move(options.sampler);
   auto recorder = std::unique_ptr<Recorder>{new LegacyManualRecorder{
       *logger, std::move(options), std::move(transporter)}};
-  return std::shared_ptr<LightStepTracer>{new LegacyTracerImpl{
-      std::move(logger), std::move(propagation_options), std::move(recorder)}};
+  return std::shared_ptr<LightStepTracer>{
+      new LegacyTracerImpl{std::move(logger), std::move(propagation_options),
+                           std::move(recorder), std::move(sampler)}};
 }
 
 //------------------------------------------------------------------------------
@@ -182,10 +244,11 @@ static std::shared_ptr<LightStepTracer> MakeSingleThreadedTracer(
     return nullptr;
   }
   auto propagation_options = MakePropagationOptions(options);
+  auto sampler = std::move(options.sampler);
   auto recorder = std::unique_ptr<Recorder>{
       new ManualRecorder{*logger, std::move(options), std::move(transporter)}};
-  return std::shared_ptr<LightStepTracer>{new TracerImpl{
-      std::move(logger), std::move(propagation_options), std::move(recorder)}};
+  return MakeTracerImpl(std::move(logger), std::move(propagation_options),
+                        std::move(recorder), std::move(sampler));
 }
 
 //------------------------------------------------------------------------------
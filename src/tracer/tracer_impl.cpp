@@ -50,21 +50,46 @@ ExtractImpl(const PropagationOptions& propagation_options,
       make_error_code(std::errc::not_enough_memory));
 }
 
+//------------------------------------------------------------------------------
+// MakeTracerImpl
+//------------------------------------------------------------------------------
+std::shared_ptr<TracerImpl> MakeTracerImpl(
+    PropagationOptions&& propagation_options,
+    std::unique_ptr<Recorder>&& recorder, std::unique_ptr<Sampler>&& sampler) {
+  return MakeTracerImpl(std::make_shared<Logger>(),
+                        std::move(propagation_options), std::move(recorder),
+                        std::move(sampler));
+}
+
+std::shared_ptr<TracerImpl> MakeTracerImpl(
+    std::shared_ptr<Logger> logger, PropagationOptions&& propagation_options,
+    std::unique_ptr<Recorder>&& recorder, std::unique_ptr<Sampler>&& sampler) {
+  std::unique_ptr<TracerImpl, TracerImpl::OwnerReleaser> result{
+      new TracerImpl{std::move(logger), std::move(propagation_options),
+                     std::move(recorder), std::move(sampler)}};
+  return std::shared_ptr<TracerImpl>{std::move(result)};
+}
+
 //--------------------------------------------------------------------------------------------------
 // constructor
 //--------------------------------------------------------------------------------------------------
-TracerImpl::TracerImpl(PropagationOptions&& propagation_options,
-                       std::unique_ptr<Recorder>&& recorder) noexcept
-    : logger_{std::make_shared<Logger>()},
-      propagation_options_{std::move(propagation_options)},
-      recorder_{std::move(recorder)} {}
-
 TracerImpl::TracerImpl(std::shared_ptr<Logger> logger,
                        PropagationOptions&& propagation_options,
-                       std::unique_ptr<Recorder>&& recorder) noexcept
+                       std::unique_ptr<Recorder>&& recorder,
+                       std::unique_ptr<Sampler>&& sampler) noexcept
     : logger_{std::move(logger)},
       propagation_options_{std::move(propagation_options)},
-      recorder_{std::move(recorder)} {}
+      recorder_{std::move(recorder)},
+      sampler_{std::move(sampler)} {}
+
+//------------------------------------------------------------------------------
+// OwnerReleaser
+//------------------------------------------------------------------------------
+void TracerImpl::OwnerReleaser::operator()(TracerImpl* tracer) const noexcept {
+  if (tracer->references_.ReleaseOwner()) {
+    delete tracer;
+  }
+}
 
 //------------------------------------------------------------------------------
 // StartSpanWithOptions
@@ -73,7 +98,17 @@ std::unique_ptr<opentracing::Span> TracerImpl::StartSpanWithOptions(
     opentracing::string_view operation_name,
     const opentracing::StartSpanOptions& options) const noexcept try {
   return std::unique_ptr<opentracing::Span>{
-      new Span{shared_from_this(), operation_name, options}};
+      new Span{*this, operation_name, options}};
+} catch (const std::exception& e) {
+  logger_->Error("StartSpanWithOptions failed: ", e.what());
+  return nullptr;
+}
+
+std::unique_ptr<LightStepSpan> TracerImpl::StartSpanWithOptions(
+    const OperationNameHandle& operation_name,
+    const opentracing::StartSpanOptions& options) const noexcept try {
+  return std::unique_ptr<LightStepSpan>{
+      new Span{*this, operation_name, options}};
 } catch (const std::exception& e) {
   logger_->Error("StartSpanWithOptions failed: ", e.what());
   return nullptr;
@@ -3,23 +3,36 @@
 #include <memory>
 
 #include "common/logger.h"
+#include "common/noncopyable.h"
+#include "common/sharded_reference_count.h"
 #include "recorder/recorder.h"
 #include "tracer/propagation/propagation.h"
 
 namespace lightstep {
+class TracerImpl;
+
 /**
- * LightStep's implementation of the opentracing Tracer class.
+ * Constructs a TracerImpl.
+ *
+ * The returned pointer holds the owner's reference to the tracer. Spans hold
+ * their own references so that the tracer is destroyed once both the owner's
+ * pointer and every outstanding span are released.
  */
-class TracerImpl final : public LightStepTracer,
-                         public std::enable_shared_from_this<TracerImpl> {
- public:
-  TracerImpl(PropagationOptions&& propagation_options,
-             std::unique_ptr<Recorder>&& recorder) noexcept;
+std::shared_ptr<TracerImpl> MakeTracerImpl(
+    PropagationOptions&& propagation_options,
+    std::unique_ptr<Recorder>&& recorder,
+    std::unique_ptr<Sampler>&& sampler = nullptr);
 
-  TracerImpl(std::shared_ptr<Logger> logger,
-             PropagationOptions&& propagation_options,
-             std::unique_ptr<Recorder>&& recorder) noexcept;
+std::shared_ptr<TracerImpl> MakeTracerImpl(
+    std::shared_ptr<Logger> logger, PropagationOptions&& propagation_options,
+    std::unique_ptr<Recorder>&& recorder,
+    std::unique_ptr<Sampler>&& sampler = nullptr);
 
+/**
+ * LightStep's implementation of the opentracing Tracer class.
+ */
+class TracerImpl final : public LightStepTracer {
+ public:
   /**
    * @return the associated Logger.
    */
@@ -30,11 +43,22 @@ class TracerImpl final : public LightStepTracer,
    */
   Recorder& recorder() const noexcept { return *recorder_; }
 
+  /**
+   * @return the Sampler used for root spans or nullptr if every trace is
+   * sampled.
+   */
+  Sampler* sampler() const noexcept { return sampler_.get(); }
+
   // opentracing::Span
   std::unique_ptr<opentracing::Span> StartSpanWithOptions(
       opentracing::string_view operation_name,
       const opentracing::StartSpanOptions& options) const noexcept override;
 
+  // LightStepTracer
+  std::unique_ptr<LightStepSpan> StartSpanWithOptions(
+      const OperationNameHandle& operation_name,
+      const opentracing::StartSpanOptions& options) const noexcept override;
+
   opentracing::expected<void> Inject(
       const opentracing::SpanContext& span_context,
       std::ostream& writer) const override;
@@ -65,8 +89,55 @@ class TracerImpl final : public LightStepTracer,
       std::chrono::system_clock::duration timeout) noexcept override;
 
  private:
+  friend class TracerImplReference;
+  friend std::shared_ptr<TracerImpl> MakeTracerImpl(
+      std::shared_ptr<Logger> logger, PropagationOptions&& propagation_options,
+      std::unique_ptr<Recorder>&& recorder,
+      std::unique_ptr<Sampler>&& sampler);
+
+  // Deleter for the owner's pointer.
+  struct OwnerReleaser {
+    void operator()(TracerImpl* tracer) const noexcept;
+  };
+
   std::shared_ptr<Logger> logger_;
   PropagationOptions propagation_options_;
   std::unique_ptr<Recorder> recorder_;
+  std::unique_ptr<Sampler> sampler_;
+
+  // Counts the references held by spans. Sharded so that threads starting and
+  // finishing spans don't contend on a single shared_ptr control block.
+  mutable ShardedReferenceCount references_;
+
+  TracerImpl(std::shared_ptr<Logger> logger,
+             PropagationOptions&& propagation_options,
+             std::unique_ptr<Recorder>&& recorder,
+             std::unique_ptr<Sampler>&& sampler) noexcept;
+
+  ~TracerImpl() noexcept override = default;
+};
+
+/**
+ * Holds a reference to a TracerImpl that keeps it alive.
+ */
+class TracerImplReference : private Noncopyable {
+ public:
+  explicit TracerImplReference(const TracerImpl& tracer) noexcept
+      : tracer_{&tracer} {
+    tracer.references_.Acquire();
+  }
+
+  ~TracerImplReference() noexcept {
+    if (tracer_->references_.Release()) {
+      delete tracer_;
+    }
+  }
+
+  const TracerImpl& operator*() const noexcept { return *tracer_; }
+
+  const TracerImpl* operator->() const noexcept { return tracer_; }
+
+ private:
+  const TracerImpl* tracer_;
 };
 }  // namespace lightstep
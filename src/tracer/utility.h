@@ -58,6 +58,30 @@ inline std::tuple<SystemTime, SteadyTime> ComputeStartTimestamps(
                                             start_steady_timestamp};
 }
 
+/**
+ * Compute only the steady start timestamp of a span.
+ *
+ * Cheaper than ComputeStartTimestamps when the system timestamp isn't needed.
+ * @param recorder the recorder
+ * @param start_system_timestamp the system start time or SystemTime{} if not
+ * set
+ * @param start_steady_timestamp the steady start time  or SteadyTime{} if not
+ * set
+ * @return the start steady timestamp
+ */
+inline SteadyTime ComputeStartSteadyTimestamp(
+    const Recorder& recorder, const SystemTime& start_system_timestamp,
+    const SteadyTime& start_steady_timestamp) noexcept {
+  if (start_steady_timestamp != SteadyTime()) {
+    return start_steady_timestamp;
+  }
+  if (start_system_timestamp != SystemTime()) {
+    return ToSteadyTimestamp(recorder.ComputeSystemSteadyTimestampDelta(),
+                             start_system_timestamp);
+  }
+  return SteadyClock::now();
+}
+
 /**
  * Appends trace-states to have the union of the two key-value lists.
  * @param trace_state the trace_state to append to
@@ -0,0 +1,84 @@
+#include "common/background_log_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+TEST_CASE("BackgroundLogSink") {
+  std::mutex mutex;
+  std::vector<std::string> messages;
+  std::mutex sink_mutex;
+  auto sink = [&](LogLevel /*level*/, opentracing::string_view message) {
+    std::lock_guard<std::mutex> sink_lock_guard{sink_mutex};
+    std::lock_guard<std::mutex> lock_guard{mutex};
+    messages.emplace_back(message);
+  };
+
+  SECTION("Records are passed to the sink in order") {
+    BackgroundLogSink background_log_sink{sink, 10};
+    background_log_sink(LogLevel::info, "abc");
+    background_log_sink(LogLevel::info, "123");
+    background_log_sink.Flush();
+    std::lock_guard<std::mutex> lock_guard{mutex};
+    REQUIRE(messages == std::vector<std::string>{"abc", "123"});
+  }
+
+  SECTION("Records are dropped when the queue is full") {
+    BackgroundLogSink background_log_sink{sink, 1};
+    {
+      // Block the sink so that records back up.
+      std::lock_guard<std::mutex> sink_lock_guard{sink_mutex};
+      for (int i = 0; i < 5; ++i) {
+        background_log_sink(LogLevel::info, "abc");
+      }
+    }
+    background_log_sink.Flush();
+    REQUIRE(background_log_sink.num_dropped() >= 3);
+    std::lock_guard<std::mutex> lock_guard{mutex};
+    REQUIRE(std::any_of(
+        messages.begin(), messages.end(), [](const std::string& message) {
+          return message.find("the log queue was full") != std::string::npos;
+        }));
+  }
+
+  SECTION("FlushWithTimeout gives up if the sink doesn't keep up") {
+    BackgroundLogSink background_log_sink{sink, 10};
+    {
+      std::lock_guard<std::mutex> sink_lock_guard{sink_mutex};
+      background_log_sink(LogLevel::info, "abc");
+      REQUIRE(!background_log_sink.FlushWithTimeout(
+          std::chrono::milliseconds{10}));
+    }
+    REQUIRE(background_log_sink.FlushWithTimeout(std::chrono::seconds{5}));
+    std::lock_guard<std::mutex> lock_guard{mutex};
+    REQUIRE(messages == std::vector<std::string>{"abc"});
+  }
+
+  SECTION("Records queued while stopped are passed on once restarted") {
+    BackgroundLogSink background_log_sink{sink, 10};
+    background_log_sink.Stop();
+    background_log_sink(LogLevel::info, "abc");
+    background_log_sink.Flush();
+    {
+      std::lock_guard<std::mutex> lock_guard{mutex};
+      REQUIRE(messages.empty());
+    }
+    background_log_sink.Start();
+    background_log_sink.Flush();
+    std::lock_guard<std::mutex> lock_guard{mutex};
+    REQUIRE(messages == std::vector<std::string>{"abc"});
+  }
+
+  SECTION("Queued records are passed to the sink on destruction") {
+    {
+      BackgroundLogSink background_log_sink{sink, 10};
+      background_log_sink(LogLevel::info, "abc");
+    }
+    REQUIRE(messages == std::vector<std::string>{"abc"});
+  }
+}
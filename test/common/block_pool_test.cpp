@@ -0,0 +1,81 @@
+#include "common/block_pool.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+namespace {
+struct TestBlock {
+  char data[100];
+};
+
+struct CrossThreadTestBlock {
+  char data[100];
+};
+}  // namespace
+
+static void AllocateBlocks(std::vector<void*>& blocks, int n) {
+  for (int i = 0; i < n; ++i) {
+    blocks.push_back(BlockPool<CrossThreadTestBlock>::Allocate());
+  }
+}
+
+static void FreeBlocks(std::vector<void*>& blocks) {
+  for (auto block : blocks) {
+    BlockPool<CrossThreadTestBlock>::Free(block);
+  }
+  blocks.clear();
+}
+
+TEST_CASE("BlockPool") {
+  using Pool = BlockPool<TestBlock>;
+
+  SECTION("Freed blocks are reused by later allocations.") {
+    auto block1 = Pool::Allocate();
+    Pool::Free(block1);
+    auto block2 = Pool::Allocate();
+    REQUIRE(block1 == block2);
+    Pool::Free(block2);
+  }
+
+  SECTION("Live blocks are never handed out twice.") {
+    std::vector<void*> blocks;
+    for (int i = 0; i < 3 * static_cast<int>(Pool::MaxThreadCacheSize); ++i) {
+      blocks.push_back(Pool::Allocate());
+    }
+    auto sorted_blocks = blocks;
+    std::sort(sorted_blocks.begin(), sorted_blocks.end());
+    REQUIRE(std::unique(sorted_blocks.begin(), sorted_blocks.end()) ==
+            sorted_blocks.end());
+    for (auto block : blocks) {
+      Pool::Free(block);
+    }
+  }
+
+  SECTION("Freeing null is a no-op.") { Pool::Free(nullptr); }
+}
+
+TEST_CASE("BlockPool recycles blocks freed on a different thread") {
+  using Pool = BlockPool<CrossThreadTestBlock>;
+  const int n = 10 * static_cast<int>(Pool::TransferBatchSize);
+  std::vector<void*> blocks;
+
+  // Prime the pool with blocks freed from another thread.
+  AllocateBlocks(blocks, n);
+  std::thread{FreeBlocks, std::ref(blocks)}.join();
+  auto stats1 = Pool::stats();
+
+  // Allocations on this thread should now be served from the central free
+  // list.
+  AllocateBlocks(blocks, n);
+  FreeBlocks(blocks);
+  auto stats2 = Pool::stats();
+
+  REQUIRE(stats1.num_misses == static_cast<uint64_t>(n));
+  REQUIRE(stats2.num_misses == stats1.num_misses);
+  REQUIRE(stats2.num_hits >= stats1.num_hits + static_cast<uint64_t>(n) -
+                                 Pool::TransferBatchSize);
+}
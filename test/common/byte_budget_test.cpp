@@ -0,0 +1,37 @@
+#include "common/byte_budget.h"
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+TEST_CASE("ByteBudget") {
+  SECTION("Reservations succeed until the budget is used up.") {
+    ByteBudget budget{10};
+    REQUIRE(budget.is_limited());
+    REQUIRE(budget.Reserve(6));
+    REQUIRE(budget.Reserve(4));
+    REQUIRE(!budget.Reserve(1));
+    REQUIRE(budget.num_bytes_used() == 10);
+  }
+
+  SECTION("A failed reservation doesn't use any of the budget.") {
+    ByteBudget budget{10};
+    REQUIRE(budget.Reserve(6));
+    REQUIRE(!budget.Reserve(5));
+    REQUIRE(budget.num_bytes_used() == 6);
+  }
+
+  SECTION("Released bytes can be reserved again.") {
+    ByteBudget budget{10};
+    REQUIRE(budget.Reserve(10));
+    budget.Release(4);
+    REQUIRE(budget.num_bytes_used() == 6);
+    REQUIRE(budget.Reserve(4));
+  }
+
+  SECTION("A budget of 0 has no limit.") {
+    ByteBudget budget{0};
+    REQUIRE(!budget.is_limited());
+    REQUIRE(budget.Reserve(1000000));
+    REQUIRE(budget.num_bytes_used() == 0);
+  }
+}
@@ -0,0 +1,155 @@
+#include "common/byte_ring.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+static bool WriteString(ByteRing& ring, const std::string& s) {
+  uint64_t position;
+  if (!ring.Reserve(s.size(), position)) {
+    return false;
+  }
+  ring.Write(position, s.data(), s.size());
+  ring.Commit(position, s.size());
+  return true;
+}
+
+static std::string ReadString(const ByteRing& ring) {
+  std::string result;
+  ring.ForEachFragment(ring.consumer_position(), ring.committed_position(),
+                       [&result](void* data, int size) {
+                         result.append(static_cast<char*>(data),
+                                       static_cast<size_t>(size));
+                         return true;
+                       });
+  return result;
+}
+
+static std::vector<std::string> ReadFragments(const ByteRing& ring) {
+  std::vector<std::string> result;
+  ring.ForEachFragment(ring.consumer_position(), ring.committed_position(),
+                       [&result](void* data, int size) {
+                         result.emplace_back(static_cast<char*>(data),
+                                             static_cast<size_t>(size));
+                         return true;
+                       });
+  return result;
+}
+
+TEST_CASE("ByteRing") {
+  ByteRing ring{10};
+
+  SECTION("Committed bytes are visible to the consumer.") {
+    REQUIRE(ring.empty());
+    REQUIRE(WriteString(ring, "abc"));
+    REQUIRE(ring.size() == 3);
+    REQUIRE(ReadString(ring) == "abc");
+    REQUIRE(ring.at(ring.consumer_position() + 1) == 'b');
+  }
+
+  SECTION("Reserved bytes aren't visible until they're committed.") {
+    uint64_t position;
+    REQUIRE(ring.Reserve(3, position));
+    ring.Write(position, "abc", 3);
+    REQUIRE(ring.empty());
+    ring.Commit(position, 3);
+    REQUIRE(ReadString(ring) == "abc");
+  }
+
+  SECTION("Later commits don't wait on earlier reservations.") {
+    uint64_t position1, position2, position3;
+    REQUIRE(ring.Reserve(2, position1));
+    REQUIRE(ring.Reserve(2, position2));
+    REQUIRE(ring.Reserve(2, position3));
+    ring.Write(position1, "ab", 2);
+    ring.Write(position2, "cd", 2);
+    ring.Write(position3, "ef", 2);
+    ring.Commit(position3, 2);
+    ring.Commit(position2, 2);
+    REQUIRE(ring.empty());
+    ring.Commit(position1, 2);
+    REQUIRE(ReadString(ring) == "abcdef");
+  }
+
+  SECTION("Reservations fail when the ring is full.") {
+    REQUIRE(WriteString(ring, "0123456789"));
+    REQUIRE(!WriteString(ring, "a"));
+    ring.Consume(4);
+    REQUIRE(!WriteString(ring, "abcde"));
+    REQUIRE(WriteString(ring, "abcd"));
+  }
+
+  SECTION("Bytes that wrap around the ring are split into two fragments.") {
+    REQUIRE(WriteString(ring, "0123456"));
+    ring.Consume(7);
+    REQUIRE(WriteString(ring, "abcdef"));
+    REQUIRE(ReadFragments(ring) == std::vector<std::string>{"abc", "def"});
+    REQUIRE(ReadString(ring) == "abcdef");
+  }
+
+  SECTION("Clear consumes all committed bytes.") {
+    REQUIRE(WriteString(ring, "abc"));
+    ring.Clear();
+    REQUIRE(ring.empty());
+    REQUIRE(ring.consumer_position() == 3);
+  }
+
+  SECTION("Reset discards reserved bytes.") {
+    uint64_t position;
+    REQUIRE(ring.Reserve(3, position));
+    ring.Reset();
+    REQUIRE(WriteString(ring, "abc"));
+    REQUIRE(ReadString(ring) == "abc");
+  }
+}
+
+TEST_CASE("ByteRing supports concurrent producers") {
+  const int num_threads = 4;
+  const int n = 10000;
+  ByteRing ring{1000};
+  std::vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < num_threads; ++thread_index) {
+    threads.emplace_back([&ring, thread_index] {
+      std::string record(1 + thread_index,
+                         static_cast<char>('a' + thread_index));
+      for (int i = 0; i < n; ++i) {
+        while (!WriteString(ring, record)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Records are only ever committed whole, so the consumer must always see
+  // runs of the same character whose length matches the producer.
+  std::vector<int> counts(num_threads, 0);
+  std::string pending;
+  const int total = n * (num_threads * (num_threads + 1)) / 2;
+  int num_read = 0;
+  while (num_read < total) {
+    auto s = ReadString(ring);
+    ring.Consume(s.size());
+    num_read += static_cast<int>(s.size());
+    pending.append(s);
+    size_t i = 0;
+    while (i < pending.size()) {
+      auto thread_index = pending[i] - 'a';
+      auto record_size = static_cast<size_t>(thread_index + 1);
+      REQUIRE(pending.size() - i >= record_size);
+      REQUIRE(pending.compare(i, record_size,
+                              std::string(record_size, pending[i])) == 0);
+      ++counts[thread_index];
+      i += record_size;
+    }
+    pending.clear();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto count : counts) {
+    REQUIRE(count == n);
+  }
+}
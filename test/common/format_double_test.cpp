@@ -0,0 +1,53 @@
+#include "common/format_double.h"
+
+#include <string>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+static std::string Delocalize(std::string s) {
+  s.resize(DelocalizeRadix(&s[0], s.size()));
+  return s;
+}
+
+static std::string Format(double x, size_t buffer_size = 32) {
+  std::string buffer(buffer_size, 'x');
+  auto size = FormatDouble(x, &buffer[0], buffer.size());
+  REQUIRE(size < buffer_size);
+  REQUIRE(buffer[size] == '\0');
+  buffer.resize(size);
+  return buffer;
+}
+
+TEST_CASE("FormatDouble") {
+  SECTION("Doubles are formatted like %g") {
+    REQUIRE(Format(1.5) == "1.5");
+    REQUIRE(Format(-0.25) == "-0.25");
+    REQUIRE(Format(1e100) == "1e+100");
+    REQUIRE(Format(3) == "3");
+  }
+
+  SECTION("Numbers that don't fit are truncated") {
+    REQUIRE(Format(1.5, 3) == "1.");
+    REQUIRE(Format(1.5, 1).empty());
+  }
+}
+
+TEST_CASE("DelocalizeRadix") {
+  SECTION("Numbers formatted with '.' are left alone") {
+    REQUIRE(Delocalize("1.5") == "1.5");
+    REQUIRE(Delocalize("-2.5e-10") == "-2.5e-10");
+    REQUIRE(Delocalize("3") == "3");
+    REQUIRE(Delocalize("1e+100") == "1e+100");
+  }
+
+  SECTION("A comma radix is replaced") {
+    REQUIRE(Delocalize("1,5") == "1.5");
+    REQUIRE(Delocalize("-2,5e-10") == "-2.5e-10");
+  }
+
+  SECTION("A radix of several characters is replaced") {
+    REQUIRE(Delocalize("1\xd9\xab"
+                       "5") == "1.5");
+  }
+}
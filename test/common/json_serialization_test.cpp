@@ -0,0 +1,121 @@
+#include "common/json_serialization.h"
+
+#include <clocale>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "common/direct_coded_output_stream.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+using namespace opentracing;
+
+static std::string ToJsonDirect(const Value& value) {
+  std::string result(ComputeJsonSerializationSize(value), ' ');
+  DirectCodedOutputStream stream{
+      reinterpret_cast<google::protobuf::uint8*>(&result[0])};
+  WriteJson(stream, value);
+  REQUIRE(reinterpret_cast<const char*>(stream.data()) ==
+          result.data() + result.size());
+  return result;
+}
+
+static std::string ToJsonCoded(const Value& value) {
+  std::string result;
+  {
+    google::protobuf::io::StringOutputStream output_stream{&result};
+    google::protobuf::io::CodedOutputStream stream{&output_stream};
+    WriteJson(stream, value);
+  }
+  REQUIRE(result.size() == ComputeJsonSerializationSize(value));
+  return result;
+}
+
+static std::string ToJson(const Value& value) {
+  auto result = ToJsonDirect(value);
+  REQUIRE(ToJsonCoded(value) == result);
+  return result;
+}
+
+// Switches LC_NUMERIC to a locale that uses a comma as its radix character,
+// if one is installed, and restores the previous locale when destroyed.
+namespace {
+class CommaRadixLocale {
+ public:
+  CommaRadixLocale() {
+    previous_locale_ = std::setlocale(LC_NUMERIC, nullptr);
+    for (auto name : {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8",
+                      "fr_FR.utf8", "fr_FR"}) {
+      if (std::setlocale(LC_NUMERIC, name) != nullptr) {
+        is_set_ = *std::localeconv()->decimal_point == ',';
+        return;
+      }
+    }
+  }
+
+  CommaRadixLocale(const CommaRadixLocale&) = delete;
+  CommaRadixLocale& operator=(const CommaRadixLocale&) = delete;
+
+  ~CommaRadixLocale() {
+    std::setlocale(LC_NUMERIC, previous_locale_.c_str());
+  }
+
+  bool is_set() const noexcept { return is_set_; }
+
+ private:
+  std::string previous_locale_;
+  bool is_set_{false};
+};
+}  // namespace
+
+TEST_CASE("JsonSerialization") {
+  SECTION("Scalars are encoded within arrays") {
+    REQUIRE(ToJson(Values{}) == "[]");
+    REQUIRE(ToJson(Values{true, false, nullptr}) == "[true,false,null]");
+    REQUIRE(ToJson(Values{1, -2, 3u}) == "[1,-2,3]");
+    REQUIRE(ToJson(Values{"abc", std::string{"xyz"}}) == R"(["abc","xyz"])");
+  }
+
+  SECTION("Integer limits are encoded exactly") {
+    REQUIRE(ToJson(Values{std::numeric_limits<int64_t>::min()}) ==
+            "[-9223372036854775808]");
+    REQUIRE(ToJson(Values{std::numeric_limits<uint64_t>::max()}) ==
+            "[18446744073709551615]");
+  }
+
+  SECTION("Doubles are encoded like %g") {
+    REQUIRE(ToJson(Values{1.5, 1e100, -0.25}) == "[1.5,1e+100,-0.25]");
+    REQUIRE(ToJson(Values{std::numeric_limits<double>::quiet_NaN(),
+                          std::numeric_limits<double>::infinity(),
+                          -std::numeric_limits<double>::infinity()}) ==
+            R"(["NaN","+Inf","-Inf"])");
+  }
+
+  SECTION("Doubles use '.' as the radix character in any locale") {
+    CommaRadixLocale locale;
+    if (!locale.is_set()) {
+      WARN("No comma radix locale is installed");
+      return;
+    }
+    REQUIRE(ToJson(Values{1.5, -0.25, 2.5e-10}) == "[1.5,-0.25,2.5e-10]");
+  }
+
+  SECTION("Special characters in strings are escaped") {
+    REQUIRE(ToJson(Values{"a\"b\\c\b\n\r\t\x0f\x1f"}) ==
+            R"(["a\"b\\c\b\n\r\t\u000f\u001f"])");
+  }
+
+  SECTION("Numbers after an escaped string are still decimal") {
+    REQUIRE(ToJson(Values{"\x0f", 10}) == R"(["\u000f",10])");
+  }
+
+  SECTION("Dictionaries and nested aggregates are encoded") {
+    REQUIRE(ToJson(Dictionary{}) == "{}");
+    REQUIRE(ToJson(Dictionary{{"a\n", Values{1, Dictionary{{"b", "c"}}}}}) ==
+            R"({"a\n":[1,{"b":"c"}]})");
+  }
+}
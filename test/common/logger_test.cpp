@@ -1,8 +1,22 @@
 #include "common/logger.h"
 
+#include <chrono>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "3rd_party/catch2/catch.hpp"
 using namespace lightstep;
 
+namespace {
+struct Streamable {};
+
+std::ostream& operator<<(std::ostream& out, const Streamable& /*streamable*/) {
+  return out << "streamable";
+}
+}  // namespace
+
 TEST_CASE("logger") {
   LogLevel logged_level = LogLevel::off;
   std::string logged_message;
@@ -38,3 +52,66 @@ TEST_CASE("logger") {
     CHECK(logged_message == "abc123");
   }
 }
+
+TEST_CASE("LogMessageBuffer") {
+  auto& buffer = LogMessageBuffer::GetThreadInstance();
+
+  SECTION("Numbers are formatted without streams") {
+    Concatenate(buffer, -123, ' ', 456u, ' ', 1.5, ' ', true);
+    CHECK(buffer.message() == "-123 456 1.5 1");
+  }
+
+  SECTION("The minimum integer is formatted correctly") {
+    buffer.Append(std::numeric_limits<int64_t>::min());
+    CHECK(buffer.message() ==
+          std::to_string(std::numeric_limits<int64_t>::min()));
+  }
+
+  SECTION("Types without a specific overload use operator<<") {
+    buffer.Append(std::chrono::seconds{3}.count());
+    buffer.Append(Streamable{});
+    CHECK(buffer.message() == "3streamable");
+  }
+
+  SECTION("Long messages are truncated") {
+    std::string s(2 * MaxLogMessageSize, 'a');
+    buffer.Append(s);
+    CHECK(buffer.message().size() == MaxLogMessageSize);
+  }
+
+  SECTION("Getting the thread's buffer clears it") {
+    buffer.Append("abc");
+    CHECK(LogMessageBuffer::GetThreadInstance().message().empty());
+  }
+}
+
+TEST_CASE("LogRateLimiter") {
+  auto now = std::chrono::steady_clock::now();
+  LogRateLimiter rate_limiter{2, std::chrono::seconds{1}};
+  int64_t num_suppressed;
+
+  SECTION("Messages past the limit are suppressed until the next period") {
+    CHECK(rate_limiter.Acquire(now, num_suppressed));
+    CHECK(num_suppressed == 0);
+    CHECK(rate_limiter.Acquire(now, num_suppressed));
+    CHECK(!rate_limiter.Acquire(now, num_suppressed));
+    CHECK(!rate_limiter.Acquire(now, num_suppressed));
+    CHECK(rate_limiter.Acquire(now + std::chrono::seconds{2}, num_suppressed));
+    CHECK(num_suppressed == 2);
+  }
+
+  SECTION("The logger appends the number of suppressed messages") {
+    std::vector<std::string> messages;
+    Logger logger{[&](LogLevel /*level*/, opentracing::string_view message) {
+      messages.emplace_back(message);
+    }};
+    LogRateLimiter logger_rate_limiter{1, std::chrono::milliseconds{10}};
+    logger.Error(logger_rate_limiter, "a");
+    logger.Error(logger_rate_limiter, "b");
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    logger.Error(logger_rate_limiter, "c");
+    REQUIRE(messages.size() == 2);
+    CHECK(messages[0] == "a");
+    CHECK(messages[1] == "c (suppressed 1 similar messages)");
+  }
+}
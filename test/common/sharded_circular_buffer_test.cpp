@@ -0,0 +1,128 @@
+#include "common/sharded_circular_buffer.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+static void GenerateNumbers(ShardedCircularBuffer<uint32_t>& buffer,
+                            std::vector<uint32_t>& numbers, uint32_t first,
+                            int n) {
+  for (int i = 0; i < n; ++i) {
+    auto value = first + static_cast<uint32_t>(i);
+    std::unique_ptr<uint32_t> x{new uint32_t{value}};
+    if (buffer.Add(x)) {
+      numbers.push_back(value);
+    }
+  }
+}
+
+static void ConsumeNumbers(ShardedCircularBuffer<uint32_t>& buffer,
+                           std::vector<uint32_t>& numbers) {
+  for (size_t i = 0; i < buffer.num_shards(); ++i) {
+    auto& shard = buffer.shard(i);
+    shard.Consume(
+        shard.size(),
+        [&](CircularBufferRange<AtomicUniquePtr<uint32_t>> range) noexcept {
+          range.ForEach([&](AtomicUniquePtr<uint32_t> & ptr) noexcept {
+            numbers.push_back(*ptr);
+            ptr.Reset();
+            return true;
+          });
+        });
+  }
+}
+
+TEST_CASE("ShardedCircularBuffer") {
+  SECTION("The maximum size is split across the shards.") {
+    ShardedCircularBuffer<int> buffer{10, 3};
+    REQUIRE(buffer.num_shards() == 3);
+    REQUIRE(buffer.max_size() == 10);
+    REQUIRE(buffer.shard(0).max_size() == 4);
+    REQUIRE(buffer.shard(1).max_size() == 3);
+    REQUIRE(buffer.shard(2).max_size() == 3);
+  }
+
+  SECTION("There are never more shards than elements.") {
+    ShardedCircularBuffer<int> buffer{2, 8};
+    REQUIRE(buffer.num_shards() == 2);
+  }
+
+  SECTION("The default number of shards is bounded.") {
+    ShardedCircularBuffer<int> buffer{1000};
+    REQUIRE(buffer.num_shards() >= 1);
+    REQUIRE(buffer.num_shards() <=
+            ShardedCircularBuffer<int>::MaxDefaultNumShards);
+  }
+
+  SECTION("Elements spill over into other shards when a shard is full.") {
+    ShardedCircularBuffer<uint32_t> buffer{4, 2};
+    std::vector<uint32_t> numbers;
+    GenerateNumbers(buffer, numbers, 0, 10);
+    REQUIRE(numbers.size() == 4);
+    REQUIRE(buffer.size() == 4);
+    REQUIRE(buffer.production_count() == 4);
+    REQUIRE(!buffer.shard(0).empty());
+    REQUIRE(!buffer.shard(1).empty());
+
+    std::vector<uint32_t> consumed;
+    ConsumeNumbers(buffer, consumed);
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.consumption_count() == 4);
+    std::sort(consumed.begin(), consumed.end());
+    REQUIRE(consumed == numbers);
+  }
+
+  SECTION("AddToShard returns the shard an element was added to.") {
+    ShardedCircularBuffer<uint32_t> buffer{2, 2};
+    std::unique_ptr<uint32_t> x{new uint32_t{1}};
+    auto shard1 = buffer.AddToShard(x);
+    REQUIRE(shard1 != nullptr);
+    REQUIRE(shard1->size() == 1);
+    x.reset(new uint32_t{2});
+    auto shard2 = buffer.AddToShard(x);
+    REQUIRE(shard2 != nullptr);
+    REQUIRE(shard2 != shard1);
+    x.reset(new uint32_t{3});
+    REQUIRE(buffer.AddToShard(x) == nullptr);
+  }
+
+  SECTION("Clear removes the elements of every shard.") {
+    ShardedCircularBuffer<uint32_t> buffer{4, 2};
+    std::vector<uint32_t> numbers;
+    GenerateNumbers(buffer, numbers, 0, 4);
+    buffer.Clear();
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.size() == 0);
+  }
+
+  SECTION("Elements added from multiple threads are all consumed.") {
+    const int num_threads = 8;
+    const int n = 1000;
+    ShardedCircularBuffer<uint32_t> buffer{num_threads * n, 4};
+    std::vector<std::vector<uint32_t>> thread_numbers(num_threads);
+    std::vector<std::thread> threads(num_threads);
+    for (int thread_index = 0; thread_index < num_threads; ++thread_index) {
+      threads[thread_index] = std::thread{
+          GenerateNumbers, std::ref(buffer),
+          std::ref(thread_numbers[thread_index]),
+          static_cast<uint32_t>(thread_index * n), n};
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    std::vector<uint32_t> numbers;
+    for (auto& v : thread_numbers) {
+      numbers.insert(numbers.end(), v.begin(), v.end());
+    }
+    REQUIRE(numbers.size() == num_threads * n);
+
+    std::vector<uint32_t> consumed;
+    ConsumeNumbers(buffer, consumed);
+    std::sort(numbers.begin(), numbers.end());
+    std::sort(consumed.begin(), consumed.end());
+    REQUIRE(consumed == numbers);
+  }
+}
@@ -0,0 +1,69 @@
+#include "common/sharded_reference_count.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+TEST_CASE("ShardedReferenceCount") {
+  ShardedReferenceCount references{4};
+  REQUIRE(references.num_shards() == 4);
+  REQUIRE(references.count() == 0);
+
+  SECTION("The owner's reference is the last when nothing else is held.") {
+    REQUIRE(references.ReleaseOwner());
+  }
+
+  SECTION("Acquired references outlive the owner's reference.") {
+    references.Acquire();
+    references.Acquire();
+    REQUIRE(references.count() == 2);
+    REQUIRE(!references.ReleaseOwner());
+    REQUIRE(references.count() == 2);
+    REQUIRE(!references.Release());
+    REQUIRE(references.Release());
+  }
+
+  SECTION("References can be acquired after the owner releases.") {
+    references.Acquire();
+    REQUIRE(!references.ReleaseOwner());
+    references.Acquire();
+    REQUIRE(!references.Release());
+    REQUIRE(references.Release());
+  }
+
+  SECTION("References can be released from a different thread.") {
+    references.Acquire();
+    std::thread thread{[&] { REQUIRE(!references.Release()); }};
+    thread.join();
+    REQUIRE(references.count() == 0);
+    REQUIRE(references.ReleaseOwner());
+  }
+
+  SECTION("Exactly one release is last when threads race the owner.") {
+    const int num_threads = 8;
+    const int num_references = 1000;
+    std::atomic<int> num_last{0};
+    for (int i = 0; i < num_threads; ++i) {
+      references.Acquire();
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < num_references; ++j) {
+          references.Acquire();
+          num_last += static_cast<int>(references.Release());
+        }
+        num_last += static_cast<int>(references.Release());
+      });
+    }
+    num_last += static_cast<int>(references.ReleaseOwner());
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    REQUIRE(num_last == 1);
+  }
+}
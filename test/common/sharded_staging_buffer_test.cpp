@@ -0,0 +1,113 @@
+#include "common/sharded_staging_buffer.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+TEST_CASE("ShardedStagingBuffer") {
+  ShardedStagingBuffer<std::unique_ptr<int>> buffer{4};
+  REQUIRE(buffer.num_shards() == 4);
+  std::vector<int> consumed;
+  auto consume = [&] {
+    consumed.clear();
+    buffer.Consume([&](std::unique_ptr<int>&& x) {
+      consumed.push_back(*x);
+      x.reset();
+    });
+  };
+
+  SECTION("Consuming an empty buffer does nothing.") {
+    consume();
+    REQUIRE(consumed.empty());
+  }
+
+  SECTION("Staged elements are consumed once in the order they were added.") {
+    buffer.Add(std::unique_ptr<int>{new int{1}});
+    buffer.Add(std::unique_ptr<int>{new int{2}});
+    consume();
+    REQUIRE(consumed == std::vector<int>{1, 2});
+    consume();
+    REQUIRE(consumed.empty());
+  }
+
+  SECTION("Elements can be constructed while staging them.") {
+    buffer.Emplace([] { return std::unique_ptr<int>{new int{3}}; });
+    consume();
+    REQUIRE(consumed == std::vector<int>{3});
+  }
+
+  SECTION("TryEmplace only stages elements while the shard has room.") {
+    auto make_value = [] { return std::unique_ptr<int>{new int{4}}; };
+    REQUIRE(buffer.TryEmplace(8, make_value) == 2);
+    REQUIRE(buffer.TryEmplace(8, make_value) == 1);
+    REQUIRE(buffer.TryEmplace(8, make_value) == 0);
+    consume();
+    REQUIRE(consumed == std::vector<int>{4, 4});
+    REQUIRE(buffer.TryEmplace(8, make_value) == 2);
+  }
+
+  SECTION("TryEmplace gives every shard room for at least one element.") {
+    auto make_value = [] { return std::unique_ptr<int>{new int{5}}; };
+    REQUIRE(buffer.TryEmplace(1, make_value) == 1);
+    REQUIRE(buffer.TryEmplace(1, make_value) == 0);
+  }
+
+  SECTION("TryEmplace keeps the elements staged across shards to the limit.") {
+    const int num_threads = 8;
+    const size_t max_size = 10;
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < 100; ++j) {
+          buffer.TryEmplace(max_size,
+                            [j] { return std::unique_ptr<int>{new int{j}}; });
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    consume();
+    REQUIRE(!consumed.empty());
+    REQUIRE(consumed.size() <= max_size);
+  }
+
+  SECTION("empty checks whether any shard has staged elements.") {
+    REQUIRE(buffer.empty());
+    buffer.Add(std::unique_ptr<int>{new int{1}});
+    REQUIRE(!buffer.empty());
+    consume();
+    REQUIRE(buffer.empty());
+  }
+
+  SECTION("Elements can be staged from many threads.") {
+    const int num_threads = 8;
+    const int num_elements = 1000;
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < num_elements; ++j) {
+          buffer.Add(std::unique_ptr<int>{new int{j}});
+        }
+      });
+    }
+    size_t num_consumed = 0;
+    auto consume_all = [&] {
+      consume();
+      num_consumed += consumed.size();
+    };
+    for (int i = 0; i < 10; ++i) {
+      consume_all();
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    consume_all();
+    REQUIRE(num_consumed == num_threads * num_elements);
+  }
+}
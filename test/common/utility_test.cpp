@@ -1,7 +1,10 @@
 #include "common/utility.h"
 
+#include <chrono>
 #include <cmath>
 #include <limits>
+#include <utility>
+#include <vector>
 
 #include "3rd_party/catch2/catch.hpp"
 using namespace lightstep;
@@ -55,3 +58,27 @@ TEST_CASE("Json") {
     REQUIRE(key_value1.json_value() == "[null]");
   }
 }
+
+TEST_CASE("SetKeyValue") {
+  google::protobuf::Arena arena;
+  auto& key_value =
+      *google::protobuf::Arena::CreateMessage<collector::KeyValue>(&arena);
+
+  SECTION("Key-values are set in place on the message's arena.") {
+    SetKeyValue(key_value, "abc", 123);
+    REQUIRE(key_value.GetArena() == &arena);
+    REQUIRE(key_value.key() == "abc");
+    REQUIRE(key_value.int_value() == 123);
+  }
+
+  SECTION("Log records are set in place on the message's arena.") {
+    auto& log = *google::protobuf::Arena::CreateMessage<collector::Log>(&arena);
+    std::vector<std::pair<string_view, Value>> fields = {{"abc", 123},
+                                                         {"xyz", "x"}};
+    SetLog(log, std::chrono::system_clock::now(), fields.begin(),
+           fields.end());
+    REQUIRE(log.fields_size() == 2);
+    REQUIRE(log.fields(0).GetArena() == &arena);
+    REQUIRE(log.fields(1).string_value() == "x");
+  }
+}
@@ -0,0 +1,81 @@
+#include "network/event_notifier.h"
+
+#include <chrono>
+#include <thread>
+
+#include "network/event.h"
+#include "network/event_base.h"
+
+#include "3rd_party/catch2/catch.hpp"
+
+#include <event2/event.h>
+
+using namespace lightstep;
+
+namespace {
+struct CallbackContext {
+  EventBase* event_base{nullptr};
+  EventNotifier* notifier{nullptr};
+  int num_notifications{0};
+};
+}  // namespace
+
+static void NotificationCallback(int /*file_descriptor*/, short /*what*/,
+                                 void* context) {
+  auto& callback_context = *static_cast<CallbackContext*>(context);
+  callback_context.notifier->Consume();
+  ++callback_context.num_notifications;
+  callback_context.event_base->LoopBreak();
+}
+
+TEST_CASE("EventNotifier") {
+  EventBase event_base;
+  EventNotifier notifier;
+  CallbackContext callback_context;
+  callback_context.event_base = &event_base;
+  callback_context.notifier = &notifier;
+  Event event{event_base, notifier.file_descriptor(), EV_READ | EV_PERSIST,
+              NotificationCallback, static_cast<void*>(&callback_context)};
+  event.Add(nullptr);
+
+  SECTION("Notify wakes up the event loop.") {
+    REQUIRE(!notifier.pending());
+    notifier.Notify();
+    REQUIRE(notifier.pending());
+    event_base.Dispatch();
+    REQUIRE(callback_context.num_notifications == 1);
+    REQUIRE(!notifier.pending());
+  }
+
+  SECTION("Notify can be called from another thread.") {
+    std::thread thread{[&notifier] {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      notifier.Notify();
+    }};
+    event_base.Dispatch();
+    thread.join();
+    REQUIRE(callback_context.num_notifications == 1);
+  }
+
+  SECTION("Notifications are coalesced until consumed.") {
+    notifier.Notify();
+    notifier.Notify();
+    notifier.Notify();
+    event_base.Dispatch();
+    REQUIRE(callback_context.num_notifications == 1);
+
+    // No notification is left over so the loop should time out.
+    event_base.OnTimeout(
+        std::chrono::milliseconds{50},
+        [](int /*file_descriptor*/, short /*what*/, void* context) {
+          static_cast<EventBase*>(context)->LoopBreak();
+        },
+        static_cast<void*>(&event_base));
+    event_base.Dispatch();
+    REQUIRE(callback_context.num_notifications == 1);
+
+    notifier.Notify();
+    event_base.Dispatch();
+    REQUIRE(callback_context.num_notifications == 2);
+  }
+}
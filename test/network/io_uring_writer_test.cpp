@@ -0,0 +1,180 @@
+#include "network/io_uring_writer.h"
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "3rd_party/catch2/catch.hpp"
+#include "common/fragment_array_input_stream.h"
+#include "network/event_base.h"
+#include "network/socket.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using namespace lightstep;
+
+static std::string ReadAll(FileDescriptor file_descriptor) {
+  std::string result;
+  std::array<char, 4096> buffer;
+  while (true) {
+    auto rcode = ::read(file_descriptor, static_cast<void*>(buffer.data()),
+                        buffer.size());
+    if (rcode <= 0) {
+      return result;
+    }
+    result.append(buffer.data(), static_cast<size_t>(rcode));
+  }
+}
+
+namespace {
+struct WriteContext {
+  EventBase* event_base{nullptr};
+  int num_pending_writes{0};
+  int num_completions{0};
+  ErrorCode error_code{0};
+
+  void OnWriteComplete(ErrorCode write_error_code) {
+    ++num_completions;
+    if (write_error_code != 0) {
+      error_code = write_error_code;
+    }
+    if (--num_pending_writes == 0) {
+      event_base->LoopBreak();
+    }
+  }
+};
+}  // namespace
+
+static void BreakLoop(FileDescriptor /*file_descriptor*/, short /*what*/,
+                      void* context) {
+  static_cast<EventBase*>(context)->LoopBreak();
+}
+
+TEST_CASE("IoUringWriter") {
+  EventBase event_base;
+  std::unique_ptr<IoUringWriter> writer;
+  try {
+    writer.reset(new IoUringWriter{event_base, 2});
+  } catch (const std::exception& e) {
+    WARN("io_uring isn't supported: " << e.what());
+    return;
+  }
+
+  int descriptors[2];
+  REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, descriptors) == 0);
+  Socket writer_socket{descriptors[0]};
+  Socket reader_socket{descriptors[1]};
+
+  WriteContext context;
+  context.event_base = &event_base;
+  auto callback =
+      MakeIoUringWriteCallback<WriteContext, &WriteContext::OnWriteComplete>();
+  IoUringWrite write1{*writer, callback, static_cast<void*>(&context)};
+  IoUringWrite write2{*writer, callback, static_cast<void*>(&context)};
+
+  FragmentArrayInputStream fragments1{MakeFragment("abc"), MakeFragment("123")};
+  FragmentArrayInputStream fragments2{MakeFragment("xyz"), MakeFragment("")};
+
+  SECTION("Queueing a write with no fragments returns false.") {
+    FragmentArrayInputStream fragments{MakeFragment("")};
+    REQUIRE(!write1.Queue(writer_socket.file_descriptor(), {&fragments}));
+    REQUIRE(!write1.pending());
+  }
+
+  SECTION(
+      "Writes queued together are submitted together and consume their "
+      "fragments right away.") {
+    REQUIRE(write1.Queue(writer_socket.file_descriptor(), {&fragments1}));
+    REQUIRE(write2.Queue(writer_socket.file_descriptor(), {&fragments2}));
+    REQUIRE(fragments1.empty());
+    REQUIRE(fragments2.empty());
+    context.num_pending_writes = 2;
+    event_base.Dispatch();
+    REQUIRE(context.num_completions == 2);
+    REQUIRE(context.error_code == 0);
+    REQUIRE(!write1.pending());
+    REQUIRE(!write2.pending());
+    writer_socket = Socket{};
+    REQUIRE(ReadAll(reader_socket.file_descriptor()) == "abc123xyz");
+  }
+
+  SECTION("We can write more fragments than fit in the submission queue.") {
+    for (int num_fragments : {IoVecMax + 1, 2 * IoVecMax, 5 * IoVecMax + 3}) {
+      SECTION("num_fragments = " + std::to_string(num_fragments)) {
+        FragmentArrayInputStream fragments;
+        std::string data;
+        for (int i = 0; i < num_fragments; ++i) {
+          data.push_back(static_cast<char>('a' + i % 26));
+        }
+        for (int i = 0; i < num_fragments; ++i) {
+          fragments.Add(Fragment{static_cast<void*>(&data[i]), 1});
+        }
+        REQUIRE(write1.Queue(writer_socket.file_descriptor(), {&fragments}));
+        context.num_pending_writes = 1;
+        event_base.Dispatch();
+        REQUIRE(context.error_code == 0);
+        writer_socket = Socket{};
+        REQUIRE(ReadAll(reader_socket.file_descriptor()) == data);
+      }
+    }
+  }
+
+  SECTION("Short writes are resubmitted until every byte is written.") {
+    std::string data(4 * 1024 * 1024, ' ');
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<char>('a' + i % 26);
+    }
+    auto reader_file_descriptor = reader_socket.file_descriptor();
+    std::string result;
+    std::thread reader{
+        [&result, reader_file_descriptor] {
+          result = ReadAll(reader_file_descriptor);
+        }};
+    FragmentArrayInputStream fragments{
+        {static_cast<void*>(&data[0]), static_cast<int>(data.size() / 2)},
+        {static_cast<void*>(&data[data.size() / 2]),
+         static_cast<int>(data.size() / 2)}};
+    REQUIRE(write1.Queue(writer_socket.file_descriptor(), {&fragments}));
+    context.num_pending_writes = 1;
+    event_base.Dispatch();
+    writer_socket = Socket{};
+    reader.join();
+    REQUIRE(context.error_code == 0);
+    REQUIRE(result == data);
+  }
+
+  SECTION("A blocked write can be canceled without calling its callback.") {
+    std::string data(16 * 1024 * 1024, 'x');
+    FragmentArrayInputStream fragments{
+        {static_cast<void*>(&data[0]), static_cast<int>(data.size())}};
+    REQUIRE(write1.Queue(writer_socket.file_descriptor(), {&fragments}));
+    context.num_pending_writes = 1;
+    event_base.OnTimeout(std::chrono::milliseconds{100}, BreakLoop,
+                         static_cast<void*>(&event_base));
+    event_base.Dispatch();
+    REQUIRE(write1.pending());
+    write1.Cancel();
+    REQUIRE(!write1.pending());
+    REQUIRE(context.num_completions == 0);
+
+    // The writer can still be used after a cancellation.
+    REQUIRE(write2.Queue(reader_socket.file_descriptor(), {&fragments1}));
+    event_base.Dispatch();
+    REQUIRE(context.num_completions == 1);
+    REQUIRE(context.error_code == 0);
+  }
+
+  SECTION("The callback is called with the error a write fails with.") {
+    auto file_descriptor = ::open("/dev/null", O_RDONLY);
+    REQUIRE(file_descriptor >= 0);
+    REQUIRE(write1.Queue(file_descriptor, {&fragments1}));
+    context.num_pending_writes = 1;
+    event_base.Dispatch();
+    ::close(file_descriptor);
+    REQUIRE(context.num_completions == 1);
+    REQUIRE(context.error_code != 0);
+  }
+}
@@ -34,4 +34,19 @@ TEST_CASE("IpAddress") {
     addr3.set_port(8080);
     REQUIRE(addr3.ipv6_address().sin6_port == htons(8080));
   }
+
+  SECTION("Addresses can be made for unix domain sockets.") {
+    auto addr5 = MakeUnixSocketAddress("/tmp/satellite.sock");
+    REQUIRE(addr5.family() == AF_UNIX);
+    REQUIRE(ToString(addr5) == "unix:///tmp/satellite.sock");
+    REQUIRE(addr5 == MakeUnixSocketAddress("/tmp/satellite.sock"));
+    REQUIRE(addr5 != MakeUnixSocketAddress("/tmp/satellite2.sock"));
+    REQUIRE(addr5 != addr1);
+    REQUIRE(addr5.addr_length() == sizeof(sockaddr_un));
+  }
+
+  SECTION("Unix domain socket paths must fit in a sockaddr.") {
+    REQUIRE_THROWS(MakeUnixSocketAddress(""));
+    REQUIRE_THROWS(MakeUnixSocketAddress(std::string(1000, 'a')));
+  }
 }
@@ -1,5 +1,10 @@
 #include "network/socket.h"
 
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
 #include "3rd_party/catch2/catch.hpp"
 
 using namespace lightstep;
@@ -26,4 +31,23 @@ TEST_CASE("Socket") {
     s1.SetNonblocking();
     s1.SetReuseAddress();
   }
+
+  SECTION("We can connect to a unix domain socket.") {
+    std::string path =
+        "/tmp/lightstep_socket_test_" + std::to_string(::getpid()) + ".sock";
+    std::remove(path.c_str());
+    auto address = MakeUnixSocketAddress(path);
+    Socket listener{AF_UNIX, SOCK_STREAM};
+    REQUIRE(::bind(listener.file_descriptor(), &address.addr(),
+                   static_cast<socklen_t>(address.addr_length())) == 0);
+    REQUIRE(::listen(listener.file_descriptor(), 1) == 0);
+    auto socket = Connect(address);
+    Socket peer{::accept(listener.file_descriptor(), nullptr, nullptr)};
+    REQUIRE(peer.file_descriptor() != InvalidSocket);
+    REQUIRE(::write(socket.file_descriptor(), "abc", 3) == 3);
+    char buffer[3];
+    REQUIRE(::read(peer.file_descriptor(), buffer, 3) == 3);
+    REQUIRE(std::string(buffer, 3) == "abc");
+    std::remove(path.c_str());
+  }
 }
@@ -83,6 +83,87 @@ TEST_CASE("VectorWrite") {
     }
   }
 
+  SECTION("Small fragments can be coalesced before they're written.") {
+    FragmentCoalescer coalescer{16, 8, 10};
+    FragmentArrayInputStream fragments;
+    std::string big_fragment(20, 'b');
+    for (auto s : {"a", "bc", "def", "ghij", "klmno"}) {
+      fragments.Add(MakeFragment(s));
+    }
+    fragments.Add(Fragment{static_cast<void*>(&big_fragment[0]), 20});
+    fragments.Add(MakeFragment("z"));
+    auto result = Write(socket.file_descriptor(), {&fragments}, &coalescer);
+    socket = Socket{};
+    REQUIRE(result);
+    REQUIRE(IsEventuallyTrue([&] {
+      return echo_server.data() == "abcdefghijklmno" + big_fragment + "z";
+    }));
+  }
+
+  SECTION("Fragments aren't coalesced if they're large enough on average.") {
+    FragmentCoalescer coalescer{2, 8, 10};
+    REQUIRE(!coalescer.ShouldCoalesce(2, 6));
+    REQUIRE(coalescer.ShouldCoalesce(4, 6));
+    auto result =
+        Write(socket.file_descriptor(), {&fragments1, &fragments2}, &coalescer);
+    socket = Socket{};
+    REQUIRE(result);
+    REQUIRE(
+        IsEventuallyTrue([&] { return echo_server.data() == "abc123xyz"; }));
+  }
+
+  SECTION("Coalesced writes consume only what was written.") {
+    socket.SetNonblocking();
+    FragmentCoalescer coalescer{1000, 100, 4096};
+    std::string data(64, 'x');
+    int i = 0;
+    int max_iterations = 100000;
+    for (; i < max_iterations; ++i) {
+      FragmentArrayInputStream fragments;
+      for (int j = 0; j < 100; ++j) {
+        fragments.Add(Fragment{static_cast<void*>(&data[0]), 64});
+      }
+      if (!Write(socket.file_descriptor(), {&fragments}, &coalescer)) {
+        REQUIRE(!fragments.empty());
+        break;
+      }
+      REQUIRE(fragments.empty());
+    }
+    REQUIRE(i < max_iterations);
+  }
+
+  SECTION("Writes below the minimum size aren't sent with MSG_ZEROCOPY.") {
+    ZeroCopySendTracker zero_copy{100};
+    auto result = Write(socket.file_descriptor(), {&fragments1, &fragments2},
+                        nullptr, &zero_copy);
+    socket = Socket{};
+    REQUIRE(result);
+    REQUIRE(zero_copy.num_sends() == 0);
+    REQUIRE(
+        IsEventuallyTrue([&] { return echo_server.data() == "abc123xyz"; }));
+  }
+
+  SECTION("Large writes can be sent with MSG_ZEROCOPY.") {
+    ZeroCopySendTracker zero_copy{1};
+    if (EnableZeroCopy(socket.file_descriptor())) {
+      std::string data(10000, 'x');
+      FragmentArrayInputStream fragments{
+          {static_cast<void*>(&data[0]), static_cast<int>(data.size())}};
+      REQUIRE(Write(socket.file_descriptor(), {&fragments}, nullptr,
+                    &zero_copy));
+      REQUIRE(zero_copy.num_sends() == 1);
+      REQUIRE(IsEventuallyTrue([&] {
+        zero_copy.ReadCompletions(socket.file_descriptor());
+        return !zero_copy.has_pending_sends();
+      }));
+
+      // Loopback connections copy the data, so zero-copy isn't used again.
+      REQUIRE(!zero_copy.ShouldUseZeroCopy(data.size()));
+      socket = Socket{};
+      REQUIRE(IsEventuallyTrue([&] { return echo_server.data() == data; }));
+    }
+  }
+
   SECTION("Write throws an exception when there's an error.") {
     socket.SetNonblocking();
     auto file_descriptor = socket.file_descriptor();
@@ -90,3 +171,43 @@ TEST_CASE("VectorWrite") {
     REQUIRE_THROWS(Write(file_descriptor, {&fragments1, &fragments2}));
   }
 }
+
+TEST_CASE("ZeroCopySendTracker") {
+  ZeroCopySendTracker zero_copy{10};
+  for (int i = 0; i < 4; ++i) {
+    zero_copy.OnSend();
+  }
+  REQUIRE(zero_copy.num_sends() == 4);
+  REQUIRE(zero_copy.has_pending_sends());
+
+  SECTION("Zero-copy is only used for writes of at least the minimum size.") {
+    REQUIRE(!zero_copy.ShouldUseZeroCopy(9));
+    REQUIRE(zero_copy.ShouldUseZeroCopy(10));
+  }
+
+  SECTION("Completions advance the number of completed sends.") {
+    zero_copy.OnCompletion(0, 1, false);
+    REQUIRE(zero_copy.num_completed_sends() == 2);
+    zero_copy.OnCompletion(2, 3, false);
+    REQUIRE(zero_copy.num_completed_sends() == 4);
+    REQUIRE(!zero_copy.has_pending_sends());
+  }
+
+  SECTION("Completions can arrive out of order.") {
+    zero_copy.OnCompletion(2, 2, false);
+    zero_copy.OnCompletion(1, 1, false);
+    REQUIRE(zero_copy.num_completed_sends() == 0);
+    zero_copy.OnCompletion(3, 3, false);
+    zero_copy.OnCompletion(0, 0, false);
+    REQUIRE(zero_copy.num_completed_sends() == 4);
+  }
+
+  SECTION("Zero-copy is disabled once the kernel reports copying.") {
+    zero_copy.OnCompletion(0, 0, true);
+    REQUIRE(!zero_copy.ShouldUseZeroCopy(100));
+    zero_copy.Reset();
+    REQUIRE(zero_copy.ShouldUseZeroCopy(100));
+    REQUIRE(zero_copy.num_sends() == 0);
+    REQUIRE(!zero_copy.has_pending_sends());
+  }
+}
@@ -46,9 +46,9 @@ GenerateRandomBinaryNumber(size_t max_digits) {
 //--------------------------------------------------------------------------------------------------
 // GenerateRandomBinaryNumbers
 //--------------------------------------------------------------------------------------------------
-static void GenerateRandomBinaryNumbers(CircularBuffer<ChainedStream>& buffer,
-                                        std::vector<uint32_t>& numbers,
-                                        size_t n) {
+static void GenerateRandomBinaryNumbers(
+    ShardedCircularBuffer<ChainedStream>& buffer,
+    std::vector<uint32_t>& numbers, size_t n) {
   while (n-- != 0) {
     uint32_t x;
     opentracing::string_view s;
@@ -163,9 +163,9 @@ static bool HasPendingData(ConnectionStream& connection_stream) {
 //--------------------------------------------------------------------------------------------------
 // RunBinaryNumberProducer
 //--------------------------------------------------------------------------------------------------
-void RunBinaryNumberProducer(CircularBuffer<ChainedStream>& buffer,
-                             std::vector<uint32_t>& numbers, size_t num_threads,
-                             size_t n) {
+void RunBinaryNumberProducer(ShardedCircularBuffer<ChainedStream>& buffer,
+                             std::vector<uint32_t>& numbers,
+                             size_t num_threads, size_t n) {
   std::vector<std::vector<uint32_t>> thread_numbers(num_threads);
   std::vector<std::thread> threads(num_threads);
   for (size_t thread_index = 0; thread_index < num_threads; ++thread_index) {
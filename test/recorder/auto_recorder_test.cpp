@@ -1,4 +1,6 @@
 #include <atomic>
+#include <thread>
+#include <vector>
 
 #include "3rd_party/catch2/catch.hpp"
 #include "lightstep/tracer.h"
@@ -27,7 +29,7 @@ TEST_CASE("auto_recorder") {
   auto recorder = new AutoRecorder{
       logger, std::move(options),
       std::unique_ptr<SyncTransporter>{in_memory_transporter},
-      std::unique_ptr<ConditionVariableWrapper>{condition_variable}};
+      std::unique_ptr<ConditionVariableWrapper>{condition_variable}, 1};
   auto tracer = std::shared_ptr<opentracing::Tracer>{new LegacyTracerImpl{
       PropagationOptions{}, std::unique_ptr<Recorder>{recorder}}};
   CHECK(tracer);
@@ -202,3 +204,58 @@ TEST_CASE("auto_recorder") {
     REQUIRE_NOTHROW(condition_variable->WaitTillNextEvent());
   }
 }
+
+TEST_CASE("auto_recorder with several staging shards") {
+  Logger logger{};
+  auto metrics_observer = new CountingMetricsObserver{};
+  LightStepTracerOptions options;
+  const size_t max_buffered_spans = 8;
+  options.reporting_period = std::chrono::milliseconds{2};
+  options.max_buffered_spans =
+      std::function<size_t()>{[=] { return max_buffered_spans; }};
+  options.metrics_observer.reset(metrics_observer);
+  auto in_memory_transporter = new InMemorySyncTransporter{};
+  auto condition_variable = new TestingConditionVariableWrapper{};
+  auto recorder = new AutoRecorder{
+      logger, std::move(options),
+      std::unique_ptr<SyncTransporter>{in_memory_transporter},
+      std::unique_ptr<ConditionVariableWrapper>{condition_variable}, 4};
+  auto tracer = std::shared_ptr<opentracing::Tracer>{new LegacyTracerImpl{
+      PropagationOptions{}, std::unique_ptr<Recorder>{recorder}}};
+  CHECK(tracer);
+  REQUIRE_NOTHROW(condition_variable->WaitTillNextEvent());
+  condition_variable->set_block_notify_all(true);
+
+  SECTION(
+      "Spans staged across shards stay within `max_buffered_spans` and the "
+      "rest are dropped when they're recorded.") {
+    const int num_threads = 4;
+    const int num_spans_per_thread = 10;
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < num_spans_per_thread; ++j) {
+          auto span = tracer->StartSpan("abc");
+          span->Finish();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const int num_spans = num_threads * num_spans_per_thread;
+    CHECK(metrics_observer->num_spans_dropped >=
+          num_spans - static_cast<int>(max_buffered_spans));
+
+    condition_variable->set_block_notify_all(false);
+    REQUIRE_NOTHROW(condition_variable->Step());
+    REQUIRE_NOTHROW(condition_variable->WaitTillNextEvent());
+    auto reports = in_memory_transporter->reports();
+    REQUIRE(reports.size() == 1);
+    CHECK(reports.at(0).spans_size() ==
+          num_spans - metrics_observer->num_spans_dropped);
+    CHECK(metrics_observer->num_spans_sent ==
+          num_spans - metrics_observer->num_spans_dropped);
+  }
+}
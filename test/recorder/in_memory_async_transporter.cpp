@@ -16,34 +16,38 @@ InMemoryAsyncTransporter::InMemoryAsyncTransporter(
 // Succeed
 //--------------------------------------------------------------------------------------------------
 void InMemoryAsyncTransporter::Succeed() noexcept {
-  if (active_callback_ == nullptr || active_message_ == nullptr) {
+  if (pending_.empty()) {
     std::terminate();
   }
-  std::string s(active_message_->num_bytes(), ' ');
-  active_message_->CopyOut(&s[0], s.size());
-  collector::ReportRequest report;
-  if (!report.ParseFromString(s)) {
-    std::terminate();
+  auto pending = std::move(pending_);
+  pending_.clear();
+  for (auto& send : pending) {
+    auto& message = *send.second;
+    std::string s(message.num_bytes(), ' ');
+    message.CopyOut(&s[0], s.size());
+    collector::ReportRequest report;
+    if (!report.ParseFromString(s)) {
+      std::terminate();
+    }
+    reports_.emplace_back(report);
+    std::copy(report.spans().begin(), report.spans().end(),
+              std::back_inserter(spans_));
+    send.first->OnSuccess(message);
   }
-  reports_.emplace_back(report);
-  std::copy(report.spans().begin(), report.spans().end(),
-            std::back_inserter(spans_));
-
-  active_callback_->OnSuccess(*active_message_);
-  active_callback_ = nullptr;
-  active_message_.reset();
 }
 
 //--------------------------------------------------------------------------------------------------
 // Fail
 //--------------------------------------------------------------------------------------------------
 void InMemoryAsyncTransporter::Fail() noexcept {
-  if (active_callback_ == nullptr || active_message_ == nullptr) {
+  if (pending_.empty()) {
     std::terminate();
   }
-  active_callback_->OnFailure(*active_message_);
-  active_callback_ = nullptr;
-  active_message_.reset();
+  auto pending = std::move(pending_);
+  pending_.clear();
+  for (auto& send : pending) {
+    send.first->OnFailure(*send.second);
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -60,7 +64,6 @@ void InMemoryAsyncTransporter::OnSpanBufferFull() noexcept {
 //--------------------------------------------------------------------------------------------------
 void InMemoryAsyncTransporter::Send(std::unique_ptr<BufferChain>&& message,
                                     Callback& callback) noexcept {
-  active_callback_ = &callback;
-  active_message_ = std::move(message);
+  pending_.emplace_back(&callback, std::move(message));
 }
 }  // namespace lightstep
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "lightstep-tracer-common/collector.pb.h"
@@ -28,12 +30,17 @@ class InMemoryAsyncTransporter final : public AsyncTransporter {
   const std::vector<collector::Span>& spans() const noexcept { return spans_; }
 
   /**
-   * Make the last Send succeed.
+   * @return the number of Sends that haven't yet succeeded or failed.
+   */
+  size_t num_pending() const noexcept { return pending_.size(); }
+
+  /**
+   * Make the pending Sends succeed.
    */
   void Succeed() noexcept;
 
   /**
-   * Make the last Send fail.
+   * Make the pending Sends fail.
    */
   void Fail() noexcept;
 
@@ -49,7 +56,6 @@ class InMemoryAsyncTransporter final : public AsyncTransporter {
   std::vector<collector::ReportRequest> reports_;
   std::vector<collector::Span> spans_;
 
-  Callback* active_callback_{nullptr};
-  std::unique_ptr<BufferChain> active_message_;
+  std::vector<std::pair<Callback*, std::unique_ptr<BufferChain>>> pending_;
 };
 }  // namespace lightstep
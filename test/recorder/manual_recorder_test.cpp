@@ -28,8 +28,8 @@ TEST_CASE("ManualRecorder") {
   auto recorder = new ManualRecorder{
       logger, std::move(options),
       std::unique_ptr<AsyncTransporter>{in_memory_transporter}};
-  tracer = std::shared_ptr<LightStepTracer>{new TracerImpl{
-      PropagationOptions{}, std::unique_ptr<Recorder>{recorder}}};
+  tracer = MakeTracerImpl(PropagationOptions{},
+                          std::unique_ptr<Recorder>{recorder});
   REQUIRE(tracer);
 
   SECTION("Buffered spans get transported after Flush is manually called.") {
@@ -115,3 +115,122 @@ TEST_CASE("ManualRecorder") {
     CHECK(metrics_observer->num_spans_dropped == 2);
   }
 }
+
+TEST_CASE("ManualRecorder byte budget") {
+  Logger logger{};
+  auto metrics_observer = new CountingMetricsObserver{};
+  LightStepTracerOptions options;
+  options.max_buffered_spans = 100;
+  options.max_buffered_bytes = 1000;
+  options.metrics_observer.reset(metrics_observer);
+  auto in_memory_transporter = new InMemoryAsyncTransporter{[] {}};
+  auto recorder = new ManualRecorder{
+      logger, std::move(options),
+      std::unique_ptr<AsyncTransporter>{in_memory_transporter}};
+  auto tracer = MakeTracerImpl(PropagationOptions{},
+                               std::unique_ptr<Recorder>{recorder});
+  REQUIRE(tracer);
+  std::string large_value(400, 'x');
+  auto record_span = [&] {
+    auto span = tracer->StartSpan(
+        "abc", {opentracing::SetTag("large", large_value)});
+    CHECK(span);
+    span->Finish();
+  };
+
+  SECTION("Spans that would exceed the byte budget are dropped.") {
+    for (int i = 0; i < 3; ++i) {
+      record_span();
+    }
+    CHECK(metrics_observer->num_spans_dropped == 1);
+    CHECK(metrics_observer->num_bytes_dropped > large_value.size());
+  }
+
+  SECTION("Flushing returns bytes to the budget.") {
+    for (int i = 0; i < 2; ++i) {
+      record_span();
+    }
+    CHECK(tracer->Flush());
+    in_memory_transporter->Succeed();
+    for (int i = 0; i < 2; ++i) {
+      record_span();
+    }
+    CHECK(metrics_observer->num_spans_dropped == 0);
+    CHECK(tracer->Flush());
+    in_memory_transporter->Succeed();
+    CHECK(metrics_observer->num_spans_sent == 4);
+  }
+}
+
+TEST_CASE("ManualRecorder report limits") {
+  Logger logger{};
+  auto metrics_observer = new CountingMetricsObserver{};
+  LightStepTracerOptions options;
+  options.max_buffered_spans = 100;
+  options.max_report_spans = 2;
+  options.max_report_bytes = 1000;
+  options.metrics_observer.reset(metrics_observer);
+  auto in_memory_transporter = new InMemoryAsyncTransporter{[] {}};
+  auto recorder = new ManualRecorder{
+      logger, std::move(options),
+      std::unique_ptr<AsyncTransporter>{in_memory_transporter}};
+  auto tracer = MakeTracerImpl(PropagationOptions{},
+                               std::unique_ptr<Recorder>{recorder});
+  REQUIRE(tracer);
+  auto record_span = [&](const std::string& value) {
+    auto span =
+        tracer->StartSpan("abc", {opentracing::SetTag("value", value)});
+    CHECK(span);
+    span->Finish();
+  };
+
+  SECTION("Flushes are split into reports of at most max_report_spans.") {
+    for (int i = 0; i < 5; ++i) {
+      record_span("x");
+    }
+    CHECK(tracer->Flush());
+    CHECK(in_memory_transporter->num_pending() == 3);
+    in_memory_transporter->Succeed();
+    auto& reports = in_memory_transporter->reports();
+    REQUIRE(reports.size() == 3);
+    CHECK(reports[0].spans_size() == 2);
+    CHECK(reports[1].spans_size() == 2);
+    CHECK(reports[2].spans_size() == 1);
+    CHECK(metrics_observer->num_spans_sent == 5);
+    CHECK(metrics_observer->num_flushes == 1);
+  }
+
+  SECTION("Flushes are split into reports of at most max_report_bytes.") {
+    std::string large_value(600, 'x');
+    for (int i = 0; i < 3; ++i) {
+      record_span(large_value);
+    }
+    CHECK(tracer->Flush());
+    CHECK(in_memory_transporter->num_pending() == 3);
+  }
+
+  SECTION("A span larger than max_report_bytes is sent in its own report.") {
+    record_span(std::string(2000, 'x'));
+    CHECK(tracer->Flush());
+    in_memory_transporter->Succeed();
+    REQUIRE(in_memory_transporter->reports().size() == 1);
+    CHECK(in_memory_transporter->spans().size() == 1);
+  }
+
+  SECTION("The spans of every failed report are counted as dropped.") {
+    logger.set_level(LogLevel::off);
+    for (int i = 0; i < 3; ++i) {
+      record_span("x");
+    }
+    CHECK(tracer->Flush());
+    CHECK(in_memory_transporter->num_pending() == 2);
+    in_memory_transporter->Fail();
+    CHECK(metrics_observer->num_spans_dropped == 3);
+
+    record_span("x");
+    CHECK(tracer->Flush());
+    in_memory_transporter->Succeed();
+    REQUIRE(in_memory_transporter->reports().size() == 1);
+    CHECK(LookupSpansDropped(in_memory_transporter->reports().at(0)) == 3);
+  }
+}
@@ -0,0 +1,59 @@
+#include "recorder/stream_recorder/connection_scaler.h"
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+TEST_CASE("ConnectionScaler") {
+  ConnectionScaler scaler{2, 10, 0.25, 1000};
+  ConnectionLoad load;
+  load.num_connections = 4;
+  load.bytes_per_second = 3500;
+
+  SECTION("Scaling is disabled if the bounds are equal.") {
+    REQUIRE(scaler.enabled());
+    REQUIRE(!ConnectionScaler(4, 4, 0.25, 1000).enabled());
+  }
+
+  SECTION("The bounds are kept valid.") {
+    ConnectionScaler scaler2{0, -1, 0.25, 1000};
+    REQUIRE(scaler2.min_connections() == 1);
+    REQUIRE(scaler2.max_connections() == 1);
+  }
+
+  SECTION("The number of connections is unchanged under a steady load.") {
+    REQUIRE(scaler.ComputeNumConnections(load) == 4);
+  }
+
+  SECTION("Connections are added when backlogged and blocked on writes.") {
+    load.backlogged = true;
+    load.write_blocked_fraction = 0.5;
+    REQUIRE(scaler.ComputeNumConnections(load) == 6);
+    load.num_connections = 8;
+    REQUIRE(scaler.ComputeNumConnections(load) == 10);
+  }
+
+  SECTION("Connections aren't added unless writes are blocked.") {
+    load.backlogged = true;
+    load.write_blocked_fraction = 0.1;
+    REQUIRE(scaler.ComputeNumConnections(load) == 4);
+  }
+
+  SECTION("Connections are removed when the rest can carry the load.") {
+    load.bytes_per_second = 2500;
+    REQUIRE(scaler.ComputeNumConnections(load) == 3);
+    load.bytes_per_second = 0;
+    load.num_connections = 2;
+    REQUIRE(scaler.ComputeNumConnections(load) == 2);
+  }
+
+  SECTION("Connections aren't removed while writes are blocked.") {
+    load.bytes_per_second = 0;
+    load.write_blocked_fraction = 0.2;
+    REQUIRE(scaler.ComputeNumConnections(load) == 4);
+  }
+
+  SECTION("The number of connections is brought within the bounds.") {
+    load.num_connections = 20;
+    REQUIRE(scaler.ComputeNumConnections(load) == 10);
+  }
+}
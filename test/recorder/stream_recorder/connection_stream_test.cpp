@@ -1,10 +1,12 @@
 #include "recorder/stream_recorder/connection_stream.h"
 
 #include "3rd_party/catch2/catch.hpp"
+#include "common/chunked_http_framing.h"
 #include "recorder/serialization/report_request_header.h"
 #include "recorder/stream_recorder/span_stream.h"
 #include "test/number_simulation.h"
 #include "test/utility.h"
+#include "tracer/counting_metrics_observer.h"
 using namespace lightstep;
 
 static std::string ToString(
@@ -33,10 +35,11 @@ static collector::ReportRequest ParseStreamHeader(std::string& s) {
 
 TEST_CASE("ConnectionStream") {
   LightStepTracerOptions tracer_options;
-  CircularBuffer<ChainedStream> span_buffer{1000};
+  ShardedCircularBuffer<ChainedStream> span_buffer{1000};
   MetricsObserver metrics_observer;
   MetricsTracker metrics{metrics_observer};
-  SpanStream span_stream{span_buffer, metrics};
+  ByteBudget span_buffer_budget{0};
+  SpanStream span_stream{span_buffer, span_buffer_budget, metrics};
   std::string header_common_fragment =
       WriteReportRequestHeader(tracer_options, 123);
   auto host_header_fragment = MakeFragment("Host:abc\r\n");
@@ -240,6 +243,165 @@ TEST_CASE("ConnectionStream") {
   }
 }
 
+namespace {
+// Passes data through unchanged so that the stream can be inspected.
+class IdentityCompressor final : public StreamCompressor {
+ public:
+  bool finished = false;
+
+  Fragment content_encoding_header() const noexcept override {
+    return MakeFragment("Content-Encoding:identity\r\n");
+  }
+
+  bool Reset() noexcept override {
+    ClearOutput();
+    finished = false;
+    return true;
+  }
+
+  bool Compress(const void* data, size_t size) noexcept override {
+    output_.append(static_cast<const char*>(data), size);
+    return true;
+  }
+
+  bool Flush() noexcept override { return true; }
+
+  bool Finish() noexcept override {
+    finished = true;
+    return true;
+  }
+
+  Fragment output() const noexcept override {
+    return {const_cast<char*>(output_.data()),
+            static_cast<int>(output_.size())};
+  }
+
+  void ClearOutput() noexcept override { output_.clear(); }
+
+ private:
+  std::string output_;
+};
+}  // namespace
+
+static std::string RemoveSpanChunkFraming(const std::string& s) {
+  return s.substr(ChunkedHttpMaxHeaderSize,
+                  s.size() - ChunkedHttpMaxHeaderSize - 2);
+}
+
+static std::string Dechunk(const std::string& s) {
+  std::string result;
+  size_t position = 0;
+  while (true) {
+    auto chunk_start = s.find("\r\n", position);
+    REQUIRE(chunk_start != std::string::npos);
+    auto chunk_size =
+        std::stoul(s.substr(position, chunk_start - position), nullptr, 16);
+    chunk_start += 2;
+    if (chunk_size == 0) {
+      REQUIRE(s.substr(chunk_start) == "\r\n");
+      return result;
+    }
+    result += s.substr(chunk_start, chunk_size);
+    REQUIRE(s.substr(chunk_start + chunk_size, 2) == "\r\n");
+    position = chunk_start + chunk_size + 2;
+  }
+}
+
+TEST_CASE("ConnectionStream with a compressor") {
+  LightStepTracerOptions tracer_options;
+  ShardedCircularBuffer<ChainedStream> span_buffer{1000};
+  CountingMetricsObserver metrics_observer;
+  MetricsTracker metrics{metrics_observer};
+  ByteBudget span_buffer_budget{0};
+  SpanStream span_stream{span_buffer, span_buffer_budget, metrics};
+  std::string header_common_fragment =
+      WriteReportRequestHeader(tracer_options, 123);
+  auto host_header_fragment = MakeFragment("Host:abc\r\n");
+  auto compressor = new IdentityCompressor{};
+  ConnectionStream connection_stream{
+      host_header_fragment,
+      Fragment{static_cast<void*>(&header_common_fragment[0]),
+               static_cast<int>(header_common_fragment.size())},
+      span_stream, std::unique_ptr<StreamCompressor>{compressor}};
+  std::string contents;
+  auto write_all = [&contents](
+      std::initializer_list<FragmentInputStream*> fragment_streams) {
+    auto s = ToString(fragment_streams);
+    contents += s;
+    return Consume(fragment_streams, static_cast<int>(s.size()));
+  };
+
+  SECTION("The Content-Encoding is declared in the http header.") {
+    REQUIRE(connection_stream.Flush(write_all));
+    REQUIRE(contents.find("Content-Encoding:identity\r\n") !=
+            std::string::npos);
+    REQUIRE(contents.find("\r\n\r\n") + 4 ==
+            static_cast<size_t>(connection_stream.first_chunk_position()));
+  }
+
+  SECTION(
+      "Only the payloads of span chunks are compressed and the compressed "
+      "data is framed as chunks.") {
+    AddSpanChunkFramedString(span_buffer, "abc");
+    REQUIRE(connection_stream.Flush(write_all));
+    AddSpanChunkFramedString(span_buffer, "123");
+    REQUIRE(connection_stream.Flush(write_all));
+    connection_stream.Shutdown();
+    REQUIRE(connection_stream.Flush(write_all));
+    REQUIRE(connection_stream.completed());
+    REQUIRE(compressor->finished);
+    auto body = Dechunk(contents.substr(contents.find("\r\n\r\n") + 4));
+    auto spans = RemoveSpanChunkFraming(AddSpanChunkFraming("abc")) +
+                 RemoveSpanChunkFraming(AddSpanChunkFraming("123"));
+    REQUIRE(body.size() > spans.size());
+    REQUIRE(body.substr(body.size() - spans.size()) == spans);
+    collector::ReportRequest report_request;
+    REQUIRE(report_request.ParseFromString(
+        body.substr(0, body.size() - spans.size())));
+    REQUIRE(span_buffer.empty());
+    REQUIRE(metrics_observer.num_spans_sent == 2);
+    REQUIRE(metrics_observer.num_spans_dropped == 0);
+  }
+
+  SECTION("A partially written chunk is finished before the stream ends.") {
+    AddSpanChunkFramedString(span_buffer, "abc");
+    REQUIRE(!connection_stream.Flush(
+        [&contents](
+            std::initializer_list<FragmentInputStream*> fragment_streams) {
+          contents = ToString(fragment_streams).substr(0, 1);
+          return Consume(fragment_streams, 1);
+        }));
+    connection_stream.Shutdown();
+    REQUIRE(connection_stream.Flush(write_all));
+    REQUIRE(connection_stream.completed());
+    auto body = Dechunk(contents.substr(contents.find("\r\n\r\n") + 4));
+    auto span = RemoveSpanChunkFraming(AddSpanChunkFraming("abc"));
+    REQUIRE(body.substr(body.size() - span.size()) == span);
+  }
+
+  SECTION(
+      "If the stream is reset before a compressed chunk is written, its spans "
+      "are recorded as dropped.") {
+    AddSpanChunkFramedString(span_buffer, "abc");
+    REQUIRE(!connection_stream.Flush(
+        [](std::initializer_list<FragmentInputStream*> fragment_streams) {
+          return Consume(fragment_streams, 1);
+        }));
+    REQUIRE(metrics_observer.num_spans_sent == 0);
+    connection_stream.Reset();
+    REQUIRE(metrics_observer.num_spans_sent == 0);
+    REQUIRE(metrics_observer.num_spans_dropped == 1);
+    REQUIRE(connection_stream.Flush(write_all));
+    auto body = Dechunk(contents.substr(contents.find("\r\n\r\n") + 4) +
+                        "0\r\n\r\n");
+    collector::ReportRequest report_request;
+    REQUIRE(report_request.ParseFromString(body));
+    auto& counts = report_request.internal_metrics().counts();
+    REQUIRE(counts.size() == 1);
+    REQUIRE(counts[0].int_value() == 1);
+  }
+}
+
 TEST_CASE(
     "Verify through simulation that ConnectionStream behaves correctly.") {
   LightStepTracerOptions tracer_options;
@@ -247,13 +409,14 @@ TEST_CASE(
       WriteReportRequestHeader(tracer_options, 123);
   MetricsObserver metrics_observer;
   MetricsTracker metrics{metrics_observer};
+  ByteBudget span_buffer_budget{0};
   auto host_header_fragment = MakeFragment("Host:abc\r\n");
   const size_t num_producer_threads = 4;
   const size_t num_connections = 10;
   const size_t n = 25000;
   for (size_t max_size : {1, 2, 10, 100, 1000}) {
-    CircularBuffer<ChainedStream> buffer{max_size};
-    SpanStream span_stream{buffer, metrics};
+    ShardedCircularBuffer<ChainedStream> buffer{max_size};
+    SpanStream span_stream{buffer, span_buffer_budget, metrics};
     std::vector<ConnectionStream> connection_streams;
     connection_streams.reserve(num_connections);
     for (int i = 0; i < static_cast<int>(num_connections); ++i) {
@@ -0,0 +1,141 @@
+#include <array>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "3rd_party/catch2/catch.hpp"
+#include "recorder/stream_recorder/stream_compressor.h"
+
+#include <zlib.h>
+
+using namespace lightstep;
+
+static std::string Inflate(const std::string& s, bool& stream_end) {
+  z_stream stream;
+  std::memset(static_cast<void*>(&stream), 0, sizeof(stream));
+  REQUIRE(inflateInit2(&stream, 15 + 16) == Z_OK);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(s.data()));
+  stream.avail_in = static_cast<uInt>(s.size());
+  std::string result;
+  std::array<char, 1024> buffer;
+  int rcode;
+  do {
+    stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+    stream.avail_out = static_cast<uInt>(buffer.size());
+    rcode = inflate(&stream, Z_SYNC_FLUSH);
+    REQUIRE((rcode == Z_OK || rcode == Z_STREAM_END || rcode == Z_BUF_ERROR));
+    result.append(buffer.data(), buffer.size() - stream.avail_out);
+  } while (rcode == Z_OK && stream.avail_out == 0);
+  stream_end = rcode == Z_STREAM_END;
+  inflateEnd(&stream);
+  return result;
+}
+
+static std::string ToString(Fragment fragment) {
+  return std::string{static_cast<char*>(fragment.first),
+                     static_cast<size_t>(fragment.second)};
+}
+
+TEST_CASE("GzipStreamCompressor") {
+  Logger logger;
+  StreamRecorderOptions options;
+  CompressionBudget budget{0, std::chrono::seconds{1}};
+
+  SECTION("No compressor is made if compression is disabled.") {
+    options.compression_level = 0;
+    REQUIRE(MakeStreamCompressor(logger, options, budget) == nullptr);
+  }
+
+  options.compression_level = 6;
+  auto compressor = MakeStreamCompressor(logger, options, budget);
+  REQUIRE(compressor != nullptr);
+  REQUIRE(ToString(compressor->content_encoding_header()) ==
+          "Content-Encoding:gzip\r\n");
+  std::string contents(10000, 'a');
+  REQUIRE(compressor->Compress(contents.data(), contents.size()));
+
+  SECTION("Flushing makes everything compressed so far available.") {
+    REQUIRE(compressor->Flush());
+    auto output = ToString(compressor->output());
+    REQUIRE(output.size() < contents.size());
+    bool stream_end;
+    REQUIRE(Inflate(output, stream_end) == contents);
+    REQUIRE(!stream_end);
+  }
+
+  SECTION("Output is accumulated until it's cleared.") {
+    REQUIRE(compressor->Flush());
+    auto output = ToString(compressor->output());
+    REQUIRE(compressor->Compress("abc", 3));
+    REQUIRE(compressor->Flush());
+    auto output2 = ToString(compressor->output());
+    REQUIRE(output2.substr(0, output.size()) == output);
+    compressor->ClearOutput();
+    REQUIRE(compressor->output().second == 0);
+    bool stream_end;
+    REQUIRE(Inflate(output2, stream_end) == contents + "abc");
+  }
+
+  SECTION("Finishing the stream writes the gzip trailer.") {
+    REQUIRE(compressor->Finish());
+    bool stream_end;
+    REQUIRE(Inflate(ToString(compressor->output()), stream_end) == contents);
+    REQUIRE(stream_end);
+  }
+
+  SECTION("Reset begins a new stream.") {
+    REQUIRE(compressor->Flush());
+    REQUIRE(compressor->Reset());
+    REQUIRE(compressor->output().second == 0);
+    REQUIRE(compressor->Compress("abc", 3));
+    REQUIRE(compressor->Finish());
+    bool stream_end;
+    REQUIRE(Inflate(ToString(compressor->output()), stream_end) == "abc");
+    REQUIRE(stream_end);
+  }
+
+  SECTION("Data is stored uncompressed once the budget is exhausted.") {
+    CompressionBudget exhausted_budget{1e-9, std::chrono::hours{1}};
+    exhausted_budget.Charge(std::chrono::seconds{1});
+    compressor = MakeStreamCompressor(logger, options, exhausted_budget);
+    REQUIRE(compressor->Reset());
+    REQUIRE(compressor->Compress(contents.data(), contents.size()));
+    REQUIRE(compressor->Finish());
+    auto output = ToString(compressor->output());
+    REQUIRE(output.size() > contents.size());
+    bool stream_end;
+    REQUIRE(Inflate(output, stream_end) == contents);
+    REQUIRE(stream_end);
+  }
+
+  SECTION("Compression resumes once the budget is replenished.") {
+    CompressionBudget budget2{0.5, std::chrono::milliseconds{1}};
+    budget2.Charge(std::chrono::seconds{1});
+    compressor = MakeStreamCompressor(logger, options, budget2);
+    REQUIRE(compressor->Reset());
+    std::this_thread::sleep_for(std::chrono::milliseconds{2});
+    REQUIRE(compressor->Flush());
+    compressor->ClearOutput();
+    REQUIRE(compressor->Compress(contents.data(), contents.size()));
+    REQUIRE(compressor->Flush());
+    REQUIRE(compressor->output().second < 1000);
+  }
+}
+
+TEST_CASE("CompressionBudget") {
+  auto now = std::chrono::steady_clock::now();
+
+  SECTION("A budget of 0 is never exhausted.") {
+    CompressionBudget budget{0, std::chrono::seconds{1}};
+    budget.Charge(std::chrono::hours{1});
+    REQUIRE(!budget.exhausted(now));
+  }
+
+  SECTION("The budget is replenished every period.") {
+    CompressionBudget budget{0.5, std::chrono::seconds{1}};
+    REQUIRE(!budget.exhausted(now));
+    budget.Charge(std::chrono::milliseconds{600});
+    REQUIRE(budget.exhausted(now));
+    REQUIRE(!budget.exhausted(now + std::chrono::seconds{2}));
+  }
+}
@@ -0,0 +1,93 @@
+#include "recorder/stream_recorder/retained_spans.h"
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+static void RetainSpans(RetainedSpans& spans, int n) {
+  spans.Reserve(static_cast<size_t>(n));
+  for (int i = 0; i < n; ++i) {
+    spans.Retain(std::unique_ptr<ChainedStream>{new ChainedStream{}});
+  }
+}
+
+TEST_CASE("RetainedSpans") {
+  RetainedSpans spans;
+
+  SECTION("Spans are released once the sends they were sealed with complete.") {
+    RetainSpans(spans, 2);
+    spans.Seal(1);
+    RetainSpans(spans, 3);
+    spans.Seal(4);
+    REQUIRE(spans.size() == 5);
+    spans.Release(0);
+    REQUIRE(spans.size() == 5);
+    spans.Release(1);
+    REQUIRE(spans.size() == 3);
+    spans.Release(3);
+    REQUIRE(spans.size() == 3);
+    spans.Release(4);
+    REQUIRE(spans.size() == 0);
+  }
+
+  SECTION("Spans aren't released until they're sealed.") {
+    RetainSpans(spans, 2);
+    spans.Release(100);
+    REQUIRE(spans.size() == 2);
+    spans.Seal(100);
+    spans.Release(100);
+    REQUIRE(spans.size() == 0);
+  }
+
+  SECTION("Send numbers can wrap around.") {
+    RetainSpans(spans, 1);
+    spans.Seal(0xffffffff);
+    RetainSpans(spans, 1);
+    spans.Seal(1);
+    spans.Release(0xffffffff);
+    REQUIRE(spans.size() == 1);
+    spans.Release(1);
+    REQUIRE(spans.size() == 0);
+  }
+
+  SECTION("Ranges of the contiguous span buffer are released like spans.") {
+    uint64_t position;
+    REQUIRE(!spans.oldest_ring_position(position));
+    spans.Reserve(2);
+    spans.RetainRing(10);
+    spans.Seal(1);
+    spans.RetainRing(20);
+    spans.Seal(2);
+    REQUIRE(spans.oldest_ring_position(position));
+    REQUIRE(position == 10);
+    spans.Release(1);
+    REQUIRE(spans.oldest_ring_position(position));
+    REQUIRE(position == 20);
+    spans.Release(2);
+    REQUIRE(!spans.oldest_ring_position(position));
+  }
+
+  SECTION("Clear frees all the spans.") {
+    RetainSpans(spans, 3);
+    spans.Seal(10);
+    spans.Reserve(1);
+    spans.RetainRing(10);
+    spans.Clear();
+    REQUIRE(spans.size() == 0);
+    uint64_t position;
+    REQUIRE(!spans.oldest_ring_position(position));
+    RetainSpans(spans, 1);
+    spans.Seal(1);
+    spans.Release(1);
+    REQUIRE(spans.size() == 0);
+  }
+
+  SECTION("Unsent spans are tallied until the spans are cleared.") {
+    spans.AddUnsentSpans(2, 100);
+    spans.AddUnsentSpans(1, 50);
+    REQUIRE(spans.num_unsent_spans() == 3);
+    REQUIRE(spans.num_unsent_bytes() == 150);
+    spans.Clear();
+    REQUIRE(spans.num_unsent_spans() == 0);
+    REQUIRE(spans.num_unsent_bytes() == 0);
+  }
+}
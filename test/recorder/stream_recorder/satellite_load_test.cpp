@@ -0,0 +1,74 @@
+#include "recorder/stream_recorder/satellite_load.h"
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+TEST_CASE("LatencyEwma") {
+  LatencyEwma latency{0.5};
+
+  SECTION("The average is 0 without samples.") {
+    REQUIRE(latency.value() == 0);
+  }
+
+  SECTION("The first sample initializes the average.") {
+    latency.Add(std::chrono::microseconds{100});
+    REQUIRE(latency.value() == Approx(100));
+  }
+
+  SECTION("New samples are weighted into the average.") {
+    latency.Add(std::chrono::microseconds{100});
+    latency.Add(std::chrono::microseconds{200});
+    REQUIRE(latency.value() == Approx(150));
+  }
+
+  SECTION("Reset forgets all samples.") {
+    latency.Add(std::chrono::microseconds{100});
+    latency.Reset();
+    REQUIRE(latency.value() == 0);
+    latency.Add(std::chrono::microseconds{10});
+    REQUIRE(latency.value() == Approx(10));
+  }
+}
+
+TEST_CASE("SatelliteEndpointLoads") {
+  SatelliteEndpointLoads loads{0.5};
+  IpAddress endpoint1{"192.168.0.1", 1234};
+  IpAddress endpoint2{"192.168.0.2", 1234};
+
+  SECTION("Untracked endpoints have the lowest cost.") {
+    REQUIRE(loads.cost(endpoint1) == ComputeSatelliteCost(0, 0));
+  }
+
+  SECTION("Each connection adds to an endpoint's cost.") {
+    loads.OnConnect(endpoint1);
+    REQUIRE(loads.cost(endpoint1) > loads.cost(endpoint2));
+    loads.OnConnect(endpoint2);
+    REQUIRE(loads.cost(endpoint1) == loads.cost(endpoint2));
+    loads.OnDisconnect(endpoint2);
+    REQUIRE(loads.cost(endpoint1) > loads.cost(endpoint2));
+  }
+
+  SECTION("Slow endpoints cost more.") {
+    loads.OnConnect(endpoint1);
+    loads.OnConnect(endpoint2);
+    loads.RecordLatency(endpoint1, std::chrono::milliseconds{10});
+    loads.RecordLatency(endpoint2, std::chrono::microseconds{10});
+    REQUIRE(loads.cost(endpoint1) > loads.cost(endpoint2));
+  }
+
+  SECTION("Latencies are remembered after connections close.") {
+    loads.OnConnect(endpoint1);
+    loads.RecordLatency(endpoint1, std::chrono::milliseconds{10});
+    loads.OnDisconnect(endpoint1);
+    REQUIRE(loads.cost(endpoint1) > loads.cost(endpoint2));
+  }
+
+  SECTION("The number of unused endpoints tracked is bounded.") {
+    for (int i = 0; i < 1000; ++i) {
+      IpAddress endpoint{"192.168.0.1", static_cast<uint16_t>(i + 1)};
+      loads.OnConnect(endpoint);
+      loads.OnDisconnect(endpoint);
+    }
+    REQUIRE(loads.size() < 100);
+  }
+}
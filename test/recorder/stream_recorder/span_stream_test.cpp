@@ -3,16 +3,22 @@
 #include <iostream>
 
 #include "test/utility.h"
+#include "tracer/counting_metrics_observer.h"
 
 #include "3rd_party/catch2/catch.hpp"
 using namespace lightstep;
 
 TEST_CASE("SpanStream") {
   const size_t max_spans = 10;
-  CircularBuffer<ChainedStream> buffer{max_spans};
+  ShardedCircularBuffer<ChainedStream> buffer{max_spans};
   MetricsObserver metrics_observer;
   MetricsTracker metrics{metrics_observer};
-  SpanStream span_stream{buffer, metrics};
+  ByteBudget span_buffer_budget{1000};
+  SpanStream span_stream{buffer, span_buffer_budget, metrics};
+  auto add_span = [&](const std::string& s) {
+    span_buffer_budget.Reserve(AddSpanChunkFraming(s).size());
+    return AddSpanChunkFramedString(buffer, s);
+  };
 
   SECTION("When the attached buffer is empty, SpanStream has no fragments") {
     REQUIRE(span_stream.empty());
@@ -21,20 +27,20 @@ TEST_CASE("SpanStream") {
   }
 
   SECTION("SpanStream mirrors the contents of its attached buffer") {
-    REQUIRE(AddSpanChunkFramedString(buffer, "abc123"));
+    REQUIRE(add_span("abc123"));
     span_stream.Allot();
     REQUIRE(ToString(span_stream) == AddSpanChunkFraming("abc123"));
   }
 
   SECTION("SpanStream is empty after it's been cleared") {
-    REQUIRE(AddSpanChunkFramedString(buffer, "abc123"));
+    REQUIRE(add_span("abc123"));
     span_stream.Allot();
     span_stream.Clear();
     REQUIRE(span_stream.empty());
   }
 
   SECTION("SpanStream leaves a remnant if a span is partially consumed") {
-    REQUIRE(AddSpanChunkFramedString(buffer, "abc123"));
+    REQUIRE(add_span("abc123"));
     span_stream.Allot();
     auto contents = ToString(span_stream);
     REQUIRE(!Consume({&span_stream}, 3));
@@ -45,13 +51,13 @@ TEST_CASE("SpanStream") {
   }
 
   SECTION("SpanStream leaves no remnant when spans are completely consumed") {
-    REQUIRE(AddSpanChunkFramedString(buffer, "abc123"));
+    REQUIRE(add_span("abc123"));
     span_stream.Allot();
     span_stream.Clear();
     REQUIRE(span_stream.ConsumeRemnant() == nullptr);
 
-    REQUIRE(AddSpanChunkFramedString(buffer, "abc"));
-    REQUIRE(AddSpanChunkFramedString(buffer, "123"));
+    REQUIRE(add_span("abc"));
+    REQUIRE(add_span("123"));
     span_stream.Allot();
     auto span1 = AddSpanChunkFraming("abc");
     REQUIRE(!Consume({&span_stream}, static_cast<int>(span1.size())));
@@ -59,4 +65,234 @@ TEST_CASE("SpanStream") {
     span_stream.Allot();
     REQUIRE(ToString(span_stream) == AddSpanChunkFraming("123"));
   }
+
+  SECTION("Consumed spans are released from the span buffer's byte budget") {
+    REQUIRE(add_span("abc"));
+    REQUIRE(add_span("123"));
+    REQUIRE(span_buffer_budget.num_bytes_used() ==
+            2 * AddSpanChunkFraming("abc").size());
+    span_stream.Allot();
+    REQUIRE(!Consume({&span_stream}, 3));
+    REQUIRE(span_buffer_budget.num_bytes_used() ==
+            AddSpanChunkFraming("123").size());
+    span_stream.Allot();
+    span_stream.Clear();
+    REQUIRE(span_buffer_budget.num_bytes_used() == 0);
+  }
+
+  SECTION("SpanStream counts the bytes of the spans it consumes") {
+    REQUIRE(add_span("abc"));
+    REQUIRE(add_span("123"));
+    span_stream.Allot();
+    REQUIRE(!Consume({&span_stream}, 3));
+    REQUIRE(span_stream.num_bytes_consumed() ==
+            AddSpanChunkFraming("abc").size());
+    span_stream.Allot();
+    span_stream.Clear();
+    REQUIRE(span_stream.num_bytes_consumed() ==
+            2 * AddSpanChunkFraming("abc").size());
+  }
+}
+
+TEST_CASE("SpanStream with a contiguous span buffer") {
+  ShardedCircularBuffer<ChainedStream> buffer{1};
+  CountingMetricsObserver metrics_observer;
+  MetricsTracker metrics{metrics_observer};
+  ByteBudget span_buffer_budget{0};
+  ByteRing span_ring{100};
+  SpanStream span_stream{buffer, span_buffer_budget, metrics, &span_ring};
+  auto add_span = [&](const std::string& s) {
+    auto framed_s = AddSpanChunkFraming(s);
+    uint64_t position;
+    if (!span_ring.Reserve(framed_s.size(), position)) {
+      return false;
+    }
+    span_ring.Write(position, framed_s.data(), framed_s.size());
+    span_ring.Commit(position, framed_s.size());
+    return true;
+  };
+
+  SECTION("SpanStream mirrors the contents of the ring") {
+    REQUIRE(span_stream.buffer_empty());
+    REQUIRE(add_span("abc123"));
+    REQUIRE(!span_stream.buffer_empty());
+    span_stream.Allot();
+    REQUIRE(ToString(span_stream) == AddSpanChunkFraming("abc123"));
+  }
+
+  SECTION("Clearing SpanStream consumes the spans from the ring") {
+    REQUIRE(add_span("abc"));
+    REQUIRE(add_span("123"));
+    span_stream.Allot();
+    span_stream.Clear();
+    REQUIRE(span_stream.empty());
+    REQUIRE(span_ring.empty());
+    REQUIRE(metrics_observer.num_spans_sent == 2);
+    REQUIRE(span_stream.num_bytes_consumed() ==
+            2 * AddSpanChunkFraming("abc").size());
+  }
+
+  SECTION("Spans that wrap around the ring are split into two fragments") {
+    auto span_size = AddSpanChunkFraming("abcdefghij").size();
+    while (span_ring.consumer_position() + span_size <= span_ring.capacity()) {
+      REQUIRE(add_span("abcdefghij"));
+      span_stream.Allot();
+      span_stream.Clear();
+    }
+    REQUIRE(add_span("abcdefghij"));
+    span_stream.Allot();
+    REQUIRE(span_stream.num_fragments() == 2);
+    REQUIRE(ToString(span_stream) == AddSpanChunkFraming("abcdefghij"));
+  }
+
+  SECTION("SpanStream copies out a remnant if a span is partially consumed") {
+    REQUIRE(add_span("abc"));
+    REQUIRE(add_span("123"));
+    span_stream.Allot();
+    auto span1 = AddSpanChunkFraming("abc");
+    auto span2 = AddSpanChunkFraming("123");
+    REQUIRE(!Consume({&span_stream}, static_cast<int>(span1.size()) + 3));
+    auto remnant = span_stream.ConsumeRemnant();
+    REQUIRE(remnant != nullptr);
+    REQUIRE(ToString(*remnant) == span2.substr(3));
+    REQUIRE(span_ring.empty());
+    REQUIRE(metrics_observer.num_spans_sent == 1);
+  }
+
+  SECTION("SpanStream leaves no remnant when spans are completely consumed") {
+    REQUIRE(add_span("abc"));
+    REQUIRE(add_span("123"));
+    span_stream.Allot();
+    auto span1 = AddSpanChunkFraming("abc");
+    REQUIRE(!Consume({&span_stream}, static_cast<int>(span1.size())));
+    REQUIRE(span_stream.ConsumeRemnant() == nullptr);
+    span_stream.Allot();
+    REQUIRE(ToString(span_stream) == AddSpanChunkFraming("123"));
+  }
+
+  SECTION("Retained spans stay in the ring until they're released") {
+    RetainedSpans retained_spans;
+    span_stream.AddRingRetainer(retained_spans);
+    retained_spans.Reserve(span_stream.max_allotment_size() + 1);
+    REQUIRE(add_span("abc"));
+    REQUIRE(add_span("123"));
+    span_stream.set_retained_spans(&retained_spans);
+    span_stream.Allot();
+    span_stream.Clear();
+    span_stream.set_retained_spans(nullptr);
+    REQUIRE(span_stream.buffer_empty());
+    REQUIRE(!span_ring.empty());
+
+    REQUIRE(add_span("xyz"));
+    span_stream.Allot();
+    REQUIRE(ToString(span_stream) == AddSpanChunkFraming("xyz"));
+    span_stream.Clear();
+    REQUIRE(!span_ring.empty());
+
+    retained_spans.Seal(1);
+    retained_spans.Release(1);
+    span_stream.ReleaseRing();
+    REQUIRE(span_ring.empty());
+    span_stream.RemoveRingRetainer(retained_spans);
+  }
+}
+
+TEST_CASE("SpanStream over a subset of shards") {
+  ShardedCircularBuffer<ChainedStream> buffer{40, 4};
+  MetricsObserver metrics_observer;
+  MetricsTracker metrics{metrics_observer};
+  ByteBudget span_buffer_budget{0};
+  SpanStream span_stream1{buffer, span_buffer_budget, metrics, nullptr, 0, 2};
+  SpanStream span_stream2{buffer, span_buffer_budget, metrics, nullptr, 1, 2};
+  auto add_span = [&](size_t shard_index, const std::string& s) {
+    auto framed_s = AddSpanChunkFraming(s);
+    std::unique_ptr<ChainedStream> chain{new ChainedStream{}};
+    {
+      google::protobuf::io::CodedOutputStream stream{chain.get()};
+      stream.WriteString(framed_s);
+    }
+    chain->CloseOutput();
+    return buffer.shard(shard_index).Add(chain);
+  };
+
+  SECTION("Every other shard is streamed from") {
+    REQUIRE(span_stream1.num_shards() == 2);
+    REQUIRE(span_stream2.num_shards() == 2);
+  }
+
+  SECTION("SpanStream only mirrors the contents of its own shards") {
+    REQUIRE(add_span(1, "abc"));
+    REQUIRE(span_stream1.buffer_empty());
+    REQUIRE(!span_stream2.buffer_empty());
+    span_stream1.Allot();
+    REQUIRE(span_stream1.empty());
+    span_stream2.Allot();
+    REQUIRE(ToString(span_stream2) == AddSpanChunkFraming("abc"));
+  }
+
+  SECTION("SpanStream alternates between its shards") {
+    REQUIRE(add_span(0, "abc"));
+    REQUIRE(add_span(2, "123"));
+    span_stream1.Allot();
+    auto contents = ToString(span_stream1);
+    span_stream1.Clear();
+    span_stream1.Allot();
+    contents += ToString(span_stream1);
+    span_stream1.Clear();
+    REQUIRE(contents.size() == 2 * AddSpanChunkFraming("abc").size());
+    REQUIRE(span_stream1.buffer_empty());
+    REQUIRE(span_stream2.buffer_empty());
+  }
+}
+
+TEST_CASE("SpanStream with retained spans") {
+  ShardedCircularBuffer<ChainedStream> buffer{10, 1};
+  CountingMetricsObserver metrics_observer;
+  MetricsTracker metrics{metrics_observer};
+  ByteBudget span_buffer_budget{0};
+  SpanStream span_stream{buffer, span_buffer_budget, metrics};
+  RetainedSpans retained_spans;
+  REQUIRE(span_stream.max_allotment_size() == 10);
+  retained_spans.Reserve(span_stream.max_allotment_size() + 1);
+  span_stream.set_retained_spans(&retained_spans);
+  REQUIRE(AddSpanChunkFramedString(buffer, "abc"));
+  REQUIRE(AddSpanChunkFramedString(buffer, "123"));
+  REQUIRE(AddSpanChunkFramedString(buffer, "xyz"));
+  span_stream.Allot();
+
+  SECTION("Consumed spans are moved to the retained spans") {
+    auto span1 = AddSpanChunkFraming("abc");
+    REQUIRE(!Consume({&span_stream}, static_cast<int>(span1.size()) + 1));
+    REQUIRE(retained_spans.size() == 1);
+    auto remnant = span_stream.ConsumeRemnant();
+    REQUIRE(remnant != nullptr);
+    span_stream.ReleaseSpan(std::move(remnant));
+    REQUIRE(retained_spans.size() == 2);
+    span_stream.Allot();
+    span_stream.Clear();
+    REQUIRE(retained_spans.size() == 3);
+    REQUIRE(buffer.empty());
+  }
+
+  SECTION(
+      "Cleared spans can be tallied in the retained spans instead of being "
+      "counted as sent") {
+    span_stream.set_retained_spans(&retained_spans, true);
+    span_stream.Clear();
+    REQUIRE(retained_spans.size() == 3);
+    REQUIRE(retained_spans.num_unsent_spans() == 3);
+    REQUIRE(retained_spans.num_unsent_bytes() ==
+            3 * AddSpanChunkFraming("abc").size());
+    REQUIRE(metrics_observer.num_spans_sent == 0);
+    retained_spans.Clear();
+    REQUIRE(retained_spans.num_unsent_spans() == 0);
+    REQUIRE(retained_spans.num_unsent_bytes() == 0);
+  }
+
+  SECTION("Spans are freed once the retained spans are unset") {
+    span_stream.set_retained_spans(nullptr);
+    span_stream.Clear();
+    REQUIRE(retained_spans.size() == 0);
+    REQUIRE(buffer.empty());
+  }
 }
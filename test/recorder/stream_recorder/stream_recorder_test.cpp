@@ -1,9 +1,12 @@
 #include "recorder/stream_recorder/stream_recorder.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdlib>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "test/mock_satellite/mock_satellite_handle.h"
 #include "test/ports.h"
@@ -61,8 +64,8 @@ TEST_CASE("StreamRecorder") {
   auto stream_recorder = new StreamRecorder{*logger, std::move(tracer_options),
                                             std::move(recorder_options)};
   std::unique_ptr<Recorder> recorder{stream_recorder};
-  auto tracer = std::make_shared<TracerImpl>(logger, PropagationOptions{},
-                                             std::move(recorder));
+  auto tracer =
+      MakeTracerImpl(logger, PropagationOptions{}, std::move(recorder));
 
   SECTION("Spans are consumed from the buffer and sent to the satellite.") {
     auto span = tracer->StartSpan("abc");
@@ -215,3 +218,111 @@ TEST_CASE("StreamRecorder") {
     REQUIRE(logger_sink->contents().find("is readable") == std::string::npos);
   }
 }
+
+TEST_CASE("StreamRecorder with multiple streamer threads") {
+  std::unique_ptr<MockSatelliteHandle> mock_satellite{new MockSatelliteHandle{
+      static_cast<uint16_t>(PortAssignments::StreamRecorderTest)}};
+
+  auto logger = std::make_shared<Logger>();
+  LightStepTracerOptions tracer_options;
+  tracer_options.satellite_endpoints = {
+      {"localhost",
+       static_cast<uint16_t>(PortAssignments::StreamRecorderTest)}};
+  tracer_options.max_buffered_spans = 10000;
+  auto metrics_observer = new CountingMetricsObserver{};
+  tracer_options.metrics_observer.reset(metrics_observer);
+
+  StreamRecorderOptions recorder_options;
+  recorder_options.num_satellite_connections = 4;
+  recorder_options.num_span_buffer_shards = 4;
+  recorder_options.num_streamer_threads = 2;
+
+  auto stream_recorder = new StreamRecorder{*logger, std::move(tracer_options),
+                                            std::move(recorder_options)};
+  std::unique_ptr<Recorder> recorder{stream_recorder};
+  auto tracer =
+      MakeTracerImpl(logger, PropagationOptions{}, std::move(recorder));
+  REQUIRE(stream_recorder->num_streamer_threads() == 2);
+
+  SECTION(
+      "Spans recorded from several threads are each sent to the satellite "
+      "exactly once.") {
+    const int num_threads = 4;
+    const int num_spans_per_thread = 500;
+    std::vector<std::string> expected_operation_names;
+    std::vector<std::thread> threads;
+    for (int thread_index = 0; thread_index < num_threads; ++thread_index) {
+      auto prefix = std::to_string(thread_index) + "-";
+      for (int i = 0; i < num_spans_per_thread; ++i) {
+        expected_operation_names.push_back(prefix + std::to_string(i));
+      }
+      threads.emplace_back([&tracer, prefix] {
+        for (int i = 0; i < num_spans_per_thread; ++i) {
+          tracer->StartSpan(prefix + std::to_string(i));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    REQUIRE(stream_recorder->FlushWithTimeout(std::chrono::seconds{5}));
+    std::vector<collector::Span> spans;
+    REQUIRE(IsEventuallyTrue([&] {
+      spans = mock_satellite->spans();
+      return spans.size() >= expected_operation_names.size();
+    }));
+    std::vector<std::string> operation_names;
+    operation_names.reserve(spans.size());
+    for (auto& span : spans) {
+      operation_names.push_back(span.operation_name());
+    }
+    std::sort(operation_names.begin(), operation_names.end());
+    std::sort(expected_operation_names.begin(),
+              expected_operation_names.end());
+    REQUIRE(operation_names == expected_operation_names);
+    REQUIRE(metrics_observer->num_spans_dropped == 0);
+  }
+}
+
+TEST_CASE("StreamRecorder with io_uring") {
+  std::unique_ptr<MockSatelliteHandle> mock_satellite{new MockSatelliteHandle{
+      static_cast<uint16_t>(PortAssignments::StreamRecorderTest)}};
+
+  auto logger = std::make_shared<Logger>();
+  LightStepTracerOptions tracer_options;
+  tracer_options.satellite_endpoints = {
+      {"localhost",
+       static_cast<uint16_t>(PortAssignments::StreamRecorderTest)}};
+  tracer_options.max_buffered_spans = 10000;
+  auto metrics_observer = new CountingMetricsObserver{};
+  tracer_options.metrics_observer.reset(metrics_observer);
+
+  StreamRecorderOptions recorder_options;
+  recorder_options.num_satellite_connections = 2;
+  recorder_options.use_io_uring = true;
+
+  auto stream_recorder = new StreamRecorder{*logger, std::move(tracer_options),
+                                            std::move(recorder_options)};
+  std::unique_ptr<Recorder> recorder{stream_recorder};
+  auto tracer =
+      MakeTracerImpl(logger, PropagationOptions{}, std::move(recorder));
+
+  SECTION(
+      "Spans are sent to the satellite and counted as sent once their writes "
+      "complete.") {
+    const int num_spans = 1000;
+    for (int i = 0; i < num_spans; ++i) {
+      tracer->StartSpan(std::to_string(i));
+    }
+    REQUIRE(stream_recorder->FlushWithTimeout(std::chrono::seconds{5}));
+    std::vector<collector::Span> spans;
+    REQUIRE(IsEventuallyTrue([&] {
+      spans = mock_satellite->spans();
+      return spans.size() >= static_cast<size_t>(num_spans);
+    }));
+    REQUIRE(spans.size() == static_cast<size_t>(num_spans));
+    REQUIRE(IsEventuallyTrue(
+        [&] { return metrics_observer->num_spans_sent == num_spans; }));
+    REQUIRE(metrics_observer->num_spans_dropped == 0);
+  }
+}
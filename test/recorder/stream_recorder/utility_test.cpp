@@ -26,3 +26,10 @@ TEST_CASE("SeparateEndpoints") {
     REQUIRE(hosts.size() == 1);
   }
 }
+
+TEST_CASE("GetUnixSocketPath") {
+  REQUIRE(GetUnixSocketPath("unix:///tmp/satellite.sock") ==
+          std::string{"/tmp/satellite.sock"});
+  REQUIRE(GetUnixSocketPath("satellite.service") == nullptr);
+  REQUIRE(GetUnixSocketPath("unix") == nullptr);
+}
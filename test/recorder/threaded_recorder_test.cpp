@@ -0,0 +1,168 @@
+#include "recorder/threaded_recorder.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "3rd_party/catch2/catch.hpp"
+#include "lightstep/tracer.h"
+#include "test/utility.h"
+#include "tracer/counting_metrics_observer.h"
+#include "tracer/tracer_impl.h"
+using namespace lightstep;
+
+namespace {
+/**
+ * An AsyncTransporter that completes each report as soon as it's sent.
+ */
+class ImmediateAsyncTransporter final : public AsyncTransporter {
+ public:
+  void set_should_fail(bool should_fail) noexcept {
+    should_fail_ = should_fail;
+  }
+
+  std::vector<collector::ReportRequest> reports() const {
+    std::lock_guard<std::mutex> lock_guard{mutex_};
+    return reports_;
+  }
+
+  size_t num_spans() const {
+    size_t result = 0;
+    for (auto& report : reports()) {
+      result += static_cast<size_t>(report.spans_size());
+    }
+    return result;
+  }
+
+  // AsyncTransporter
+  void Send(std::unique_ptr<BufferChain>&& message,
+            Callback& callback) noexcept override {
+    if (should_fail_) {
+      return callback.OnFailure(*message);
+    }
+    std::string s(message->num_bytes(), ' ');
+    message->CopyOut(&s[0], s.size());
+    collector::ReportRequest report;
+    if (!report.ParseFromString(s)) {
+      std::terminate();
+    }
+    {
+      std::lock_guard<std::mutex> lock_guard{mutex_};
+      reports_.emplace_back(std::move(report));
+    }
+    callback.OnSuccess(*message);
+  }
+
+ private:
+  std::atomic<bool> should_fail_{false};
+  mutable std::mutex mutex_;
+  std::vector<collector::ReportRequest> reports_;
+};
+}  // namespace
+
+TEST_CASE("ThreadedRecorder") {
+  Logger logger{};
+  auto metrics_observer = new CountingMetricsObserver{};
+  LightStepTracerOptions options;
+  options.max_buffered_spans = 10;
+  options.reporting_period = std::chrono::hours{1};
+  options.metrics_observer.reset(metrics_observer);
+  auto transporter = new ImmediateAsyncTransporter{};
+  auto recorder =
+      new ThreadedRecorder{logger, std::move(options),
+                           std::unique_ptr<AsyncTransporter>{transporter}};
+  auto tracer =
+      MakeTracerImpl(PropagationOptions{}, std::unique_ptr<Recorder>{recorder});
+  REQUIRE(tracer);
+  auto record_spans = [&](int n) {
+    for (int i = 0; i < n; ++i) {
+      auto span = tracer->StartSpan("abc");
+      REQUIRE(span);
+      span->Finish();
+    }
+  };
+
+  SECTION("Flush waits until buffered spans are transported.") {
+    record_spans(2);
+    REQUIRE(tracer->Flush());
+    REQUIRE(transporter->reports().size() == 1);
+    REQUIRE(transporter->num_spans() == 2);
+    REQUIRE(metrics_observer->num_spans_sent == 2);
+    REQUIRE(metrics_observer->num_flushes == 1);
+  }
+
+  SECTION("Flushing with no buffered spans doesn't send a report.") {
+    REQUIRE(tracer->Flush());
+    REQUIRE(transporter->reports().empty());
+  }
+
+  SECTION("Spans are flushed early once the buffer is half full.") {
+    record_spans(5);
+    for (int i = 0; i < 1000 && transporter->num_spans() < 5; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    REQUIRE(transporter->num_spans() == 5);
+  }
+
+  SECTION("Spans of failed reports are counted in the next report.") {
+    logger.set_level(LogLevel::off);
+    transporter->set_should_fail(true);
+    record_spans(2);
+    REQUIRE(tracer->Flush());
+    REQUIRE(metrics_observer->num_spans_dropped == 2);
+    transporter->set_should_fail(false);
+    record_spans(1);
+    REQUIRE(tracer->Flush());
+    REQUIRE(transporter->reports().size() == 1);
+    REQUIRE(LookupSpansDropped(transporter->reports().at(0)) == 2);
+  }
+}
+
+TEST_CASE("ThreadedRecorder reporting period") {
+  Logger logger{};
+  LightStepTracerOptions options;
+  options.reporting_period = std::chrono::milliseconds{1};
+  auto transporter = new ImmediateAsyncTransporter{};
+  auto recorder =
+      new ThreadedRecorder{logger, std::move(options),
+                           std::unique_ptr<AsyncTransporter>{transporter}};
+  auto tracer =
+      MakeTracerImpl(PropagationOptions{}, std::unique_ptr<Recorder>{recorder});
+
+  SECTION("Spans are sent every reporting period without a flush.") {
+    tracer->StartSpan("abc");
+    for (int i = 0; i < 1000 && transporter->num_spans() == 0; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    REQUIRE(transporter->num_spans() == 1);
+  }
+}
+
+TEST_CASE("ThreadedRecorder report limits") {
+  Logger logger{};
+  auto metrics_observer = new CountingMetricsObserver{};
+  LightStepTracerOptions options;
+  options.reporting_period = std::chrono::hours{1};
+  options.max_report_spans = 2;
+  options.metrics_observer.reset(metrics_observer);
+  auto transporter = new ImmediateAsyncTransporter{};
+  auto recorder =
+      new ThreadedRecorder{logger, std::move(options),
+                           std::unique_ptr<AsyncTransporter>{transporter}};
+  auto tracer =
+      MakeTracerImpl(PropagationOptions{}, std::unique_ptr<Recorder>{recorder});
+
+  SECTION("Flush waits until every report of a split flush is transported.") {
+    for (int i = 0; i < 5; ++i) {
+      tracer->StartSpan("abc");
+    }
+    REQUIRE(tracer->Flush());
+    REQUIRE(transporter->reports().size() == 3);
+    REQUIRE(transporter->num_spans() == 5);
+    REQUIRE(metrics_observer->num_spans_sent == 5);
+    REQUIRE(metrics_observer->num_flushes == 1);
+  }
+}
@@ -34,6 +34,79 @@ TEST_CASE("LightStepTracerFactory") {
     REQUIRE(options.tags["xyz"].get<std::string>() == "456");
   }
 
+  SECTION("We can specify a sampler from a tracer's json configuration") {
+    const char* config = R"({
+      "component_name": "t",
+      "sampler": {
+        "type": "trace_id_ratio",
+        "ratio": 0
+      }
+    })";
+    auto options_maybe = MakeTracerOptions(config, error_message);
+    REQUIRE(options_maybe);
+    REQUIRE(options_maybe->sampler != nullptr);
+    REQUIRE(!options_maybe->sampler->ShouldSample(123, "abc"));
+  }
+
+  SECTION("We can specify a byte budget from a tracer's json configuration") {
+    const char* config = R"({
+      "component_name": "t",
+      "max_buffered_bytes": 1048576
+    })";
+    auto options_maybe = MakeTracerOptions(config, error_message);
+    REQUIRE(options_maybe);
+    REQUIRE(options_maybe->max_buffered_bytes == 1048576);
+  }
+
+  SECTION(
+      "We can specify the number of concurrent reports from a tracer's json "
+      "configuration") {
+    const char* config = R"({
+      "component_name": "t",
+      "max_concurrent_reports": 8
+    })";
+    auto options_maybe = MakeTracerOptions(config, error_message);
+    REQUIRE(options_maybe);
+    REQUIRE(options_maybe->max_concurrent_reports == 8);
+  }
+
+  SECTION(
+      "We can bound the size of reports from a tracer's json configuration") {
+    const char* config = R"({
+      "component_name": "t",
+      "max_report_spans": 100,
+      "max_report_bytes": 65536
+    })";
+    auto options_maybe = MakeTracerOptions(config, error_message);
+    REQUIRE(options_maybe);
+    REQUIRE(options_maybe->max_report_spans == 100);
+    REQUIRE(options_maybe->max_report_bytes == 65536);
+  }
+
+  SECTION(
+      "We can enable the contiguous span buffer from a tracer's json "
+      "configuration") {
+    const char* config = R"({
+      "component_name": "t",
+      "use_stream_recorder": true,
+      "use_contiguous_span_buffer": true
+    })";
+    auto options_maybe = MakeTracerOptions(config, error_message);
+    REQUIRE(options_maybe);
+    REQUIRE(options_maybe->use_contiguous_span_buffer);
+  }
+
+  SECTION("MakeTracerOptions fails if there's an invalid sampler type") {
+    const char* config = R"({
+      "component_name": "t",
+      "sampler": {
+        "type": "abc"
+      }
+    })";
+    auto options_maybe = MakeTracerOptions(config, error_message);
+    REQUIRE(!options_maybe);
+  }
+
   SECTION("MakeTracerOptions fails if there's an invalid propagation_mode") {
     const char* config = R"({
       "component_name": "t",
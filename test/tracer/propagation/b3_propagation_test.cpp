@@ -15,8 +15,8 @@ TEST_CASE("b3 propagation") {
   tracer_options.propagation_modes = {PropagationMode::b3};
   auto recorder = new InMemoryRecorder{};
   auto tracer = std::shared_ptr<opentracing::Tracer>{
-      new TracerImpl{MakePropagationOptions(tracer_options),
-                     std::unique_ptr<Recorder>{recorder}}};
+      MakeTracerImpl(MakePropagationOptions(tracer_options),
+                     std::unique_ptr<Recorder>{recorder})};
   std::unordered_map<std::string, std::string> text_map;
   TextMapCarrier text_map_carrier{text_map};
   HTTPHeadersCarrier http_headers_carrier{text_map};
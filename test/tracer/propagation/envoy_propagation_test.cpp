@@ -14,8 +14,8 @@ TEST_CASE("envoy propagation") {
   LightStepTracerOptions tracer_options;
   tracer_options.use_single_key_propagation = true;
   auto tracer = std::shared_ptr<opentracing::Tracer>{
-      new TracerImpl{MakePropagationOptions(tracer_options),
-                     std::unique_ptr<Recorder>{new InMemoryRecorder{}}}};
+      MakeTracerImpl(MakePropagationOptions(tracer_options),
+                     std::unique_ptr<Recorder>{new InMemoryRecorder{}})};
   auto multikey_tracer = std::shared_ptr<opentracing::Tracer>{
       new LegacyTracerImpl{MakePropagationOptions(LightStepTracerOptions{}),
                            std::unique_ptr<Recorder>{new InMemoryRecorder{}}}};
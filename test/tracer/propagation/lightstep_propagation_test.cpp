@@ -15,8 +15,8 @@ TEST_CASE("lightstep propagation") {
   tracer_options.propagation_modes = {PropagationMode::b3,
                                       PropagationMode::lightstep};
   auto tracer = std::shared_ptr<opentracing::Tracer>{
-      new TracerImpl{MakePropagationOptions(tracer_options),
-                     std::unique_ptr<Recorder>{new InMemoryRecorder{}}}};
+      MakeTracerImpl(MakePropagationOptions(tracer_options),
+                     std::unique_ptr<Recorder>{new InMemoryRecorder{}})};
   std::unordered_map<std::string, std::string> text_map;
   TextMapCarrier text_map_carrier{text_map};
   HTTPHeadersCarrier http_headers_carrier{text_map};
@@ -44,8 +44,8 @@ MakeTracers(const LightStepTracerOptions& tracer_options = {}) {
   result.emplace_back("LegacyTracer", legacy_tracer);
 
   auto tracer = std::shared_ptr<opentracing::Tracer>{
-      new TracerImpl{MakePropagationOptions(tracer_options),
-                     std::unique_ptr<Recorder>{new InMemoryRecorder{}}}};
+      MakeTracerImpl(MakePropagationOptions(tracer_options),
+                     std::unique_ptr<Recorder>{new InMemoryRecorder{}})};
   result.emplace_back("Tracer", tracer);
   return result;
 }
@@ -14,8 +14,8 @@ TEST_CASE("trace-context propagation") {
   tracer_options.propagation_modes = {PropagationMode::trace_context};
   auto recorder = new InMemoryRecorder{};
   auto tracer = std::shared_ptr<opentracing::Tracer>{
-      new TracerImpl{MakePropagationOptions(tracer_options),
-                     std::unique_ptr<Recorder>{recorder}}};
+      MakeTracerImpl(MakePropagationOptions(tracer_options),
+                     std::unique_ptr<Recorder>{recorder})};
   std::unordered_map<std::string, std::string> text_map;
   TextMapCarrier text_map_carrier{text_map};
   HTTPHeadersCarrier http_headers_carrier{text_map};
@@ -0,0 +1,62 @@
+#include "tracer/sampler/adaptive_sampler.h"
+
+#include <random>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+static int CountSampled(AdaptiveSampler& sampler,
+                        std::mt19937_64& random_number_generator, int n,
+                        std::chrono::steady_clock::time_point& now) {
+  // Spread the traces evenly over one adjustment period.
+  auto delta = AdaptiveSampler::AdjustmentPeriod / n;
+  int result = 0;
+  for (int i = 0; i < n; ++i) {
+    result += static_cast<int>(
+        sampler.ShouldSample(random_number_generator(), now));
+    now += delta;
+  }
+  return result;
+}
+
+TEST_CASE("AdaptiveSampler") {
+  auto now = std::chrono::steady_clock::now();
+  std::mt19937_64 random_number_generator{0};
+
+  SECTION("Every trace is sampled while under the target rate.") {
+    AdaptiveSampler sampler{100, now};
+    for (int i = 0; i < 5; ++i) {
+      REQUIRE(CountSampled(sampler, random_number_generator, 50, now) == 50);
+    }
+    REQUIRE(sampler.ratio() == 1.0);
+  }
+
+  SECTION("Bursts are capped at the target rate.") {
+    AdaptiveSampler sampler{100, now};
+    REQUIRE(CountSampled(sampler, random_number_generator, 1000, now) <= 200);
+  }
+
+  SECTION("The sampled fraction converges to the target rate.") {
+    AdaptiveSampler sampler{100, now};
+    for (int i = 0; i < 10; ++i) {
+      CountSampled(sampler, random_number_generator, 10000, now);
+    }
+    REQUIRE(sampler.ratio() == Approx(0.01).epsilon(0.01));
+    auto num_sampled =
+        CountSampled(sampler, random_number_generator, 10000, now);
+    REQUIRE(num_sampled > 70);
+    REQUIRE(num_sampled <= 130);
+  }
+
+  SECTION("The sampled fraction recovers when traffic drops.") {
+    AdaptiveSampler sampler{100, now};
+    for (int i = 0; i < 5; ++i) {
+      CountSampled(sampler, random_number_generator, 10000, now);
+    }
+    REQUIRE(sampler.ratio() < 0.1);
+    for (int i = 0; i < 10; ++i) {
+      CountSampled(sampler, random_number_generator, 10, now);
+    }
+    REQUIRE(sampler.ratio() == 1.0);
+  }
+}
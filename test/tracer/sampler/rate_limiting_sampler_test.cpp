@@ -0,0 +1,46 @@
+#include "tracer/sampler/rate_limiting_sampler.h"
+
+#include <string>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+TEST_CASE("RateLimitingSampler") {
+  auto now = std::chrono::steady_clock::now();
+  RateLimitingSampler sampler{2};
+
+  SECTION("Traces beyond the rate are not sampled.") {
+    REQUIRE(sampler.ShouldSample("abc", now));
+    REQUIRE(sampler.ShouldSample("abc", now));
+    REQUIRE(!sampler.ShouldSample("abc", now));
+  }
+
+  SECTION("Tokens are replenished over time.") {
+    REQUIRE(sampler.ShouldSample("abc", now));
+    REQUIRE(sampler.ShouldSample("abc", now));
+    now += std::chrono::milliseconds{500};
+    REQUIRE(sampler.ShouldSample("abc", now));
+    REQUIRE(!sampler.ShouldSample("abc", now));
+  }
+
+  SECTION("Each operation is limited separately.") {
+    REQUIRE(sampler.ShouldSample("abc", now));
+    REQUIRE(sampler.ShouldSample("abc", now));
+    REQUIRE(!sampler.ShouldSample("abc", now));
+    REQUIRE(sampler.ShouldSample("xyz", now));
+  }
+
+  SECTION("Operations beyond the maximum tracked share a limit.") {
+    for (size_t i = 0; i < RateLimitingSampler::MaxOperations; ++i) {
+      REQUIRE(sampler.ShouldSample(std::to_string(i), now));
+    }
+    REQUIRE(sampler.ShouldSample("abc", now));
+    REQUIRE(sampler.ShouldSample("xyz", now));
+    REQUIRE(!sampler.ShouldSample("qrs", now));
+  }
+
+  SECTION("A rate of 0 samples no traces.") {
+    RateLimitingSampler sampler2{0};
+    REQUIRE(!sampler2.ShouldSample("abc", now));
+  }
+}
@@ -0,0 +1,48 @@
+#include "tracer/sampler/trace_id_ratio_sampler.h"
+
+#include <limits>
+#include <random>
+
+#include "3rd_party/catch2/catch.hpp"
+using namespace lightstep;
+
+TEST_CASE("TraceIdRatioSampler") {
+  const uint64_t max_trace_id = std::numeric_limits<uint64_t>::max();
+
+  SECTION("A ratio of 1 samples every trace.") {
+    TraceIdRatioSampler sampler{1.0};
+    REQUIRE(sampler.ShouldSample(0, "abc"));
+    REQUIRE(sampler.ShouldSample(max_trace_id, "abc"));
+  }
+
+  SECTION("A ratio of 0 samples no traces.") {
+    TraceIdRatioSampler sampler{0.0};
+    REQUIRE(!sampler.ShouldSample(0, "abc"));
+    REQUIRE(!sampler.ShouldSample(max_trace_id, "abc"));
+  }
+
+  SECTION("Ratios outside of [0, 1] are clamped.") {
+    REQUIRE(TraceIdRatioSampler{2.0}.ShouldSample(max_trace_id, "abc"));
+    REQUIRE(!TraceIdRatioSampler{-1.0}.ShouldSample(0, "abc"));
+  }
+
+  SECTION("The decision only depends on the trace id.") {
+    TraceIdRatioSampler sampler{0.5};
+    REQUIRE(sampler.ShouldSample(max_trace_id / 4, "abc"));
+    REQUIRE(sampler.ShouldSample(max_trace_id / 4, "xyz"));
+    REQUIRE(!sampler.ShouldSample(max_trace_id / 4 * 3, "abc"));
+  }
+
+  SECTION("The given fraction of random trace ids are sampled.") {
+    TraceIdRatioSampler sampler{0.25};
+    std::mt19937_64 random_number_generator{0};
+    const int n = 100000;
+    int num_sampled = 0;
+    for (int i = 0; i < n; ++i) {
+      num_sampled +=
+          static_cast<int>(sampler.ShouldSample(random_number_generator(), ""));
+    }
+    REQUIRE(num_sampled > n / 4 - n / 100);
+    REQUIRE(num_sampled < n / 4 + n / 100);
+  }
+}
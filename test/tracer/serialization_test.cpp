@@ -48,6 +48,45 @@ TEST_CASE("Serialization") {
     REQUIRE(tag.int_value() == 123);
   }
 
+  SECTION("We can serialize a registered operation name") {
+    auto operation_name = LightStepTracer::RegisterOperationName("abc");
+    REQUIRE(operation_name.value() == "abc");
+    WriteOperationName(coded_stream, operation_name);
+    finalize();
+    REQUIRE(span.operation_name() == "abc");
+  }
+
+  SECTION("We can attach tags with a registered key") {
+    auto key = LightStepTracer::RegisterTagKey("abc");
+    REQUIRE(key.value() == "abc");
+    WriteTag(coded_stream, key, 123);
+    WriteTag(coded_stream, key, "xyz");
+    finalize();
+    REQUIRE(span.tags().size() == 2);
+    REQUIRE(span.tags()[0].key() == "abc");
+    REQUIRE(span.tags()[0].int_value() == 123);
+    REQUIRE(span.tags()[1].key() == "abc");
+    REQUIRE(span.tags()[1].string_value() == "xyz");
+  }
+
+  SECTION("Typed tags serialize the same as opentracing::Value tags") {
+    auto key = LightStepTracer::RegisterTagKey("key");
+    WriteTypedTag(coded_stream, "abc", true);
+    WriteTypedTag(coded_stream, "abc", int64_t{-123});
+    WriteTypedTag(coded_stream, "abc", 1.5);
+    WriteTypedTag(coded_stream, "abc", opentracing::string_view{"xyz"});
+    WriteTypedTag(coded_stream, key, int64_t{123});
+    finalize();
+    std::vector<opentracing::Value> values = {true, -123, 1.5, "xyz"};
+    REQUIRE(span.tags().size() == values.size() + 1);
+    for (size_t i = 0; i < values.size(); ++i) {
+      REQUIRE(google::protobuf::util::MessageDifferencer::Equals(
+          span.tags()[static_cast<int>(i)], ToKeyValue("abc", values[i])));
+    }
+    REQUIRE(google::protobuf::util::MessageDifferencer::Equals(
+        span.tags()[static_cast<int>(values.size())], ToKeyValue("key", 123)));
+  }
+
   SECTION("We can write the start timestamp") {
     auto now = std::chrono::system_clock::now();
     WriteStartTimestamp(coded_stream, now);
@@ -115,4 +154,16 @@ TEST_CASE("Serialization") {
     REQUIRE(google::protobuf::util::MessageDifferencer::Equals(span.logs()[0],
                                                                expected_log));
   }
+
+  SECTION("We can attach logs with a typed field to a span") {
+    auto now = std::chrono::system_clock::now();
+    WriteTypedLog(coded_stream, now, "abc", opentracing::string_view{"xyz"});
+    finalize();
+    std::vector<std::pair<std::string, opentracing::Value>> fields = {
+        {"abc", "xyz"}};
+    auto expected_log = ToLog(now, fields.begin(), fields.end());
+    REQUIRE(span.logs().size() == 1);
+    REQUIRE(google::protobuf::util::MessageDifferencer::Equals(span.logs()[0],
+                                                               expected_log));
+  }
 }
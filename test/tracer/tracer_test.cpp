@@ -13,15 +13,74 @@ using namespace lightstep;
 using namespace opentracing;
 
 static std::shared_ptr<opentracing::Tracer> MakeTracer(
-    const std::string& name, std::unique_ptr<Recorder>&& recorder) {
+    const std::string& name, std::unique_ptr<Recorder>&& recorder,
+    std::unique_ptr<Sampler>&& sampler = nullptr) {
   if (name == "legacy") {
-    return std::shared_ptr<opentracing::Tracer>{
-        new LegacyTracerImpl{PropagationOptions{}, std::move(recorder)}};
+    return std::shared_ptr<opentracing::Tracer>{new LegacyTracerImpl{
+        PropagationOptions{}, std::move(recorder), std::move(sampler)}};
   }
-  return std::shared_ptr<opentracing::Tracer>{
-      new TracerImpl{PropagationOptions{}, std::move(recorder)}};
+  return MakeTracerImpl(PropagationOptions{}, std::move(recorder),
+                        std::move(sampler));
 }
 
+namespace {
+// A LightStepTracer that forwards to another tracer and relies on the default
+// for starting spans from registered operation names.
+class ForwardingTracer final : public LightStepTracer {
+ public:
+  explicit ForwardingTracer(std::shared_ptr<opentracing::Tracer> tracer)
+      : tracer_{std::move(tracer)} {}
+
+  std::unique_ptr<opentracing::Span> StartSpanWithOptions(
+      string_view operation_name, const StartSpanOptions& options) const
+      noexcept override {
+    return tracer_->StartSpanWithOptions(operation_name, options);
+  }
+
+  using LightStepTracer::StartSpanWithOptions;
+
+  expected<void> Inject(const SpanContext& span_context,
+                        std::ostream& writer) const override {
+    return tracer_->Inject(span_context, writer);
+  }
+
+  expected<void> Inject(const SpanContext& span_context,
+                        const TextMapWriter& writer) const override {
+    return tracer_->Inject(span_context, writer);
+  }
+
+  expected<void> Inject(const SpanContext& span_context,
+                        const HTTPHeadersWriter& writer) const override {
+    return tracer_->Inject(span_context, writer);
+  }
+
+  expected<std::unique_ptr<SpanContext>> Extract(
+      std::istream& reader) const override {
+    return tracer_->Extract(reader);
+  }
+
+  expected<std::unique_ptr<SpanContext>> Extract(
+      const TextMapReader& reader) const override {
+    return tracer_->Extract(reader);
+  }
+
+  expected<std::unique_ptr<SpanContext>> Extract(
+      const HTTPHeadersReader& reader) const override {
+    return tracer_->Extract(reader);
+  }
+
+  bool Flush() noexcept override { return true; }
+
+  bool FlushWithTimeout(
+      std::chrono::system_clock::duration /*timeout*/) noexcept override {
+    return true;
+  }
+
+ private:
+  std::shared_ptr<opentracing::Tracer> tracer_;
+};
+}  // namespace
+
 TEST_CASE("tracer") {
   for (std::string tracer_type : {"legacy", "nextgen"}) {
     auto recorder = new InMemoryRecorder{};
@@ -40,6 +99,35 @@ TEST_CASE("tracer") {
       REQUIRE(HasTag(span, "xyz", true));
     }
 
+    SECTION(tracer_type +
+            ": Spans can be started and tagged with registered strings.") {
+      auto operation_name = LightStepTracer::RegisterOperationName("a");
+      auto key = LightStepTracer::RegisterTagKey("abc");
+      {
+        auto span = static_cast<LightStepTracer&>(*tracer).StartSpan(
+            operation_name, {SetTag("xyz", true)});
+        REQUIRE(span);
+        span->SetTag(key, 123);
+        span->Finish();
+      }
+      auto span = recorder->top();
+      REQUIRE(span.operation_name() == "a");
+      REQUIRE(HasTag(span, "abc", 123));
+      REQUIRE(HasTag(span, "xyz", true));
+    }
+
+    SECTION(tracer_type +
+            ": A registered key can set the sampling priority.") {
+      auto key = LightStepTracer::RegisterTagKey(SamplingPriorityKey);
+      {
+        auto span = static_cast<LightStepTracer&>(*tracer).StartSpan(
+            LightStepTracer::RegisterOperationName("a"));
+        REQUIRE(span);
+        span->SetTag(key, 0);
+      }
+      REQUIRE(recorder->size() == 0);
+    }
+
     SECTION(tracer_type +
             ": Sampling of a span can be turned off by setting the "
             "sampling_priority "
@@ -78,6 +166,26 @@ TEST_CASE("tracer") {
       REQUIRE(recorder->size() == 1);
     }
 
+    SECTION(tracer_type +
+            ": A span sampled after it's started keeps its operation name and "
+            "parent.") {
+      auto parent_span =
+          tracer->StartSpan("a", {SetTag(SamplingPriorityKey, 0u)});
+      REQUIRE(parent_span);
+      {
+        auto child_span = tracer->StartSpan(
+            "b", {opentracing::ChildOf(&parent_span->context())});
+        REQUIRE(child_span);
+        child_span->SetOperationName("c");
+        child_span->SetTag(SamplingPriorityKey, 1);
+        child_span->SetTag("abc", 123);
+      }
+      auto span = recorder->top();
+      REQUIRE(span.operation_name() == "c");
+      REQUIRE(span.references_size() == 1);
+      REQUIRE(HasTag(span, "abc", 123));
+    }
+
     SECTION(tracer_type +
             ": You can set a single child-of reference when starting a span.") {
       auto span_a = tracer->StartSpan("a");
@@ -201,6 +309,30 @@ TEST_CASE("tracer") {
       REQUIRE(recorder->top().logs().size() == 1);
     }
 
+    SECTION(tracer_type + ": Tags and logs can be added with typed values.") {
+      {
+        auto span = static_cast<LightStepTracer&>(*tracer).StartSpan(
+            LightStepTracer::RegisterOperationName("a"));
+        REQUIRE(span);
+        span->SetTag("int", 123);
+        span->SetTag("bool", true);
+        span->SetTag("double", 1.5);
+        span->SetTag("string", std::string{"abc"});
+        span->SetTag(LightStepTracer::RegisterTagKey("literal"), "xyz");
+        span->Log("event", "abc");
+        span->Finish();
+      }
+      auto span = recorder->top();
+      REQUIRE(HasTag(span, "int", 123));
+      REQUIRE(HasTag(span, "bool", true));
+      REQUIRE(HasTag(span, "double", 1.5));
+      REQUIRE(HasTag(span, "string", "abc"));
+      REQUIRE(HasTag(span, "literal", "xyz"));
+      REQUIRE(span.logs().size() == 1);
+      REQUIRE(span.logs()[0].fields()[0].key() == "event");
+      REQUIRE(span.logs()[0].fields()[0].string_value() == "abc");
+    }
+
     SECTION(tracer_type + ": Logs can be added with FinishSpanOptions.") {
       auto span = tracer->StartSpan("a");
       REQUIRE(span);
@@ -219,6 +351,65 @@ TEST_CASE("tracer") {
       span->SetTag("abc", 123);
       span->Log({{"abc", 123}});
     }
+
+    SECTION(tracer_type + ": Spans keep the tracer alive.") {
+      auto parent = tracer->StartSpan("a");
+      REQUIRE(parent);
+      tracer.reset();
+      auto child = parent->tracer().StartSpan(
+          "b", {opentracing::ChildOf(&parent->context())});
+      REQUIRE(child);
+      parent.reset();
+      child->Finish();
+      REQUIRE(recorder->size() == 2);
+      child.reset();
+    }
+  }
+}
+
+TEST_CASE("tracer sampling") {
+  for (std::string tracer_type : {"legacy", "nextgen"}) {
+    auto recorder = new InMemoryRecorder{};
+    auto tracer = MakeTracer(tracer_type, std::unique_ptr<Recorder>{recorder},
+                             MakeTraceIdRatioSampler(0));
+
+    SECTION(tracer_type +
+            ": Root spans rejected by the sampler aren't sampled.") {
+      auto span = tracer->StartSpan("a");
+      REQUIRE(span);
+      auto child_span = tracer->StartSpan("b", {ChildOf(&span->context())});
+      REQUIRE(child_span);
+      child_span->Finish();
+      span->Finish();
+      REQUIRE(recorder->size() == 0);
+    }
+
+    SECTION(tracer_type + ": Sampling priority overrides the sampler.") {
+      auto span = tracer->StartSpan("a", {SetTag(SamplingPriorityKey, 1)});
+      REQUIRE(span);
+      span->Finish();
+      REQUIRE(recorder->size() == 1);
+    }
+  }
+}
+
+TEST_CASE("LightStepTracer") {
+  auto recorder = new InMemoryRecorder{};
+  ForwardingTracer tracer{
+      MakeTracer("nextgen", std::unique_ptr<Recorder>{recorder})};
+
+  SECTION(
+      "By default, spans started from a registered operation name are "
+      "started from its string value.") {
+    {
+      auto span = tracer.StartSpan(LightStepTracer::RegisterOperationName("a"),
+                                   {SetTag("abc", 123)});
+      REQUIRE(span);
+      span->Finish();
+    }
+    auto span = recorder->top();
+    REQUIRE(span.operation_name() == "a");
+    REQUIRE(HasTag(span, "abc", 123));
   }
 }
 
@@ -242,6 +433,14 @@ TEST_CASE("Configuration validation") {
     REQUIRE(MakeLightStepTracer(std::move(options)) != nullptr);
   }
 
+  SECTION(
+      "We can construct a streaming tracer with a contiguous span buffer.") {
+    options.collector_plaintext = true;
+    options.use_stream_recorder = true;
+    options.use_contiguous_span_buffer = true;
+    REQUIRE(MakeLightStepTracer(std::move(options)) != nullptr);
+  }
+
   SECTION(
       "Constructing the streaming tracer errors if plaintext isn't "
       "specified.") {
@@ -105,7 +105,7 @@ std::string ToString(const FragmentInputStream& fragment_input_stream) {
 //--------------------------------------------------------------------------------------------------
 // AddSpanChunkFramedString
 //--------------------------------------------------------------------------------------------------
-bool AddSpanChunkFramedString(CircularBuffer<ChainedStream>& buffer,
+bool AddSpanChunkFramedString(ShardedCircularBuffer<ChainedStream>& buffer,
                               const std::string& s) {
   auto framed_s = AddSpanChunkFraming(s);
   std::unique_ptr<ChainedStream> chain{new ChainedStream{}};
@@ -4,8 +4,8 @@
 #include <thread>
 
 #include "common/chained_stream.h"
-#include "common/circular_buffer.h"
 #include "common/fragment_input_stream.h"
+#include "common/sharded_circular_buffer.h"
 
 #include <opentracing/tracer.h>
 #include "lightstep-tracer-common/collector.pb.h"
@@ -66,7 +66,7 @@ std::string ToString(const FragmentInputStream& fragment_input_stream);
  * @param s the string to add.
  * @return true if the string was succesfully added.
  */
-bool AddSpanChunkFramedString(CircularBuffer<ChainedStream>& buffer,
+bool AddSpanChunkFramedString(ShardedCircularBuffer<ChainedStream>& buffer,
                               const std::string& s);
 
 /**